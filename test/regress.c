@@ -0,0 +1,3012 @@
+/*
+ * Regression checks for the optional features of this tree.
+ *
+ * Build it with the same SQLITE_ENABLE_* options as the library, for
+ * example:
+ *
+ *   cc -DSQLITE_ENABLE_BITMAP ... -I../tsrc ../tsrc/[a-z]*.c regress.c
+ *
+ * It runs the checks for every feature that is enabled, reports each failure
+ * on stderr and exits with a nonzero status if any check failed.  It has
+ * its own main() and so is not part of the sqlitefs project.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#ifdef __linux__
+#include <sys/types.h>
+#include <sys/uio.h>
+#endif
+#include "deps.h"
+#include "sqlite3.h"
+
+#define RESULT_SIZE (4*1024)
+
+static int nFail = 0;
+static int nCheck = 0;
+
+typedef struct
+{
+    char *zBuf;
+    int nBuf;
+} result_t;
+
+static int cbResult(void *pArg, int argc, char **argv, char **azColName)
+{
+    result_t *p = (result_t *)pArg;
+    int i;
+
+    for (i = 0; i < argc; i++)
+    {
+        p->nBuf += snprintf(p->zBuf + p->nBuf, RESULT_SIZE - p->nBuf, "%s%s",
+            (i == 0 ? (p->nBuf ? " " : "") : "|"), argv[i] ? argv[i] : "NULL");
+        if (p->nBuf >= RESULT_SIZE)
+        {
+            p->nBuf = RESULT_SIZE - 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Run zSql and compare its rows with zExpect.  Values within a row are
+ * separated by "|" and rows by " ".  An error is reported as "ERR: msg".
+ * If zExpect is NULL, any rows are accepted but an error is not.
+ */
+static void check_sql(sqlite3 *db, const char *zSql, const char *zExpect, int iLine)
+{
+    char zBuf[RESULT_SIZE];
+    char *zErr = 0;
+    result_t res;
+
+    zBuf[0] = 0;
+    res.zBuf = zBuf;
+    res.nBuf = 0;
+    nCheck++;
+    if (sqlite3_exec(db, zSql, cbResult, &res, &zErr) != SQLITE_OK)
+    {
+        snprintf(zBuf, RESULT_SIZE, "ERR: %s", zErr);
+        sqlite3_free(zErr);
+    }
+    if (zExpect == NULL ? strncmp(zBuf, "ERR: ", 5) == 0
+                        : strcmp(zBuf, zExpect) != 0)
+    {
+        nFail++;
+        fprintf(stderr, "line %d: %s\n  expected: [%s]\n  got:      [%s]\n",
+            iLine, zSql, zExpect ? zExpect : "any rows", zBuf);
+    }
+}
+
+/*
+ * Compare a value returned by the C API with the one expected.
+ */
+static void check_int(int iGot, int iExpect, int iLine)
+{
+    nCheck++;
+    if (iGot != iExpect)
+    {
+        nFail++;
+        fprintf(stderr, "line %d: expected %d, got %d\n", iLine, iExpect, iGot);
+    }
+}
+
+/*
+ * Run zRef, which must not fail, and check that zSql gives the same rows.
+ */
+static void check_same(sqlite3 *db, const char *zSql, const char *zRef, int iLine)
+{
+    char zBuf[RESULT_SIZE];
+    char *zErr = 0;
+    result_t res;
+
+    zBuf[0] = 0;
+    res.zBuf = zBuf;
+    res.nBuf = 0;
+    if (sqlite3_exec(db, zRef, cbResult, &res, &zErr) != SQLITE_OK)
+    {
+        DBG_ERR("%s: %s\n", zRef, zErr);
+        exit(1);
+    }
+    check_sql(db, zSql, zBuf, iLine);
+}
+
+#define CHECK_SQL(db, sql, expect) check_sql(db, sql, expect, __LINE__)
+#define CHECK_SAME(db, sql, ref)   check_same(db, sql, ref, __LINE__)
+#define EXEC_SQL(db, sql)          check_sql(db, sql, "", __LINE__)
+#define RUN_SQL(db, sql)           check_sql(db, sql, NULL, __LINE__)
+#define CHECK_INT(got, expect)     check_int(got, expect, __LINE__)
+
+static sqlite3 *open_db(const char *zName)
+{
+    sqlite3 *db = 0;
+
+    if (sqlite3_open(zName, &db) != SQLITE_OK)
+    {
+        DBG_ERR("cannot open %s: %s\n", zName, sqlite3_errmsg(db));
+        exit(1);
+    }
+    return db;
+}
+
+/*
+ * Count the instructions of zSql's program whose opcode is zOp.  If
+ * piJumpInto is not NULL, it is set to the number of OP_Goto instructions
+ * that jump to the instruction just after one of them.
+ */
+static int explain_count(sqlite3 *db, const char *zSql, const char *zOp, int *piJumpInto)
+{
+    char *zExplain = sqlite3_mprintf("EXPLAIN %s", zSql);
+    sqlite3_stmt *pStmt = 0;
+    int aAddr[256];
+    int aGoto[256];
+    int nAddr = 0;
+    int nGoto = 0;
+    int i, j;
+
+    if (sqlite3_prepare_v2(db, zExplain, -1, &pStmt, 0) != SQLITE_OK)
+    {
+        DBG_ERR("cannot prepare %s: %s\n", zExplain, sqlite3_errmsg(db));
+        exit(1);
+    }
+    while (sqlite3_step(pStmt) == SQLITE_ROW)
+    {
+        const char *zName = (const char *)sqlite3_column_text(pStmt, 1);
+
+        if (strcmp(zName, zOp) == 0 && nAddr < 256)
+        {
+            aAddr[nAddr++] = sqlite3_column_int(pStmt, 0);
+        }
+        else if (strcmp(zName, "Goto") == 0 && nGoto < 256)
+        {
+            aGoto[nGoto++] = sqlite3_column_int(pStmt, 3);
+        }
+    }
+    sqlite3_finalize(pStmt);
+    sqlite3_free(zExplain);
+    if (piJumpInto)
+    {
+        *piJumpInto = 0;
+        for (i = 0; i < nAddr; i++)
+        {
+            for (j = 0; j < nGoto; j++)
+            {
+                if (aGoto[j] == aAddr[i] + 1)
+                {
+                    (*piJumpInto)++;
+                }
+            }
+        }
+    }
+    return nAddr;
+}
+
+#ifdef SQLITE_ENABLE_BITMAP
+/*
+ * A row overwritten by REPLACE conflict handling does not fire the DELETE
+ * trigger, so the bitmap index must drop its entries some other way.
+ */
+static void test_bitmap(void)
+{
+    sqlite3 *db = open_db(":memory:");
+
+    EXEC_SQL(db,
+        "CREATE TABLE s(id INTEGER PRIMARY KEY, ch INTEGER, x TEXT);"
+        "INSERT INTO s VALUES(1,5,1),(2,5,2),(3,6,3);"
+        "CREATE VIRTUAL TABLE sb USING bitmap(s, ch, x);");
+
+    CHECK_SQL(db, "INSERT OR REPLACE INTO s VALUES(2,9,9);"
+        "SELECT * FROM s WHERE rowid IN (SELECT rid FROM sb WHERE ch=5)",
+        "1|5|1");
+    CHECK_SQL(db, "SELECT rid FROM sb WHERE ch=9", "2");
+    CHECK_SQL(db, "REPLACE INTO s VALUES(2,5,2); SELECT rid FROM sb WHERE ch=9",
+        "");
+
+    /* INSERT OR IGNORE leaves the existing row, and its index entries */
+    CHECK_SQL(db, "INSERT OR IGNORE INTO s VALUES(1,7,7);"
+        "SELECT rid FROM sb WHERE ch=5", "1 2");
+    CHECK_SQL(db, "SELECT rid FROM sb WHERE ch=7", "");
+
+    /* UPDATE OR REPLACE onto an existing rowid */
+    CHECK_SQL(db, "UPDATE OR REPLACE s SET id=3 WHERE id=1;"
+        "SELECT rid FROM sb WHERE ch=5", "2 3");
+    CHECK_SQL(db, "SELECT rid FROM sb WHERE ch=6", "");
+
+    /* A statement that fails part way leaves the index unchanged */
+    CHECK_SQL(db, "INSERT INTO s SELECT 4,6,4 UNION ALL SELECT 3,1,1",
+        "ERR: UNIQUE constraint failed: s.id");
+    CHECK_SQL(db, "SELECT rid FROM sb WHERE ch=5", "2 3");
+    CHECK_SQL(db, "SELECT rid FROM sb WHERE ch IN (1,6)", "");
+
+    /* Constraint values take the affinity of the indexed column */
+    CHECK_SQL(db, "SELECT rid FROM sb WHERE ch='5'", "2 3");
+    CHECK_SQL(db, "SELECT rid FROM sb WHERE ch>'4.5' AND ch<='5.0'", "2 3");
+    CHECK_SQL(db, "SELECT rid FROM sb WHERE ch='five'", "");
+    CHECK_SQL(db, "SELECT rid FROM sb WHERE x=1", "");
+
+    /* REPLACE conflicts on UNIQUE constraints other than the rowid */
+    EXEC_SQL(db,
+        "CREATE TABLE u(id INTEGER PRIMARY KEY, k TEXT UNIQUE COLLATE NOCASE,"
+        "               ch INTEGER, b INTEGER, c INTEGER, UNIQUE(b, c));"
+        "INSERT INTO u VALUES(1,'x',1,1,1),(2,'y',2,2,2),(3,'z',3,3,3);"
+        "CREATE VIRTUAL TABLE ub USING bitmap(u, ch);");
+    CHECK_SQL(db, "INSERT OR REPLACE INTO u VALUES(10,'X',7,9,9);"
+        "SELECT rid FROM ub WHERE ch IN (1,7)", "10");
+    CHECK_SQL(db, "REPLACE INTO u VALUES(11,'q',8,2,2);"
+        "SELECT rid FROM ub WHERE ch IN (2,8)", "11");
+    CHECK_SQL(db, "UPDATE OR REPLACE u SET k='Z' WHERE id=10;"
+        "SELECT rid FROM ub WHERE ch IN (3,7)", "10");
+    CHECK_SQL(db, "INSERT OR IGNORE INTO u VALUES(12,'Q',5,0,0);"
+        "SELECT rid FROM ub WHERE ch IN (5,8)", "11");
+    CHECK_SQL(db, "SELECT count(*) FROM ub", "2");
+
+    /* A UNIQUE index added later is seen after 'rebuild' */
+    EXEC_SQL(db, "CREATE UNIQUE INDEX uch ON u(ch);"
+        "INSERT INTO ub(ub) VALUES('rebuild');");
+    CHECK_SQL(db, "REPLACE INTO u VALUES(20,'w',8,6,6);"
+        "SELECT rid FROM ub WHERE ch=8", "20");
+    CHECK_SQL(db, "SELECT count(*) FROM ub", "2");
+
+    CHECK_SQL(db, "CREATE TABLE e(a INTEGER, b INTEGER);"
+        "CREATE UNIQUE INDEX ee ON e(a+b);"
+        "CREATE VIRTUAL TABLE eb USING bitmap(e, a)",
+        "ERR: bitmap: UNIQUE index ee is on an expression");
+
+    EXEC_SQL(db, "DROP TABLE ub; DROP TABLE u; DROP TABLE e;");
+    EXEC_SQL(db, "DROP TABLE sb;");
+    CHECK_SQL(db, "SELECT name FROM sqlite_master", "s");
+    sqlite3_close(db);
+}
+#endif
+
+#ifdef SQLITE_ENABLE_INTERVAL
+/*
+ * The interval index under REPLACE conflict handling.
+ */
+static void test_interval(void)
+{
+    sqlite3 *db = open_db(":memory:");
+
+    EXEC_SQL(db,
+        "CREATE TABLE s(id INTEGER PRIMARY KEY, channel, lower, upper);"
+        "INSERT INTO s VALUES(5000,1,100,200),(5001,1,150,250);"
+        "CREATE VIRTUAL TABLE si USING interval(s, channel, lower, upper);");
+
+    CHECK_SQL(db, "SELECT rid FROM si WHERE channel=1 AND lower<=160 AND upper>=160",
+        "5000 5001");
+    CHECK_SQL(db, "REPLACE INTO s VALUES(5001,2,100,200);"
+        "SELECT rid FROM si WHERE channel=1 AND lower<=160 AND upper>=160",
+        "5000");
+    CHECK_SQL(db, "SELECT rid FROM si WHERE channel=2 AND lower<=160 AND upper>=160",
+        "5001");
+
+    CHECK_SQL(db, "INSERT OR IGNORE INTO s VALUES(5000,3,0,10);"
+        "SELECT rid FROM si WHERE channel=1 AND lower<=160 AND upper>=160",
+        "5000");
+    CHECK_SQL(db, "UPDATE OR REPLACE s SET id=5000 WHERE id=5001;"
+        "SELECT channel, rid FROM si WHERE lower<=160 AND upper>=160",
+        "2|5000");
+    CHECK_SQL(db, "SELECT count(*) FROM si_node", "1");
+
+    /* REPLACE conflicts on UNIQUE constraints other than the rowid */
+    EXEC_SQL(db,
+        "CREATE TABLE u(id INTEGER PRIMARY KEY, k TEXT UNIQUE COLLATE NOCASE,"
+        "               lower, upper, b, UNIQUE(b, upper));"
+        "INSERT INTO u VALUES(1,'x',10,20,1),(2,'y',30,40,2),(3,'z',50,60,3);"
+        "CREATE VIRTUAL TABLE ui USING interval(u, lower, upper);");
+    CHECK_SQL(db, "INSERT OR REPLACE INTO u VALUES(10,'X',12,14,9);"
+        "SELECT rid FROM ui WHERE lower<=15 AND upper>=11", "10");
+    CHECK_SQL(db, "REPLACE INTO u VALUES(11,'q',35,40,2);"
+        "SELECT rid FROM ui WHERE lower<=40 AND upper>=30", "11");
+    CHECK_SQL(db, "UPDATE OR REPLACE u SET k='Z' WHERE id=10;"
+        "SELECT rid FROM ui WHERE lower<=60 AND upper>=0", "10 11");
+    CHECK_SQL(db, "INSERT OR IGNORE INTO u VALUES(12,'Q',0,100,0);"
+        "SELECT rid FROM ui WHERE lower<=60 AND upper>=0", "10 11");
+    CHECK_SQL(db, "SELECT count(*) FROM ui_node", "2");
+
+    /* A UNIQUE index added later is seen after 'rebuild' */
+    EXEC_SQL(db, "CREATE UNIQUE INDEX ulo ON u(lower);"
+        "INSERT INTO ui(ui) VALUES('rebuild');");
+    CHECK_SQL(db, "REPLACE INTO u VALUES(20,'w',35,36,7);"
+        "SELECT rid FROM ui WHERE lower<=40 AND upper>=30", "20");
+    CHECK_SQL(db, "SELECT count(*) FROM ui_node", "2");
+
+    CHECK_SQL(db, "CREATE TABLE e(a INTEGER, b INTEGER);"
+        "CREATE UNIQUE INDEX ee ON e(a+b);"
+        "CREATE VIRTUAL TABLE ei USING interval(e, a, b)",
+        "ERR: interval: UNIQUE index ee is on an expression");
+
+    EXEC_SQL(db, "DROP TABLE ui; DROP TABLE u; DROP TABLE e;");
+    EXEC_SQL(db, "DROP TABLE si;");
+    CHECK_SQL(db, "SELECT name FROM sqlite_master", "s");
+    sqlite3_close(db);
+}
+#endif
+
+/*
+ * Return the page cache misses reported by a prepared PRAGMA cache_policy.
+ */
+static int cache_misses(sqlite3_stmt *pPolicy)
+{
+    int nMiss = -1;
+
+    if (sqlite3_step(pPolicy) == SQLITE_ROW)
+    {
+        nMiss = sqlite3_column_int(pPolicy, 2);
+    }
+    sqlite3_reset(pPolicy);
+    return nMiss;
+}
+
+/*
+ * Read a small table twice, scan a table larger than the page cache and
+ * return the number of misses taken when the small table is read again
+ * under replacement policy zPolicy.
+ */
+static int cache_policy_hot_misses(const char *zPolicy)
+{
+    sqlite3 *db;
+    sqlite3_stmt *pPolicy = 0;
+    char *zSql;
+    int nMiss;
+
+    remove("regress.db");
+    remove("regress.db-journal");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "PRAGMA page_size=1024;"
+        "CREATE TABLE hot(x); CREATE TABLE big(x);"
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<8)"
+        "INSERT INTO hot SELECT randomblob(800) FROM c;"
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<400)"
+        "INSERT INTO big SELECT randomblob(800) FROM c;");
+    sqlite3_close(db);
+
+    db = open_db("regress.db");
+    zSql = sqlite3_mprintf("PRAGMA cache_size=40; PRAGMA cache_policy=%Q;"
+        "SELECT sum(length(x)) FROM hot; SELECT sum(length(x)) FROM hot;"
+        "SELECT sum(length(x)) FROM big;", zPolicy);
+    RUN_SQL(db, zSql);
+    sqlite3_free(zSql);
+    sqlite3_prepare_v2(db, "PRAGMA cache_policy", -1, &pPolicy, 0);
+    nMiss = cache_misses(pPolicy);
+    RUN_SQL(db, "SELECT sum(length(x)) FROM hot");
+    nMiss = cache_misses(pPolicy) - nMiss;
+    sqlite3_finalize(pPolicy);
+    sqlite3_close(db);
+    remove("regress.db");
+    return nMiss;
+}
+
+/*
+ * PRAGMA cache_policy changes a process-wide setting and rejects names
+ * it does not know.
+ */
+static void test_cache_policy(void)
+{
+    sqlite3 *db = open_db(":memory:");
+    sqlite3_stmt *pStmt = 0;
+
+    CHECK_SQL(db, "SELECT policy FROM pragma_cache_policy", "lru");
+    RUN_SQL(db, "PRAGMA cache_policy='2Q'");
+    CHECK_SQL(db, "PRAGMA cache_policy=mru",
+        "ERR: unknown cache policy: mru");
+    CHECK_SQL(db, "SELECT policy FROM pragma_cache_policy", "2q");
+    CHECK_SQL(db, "CREATE TABLE t(x); INSERT INTO t VALUES(1);"
+        "SELECT x FROM t; SELECT hit>0 FROM pragma_cache_policy", "1 1");
+    RUN_SQL(db, "PRAGMA main.cache_policy=lru");
+    CHECK_SQL(db, "SELECT policy FROM pragma_cache_policy", "lru");
+
+    /* The policy changes when the statement runs, not when it is
+     * prepared */
+    sqlite3_prepare_v2(db, "PRAGMA cache_policy='2q'", -1, &pStmt, 0);
+    CHECK_SQL(db, "SELECT policy FROM pragma_cache_policy", "lru");
+    CHECK_INT(sqlite3_step(pStmt), SQLITE_ROW);
+    sqlite3_finalize(pStmt);
+    CHECK_SQL(db, "SELECT policy FROM pragma_cache_policy", "2q");
+    sqlite3_close(db);
+
+    /* The pages of a table in repeated use survive a large scan under 2Q
+     * but not under LRU */
+    CHECK_INT(cache_policy_hot_misses("2q"), 0);
+    CHECK_INT(cache_policy_hot_misses("lru") > 0, 1);
+    db = open_db(":memory:");
+    RUN_SQL(db, "PRAGMA cache_policy=lru");
+    sqlite3_close(db);
+}
+
+static sqlite3 *open_uri(const char *zUri)
+{
+    sqlite3 *db = 0;
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI;
+
+    if (sqlite3_open_v2(zUri, &db, flags, 0) != SQLITE_OK)
+    {
+        DBG_ERR("cannot open %s: %s\n", zUri, sqlite3_errmsg(db));
+        exit(1);
+    }
+    return db;
+}
+
+static int file_exists(const char *zName)
+{
+    FILE *f = fopen(zName, "rb");
+
+    if (f)
+    {
+        fclose(f);
+    }
+    return f != NULL;
+}
+
+/*
+ * Return byte iOff of the header of database file zName, or -1.
+ */
+static int header_byte(const char *zName, int iOff)
+{
+    FILE *f = fopen(zName, "rb");
+    int c = -1;
+
+    if (f)
+    {
+        if (fseek(f, iOff, SEEK_SET) == 0)
+        {
+            c = fgetc(f);
+        }
+        fclose(f);
+    }
+    return c;
+}
+
+/*
+ * The "-warm" side file of cache_warmup is written for ordinary database
+ * files only, and a damaged one is harmless.
+ */
+static void test_cache_warmup(void)
+{
+    sqlite3 *db;
+    FILE *f;
+    unsigned char aHdr[8] = { 'W', 'A', 'R', 'M', 0x7f, 0xff, 0xff, 0xff };
+    int i;
+
+    remove("regress.db");
+    remove("regress.db-warm");
+    remove("-warm");
+
+    db = open_uri("file:regress.db?cache_warmup=1");
+    EXEC_SQL(db, "CREATE TABLE t(x);"
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<2000)"
+        "INSERT INTO t SELECT randomblob(500) FROM c;");
+    CHECK_SQL(db, "SELECT count(*) FROM t", "2000");
+    sqlite3_close(db);
+    nCheck++;
+    if (!file_exists("regress.db-warm"))
+    {
+        nFail++;
+        DBG_ERR("regress.db-warm was not written\n");
+    }
+
+    /* A side file that claims far more entries than it holds, padded
+     * with page numbers beyond the end of the database */
+    f = fopen("regress.db-warm", "wb");
+    if (f)
+    {
+        fwrite(aHdr, 1, sizeof(aHdr), f);
+        for (i = 0; i < 1000000; i++)
+        {
+            unsigned char aPg[4] = { 0, 0, (unsigned char)(i >> 8), (unsigned char)i };
+            fwrite(aPg, 1, sizeof(aPg), f);
+        }
+        fclose(f);
+    }
+    db = open_uri("file:regress.db?cache_warmup=1");
+    CHECK_SQL(db, "SELECT count(*), sum(length(x)) FROM t", "2000|1000000");
+    CHECK_SQL(db, "PRAGMA integrity_check", "ok");
+    sqlite3_close(db);
+
+    /* Immutable, temporary and in-memory databases have no side file */
+    remove("regress.db-warm");
+    db = open_uri("file:regress.db?immutable=1&cache_warmup=1");
+    CHECK_SQL(db, "SELECT count(*) FROM t WHERE x IS NOT NULL", "2000");
+    sqlite3_close(db);
+    db = open_uri("file:?cache_warmup=1");
+    CHECK_SQL(db, "CREATE TABLE t(x);"
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<2000)"
+        "INSERT INTO t SELECT randomblob(500) FROM c;"
+        "SELECT count(*) FROM t WHERE x IS NOT NULL;", "2000");
+    sqlite3_close(db);
+    db = open_uri("file::memory:?cache_warmup=1");
+    CHECK_SQL(db, "CREATE TABLE t(x);"
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<2000)"
+        "INSERT INTO t SELECT randomblob(500) FROM c;"
+        "SELECT count(*) FROM t WHERE x IS NOT NULL;", "2000");
+    sqlite3_close(db);
+    nCheck++;
+    if (file_exists("-warm") || file_exists("regress.db-warm"))
+    {
+        nFail++;
+        DBG_ERR("a side file was written\n");
+        remove("-warm");
+    }
+
+    remove("regress.db");
+    remove("regress.db-warm");
+}
+
+/*
+ * A VFS that passes everything to the default VFS, except that it can be
+ * told to fail writes of at least nFailSize bytes to a main journal.  If
+ * eWritev is set when a file is opened, the file has version 4 methods,
+ * with an xWritev that counts the runs of database pages written (1) or
+ * without one (2).
+ */
+typedef struct
+{
+    sqlite3_file base;
+    sqlite3_file *pReal;
+    int bJournal;
+    int bMainDb;
+} shim_file_t;
+
+static struct
+{
+    sqlite3_vfs base;
+    sqlite3_vfs *pParent;
+    int nFailSize;                  /* Fail journal writes this large */
+    int nFail;                      /* Number of writes failed */
+    int eWritev;                    /* Methods for files opened next */
+    int nWrite;                     /* Calls to xWrite on a main database */
+    int nWritev;                    /* Calls to xWritev */
+    int nWritevBuf;                 /* Buffers passed to xWritev */
+    int mxWritevBuf;                /* Most buffers passed to one xWritev */
+} shim_vfs;
+
+#define SHIM_REAL(pFile) (((shim_file_t *)(pFile))->pReal)
+
+static int shimClose(sqlite3_file *pFile)
+{
+    return SHIM_REAL(pFile)->pMethods->xClose(SHIM_REAL(pFile));
+}
+
+static int shimRead(sqlite3_file *pFile, void *zBuf, int iAmt, sqlite3_int64 iOfst)
+{
+    return SHIM_REAL(pFile)->pMethods->xRead(SHIM_REAL(pFile), zBuf, iAmt, iOfst);
+}
+
+static int shimWrite(sqlite3_file *pFile, const void *zBuf, int iAmt, sqlite3_int64 iOfst)
+{
+    if (((shim_file_t *)pFile)->bJournal
+            && shim_vfs.nFailSize > 0 && iAmt >= shim_vfs.nFailSize)
+    {
+        shim_vfs.nFail++;
+        return SQLITE_IOERR_WRITE;
+    }
+    if (((shim_file_t *)pFile)->bMainDb)
+    {
+        shim_vfs.nWrite++;
+    }
+    return SHIM_REAL(pFile)->pMethods->xWrite(SHIM_REAL(pFile), zBuf, iAmt, iOfst);
+}
+
+static int shimWritev(sqlite3_file *pFile, int nBuf, const void **apBuf, int iAmt, sqlite3_int64 iOfst)
+{
+    sqlite3_file *pReal = SHIM_REAL(pFile);
+
+    shim_vfs.nWritev++;
+    shim_vfs.nWritevBuf += nBuf;
+    if (nBuf > shim_vfs.mxWritevBuf)
+    {
+        shim_vfs.mxWritevBuf = nBuf;
+    }
+    if (pReal->pMethods->iVersion >= 4 && pReal->pMethods->xWritev)
+    {
+        return pReal->pMethods->xWritev(pReal, nBuf, apBuf, iAmt, iOfst);
+    }
+    while (nBuf-- > 0)
+    {
+        int rc = pReal->pMethods->xWrite(pReal, *(apBuf++), iAmt, iOfst);
+        if (rc != SQLITE_OK)
+        {
+            return rc;
+        }
+        iOfst += iAmt;
+    }
+    return SQLITE_OK;
+}
+
+static int shimTruncate(sqlite3_file *pFile, sqlite3_int64 size)
+{
+    return SHIM_REAL(pFile)->pMethods->xTruncate(SHIM_REAL(pFile), size);
+}
+
+static int shimSync(sqlite3_file *pFile, int flags)
+{
+    return SHIM_REAL(pFile)->pMethods->xSync(SHIM_REAL(pFile), flags);
+}
+
+static int shimFileSize(sqlite3_file *pFile, sqlite3_int64 *pSize)
+{
+    return SHIM_REAL(pFile)->pMethods->xFileSize(SHIM_REAL(pFile), pSize);
+}
+
+static int shimLock(sqlite3_file *pFile, int eLock)
+{
+    return SHIM_REAL(pFile)->pMethods->xLock(SHIM_REAL(pFile), eLock);
+}
+
+static int shimUnlock(sqlite3_file *pFile, int eLock)
+{
+    return SHIM_REAL(pFile)->pMethods->xUnlock(SHIM_REAL(pFile), eLock);
+}
+
+static int shimCheckReservedLock(sqlite3_file *pFile, int *pResOut)
+{
+    return SHIM_REAL(pFile)->pMethods->xCheckReservedLock(SHIM_REAL(pFile), pResOut);
+}
+
+static int shimFileControl(sqlite3_file *pFile, int op, void *pArg)
+{
+    return SHIM_REAL(pFile)->pMethods->xFileControl(SHIM_REAL(pFile), op, pArg);
+}
+
+static int shimSectorSize(sqlite3_file *pFile)
+{
+    return SHIM_REAL(pFile)->pMethods->xSectorSize(SHIM_REAL(pFile));
+}
+
+static int shimDeviceCharacteristics(sqlite3_file *pFile)
+{
+    return SHIM_REAL(pFile)->pMethods->xDeviceCharacteristics(SHIM_REAL(pFile));
+}
+
+static int shimFetch(sqlite3_file *pFile, sqlite3_int64 iOfst, int iAmt, void **pp)
+{
+    sqlite3_file *pReal = SHIM_REAL(pFile);
+
+    if (pReal->pMethods->iVersion < 3)
+    {
+        *pp = 0;
+        return SQLITE_OK;
+    }
+    return pReal->pMethods->xFetch(pReal, iOfst, iAmt, pp);
+}
+
+static int shimUnfetch(sqlite3_file *pFile, sqlite3_int64 iOfst, void *p)
+{
+    sqlite3_file *pReal = SHIM_REAL(pFile);
+
+    if (pReal->pMethods->iVersion < 3)
+    {
+        return SQLITE_OK;
+    }
+    return pReal->pMethods->xUnfetch(pReal, iOfst, p);
+}
+
+static sqlite3_io_methods shim_io_methods =
+{
+    1,                            /* iVersion */
+    shimClose,                    /* xClose */
+    shimRead,                     /* xRead */
+    shimWrite,                    /* xWrite */
+    shimTruncate,                 /* xTruncate */
+    shimSync,                     /* xSync */
+    shimFileSize,                 /* xFileSize */
+    shimLock,                     /* xLock */
+    shimUnlock,                   /* xUnlock */
+    shimCheckReservedLock,        /* xCheckReservedLock */
+    shimFileControl,              /* xFileControl */
+    shimSectorSize,               /* xSectorSize */
+    shimDeviceCharacteristics,    /* xDeviceCharacteristics */
+};
+
+static sqlite3_io_methods shim_io_methods_v4[2] =
+{
+    {
+        4,                            /* iVersion */
+        shimClose,                    /* xClose */
+        shimRead,                     /* xRead */
+        shimWrite,                    /* xWrite */
+        shimTruncate,                 /* xTruncate */
+        shimSync,                     /* xSync */
+        shimFileSize,                 /* xFileSize */
+        shimLock,                     /* xLock */
+        shimUnlock,                   /* xUnlock */
+        shimCheckReservedLock,        /* xCheckReservedLock */
+        shimFileControl,              /* xFileControl */
+        shimSectorSize,               /* xSectorSize */
+        shimDeviceCharacteristics,    /* xDeviceCharacteristics */
+        0, 0, 0, 0,                   /* xShmMap, xShmLock, xShmBarrier, xShmUnmap */
+        shimFetch,                    /* xFetch */
+        shimUnfetch,                  /* xUnfetch */
+        shimWritev,                   /* xWritev */
+    },
+    {
+        4,                            /* iVersion */
+        shimClose,                    /* xClose */
+        shimRead,                     /* xRead */
+        shimWrite,                    /* xWrite */
+        shimTruncate,                 /* xTruncate */
+        shimSync,                     /* xSync */
+        shimFileSize,                 /* xFileSize */
+        shimLock,                     /* xLock */
+        shimUnlock,                   /* xUnlock */
+        shimCheckReservedLock,        /* xCheckReservedLock */
+        shimFileControl,              /* xFileControl */
+        shimSectorSize,               /* xSectorSize */
+        shimDeviceCharacteristics,    /* xDeviceCharacteristics */
+        0, 0, 0, 0,                   /* xShmMap, xShmLock, xShmBarrier, xShmUnmap */
+        shimFetch,                    /* xFetch */
+        shimUnfetch,                  /* xUnfetch */
+        0,                            /* xWritev */
+    },
+};
+
+static int shimOpen(sqlite3_vfs *pVfs, const char *zName, sqlite3_file *pFile, int flags, int *pOutFlags)
+{
+    shim_file_t *p = (shim_file_t *)pFile;
+    int rc;
+
+    memset(p, 0, sizeof(shim_file_t));
+    p->pReal = (sqlite3_file *)&p[1];
+    p->bJournal = (flags & SQLITE_OPEN_MAIN_JOURNAL) != 0;
+    p->bMainDb = (flags & SQLITE_OPEN_MAIN_DB) != 0;
+    rc = shim_vfs.pParent->xOpen(shim_vfs.pParent, zName, p->pReal, flags, pOutFlags);
+    if (p->pReal->pMethods)
+    {
+        p->base.pMethods = shim_vfs.eWritev
+            ? &shim_io_methods_v4[shim_vfs.eWritev - 1] : &shim_io_methods;
+    }
+    return rc;
+}
+
+static int shimDelete(sqlite3_vfs *pVfs, const char *zName, int syncDir)
+{
+    return shim_vfs.pParent->xDelete(shim_vfs.pParent, zName, syncDir);
+}
+
+static int shimAccess(sqlite3_vfs *pVfs, const char *zName, int flags, int *pResOut)
+{
+    return shim_vfs.pParent->xAccess(shim_vfs.pParent, zName, flags, pResOut);
+}
+
+static int shimFullPathname(sqlite3_vfs *pVfs, const char *zName, int nOut, char *zOut)
+{
+    return shim_vfs.pParent->xFullPathname(shim_vfs.pParent, zName, nOut, zOut);
+}
+
+static int shimRandomness(sqlite3_vfs *pVfs, int nByte, char *zOut)
+{
+    return shim_vfs.pParent->xRandomness(shim_vfs.pParent, nByte, zOut);
+}
+
+static int shimSleep(sqlite3_vfs *pVfs, int microseconds)
+{
+    return shim_vfs.pParent->xSleep(shim_vfs.pParent, microseconds);
+}
+
+static int shimCurrentTime(sqlite3_vfs *pVfs, double *pTime)
+{
+    return shim_vfs.pParent->xCurrentTime(shim_vfs.pParent, pTime);
+}
+
+static void shim_register(void)
+{
+    if (shim_vfs.pParent) return;
+    shim_vfs.pParent = sqlite3_vfs_find(0);
+    shim_vfs.base.iVersion = 1;
+    shim_vfs.base.szOsFile = sizeof(shim_file_t) + shim_vfs.pParent->szOsFile;
+    shim_vfs.base.mxPathname = shim_vfs.pParent->mxPathname;
+    shim_vfs.base.zName = "shim";
+    shim_vfs.base.xOpen = shimOpen;
+    shim_vfs.base.xDelete = shimDelete;
+    shim_vfs.base.xAccess = shimAccess;
+    shim_vfs.base.xFullPathname = shimFullPathname;
+    shim_vfs.base.xRandomness = shimRandomness;
+    shim_vfs.base.xSleep = shimSleep;
+    shim_vfs.base.xCurrentTime = shimCurrentTime;
+    sqlite3_vfs_register(&shim_vfs.base, 0);
+}
+
+/*
+ * A failed write of buffered journal records must not leave changes from
+ * the rolled back transaction in the page cache, where a later commit
+ * would write them to the database.
+ */
+static void test_journal_ioerr(void)
+{
+    sqlite3 *db;
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    const char *zCheck =
+        "SELECT count(*), sum(x LIKE 'changed%') FROM t;"
+        "PRAGMA integrity_check;";
+
+    shim_register();
+    remove("regress.db");
+    remove("regress.db-journal");
+    if (sqlite3_open_v2("regress.db", &db, flags, "shim") != SQLITE_OK)
+    {
+        DBG_ERR("cannot open regress.db: %s\n", sqlite3_errmsg(db));
+        exit(1);
+    }
+    EXEC_SQL(db, "PRAGMA page_size=1024; PRAGMA cache_size=1000;"
+        "CREATE TABLE t(x); CREATE TABLE u(y);"
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<400)"
+        "INSERT INTO t SELECT printf('%0800d', i) FROM c;");
+
+    /* Fail the first write of the journal buffer, after more than 64KB
+     * of page images have been buffered and modified in the cache */
+    shim_vfs.nFailSize = 32768;
+    shim_vfs.nFail = 0;
+    CHECK_SQL(db, "UPDATE t SET x = 'changed' || x", "ERR: disk I/O error");
+    CHECK_SQL(db, "BEGIN; UPDATE t SET x = 'changed' || x WHERE rowid<=100",
+        "ERR: disk I/O error");
+    CHECK_SQL(db, "ROLLBACK", "ERR: cannot rollback - no transaction is active");
+    shim_vfs.nFailSize = 0;
+    nCheck++;
+    if (shim_vfs.nFail == 0)
+    {
+        nFail++;
+        DBG_ERR("no journal write failed\n");
+    }
+
+    CHECK_SQL(db, zCheck, "400|0 ok");
+    CHECK_SQL(db, "INSERT INTO u VALUES(1);", "");
+    CHECK_SQL(db, zCheck, "400|0 ok");
+    sqlite3_close(db);
+
+    db = open_db("regress.db");
+    CHECK_SQL(db, zCheck, "400|0 ok");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+
+/*
+ * Copy file zFrom to zTo.  Return the number of bytes copied.
+ */
+static long copy_file(const char *zFrom, const char *zTo)
+{
+    FILE *pIn = fopen(zFrom, "rb");
+    FILE *pOut = fopen(zTo, "wb");
+    char aBuf[4096];
+    long nTotal = 0;
+    size_t n;
+
+    while (pIn && pOut && (n = fread(aBuf, 1, sizeof(aBuf), pIn)) > 0)
+    {
+        fwrite(aBuf, 1, n, pOut);
+        nTotal += (long)n;
+    }
+    if (pIn) fclose(pIn);
+    if (pOut) fclose(pOut);
+    return nTotal;
+}
+
+/*
+ * Roll back a hot journal left by a transaction that spilled pages to
+ * the database file.  The first journal segment holds more records than
+ * one playback chunk, including one for page 1.
+ */
+static void test_hot_journal(void)
+{
+    sqlite3 *db;
+    const char *zCheck =
+        "SELECT count(*), sum(x LIKE 'changed%') FROM t;"
+        "PRAGMA page_count; PRAGMA integrity_check;";
+
+    remove("regress.db");
+    remove("regress.db-journal");
+    remove("regress2.db");
+    remove("regress2.db-journal");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "PRAGMA page_size=1024; CREATE TABLE t(x);"
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<600)"
+        "INSERT INTO t SELECT printf('%0800d', i) FROM c;");
+    sqlite3_close(db);
+
+    db = open_db("regress.db");
+    CHECK_SQL(db, zCheck, "600|0 607 ok");
+    EXEC_SQL(db, "PRAGMA cache_size=400; BEGIN;"
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<20)"
+        "INSERT INTO t SELECT printf('%0800d', i) FROM c;"
+        "UPDATE t SET x = 'changed' || x;");
+    copy_file("regress.db", "regress2.db");
+    CHECK_INT(copy_file("regress.db-journal", "regress2.db-journal")
+        > 300 * 1032, 1);
+    EXEC_SQL(db, "ROLLBACK");
+    sqlite3_close(db);
+
+    db = open_db("regress2.db");
+    CHECK_SQL(db, zCheck, "600|0 607 ok");
+    sqlite3_close(db);
+    CHECK_INT(file_exists("regress2.db-journal"), 0);
+    remove("regress.db");
+    remove("regress2.db");
+}
+
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+/*
+ * Writing the first prefix-compressed index page raises the read version
+ * of the database (header byte 19) so that older libraries refuse it.
+ * Balancing compressed pages whose records share less than the prefix of
+ * each page must not run out of sibling pages.
+ */
+static void test_prefix_compression(void)
+{
+    sqlite3 *db;
+    int iRead;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    CHECK_SQL(db, "PRAGMA prefix_compression", "0");
+    CHECK_SQL(db, "PRAGMA prefix_compression=ON", "1");
+    EXEC_SQL(db, "CREATE TABLE t(x); CREATE INDEX i ON t(x);");
+    sqlite3_close(db);
+    nCheck++;
+    iRead = header_byte("regress.db", 19);
+    if (iRead != 1)
+    {
+        nFail++;
+        DBG_ERR("read version %d before any compressed page\n", iRead);
+    }
+
+    db = open_db("regress.db");
+    CHECK_SQL(db, "PRAGMA prefix_compression=ON", "1");
+    EXEC_SQL(db,
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<2000)"
+        "INSERT INTO t SELECT printf('a shared prefix for every key %05d', i)"
+        "  FROM c;");
+    sqlite3_close(db);
+    nCheck++;
+    iRead = header_byte("regress.db", 19);
+    if (iRead != 3)
+    {
+        nFail++;
+        DBG_ERR("read version %d after compressed pages were written\n", iRead);
+    }
+
+    /* The raised version is read back as the usual one */
+    db = open_db("regress.db");
+    CHECK_SQL(db, "PRAGMA prefix_compression=OFF", "0");
+    CHECK_SQL(db, "SELECT count(*) FROM t WHERE x LIKE 'a shared%'", "2000");
+    EXEC_SQL(db, "DELETE FROM t WHERE rowid%2;"
+        "INSERT INTO t SELECT x || '.' FROM t;");
+    CHECK_SQL(db, "PRAGMA integrity_check", "ok");
+    CHECK_SQL(db, "SELECT count(*) FROM t INDEXED BY i WHERE x>''", "2000");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+/*
+ * A database created with free_space_map=ON has write version 3, reuses
+ * its free pages and keeps the map through VACUUM.  Auto-vacuum databases
+ * never have one.
+ */
+static void test_free_space_map(void)
+{
+    sqlite3 *db;
+    int iWrite;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    CHECK_SQL(db, "PRAGMA free_space_map", "0");
+    EXEC_SQL(db, "PRAGMA free_space_map=ON;");
+    CHECK_SQL(db, "PRAGMA free_space_map", "1");
+    CHECK_SQL(db, "CREATE TABLE t(x);"
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<2000)"
+        "INSERT INTO t SELECT randomblob(500) FROM c;"
+        "PRAGMA page_count;", "253");
+    CHECK_SQL(db, "DELETE FROM t WHERE rowid<=1000;"
+        "PRAGMA freelist_count;", "125");
+    CHECK_SQL(db, "PRAGMA integrity_check", "ok");
+    CHECK_SQL(db,
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<1000)"
+        "INSERT INTO t SELECT randomblob(500) FROM c;"
+        "PRAGMA page_count; PRAGMA freelist_count;", "253 0");
+    CHECK_SQL(db, "PRAGMA integrity_check", "ok");
+    EXEC_SQL(db, "VACUUM;");
+    CHECK_SQL(db, "PRAGMA free_space_map", "1");
+    CHECK_SQL(db, "SELECT count(*) FROM t", "2000");
+    sqlite3_close(db);
+    nCheck++;
+    iWrite = header_byte("regress.db", 18);
+    if (iWrite != 3)
+    {
+        nFail++;
+        DBG_ERR("write version %d with a free-space map\n", iWrite);
+    }
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "PRAGMA auto_vacuum=FULL; PRAGMA free_space_map=ON;"
+        "CREATE TABLE t(x);");
+    CHECK_SQL(db, "PRAGMA free_space_map", "0");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+#ifdef SQLITE_ENABLE_BLOB_APPEND
+/*
+ * sqlite3_blob_append() grows a value in place when it is the last column
+ * of a row with overflow pages, and rewrites the row otherwise.
+ */
+static void test_blob_append(void)
+{
+    sqlite3 *db;
+    sqlite3_blob *pBlob = 0;
+    sqlite3_blob *pOther = 0;
+    char aBuf[4092];
+    int i;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "CREATE TABLE t(a, b);"
+        "INSERT INTO t VALUES(x'01', x'02'), (x'03', x'04');");
+
+    /* A small value that is not the last column is rewritten */
+    CHECK_INT(sqlite3_blob_open(db, "main", "t", "a", 1, 1, &pBlob), SQLITE_OK);
+    CHECK_INT(sqlite3_blob_append(pBlob, "\x05\x06", 2), SQLITE_OK);
+    CHECK_INT(sqlite3_blob_bytes(pBlob), 3);
+    CHECK_INT(sqlite3_blob_append(pBlob, "\x07", -1), SQLITE_ERROR);
+    CHECK_INT(sqlite3_blob_bytes(pBlob), 3);
+    sqlite3_blob_close(pBlob);
+    CHECK_SQL(db, "SELECT hex(a), hex(b) FROM t WHERE rowid=1", "010506|02");
+
+    /* A last column that grows onto overflow pages, then in place */
+    memset(aBuf, 'x', sizeof(aBuf));
+    CHECK_INT(sqlite3_blob_open(db, "main", "t", "b", 2, 1, &pBlob), SQLITE_OK);
+    CHECK_INT(sqlite3_blob_open(db, "main", "t", "b", 2, 0, &pOther), SQLITE_OK);
+    for (i = 0; i < 10; i++)
+    {
+        CHECK_INT(sqlite3_blob_append(pBlob, aBuf, sizeof(aBuf)), SQLITE_OK);
+    }
+    CHECK_INT(sqlite3_blob_bytes(pBlob), 1 + 10 * (int)sizeof(aBuf));
+    CHECK_INT(sqlite3_blob_read(pOther, aBuf, 1, 0), SQLITE_ABORT);
+    CHECK_INT(sqlite3_blob_append(pOther, aBuf, 1), SQLITE_ABORT);
+    sqlite3_blob_close(pOther);
+    CHECK_INT(sqlite3_blob_read(pBlob, aBuf, 2, 0), SQLITE_OK);
+    CHECK_INT(aBuf[0] == '\x04' && aBuf[1] == 'x', 1);
+    sqlite3_blob_close(pBlob);
+    CHECK_SQL(db, "SELECT length(b), hex(substr(b, 1, 2)), hex(substr(b, -1))"
+        "  FROM t WHERE rowid=2", "40921|0478|78");
+
+    /* Handles opened for reading cannot append */
+    CHECK_INT(sqlite3_blob_open(db, "main", "t", "b", 2, 0, &pBlob), SQLITE_OK);
+    CHECK_INT(sqlite3_blob_append(pBlob, aBuf, 1), SQLITE_READONLY);
+    sqlite3_blob_close(pBlob);
+
+    CHECK_SQL(db, "PRAGMA integrity_check", "ok");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+#ifdef SQLITE_ENABLE_RANGE_DELETE
+/*
+ * A DELETE of a rowid range frees the subtrees inside the range without
+ * visiting their cells.  Check middle ranges, ranges that include the
+ * first or last key and ranges that empty whole subtrees, on a deep tree
+ * of one-row leaves and on a shallow tree of small rows.
+ */
+static void test_range_delete(void)
+{
+    static const struct
+    {
+        int iLo, iHi;
+    } aRange[] = {
+        { 2, 399 }, { 13, 196 }, { 500, 510 }, { 2, 1999 }, { 1, 1000 },
+        { 1000, 2000 }, { 1, 2000 }, { -5, 1 }, { 2000, 9999 }, { 700, 699 },
+    };
+    const char *azFill[] = { "zeroblob(900)", "i" };
+    sqlite3 *db;
+    int i, j;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "PRAGMA page_size=1024; CREATE TABLE u(x);");
+    for (j = 0; j < 2; j++)
+    {
+        for (i = 0; i < (int)(sizeof(aRange) / sizeof(aRange[0])); i++)
+        {
+            int iLo = aRange[i].iLo < 1 ? 1 : aRange[i].iLo;
+            int iHi = aRange[i].iHi > 2000 ? 2000 : aRange[i].iHi;
+            int nLeft = 2000 - (iHi >= iLo ? iHi - iLo + 1 : 0);
+            char *zSql = sqlite3_mprintf("DELETE FROM u;"
+                "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<2000)"
+                "INSERT INTO u(rowid, x) SELECT i, %s FROM c;"
+                "DELETE FROM u WHERE rowid BETWEEN %d AND %d;",
+                azFill[j], aRange[i].iLo, aRange[i].iHi);
+            char *zExpect = sqlite3_mprintf("%d ok", nLeft);
+
+            EXEC_SQL(db, zSql);
+            CHECK_SQL(db, "SELECT count(*) FROM u; PRAGMA integrity_check;",
+                zExpect);
+            sqlite3_free(zSql);
+            sqlite3_free(zExpect);
+        }
+    }
+
+    /* The tree stays usable after a range delete */
+    EXEC_SQL(db, "DELETE FROM u WHERE rowid BETWEEN 10 AND 1990;"
+        "INSERT INTO u(rowid, x) VALUES(1000, 'a');"
+        "DELETE FROM u WHERE rowid BETWEEN 1 AND 5;");
+    CHECK_SQL(db, "SELECT group_concat(rowid) FROM u; PRAGMA integrity_check;",
+        "6,7,8,9,1000,1991,1992,1993,1994,1995,1996,1997,1998,1999,2000 ok");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+/*
+ * Pages read through memory-mapped I/O do not take the priority hint that
+ * the b-tree layer gives interior pages, and their page headers are reused.
+ */
+static void test_mmap(void)
+{
+    sqlite3 *db;
+    int i;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "CREATE TABLE t(a INTEGER PRIMARY KEY, b);"
+        "CREATE INDEX tb ON t(b);"
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<20000)"
+        "INSERT INTO t SELECT i, printf('%08d', i*7919%20000) FROM c;");
+    sqlite3_close(db);
+
+    db = open_db("regress.db");
+    RUN_SQL(db, "PRAGMA mmap_size=100000000");
+    for (i = 0; i < 3; i++)
+    {
+        CHECK_SQL(db, "SELECT count(*), sum(a) FROM t", "20000|200010000");
+        CHECK_SQL(db, "SELECT a FROM t WHERE b='00007919'", "1");
+        CHECK_SQL(db, "SELECT count(*) FROM t"
+            " WHERE b BETWEEN '00001000' AND '00001999'",
+            "1000");
+        CHECK_SQL(db, "SELECT b FROM t WHERE a=12345", "00000055");
+    }
+    EXEC_SQL(db, "UPDATE t SET b=b||'x' WHERE a%100=0;");
+    CHECK_SQL(db, "SELECT count(*) FROM t WHERE b LIKE '%x'", "200");
+    CHECK_SQL(db, "PRAGMA integrity_check", "ok");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+
+#if defined(SQLITE_PCACHE_SHARDS) && defined(SQLITE_ENABLE_MEMORY_MANAGEMENT)
+/*
+ * Mutex methods that pass through to the default ones and count how
+ * often each SQLITE_MUTEX_FAST mutex allocated by sqlite3_initialize()
+ * is entered.  With SQLITE_ENABLE_MEMORY_MANAGEMENT, those are the
+ * mutexes of the page cache shards.
+ */
+static struct
+{
+    sqlite3_mutex_methods real;
+    int bRecord;
+    int nMutex;
+    sqlite3_mutex *apMutex[64];
+    int anEnter[64];
+} shard_mutex;
+
+static sqlite3_mutex *shardMutexAlloc(int eType)
+{
+    sqlite3_mutex *p = shard_mutex.real.xMutexAlloc(eType);
+
+    if (p && shard_mutex.bRecord && eType == SQLITE_MUTEX_FAST
+        && shard_mutex.nMutex < 64)
+    {
+        shard_mutex.apMutex[shard_mutex.nMutex++] = p;
+    }
+    return p;
+}
+
+static void shardMutexEnter(sqlite3_mutex *p)
+{
+    int i;
+
+    for (i = 0; i < shard_mutex.nMutex; i++)
+    {
+        if (shard_mutex.apMutex[i] == p)
+        {
+            shard_mutex.anEnter[i]++;
+        }
+    }
+    shard_mutex.real.xMutexEnter(p);
+}
+
+/*
+ * Each page cache shard has its own mutex, and the pages of a database
+ * are spread over all of them.
+ */
+static void test_pcache_shards(void)
+{
+    sqlite3_mutex_methods wrap;
+    sqlite3 *db;
+    int i;
+
+    sqlite3_shutdown();
+    sqlite3_config(SQLITE_CONFIG_GETMUTEX, &shard_mutex.real);
+    wrap = shard_mutex.real;
+    wrap.xMutexAlloc = shardMutexAlloc;
+    wrap.xMutexEnter = shardMutexEnter;
+    sqlite3_config(SQLITE_CONFIG_MUTEX, &wrap);
+    shard_mutex.bRecord = 1;
+    sqlite3_initialize();
+    shard_mutex.bRecord = 0;
+    CHECK_INT(shard_mutex.nMutex, SQLITE_PCACHE_SHARDS - 1);
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "CREATE TABLE t(x);"
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<200)"
+        "INSERT INTO t SELECT randomblob(2000) FROM c;");
+    CHECK_SQL(db, "SELECT count(*) FROM t WHERE length(x)=2000", "200");
+    sqlite3_close(db);
+    remove("regress.db");
+    for (i = 0; i < shard_mutex.nMutex; i++)
+    {
+        CHECK_INT(shard_mutex.anEnter[i] > 0, 1);
+    }
+
+    sqlite3_shutdown();
+    sqlite3_config(SQLITE_CONFIG_MUTEX, &shard_mutex.real);
+    sqlite3_initialize();
+}
+#endif
+
+#ifdef SQLITE_ENABLE_SUPERINSTRUCTIONS
+/*
+ * Programs that contain each fused opcode give the same results as the
+ * unfused pairs would.  The CASE query jumps to the second instruction of
+ * a Column/Column pair when its first branch is taken, and so runs that
+ * instruction without the first.
+ */
+static void test_superinstructions(void)
+{
+    static const char *zCase =
+        "SELECT CASE WHEN a THEN b ELSE c END, d FROM t";
+    static const char *zReal = "SELECT a, r FROM t";
+    static const char *zGroup = "SELECT a, count(*), sum(d) FROM t GROUP BY a";
+    static const char *zUnion =
+        "SELECT d FROM t UNION SELECT d+5 FROM t ORDER BY 1";
+    sqlite3 *db;
+    int nJumpInto = 0;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "CREATE TABLE t(a INTEGER, b TEXT, c TEXT, d INTEGER, r REAL);"
+        "INSERT INTO t VALUES(1, 'b1', 'c1', 10, 1);"
+        "INSERT INTO t VALUES(0, 'b2', 'c2', 20, 2.5);"
+        "INSERT INTO t VALUES(NULL, 'b3', 'c3', 30, NULL);"
+        "INSERT INTO t VALUES(2, 'b4', 'c4', 40, 'x');"
+        "INSERT INTO t VALUES(1, 'b5', 'c5', 50, -7);"
+        "INSERT INTO t VALUES(0, 'b6', 'c6', 60, 0);");
+
+    /* Column/Column, with a jump to the second Column */
+    CHECK_INT(explain_count(db, zCase, "ColumnChain", &nJumpInto) > 0, 1);
+    CHECK_INT(nJumpInto, 1);
+    CHECK_SQL(db, zCase, "b1|10 c2|20 c3|30 b4|40 b5|50 c6|60");
+
+    /* Column/RealAffinity */
+    CHECK_INT(explain_count(db, zReal, "ColumnReal", 0) > 0, 1);
+    CHECK_SQL(db, zReal, "1|1.0 0|2.5 NULL|NULL 2|x 1|-7.0 0|0.0");
+
+    /* Compare/Jump, with groups of one and of several rows */
+    CHECK_INT(explain_count(db, zGroup, "CompareJump", 0) > 0, 1);
+    CHECK_SQL(db, zGroup, "NULL|1|30 0|2|80 1|2|60 2|1|40");
+
+    /* Compare/Jump after OP_Permutation in a merge of two sorted queries */
+    CHECK_INT(explain_count(db, zUnion, "CompareJump", 0) > 0, 1);
+    CHECK_SQL(db, zUnion, "10 15 20 25 30 35 40 45 50 55 60 65");
+
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+#ifdef SQLITE_ENABLE_COUNTED_BTREE
+/*
+ * Run the OFFSET queries below against t and compare each with the same
+ * query given a WHERE clause that is always true, which makes SELECT
+ * step over the OFFSET rows one at a time.
+ */
+static void check_offsets(sqlite3 *db)
+{
+    static const char *azSql[] = {
+        "SELECT a, length(c) FROM t LIMIT 3 OFFSET %d",
+        "SELECT a, length(c) FROM t ORDER BY a DESC LIMIT 3 OFFSET %d",
+        "SELECT b FROM t ORDER BY b LIMIT 3 OFFSET %d",
+        "SELECT b FROM t ORDER BY b DESC LIMIT 3 OFFSET %d",
+    };
+    static const char *azRef[] = {
+        "SELECT a, length(c) FROM t WHERE +a NOTNULL LIMIT 3 OFFSET %d",
+        "SELECT a, length(c) FROM t WHERE +a NOTNULL"
+        " ORDER BY a DESC LIMIT 3 OFFSET %d",
+        "SELECT b FROM t WHERE +a NOTNULL ORDER BY b LIMIT 3 OFFSET %d",
+        "SELECT b FROM t WHERE +a NOTNULL ORDER BY b DESC LIMIT 3 OFFSET %d",
+    };
+    sqlite3_stmt *pStmt = 0;
+    int nRow = 0;
+    int aOffset[8];
+    int i, j;
+
+    sqlite3_prepare_v2(db, "SELECT count(*) FROM t", -1, &pStmt, 0);
+    if (sqlite3_step(pStmt) == SQLITE_ROW)
+    {
+        nRow = sqlite3_column_int(pStmt, 0);
+    }
+    sqlite3_finalize(pStmt);
+    aOffset[0] = 0;
+    aOffset[1] = 1;
+    aOffset[2] = nRow / 3;
+    aOffset[3] = nRow / 2 + 7;
+    aOffset[4] = nRow - 2;
+    aOffset[5] = nRow - 1;
+    aOffset[6] = nRow;
+    aOffset[7] = nRow + 100;
+    for (i = 0; i < (int)(sizeof(azSql) / sizeof(azSql[0])); i++)
+    {
+        for (j = 0; j < (int)(sizeof(aOffset) / sizeof(aOffset[0])); j++)
+        {
+            char *zSql = sqlite3_mprintf(azSql[i], aOffset[j]);
+            char *zRef = sqlite3_mprintf(azRef[i], aOffset[j]);
+
+            CHECK_SAME(db, zSql, zRef);
+            sqlite3_free(zSql);
+            sqlite3_free(zRef);
+        }
+    }
+}
+
+/*
+ * A SELECT with an OFFSET over a full table or covering index scan skips
+ * the OFFSET rows with OP_SeekOffset, using subtree entry counts that are
+ * kept up to date by inserts and deletes and discarded by a rollback or a
+ * change made by another connection.
+ */
+static void test_counted_btree(void)
+{
+    sqlite3 *db;
+    sqlite3 *db2;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "PRAGMA page_size=1024;"
+        "CREATE TABLE t(a INTEGER PRIMARY KEY, b TEXT, c);"
+        "CREATE INDEX tb ON t(b);"
+        "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<5000)"
+        "INSERT INTO t SELECT i, printf('%05d', i*7%5000), randomblob(60)"
+        " FROM s;");
+
+    /* Table and covering index scans, in both directions, use the
+    ** subtree counts.  A WHERE clause or a non-covering index does not. */
+    CHECK_INT(explain_count(db, "SELECT a, c FROM t LIMIT 1 OFFSET 10",
+        "SeekOffset", 0), 1);
+    CHECK_INT(explain_count(db, "SELECT a, c FROM t ORDER BY a DESC"
+        " LIMIT 1 OFFSET 10", "SeekOffset", 0), 1);
+    CHECK_INT(explain_count(db, "SELECT b FROM t ORDER BY b LIMIT 1 OFFSET 10",
+        "SeekOffset", 0), 1);
+    CHECK_INT(explain_count(db, "SELECT a FROM t WHERE b>'1'"
+        " LIMIT 1 OFFSET 10", "SeekOffset", 0), 0);
+    CHECK_INT(explain_count(db, "SELECT a FROM t WHERE c NOTNULL"
+        " LIMIT 1 OFFSET 10", "SeekOffset", 0), 0);
+    CHECK_INT(explain_count(db, "SELECT c FROM t ORDER BY b"
+        " LIMIT 1 OFFSET 10", "SeekOffset", 0), 0);
+
+    CHECK_SQL(db, "SELECT count(*), count(*) FROM t", "5000|5000");
+    CHECK_SQL(db, "SELECT a, length(c) FROM t LIMIT 2 OFFSET 0", "1|60 2|60");
+    CHECK_SQL(db, "SELECT a, length(c) FROM t LIMIT 2 OFFSET 4999", "5000|60");
+    CHECK_SQL(db, "SELECT a, length(c) FROM t LIMIT 2 OFFSET 5000", "");
+    CHECK_SQL(db, "SELECT b FROM t ORDER BY b LIMIT 2 OFFSET 1234",
+        "01234 01235");
+    CHECK_SQL(db, "SELECT a FROM t WHERE b>='04990' LIMIT 20 OFFSET 8",
+        "714 2857");
+    check_offsets(db);
+
+    /* Inserts and deletes that split and merge pages */
+    EXEC_SQL(db, "DELETE FROM t WHERE a BETWEEN 1000 AND 1999;"
+        "DELETE FROM t WHERE a%7=3;"
+        "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<1500)"
+        "INSERT INTO t SELECT i+10000, printf('%05dx', i), randomblob(60)"
+        " FROM s;");
+    CHECK_SQL(db, "SELECT count(*) FROM t", "4929");
+    check_offsets(db);
+
+    /* A rolled back transaction and savepoint */
+    EXEC_SQL(db, "BEGIN; DELETE FROM t WHERE a<3000;"
+        "INSERT INTO t(b) VALUES('zz');");
+    check_offsets(db);
+    EXEC_SQL(db, "ROLLBACK;");
+    CHECK_SQL(db, "SELECT count(*) FROM t", "4929");
+    check_offsets(db);
+    EXEC_SQL(db, "SAVEPOINT one; DELETE FROM t WHERE a>4000;");
+    check_offsets(db);
+    EXEC_SQL(db, "ROLLBACK TO one; RELEASE one;");
+    CHECK_SQL(db, "SELECT count(*) FROM t", "4929");
+    check_offsets(db);
+
+    /* Another connection changes the table after this one has counted */
+    db2 = open_db("regress.db");
+    EXEC_SQL(db2, "DELETE FROM t WHERE a<=2000;"
+        "INSERT INTO t(b) VALUES('00000a'), ('00000b');");
+    CHECK_SQL(db, "SELECT count(*) FROM t", "4074");
+    CHECK_SQL(db, "SELECT a FROM t ORDER BY a LIMIT 1 OFFSET 0", "2001");
+    check_offsets(db);
+    EXEC_SQL(db2, "DELETE FROM t WHERE a>11000;");
+    check_offsets(db);
+    CHECK_SQL(db, "SELECT count(*) FROM t", "3572");
+    sqlite3_close(db2);
+
+    CHECK_SQL(db, "PRAGMA integrity_check", "ok");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+#ifdef SQLITE_ENABLE_FREELIST_INDEX
+static unsigned int get4(const unsigned char *a)
+{
+    return ((unsigned int)a[0] << 24) | (a[1] << 16) | (a[2] << 8) | a[3];
+}
+
+/*
+ * Reverse the order of the leaf page numbers on every freelist trunk page
+ * of database file zName.  This gives a valid freelist laid out in the
+ * way another writer could have left it.  Return the number of trunk
+ * pages.
+ */
+static int reverse_freelist(const char *zName)
+{
+    FILE *f = fopen(zName, "r+b");
+    unsigned char aHdr[100];
+    unsigned char aPage[65536];
+    unsigned int iTrunk;
+    int nPgsz;
+    int nTrunk = 0;
+
+    if (f == NULL || fread(aHdr, 1, 100, f) != 100)
+    {
+        DBG_ERR("cannot read %s\n", zName);
+        exit(1);
+    }
+    nPgsz = (aHdr[16] << 8) | aHdr[17];
+    iTrunk = get4(&aHdr[32]);
+    while (iTrunk)
+    {
+        unsigned int nLeaf, i;
+
+        fseek(f, (long)(iTrunk - 1) * nPgsz, SEEK_SET);
+        if (fread(aPage, 1, nPgsz, f) != (size_t)nPgsz)
+        {
+            DBG_ERR("cannot read page %u of %s\n", iTrunk, zName);
+            exit(1);
+        }
+        nLeaf = get4(&aPage[4]);
+        for (i = 0; i < nLeaf / 2; i++)
+        {
+            unsigned char aTmp[4];
+            memcpy(aTmp, &aPage[8 + i * 4], 4);
+            memcpy(&aPage[8 + i * 4], &aPage[8 + (nLeaf - 1 - i) * 4], 4);
+            memcpy(&aPage[8 + (nLeaf - 1 - i) * 4], aTmp, 4);
+        }
+        fseek(f, (long)(iTrunk - 1) * nPgsz, SEEK_SET);
+        fwrite(aPage, 1, nPgsz, f);
+        iTrunk = get4(&aPage[0]);
+        nTrunk++;
+    }
+    fclose(f);
+    return nTrunk;
+}
+
+/*
+ * Leaf pages added to t after the pages of f that followed it were freed
+ * should mostly run forwards through the file, one page after another.
+ */
+#define FREELIST_ADJACENT \
+    "DROP TABLE IF EXISTS temp.l;" \
+    "CREATE TEMP TABLE l AS SELECT pageno AS p FROM dbstat" \
+    " WHERE name='t' AND pagetype='leaf' ORDER BY path;" \
+    "SELECT sum(b.p=a.p+1)*10>=count(*)*9 FROM l a JOIN l b" \
+    " ON b.rowid=a.rowid+1;"
+
+/*
+ * Fill table t with a few rows and then table f, so that the pages of f
+ * follow those of t in the file.
+ */
+#define FREELIST_SETUP(N) \
+    "CREATE TABLE t(a INTEGER PRIMARY KEY, b);" \
+    "CREATE TABLE f(a INTEGER PRIMARY KEY, b);" \
+    "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<10)" \
+    "INSERT INTO t SELECT i, randomblob(200) FROM s;" \
+    "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<" #N ")" \
+    "INSERT INTO f SELECT i, randomblob(400) FROM s;"
+
+/*
+ * Append N rows to t, starting at rowid I.
+ */
+#define FREELIST_GROW(I, N) \
+    "WITH s(i) AS (SELECT " #I " UNION ALL SELECT i+1 FROM s" \
+    " WHERE i<" #I "+" #N "-1)" \
+    "INSERT INTO t SELECT i, randomblob(200) FROM s;"
+
+/*
+ * The freelist index hands out the free page nearest to the page being
+ * split, and stays consistent with the freelist through rollbacks,
+ * vacuums and changes made by another connection, and when the freelist
+ * on disk was written by some other build.
+ */
+static void test_freelist_index(void)
+{
+    static const char *azVacuum[] = { "none", "full", "incremental" };
+    sqlite3 *db;
+    sqlite3 *db2;
+    int i;
+
+    /* Growth into the pages freed by a dropped table */
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "PRAGMA page_size=1024;" FREELIST_SETUP(300)
+        "DROP TABLE f;" FREELIST_GROW(11, 490));
+    CHECK_SQL(db, FREELIST_ADJACENT, "1");
+    CHECK_SQL(db, "SELECT count(*), sum(a) FROM t; PRAGMA integrity_check;",
+        "500|125250 ok");
+
+    /* A rolled back transaction and savepoint leave the freelist as it
+    ** was, and later allocations see it that way */
+    EXEC_SQL(db, "CREATE TABLE g(a INTEGER PRIMARY KEY, b);"
+        "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<200)"
+        "INSERT INTO g SELECT i, randomblob(400) FROM s;");
+    EXEC_SQL(db, "BEGIN; DROP TABLE g;" FREELIST_GROW(501, 100)
+        "ROLLBACK;");
+    CHECK_SQL(db, "SELECT count(*) FROM t; SELECT count(*) FROM g;"
+        "PRAGMA integrity_check;", "500 200 ok");
+    EXEC_SQL(db, "BEGIN; DELETE FROM g WHERE a%2;" FREELIST_GROW(501, 50)
+        "SAVEPOINT one; DELETE FROM g;" FREELIST_GROW(551, 50)
+        "ROLLBACK TO one;" FREELIST_GROW(551, 20) "RELEASE one; COMMIT;");
+    CHECK_SQL(db, "SELECT count(*), sum(a) FROM t; SELECT count(*) FROM g;"
+        "PRAGMA integrity_check;", "570|162735 100 ok");
+
+    /* VACUUM rewrites the freelist underneath the index */
+    EXEC_SQL(db, "DELETE FROM t WHERE a%3=0; VACUUM;"
+        "DROP TABLE g;" FREELIST_GROW(1001, 200));
+    CHECK_SQL(db, "SELECT count(*) FROM t; PRAGMA integrity_check;",
+        "580 ok");
+
+    /* Another connection allocates and frees pages after this one has
+    ** built its index */
+    db2 = open_db("regress.db");
+    EXEC_SQL(db2, "CREATE TABLE h(x); INSERT INTO h VALUES(randomblob(30000));"
+        "DELETE FROM t WHERE a>1100;");
+    EXEC_SQL(db, FREELIST_GROW(2001, 300));
+    EXEC_SQL(db2, "DROP TABLE h;");
+    EXEC_SQL(db, FREELIST_GROW(3001, 300));
+    CHECK_SQL(db, "SELECT count(*) FROM t; PRAGMA integrity_check;",
+        "1080 ok");
+    CHECK_SQL(db2, "PRAGMA integrity_check;", "ok");
+    sqlite3_close(db2);
+    sqlite3_close(db);
+
+    /* Auto-vacuum and incremental vacuum */
+    for (i = 0; i < 3; i++)
+    {
+        char *zSql = sqlite3_mprintf("PRAGMA page_size=1024;"
+            "PRAGMA auto_vacuum=%s;" FREELIST_SETUP(300)
+            "DELETE FROM f WHERE a%%3;" FREELIST_GROW(11, 200)
+            "PRAGMA incremental_vacuum(20);" FREELIST_GROW(211, 200)
+            "DROP TABLE f;" FREELIST_GROW(411, 200)
+            "PRAGMA incremental_vacuum;" FREELIST_GROW(611, 50),
+            azVacuum[i]);
+
+        remove("regress.db");
+        db = open_db("regress.db");
+        EXEC_SQL(db, zSql);
+        CHECK_SQL(db, "SELECT count(*), sum(a) FROM t;"
+            "SELECT freelist_count>0 FROM pragma_freelist_count;"
+            "PRAGMA integrity_check;",
+            "660|218130 0 ok");
+        sqlite3_close(db);
+        sqlite3_free(zSql);
+    }
+
+    /* A freelist on disk with several trunk pages whose leaves are not in
+    ** the order this build would have written them */
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "PRAGMA page_size=1024;" FREELIST_SETUP(1200)
+        "DROP TABLE f;");
+    sqlite3_close(db);
+    CHECK_INT(reverse_freelist("regress.db") > 1, 1);
+    db = open_db("regress.db");
+    CHECK_SQL(db, "PRAGMA integrity_check;", "ok");
+    EXEC_SQL(db, FREELIST_GROW(11, 1000));
+    CHECK_SQL(db, FREELIST_ADJACENT, "1");
+    CHECK_SQL(db, "SELECT count(*), sum(a) FROM t; PRAGMA integrity_check;",
+        "1010|510555 ok");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+#ifdef SQLITE_ENABLE_OVERFLOW_CACHE
+#define OVFL_BLOB_SIZE (200 * 1024)
+
+/*
+ * Fill a[] with n bytes that depend on seed and differ from one page to
+ * the next.
+ */
+static void ovfl_fill(unsigned char *a, int n, int seed)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        a[i] = (unsigned char)(i * 31 + (i >> 10) * seed + seed);
+    }
+}
+
+/*
+ * Set column x of row iRow of table b to a blob filled by ovfl_fill().
+ */
+static void ovfl_write_row(sqlite3 *db, int iRow, int seed)
+{
+    static unsigned char aBuf[OVFL_BLOB_SIZE];
+    sqlite3_stmt *pStmt = 0;
+
+    ovfl_fill(aBuf, OVFL_BLOB_SIZE, seed);
+    sqlite3_prepare_v2(db, "REPLACE INTO b(id, x) VALUES(?, ?)", -1, &pStmt, 0);
+    sqlite3_bind_int(pStmt, 1, iRow);
+    sqlite3_bind_blob(pStmt, 2, aBuf, OVFL_BLOB_SIZE, SQLITE_STATIC);
+    CHECK_INT(sqlite3_step(pStmt), SQLITE_DONE);
+    sqlite3_finalize(pStmt);
+}
+
+/*
+ * Point blob handle pBlob at row iRow and read it at offsets spread over
+ * the whole blob, in an order that jumps backwards and forwards through
+ * the overflow chain.  Check that every read returns the bytes written by
+ * ovfl_write_row() with the same seed.
+ */
+static void ovfl_check_row(sqlite3_blob *pBlob, int iRow, int seed, int iLine)
+{
+    static unsigned char aExpect[OVFL_BLOB_SIZE];
+    unsigned char aBuf[100];
+    int nBad = 0;
+    int i;
+
+    ovfl_fill(aExpect, OVFL_BLOB_SIZE, seed);
+    if (sqlite3_blob_reopen(pBlob, iRow) != SQLITE_OK)
+    {
+        nBad = -1;
+    }
+    for (i = 0; nBad == 0 && i < 64; i++)
+    {
+        int iOff = (int)(((long)i * 7919 * 1021) % (OVFL_BLOB_SIZE - 100));
+
+        if (sqlite3_blob_read(pBlob, aBuf, 100, iOff) != SQLITE_OK
+         || memcmp(aBuf, &aExpect[iOff], 100) != 0)
+        {
+            nBad++;
+        }
+    }
+    check_int(nBad, 0, iLine);
+}
+
+#define OVFL_CHECK_ROW(blob, row, seed) ovfl_check_row(blob, row, seed, __LINE__)
+
+/*
+ * A blob handle opened on row 1 of table b.
+ */
+static sqlite3_blob *ovfl_open_blob(sqlite3 *db)
+{
+    sqlite3_blob *pBlob = 0;
+
+    if (sqlite3_blob_open(db, "main", "b", "x", 1, 0, &pBlob) != SQLITE_OK)
+    {
+        DBG_ERR("cannot open blob: %s\n", sqlite3_errmsg(db));
+        exit(1);
+    }
+    return pBlob;
+}
+
+/*
+ * In an incremental-vacuum database, give table b a row 11 with 100
+ * overflow pages that has 100 free pages on either side of it.  A chain
+ * of 200 pages written next runs over the lower free pages and then
+ * jumps over row 11.
+ */
+#define OVFL_SETUP \
+    "INSERT INTO b VALUES(10, zeroblob(102000));" \
+    "INSERT INTO b VALUES(11, zeroblob(102000));" \
+    "INSERT INTO b VALUES(12, zeroblob(102000));" \
+    "DELETE FROM b WHERE id IN (10, 12);"
+
+/*
+ * Free the chain of row 1 and then row 11.  The next chain of 200 pages
+ * starts on the same page as the old chain of row 1, but is contiguous.
+ */
+#define OVFL_REWRITE \
+    "DELETE FROM b WHERE id=1; PRAGMA incremental_vacuum;" \
+    "DELETE FROM b WHERE id=11;"
+
+/*
+ * Empty table b and the file.
+ */
+#define OVFL_RESET "DELETE FROM b; PRAGMA incremental_vacuum;"
+
+/*
+ * Write the first and 150th overflow pages of row 1, the first cell of
+ * table b, to zOut as "first|150th".
+ */
+static void ovfl_chain(sqlite3 *db, char *zOut)
+{
+    result_t res;
+
+    zOut[0] = 0;
+    res.zBuf = zOut;
+    res.nBuf = 0;
+    sqlite3_exec(db, "SELECT"
+        " (SELECT pageno FROM dbstat WHERE name='b' AND path='/000+000000'),"
+        " (SELECT pageno FROM dbstat WHERE name='b' AND path='/000+000096')",
+        cbResult, &res, 0);
+}
+
+/*
+ * Check that the chain of row 1 starts on the same page as it did when
+ * zOld was written by ovfl_chain(), but then runs over other pages.
+ */
+static void ovfl_check_moved(sqlite3 *db, const char *zOld, int iLine)
+{
+    char zNew[RESULT_SIZE];
+    int iOld1 = 0, iOld150 = 0, iNew1 = 0, iNew150 = 0;
+
+    ovfl_chain(db, zNew);
+    sscanf(zOld, "%d|%d", &iOld1, &iOld150);
+    sscanf(zNew, "%d|%d", &iNew1, &iNew150);
+    check_int(iOld1 > 0 && iNew1 == iOld1 && iNew150 != iOld150, 1, iLine);
+}
+
+#define OVFL_CHECK_MOVED(db, old) ovfl_check_moved(db, old, __LINE__)
+
+/*
+ * Two blob handles hold maps of the overflow chain of the same row while
+ * that chain is freed and replaced by one that starts on the same page,
+ * relocated by incremental vacuum, restored by a rollback or replaced by
+ * another connection.  Reads through either handle must return the
+ * current content of the row.
+ */
+static void test_overflow_cache(void)
+{
+    sqlite3 *db;
+    sqlite3 *db2;
+    sqlite3_blob *pBlob1;
+    sqlite3_blob *pBlob2;
+    unsigned char aBuf[100];
+    char zChain[RESULT_SIZE];
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "PRAGMA page_size=1024; PRAGMA auto_vacuum=incremental;"
+        "CREATE TABLE b(id INTEGER PRIMARY KEY, x);" OVFL_SETUP);
+    ovfl_write_row(db, 1, 1);
+    ovfl_chain(db, zChain);
+    pBlob1 = ovfl_open_blob(db);
+    pBlob2 = ovfl_open_blob(db);
+    OVFL_CHECK_ROW(pBlob1, 1, 1);
+    OVFL_CHECK_ROW(pBlob2, 1, 1);
+
+    /* The chain is freed and replaced by a chain of the same length that
+    ** starts on the same page, while both handles hold maps of it */
+    EXEC_SQL(db, OVFL_REWRITE);
+    ovfl_write_row(db, 1, 2);
+    OVFL_CHECK_MOVED(db, zChain);
+    OVFL_CHECK_ROW(pBlob1, 1, 2);
+    OVFL_CHECK_ROW(pBlob2, 1, 2);
+
+    /* Incremental vacuum moves the tail of the chain, but not its first
+    ** page */
+    EXEC_SQL(db, OVFL_RESET OVFL_SETUP);
+    ovfl_write_row(db, 1, 3);
+    ovfl_chain(db, zChain);
+    OVFL_CHECK_ROW(pBlob1, 1, 3);
+    OVFL_CHECK_ROW(pBlob2, 1, 3);
+    EXEC_SQL(db, "DELETE FROM b WHERE id=11; PRAGMA incremental_vacuum;");
+    OVFL_CHECK_MOVED(db, zChain);
+    OVFL_CHECK_ROW(pBlob1, 1, 3);
+    OVFL_CHECK_ROW(pBlob2, 1, 3);
+
+    /* A rolled back transaction and savepoint replace the chain with the
+    ** one they started with */
+    EXEC_SQL(db, OVFL_RESET OVFL_SETUP);
+    ovfl_write_row(db, 1, 4);
+    ovfl_chain(db, zChain);
+    OVFL_CHECK_ROW(pBlob1, 1, 4);
+    EXEC_SQL(db, "BEGIN;" OVFL_REWRITE);
+    ovfl_write_row(db, 1, 5);
+    OVFL_CHECK_MOVED(db, zChain);
+    OVFL_CHECK_ROW(pBlob1, 1, 5);
+    OVFL_CHECK_ROW(pBlob2, 1, 5);
+    EXEC_SQL(db, "ROLLBACK");
+    OVFL_CHECK_ROW(pBlob1, 1, 4);
+    OVFL_CHECK_ROW(pBlob2, 1, 4);
+    EXEC_SQL(db, "BEGIN; SAVEPOINT one;" OVFL_REWRITE);
+    ovfl_write_row(db, 1, 6);
+    OVFL_CHECK_ROW(pBlob1, 1, 6);
+    OVFL_CHECK_ROW(pBlob2, 1, 6);
+    EXEC_SQL(db, "ROLLBACK TO one; RELEASE one; COMMIT;");
+    OVFL_CHECK_ROW(pBlob1, 1, 4);
+    OVFL_CHECK_ROW(pBlob2, 1, 4);
+
+    /* A write through one handle is seen through the other */
+    memset(aBuf, 0x5a, sizeof(aBuf));
+    CHECK_INT(sqlite3_blob_close(pBlob1), SQLITE_OK);
+    CHECK_INT(sqlite3_blob_open(db, "main", "b", "x", 1, 1, &pBlob1),
+        SQLITE_OK);
+    CHECK_INT(sqlite3_blob_write(pBlob1, aBuf, 100, 150000), SQLITE_OK);
+    memset(aBuf, 0, sizeof(aBuf));
+    CHECK_INT(sqlite3_blob_reopen(pBlob2, 1), SQLITE_OK);
+    CHECK_INT(sqlite3_blob_read(pBlob2, aBuf, 100, 150000), SQLITE_OK);
+    CHECK_INT(aBuf[0] == 0x5a && aBuf[99] == 0x5a, 1);
+    ovfl_write_row(db, 1, 4);
+    OVFL_CHECK_ROW(pBlob1, 1, 4);
+    OVFL_CHECK_ROW(pBlob2, 1, 4);
+
+    /* Another connection replaces the chain.  The maps belong to the
+    ** shared b-tree and so outlast the handles, which must be closed to
+    ** release their read locks. */
+    sqlite3_blob_close(pBlob1);
+    sqlite3_blob_close(pBlob2);
+    db2 = open_db("regress.db");
+    EXEC_SQL(db2, OVFL_RESET OVFL_SETUP);
+    ovfl_write_row(db2, 1, 7);
+    ovfl_chain(db2, zChain);
+    pBlob1 = ovfl_open_blob(db);
+    OVFL_CHECK_ROW(pBlob1, 1, 7);
+    sqlite3_blob_close(pBlob1);
+    EXEC_SQL(db2, OVFL_REWRITE);
+    ovfl_write_row(db2, 1, 8);
+    OVFL_CHECK_MOVED(db2, zChain);
+    sqlite3_close(db2);
+    pBlob1 = ovfl_open_blob(db);
+    pBlob2 = ovfl_open_blob(db);
+    OVFL_CHECK_ROW(pBlob1, 1, 8);
+    OVFL_CHECK_ROW(pBlob2, 1, 8);
+    sqlite3_blob_close(pBlob1);
+    sqlite3_blob_close(pBlob2);
+
+    CHECK_SQL(db, "PRAGMA integrity_check", "ok");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+#ifdef SQLITE_ENABLE_BTREE_KEYCACHE
+/*
+ * Look up every probe row in table k by rowid, by index kb and by the
+ * prefix-compressed index kp, with equality and range seeks, and compare
+ * the results with scans that do not seek.  Each query runs twice, so
+ * that the key caches of the pages it visits are built and then used.
+ */
+static void check_keycache_seeks(sqlite3 *db)
+{
+    static const char *azSql[] = {
+        "SELECT count(*), total(k.p) FROM probe JOIN k ON k.a=probe.x",
+        "SELECT total((SELECT min(a) FROM k WHERE a>=x)),"
+        " total((SELECT max(a) FROM k WHERE a<x)) FROM probe",
+        "SELECT count(*), total(k.a) FROM probe JOIN k ON k.b=probe.y",
+        "SELECT total((SELECT min(b) FROM k WHERE b>y)),"
+        " total((SELECT max(b) FROM k WHERE b<=y)) FROM probe",
+        "SELECT count(*), total(k.a) FROM probe JOIN k ON k.p=probe.z",
+        "SELECT total((SELECT min(p) FROM k WHERE p>z)),"
+        " total((SELECT max(p) FROM k WHERE p<z)) FROM probe",
+    };
+    static const char *azRef[] = {
+        "SELECT count(*), total(k.p) FROM probe JOIN k ON k.a+0=probe.x",
+        "SELECT total((SELECT min(a) FROM k WHERE a+0>=x)),"
+        " total((SELECT max(a) FROM k WHERE a+0<x)) FROM probe",
+        "SELECT count(*), total(k.a) FROM probe JOIN k ON +k.b=probe.y",
+        "SELECT total((SELECT min(b) FROM k WHERE +b>y)),"
+        " total((SELECT max(b) FROM k WHERE +b<=y)) FROM probe",
+        "SELECT count(*), total(k.a) FROM probe JOIN k ON +k.p=probe.z",
+        "SELECT total((SELECT min(p) FROM k WHERE +p>z)),"
+        " total((SELECT max(p) FROM k WHERE +p<z)) FROM probe",
+    };
+    int i;
+
+    for (i = 0; i < (int)(sizeof(azSql) / sizeof(azSql[0])); i++)
+    {
+        CHECK_SAME(db, azSql[i], azRef[i]);
+        CHECK_SAME(db, azSql[i], azRef[i]);
+    }
+}
+
+/*
+ * Seeks on pages whose key caches have been built must find the same
+ * cells after rows are inserted into or deleted from those pages, on
+ * table pages, on index pages and on prefix-compressed index pages.
+ */
+static void test_btree_keycache(void)
+{
+    sqlite3 *db;
+    int i;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "PRAGMA page_size=4096; PRAGMA automatic_index=OFF;"
+        "CREATE TABLE k(a INTEGER PRIMARY KEY, b INTEGER, p INTEGER);"
+        "CREATE INDEX kb ON k(b);"
+        "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<3000)"
+        "INSERT INTO k SELECT i*10, (i*37)%1000-500, 1000000+i*3 FROM s;"
+        "CREATE TABLE probe(x, y, z);"
+        "WITH s(i) AS (SELECT 0 UNION ALL SELECT i+1 FROM s WHERE i<250)"
+        "INSERT INTO probe SELECT i*121, i*9-1100, 1000000+i*37 FROM s;");
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+    CHECK_SQL(db, "PRAGMA prefix_compression=ON", "1");
+#endif
+    EXEC_SQL(db, "CREATE INDEX kp ON k(p);");
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+    CHECK_INT(header_byte("regress.db", 19), 3);
+#endif
+    check_keycache_seeks(db);
+
+    /* Rows added between and around the existing keys of each page */
+    EXEC_SQL(db, "INSERT INTO k SELECT a+5, b+1, p+1 FROM k WHERE a%70=0;"
+        "INSERT INTO k VALUES(-7, -9999, 5), (999999, 9999, 2000000);");
+    check_keycache_seeks(db);
+
+    /* Rows removed, including some of those the caches sampled */
+    EXEC_SQL(db, "DELETE FROM k WHERE a%3=0 OR a BETWEEN 10000 AND 10400;");
+    check_keycache_seeks(db);
+
+    /* Inserts and deletes interleaved with seeks in one transaction,
+    ** some of which land on pages already searched in that transaction */
+    EXEC_SQL(db, "BEGIN");
+    for (i = 0; i < 10; i++)
+    {
+        char *zSql = sqlite3_mprintf(
+            "INSERT OR IGNORE INTO k VALUES(%d, %d, %d);"
+            "DELETE FROM k WHERE a=%d;"
+            "UPDATE k SET b=b+%d, p=p-1 WHERE a BETWEEN %d AND %d;",
+            i * 2987 + 3, i * 14 - 60, 1000000 + i * 877,
+            i * 2990, i % 3, i * 2800, i * 2800 + 60);
+
+        EXEC_SQL(db, zSql);
+        sqlite3_free(zSql);
+        CHECK_SAME(db,
+            "SELECT count(*), total(k.p) FROM probe JOIN k ON k.a=probe.x",
+            "SELECT count(*), total(k.p) FROM probe JOIN k ON k.a+0=probe.x");
+        CHECK_SAME(db,
+            "SELECT count(*), total(k.a) FROM probe JOIN k ON k.b=probe.y",
+            "SELECT count(*), total(k.a) FROM probe JOIN k ON +k.b=probe.y");
+        CHECK_SAME(db,
+            "SELECT count(*), total(k.a) FROM probe JOIN k ON k.p=probe.z",
+            "SELECT count(*), total(k.a) FROM probe JOIN k ON +k.p=probe.z");
+    }
+    EXEC_SQL(db, "COMMIT");
+    check_keycache_seeks(db);
+
+    /* Text values in the indexed columns make the pages that hold them
+    ** unusable for the key caches */
+    EXEC_SQL(db, "UPDATE k SET b='x'||b, p='y'||p WHERE a%50=0;");
+    check_keycache_seeks(db);
+
+    CHECK_SQL(db, "PRAGMA integrity_check", "ok");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+#ifdef SQLITE_ENABLE_HEADER_CACHE
+/*
+ * Find the first copy of the n bytes aFind[] in file zName and overwrite
+ * byte iOff of it with c.  Return non-zero if a copy was found.
+ */
+static int patch_file(const char *zName, const unsigned char *aFind, int n, int iOff, unsigned char c)
+{
+    FILE *f = fopen(zName, "r+b");
+    unsigned char aBuf[65536];
+    size_t nBuf;
+    size_t i;
+    int bFound = 0;
+
+    if (f == NULL)
+    {
+        return 0;
+    }
+    nBuf = fread(aBuf, 1, sizeof(aBuf), f);
+    for (i = 0; !bFound && i + n <= nBuf; i++)
+    {
+        if (memcmp(&aBuf[i], aFind, n) == 0)
+        {
+            fseek(f, (long)(i + iOff), SEEK_SET);
+            fputc(c, f);
+            bFound = 1;
+        }
+    }
+    fclose(f);
+    return bFound;
+}
+
+/*
+ * OP_Column reuses the header decode of the previous row when the next
+ * row has the same header.  Check rows whose headers change partway
+ * through a scan, headers too long to be saved, reads of fields that the
+ * eight-at-a-time decode has already passed, and reads through the pseudo
+ * cursors that return sorter output.  The expected results come from a
+ * build without the header cache.
+ */
+static void test_header_cache(void)
+{
+    static const unsigned char aRow2[] = { 0x03, 0x01, 0x13, 0x42, 'Q', 'Z', 'Q' };
+    sqlite3 *db;
+    char *zSql;
+    int i;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+
+    /* In h, column c needs a larger integer type from row 33 onwards and
+    ** column d is NULL or a blob on a few rows */
+    EXEC_SQL(db, "CREATE TABLE h(a, b, c, d);"
+        "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<300)"
+        "INSERT INTO h SELECT 100+i%50, 'txt'||(i%10), i*1000,"
+        "  CASE WHEN i%37=0 THEN NULL WHEN i%53=0 THEN x'0102' ELSE 1.5 END"
+        "  FROM s;");
+    CHECK_SQL(db, "SELECT sum(a*rowid), sum(unicode(substr(b,4))*rowid),"
+        " sum(c), count(d), total(d), sum(length(d)*rowid) FROM h",
+        "5676300|2371500|45150000|292|430.5|130659");
+    CHECK_SQL(db, "SELECT b, sum(c), count(d), total(d), max(a) FROM h"
+        " GROUP BY b",
+        "txt0|4650000|30|45.0|140 txt1|4380000|29|43.5|141 "
+        "txt2|4410000|29|42.0|142 txt3|4440000|30|43.5|143 "
+        "txt4|4470000|29|43.5|144 txt5|4500000|29|42.0|145 "
+        "txt6|4530000|29|42.0|146 txt7|4560000|29|43.5|147 "
+        "txt8|4590000|29|43.5|148 txt9|4620000|29|42.0|149");
+    CHECK_SQL(db, "SELECT a, b, c, d FROM h ORDER BY d, c DESC LIMIT 4",
+        "146|txt6|296000|NULL 109|txt9|259000|NULL "
+        "122|txt2|222000|NULL 135|txt5|185000|NULL");
+
+    /* Forty small integers per row, so that the header is decoded eight
+    ** fields at a time, except where c12 holds text long enough to need
+    ** a two-byte serial type or c20 is NULL.  A cursor that reads only
+    ** the first few columns is sized for them alone, so the 41-byte
+    ** header is too long for its header cache. */
+    zSql = sqlite3_mprintf("CREATE TABLE w(c0");
+    for (i = 1; i < 40; i++)
+    {
+        zSql = sqlite3_mprintf("%z, c%d", zSql, i);
+    }
+    zSql = sqlite3_mprintf("%z);"
+        "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<200)"
+        "INSERT INTO w SELECT (i*1)%%90+2", zSql);
+    for (i = 1; i < 40; i++)
+    {
+        if (i == 12)
+        {
+            zSql = sqlite3_mprintf("%z, CASE WHEN i%%23=0 THEN"
+                " printf('%%070d', i) ELSE (i*13)%%90+2 END", zSql);
+        }
+        else if (i == 20)
+        {
+            zSql = sqlite3_mprintf("%z, CASE WHEN i%%17=0 THEN NULL"
+                " ELSE (i*21)%%90+2 END", zSql);
+        }
+        else
+        {
+            zSql = sqlite3_mprintf("%z, (i*%d)%%90+2", zSql, i + 1);
+        }
+    }
+    zSql = sqlite3_mprintf("%z FROM s;", zSql);
+    EXEC_SQL(db, zSql);
+    sqlite3_free(zSql);
+    CHECK_SQL(db, "SELECT sum(c0*rowid) FROM w", "919250");
+    CHECK_SQL(db, "SELECT sum(c5*rowid), total(length(c12)*rowid) FROM w",
+        "874350|94831.0");
+    CHECK_SQL(db, "SELECT sum(c2*rowid), sum(c1), sum(c9*rowid), sum(c0),"
+        " sum(c17*rowid), count(c20), sum(c39*rowid), total(length(c12))"
+        " FROM w",
+        "903450|8740|839510|8620|763800|189|845600|926.0");
+    CHECK_SQL(db, "SELECT c2, c1, c9, c0, c17, c20, c39, length(c12) FROM w"
+        " WHERE rowid IN (1, 17, 23, 34, 46, 200)",
+        "5|4|12|3|20|23|42|2 53|36|82|19|38|NULL|52|2 "
+        "71|48|52|25|56|35|22|70 14|70|72|36|74|NULL|12|2 "
+        "50|4|12|48|20|68|42|70 62|42|22|22|2|62|82|2");
+
+    /* Neighbouring serial types in m differ, so reading c first must not
+    ** take the type of the last field decoded.  a, b and c change type
+    ** from row to row without changing the size of the payload, so only
+    ** the header, down to its last byte, tells the rows apart. */
+    EXEC_SQL(db, "CREATE TABLE m(k, b, c, d, e, f, g, a);"
+        "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<40)"
+        "INSERT INTO m SELECT 'k'||(i%4),"
+        "  CASE WHEN i%3=0 THEN 'ab' ELSE x'6162' END,"
+        "  CASE WHEN i%5=0 THEN NULL ELSE 0 END, 7, 2.5, 300, x'00', i%2"
+        "  FROM s;");
+    CHECK_SQL(db, "SELECT sum(typeof(c)='null'), sum(typeof(b)='text'),"
+        " sum(a), count(DISTINCT k) FROM m", "8|13|20|4");
+    CHECK_SQL(db, "SELECT group_concat(typeof(c) || a || typeof(b) || k, ',')"
+        " FROM m WHERE rowid BETWEEN 4 AND 10",
+        "integer0blobk0,null1blobk1,integer0textk2,integer1blobk3,"
+        "integer0blobk0,integer1textk1,null0blobk2");
+
+    /* A row whose header matches the one before it, but whose payload is
+    ** a byte longer than that header describes, is corrupt.  Its header
+    ** is patched in the file to make it match. */
+    EXEC_SQL(db, "CREATE TABLE r(a, b);"
+        "INSERT INTO r VALUES(66, 'QZ'), (66, 'QZQ');");
+    sqlite3_close(db);
+    CHECK_INT(patch_file("regress.db", aRow2, sizeof(aRow2), 2, 0x11), 1);
+    db = open_db("regress.db");
+    CHECK_SQL(db, "SELECT a FROM r", "66 66");
+    CHECK_SQL(db, "SELECT b FROM r", "ERR: database disk image is malformed");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+/*
+ * Rows of a WITHOUT VARINT table read back as they were written, at the
+ * limits of each column width, with NULLs, through an index and from
+ * records too large for one page.  Values that do not fit are refused
+ * without changing the table.
+ */
+static void test_fixed_record(void)
+{
+    sqlite3 *db;
+    char *zSql;
+    int i;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "CREATE TABLE f(id INTEGER PRIMARY KEY, a TINYINT,"
+        "  b SMALLINT, c INT, d BIGINT, e INT1) WITHOUT VARINT;"
+        "INSERT INTO f VALUES(1, -128, -32768, -2147483648,"
+        "  -9223372036854775808, 0);"
+        "INSERT INTO f VALUES(2, 127, 32767, 2147483647,"
+        "  9223372036854775807, -1);"
+        "INSERT INTO f VALUES(3, NULL, '12', 3.0, NULL, '-7');"
+        "INSERT INTO f(id, c) VALUES(4, 65536);");
+    CHECK_SQL(db, "SELECT * FROM f",
+        "1|-128|-32768|-2147483648|-9223372036854775808|0 "
+        "2|127|32767|2147483647|9223372036854775807|-1 "
+        "3|NULL|12|3|NULL|-7 4|NULL|NULL|65536|NULL|NULL");
+    CHECK_SQL(db, "SELECT typeof(a), typeof(b), typeof(c), typeof(d)"
+        " FROM f WHERE id=3", "null|integer|integer|null");
+
+    /* Values that are not integers or do not fit their column */
+    CHECK_SQL(db, "INSERT INTO f(id, a) VALUES(5, 128)",
+        "ERR: integer 128 out of range for TINYINT column f.a");
+    CHECK_SQL(db, "INSERT INTO f(id, b) VALUES(5, -32769)",
+        "ERR: integer -32769 out of range for SMALLINT column f.b");
+    CHECK_SQL(db, "INSERT INTO f(id, c) VALUES(5, 2147483648)",
+        "ERR: integer 2147483648 out of range for INT column f.c");
+    CHECK_SQL(db, "INSERT INTO f(id, a) VALUES(5, 'x')",
+        "ERR: cannot store TEXT value in TINYINT column f.a");
+    CHECK_SQL(db, "INSERT INTO f(id, d) VALUES(5, 1.5)",
+        "ERR: cannot store REAL value in BIGINT column f.d");
+    CHECK_SQL(db, "INSERT INTO f(id, e) VALUES(5, x'01')",
+        "ERR: cannot store BLOB value in INT1 column f.e");
+    CHECK_SQL(db, "UPDATE f SET a=a+1",
+        "ERR: integer 128 out of range for TINYINT column f.a");
+    CHECK_SQL(db, "SELECT count(*), sum(a), sum(e) FROM f", "4|-1|-8");
+
+    /* Updates, deletes and an index */
+    EXEC_SQL(db, "CREATE INDEX fc ON f(c);"
+        "UPDATE f SET a=a-1 WHERE id=2;"
+        "UPDATE f SET c=c/2 WHERE id<3;"
+        "UPDATE f SET e=NULL, b=b*100 WHERE id=3;"
+        "DELETE FROM f WHERE id=4;");
+    CHECK_SQL(db, "SELECT * FROM f",
+        "1|-128|-32768|-1073741824|-9223372036854775808|0 "
+        "2|126|32767|1073741823|9223372036854775807|-1 "
+        "3|NULL|1200|3|NULL|NULL");
+    CHECK_SQL(db, "SELECT id, d FROM f WHERE c>0 ORDER BY c",
+        "3|NULL 2|9223372036854775807");
+    CHECK_SQL(db, "PRAGMA integrity_check", "ok");
+
+    /* Copies between tables of the same and of other layouts */
+    EXEC_SQL(db, "CREATE TABLE f2(id INTEGER PRIMARY KEY, a TINYINT,"
+        "  b SMALLINT, c INT, d BIGINT, e INT1) WITHOUT VARINT;"
+        "CREATE TABLE f3(id INTEGER PRIMARY KEY, a BIGINT,"
+        "  b BIGINT, c BIGINT, d BIGINT, e BIGINT) WITHOUT VARINT;"
+        "CREATE TABLE v(id INTEGER PRIMARY KEY, a, b, c, d, e);"
+        "INSERT INTO f2 SELECT * FROM f;"
+        "INSERT INTO f3 SELECT * FROM f2;"
+        "INSERT INTO v SELECT * FROM f3;");
+    CHECK_SAME(db, "SELECT * FROM f2", "SELECT * FROM f");
+    CHECK_SAME(db, "SELECT * FROM f3", "SELECT * FROM f");
+    CHECK_SAME(db, "SELECT * FROM v", "SELECT * FROM f");
+    EXEC_SQL(db, "DELETE FROM f2; INSERT INTO f2 SELECT * FROM v;");
+    CHECK_SAME(db, "SELECT * FROM f2", "SELECT * FROM f");
+    CHECK_SQL(db, "INSERT INTO f2 SELECT id+10, d, b, c, d, e FROM f3",
+        "ERR: integer -9223372036854775808 out of range for TINYINT column f2.a");
+    CHECK_SAME(db, "SELECT * FROM f2", "SELECT * FROM f");
+
+    /* A record of 600 BIGINT columns spills onto overflow pages */
+    zSql = sqlite3_mprintf("CREATE TABLE o(c0 BIGINT");
+    for (i = 1; i < 600; i++)
+    {
+        zSql = sqlite3_mprintf("%z, c%d BIGINT", zSql, i);
+    }
+    zSql = sqlite3_mprintf("%z) WITHOUT VARINT; INSERT INTO o VALUES(1", zSql);
+    for (i = 1; i < 600; i++)
+    {
+        zSql = sqlite3_mprintf(i % 7 ? "%z, %d" : "%z, NULL", zSql, i * 1000003);
+    }
+    zSql = sqlite3_mprintf("%z); INSERT INTO o(c0, c599) VALUES(2, -2);", zSql);
+    EXEC_SQL(db, zSql);
+    sqlite3_free(zSql);
+    CHECK_SQL(db, "SELECT c0, c1, c7, c150, c500, c595, c598, c599 FROM o",
+        "1|1000003|NULL|150000450|500001500|NULL|598001794|599001797 "
+        "2|NULL|NULL|NULL|NULL|NULL|NULL|-2");
+    CHECK_SQL(db, "SELECT sum(c0+c2+c590) FROM o", "592001777");
+
+    /* What the format does not support */
+    CHECK_SQL(db, "CREATE TABLE g(id INTEGER PRIMARY KEY, a TEXT) WITHOUT VARINT",
+        "ERR: column a of WITHOUT VARINT table g is not a fixed-width integer");
+    CHECK_SQL(db, "ALTER TABLE f ADD COLUMN z INT",
+        "ERR: Cannot add a column to a WITHOUT VARINT table");
+    sqlite3_close(db);
+
+    /* The layout is rebuilt from the schema by a new connection */
+    db = open_db("regress.db");
+    CHECK_SAME(db, "SELECT * FROM f2", "SELECT * FROM v");
+    CHECK_SQL(db, "SELECT c150, c599 FROM o WHERE c0=1", "150000450|599001797");
+    CHECK_SQL(db, "PRAGMA integrity_check", "ok");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+
+#ifdef SQLITE_ENABLE_PARTITION
+/*
+ * Rows of a partition table are stored in the partition that covers
+ * their key, including negative keys and keys on a partition boundary,
+ * and rowids and key constraints lead straight to that partition.  The
+ * stray row placed in seg_p5 below is only seen by a scan that visits
+ * partitions a key constraint should have pruned.
+ */
+static void test_partition(void)
+{
+    sqlite3 *db;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "CREATE VIRTUAL TABLE seg USING partition(k, 100,"
+        "  k int, b, INDEX(b));"
+        "INSERT INTO seg VALUES(-150, 'a'), (-101, 'b'), (-100, 'c'),"
+        "  (-1, 'd'), (0, 'e'), (99, 'f'), (100, 'g'), (250, 'h'),"
+        "  (251, 'i');");
+    CHECK_SQL(db, "SELECT name FROM sqlite_master WHERE name LIKE 'seg_p%'"
+        " ORDER BY name",
+        "seg_p-1 seg_p-1_i0 seg_p-2 seg_p-2_i0 seg_p0 seg_p0_i0 "
+        "seg_p1 seg_p1_i0 seg_p2 seg_p2_i0");
+    CHECK_SQL(db, "SELECT group_concat(k) FROM \"seg_p-2\"", "-150,-101");
+    CHECK_SQL(db, "SELECT group_concat(k) FROM \"seg_p-1\"", "-100,-1");
+    CHECK_SQL(db, "SELECT group_concat(k) FROM seg_p0", "0,99");
+    CHECK_SQL(db, "SELECT group_concat(k) FROM seg_p1", "100");
+    CHECK_SQL(db, "SELECT group_concat(k) FROM seg_p2", "250,251");
+
+    /* The rowid is the partition number above the partition table rowid */
+    CHECK_SQL(db, "SELECT rowid, k FROM seg WHERE b IN ('a', 'd', 'e', 'i')",
+        "-8589934591|-150 -4294967294|-1 1|0 8589934594|251");
+    CHECK_SQL(db, "SELECT k, b FROM seg WHERE rowid=8589934594", "251|i");
+    CHECK_SQL(db, "SELECT k, b FROM seg WHERE rowid=-4294967294", "-1|d");
+    CHECK_SQL(db, "SELECT k FROM seg WHERE rowid=4294967298", "");
+    CHECK_SQL(db, "SELECT k FROM seg WHERE rowid='x'", "");
+
+    /* Constraints on k visit only the partitions that can match */
+    EXEC_SQL(db, "CREATE TABLE seg_p5(k int, b);"
+        "INSERT INTO seg_p5 VALUES(0, 'stray');");
+    CHECK_SQL(db, "SELECT count(*) FROM seg WHERE b='stray'", "1");
+    CHECK_SQL(db, "SELECT group_concat(b, '') FROM seg WHERE k=0", "e");
+    CHECK_SQL(db, "SELECT group_concat(b, '') FROM seg WHERE k<100", "abcdef");
+    CHECK_SQL(db, "SELECT group_concat(b, '') FROM seg WHERE k<=100",
+        "abcdefg");
+    CHECK_SQL(db, "SELECT group_concat(b, '') FROM seg"
+        " WHERE k>=-101 AND k<=-100.5", "b");
+    CHECK_SQL(db, "SELECT group_concat(b, '') FROM seg"
+        " WHERE k>-100.5 AND k<0", "cd");
+    CHECK_SQL(db, "SELECT group_concat(b, '') FROM seg WHERE k>99 AND k<=250",
+        "gh");
+    CHECK_SQL(db, "SELECT count(*) FROM seg WHERE k>251", "0");
+    EXEC_SQL(db, "DROP TABLE seg_p5");
+
+    /* An update moves a row to the partition of its new key */
+    EXEC_SQL(db, "UPDATE seg SET b='E' WHERE k=0;"
+        "UPDATE seg SET k=k+200 WHERE k=99;");
+    CHECK_SQL(db, "SELECT rowid, k, b FROM seg WHERE b IN ('E', 'f')",
+        "1|0|E 8589934595|299|f");
+    CHECK_SQL(db, "SELECT group_concat(k) FROM seg_p0", "0");
+    CHECK_SQL(db, "SELECT group_concat(k) FROM seg_p2", "250,251,299");
+    CHECK_SQL(db, "INSERT INTO seg VALUES('x', 'j')",
+        "ERR: partition key seg.k must be an integer");
+    EXEC_SQL(db, "DELETE FROM seg WHERE k=250 OR rowid=-4294967294;");
+    CHECK_SQL(db, "SELECT group_concat(k) FROM seg",
+        "-150,-101,-100,0,100,251,299");
+
+    /* Retention drops a whole partition, and the table moves on rename */
+    EXEC_SQL(db, "DROP TABLE \"seg_p-2\"; ALTER TABLE seg RENAME TO s;");
+    CHECK_SQL(db, "SELECT group_concat(k) FROM s WHERE k<1000",
+        "-100,0,100,251,299");
+    CHECK_SQL(db, "SELECT group_concat(name, ' ') FROM sqlite_master"
+        " WHERE type='table'", "s s_p-1 s_p0 s_p1 s_p2");
+    EXEC_SQL(db, "INSERT INTO s VALUES(-200, 'k')");
+    CHECK_SQL(db, "SELECT group_concat(k) FROM \"s_p-2\"", "-200");
+    EXEC_SQL(db, "DROP TABLE s");
+    CHECK_SQL(db, "SELECT count(*) FROM sqlite_master", "0");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+/*
+ * Full scans of a WITHOUT VARINT table that skip rows inside
+ * OP_FixedFilter find the same rows as the same scans of an ordinary
+ * table, for each comparison, at and beyond the ends of the range of
+ * values, in either direction, as the inner loop of a join and under
+ * UPDATE and DELETE.
+ */
+static void test_fixed_filter(void)
+{
+    static const char *azOp[] = { "=", ">", "<=", "<", ">=" };
+    static const char *azVal[] = { "-101", "-100", "0", "57", "100", "101" };
+    static const char *azQuery[] = {
+        "SELECT count(*), sum(id), sum(e), count(d) FROM %s WHERE c%s%s",
+        "SELECT id, c, d FROM %s WHERE c%s%s ORDER BY id DESC LIMIT 5",
+        "SELECT id, c FROM %s WHERE d=3 AND c%s%s LIMIT 5",
+    };
+    sqlite3 *db;
+    int i, j, k;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "CREATE TABLE f(id INTEGER PRIMARY KEY, c SMALLINT,"
+        "  d TINYINT, e BIGINT) WITHOUT VARINT;"
+        "CREATE TABLE v(id INTEGER PRIMARY KEY, c, d, e);"
+        "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<3000)"
+        "INSERT INTO v SELECT i, CASE WHEN i%11 THEN (i*37)%201-100 END,"
+        "  i%7, i*i FROM s;"
+        "INSERT INTO f SELECT * FROM v;"
+        "CREATE TABLE j(x INTEGER PRIMARY KEY);"
+        "INSERT INTO j VALUES(1), (2), (3), (9);");
+    CHECK_INT(explain_count(db, "SELECT id FROM f WHERE c<0",
+        "FixedFilter", 0), 1);
+    CHECK_INT(explain_count(db, "SELECT id FROM f WHERE c<0 ORDER BY id DESC",
+        "FixedFilter", 0), 1);
+    CHECK_INT(explain_count(db, "SELECT id FROM f WHERE c<0.5",
+        "FixedFilter", 0), 0);
+    CHECK_INT(explain_count(db, "SELECT id FROM f WHERE id<10",
+        "FixedFilter", 0), 0);
+
+    for (i = 0; i < (int)(sizeof(azQuery) / sizeof(azQuery[0])); i++)
+    {
+        for (j = 0; j < (int)(sizeof(azOp) / sizeof(azOp[0])); j++)
+        {
+            for (k = 0; k < (int)(sizeof(azVal) / sizeof(azVal[0])); k++)
+            {
+                char *zSql = sqlite3_mprintf(azQuery[i], "f", azOp[j], azVal[k]);
+                char *zRef = sqlite3_mprintf(azQuery[i], "v", azOp[j], azVal[k]);
+                CHECK_SAME(db, zSql, zRef);
+                sqlite3_free(zSql);
+                sqlite3_free(zRef);
+            }
+        }
+    }
+
+    /* The filtered table is rescanned for each row of the outer loop, and
+    ** a LEFT JOIN still gives its NULL row when every row is skipped */
+    CHECK_SAME(db, "SELECT x, count(*), sum(id) FROM j, f"
+        " WHERE f.d=j.x AND f.c>90 GROUP BY x",
+        "SELECT x, count(*), sum(id) FROM j, v"
+        " WHERE v.d=j.x AND v.c>90 GROUP BY x");
+    CHECK_SAME(db, "SELECT x, count(id), sum(id) FROM j LEFT JOIN f"
+        " ON f.d+0=x AND f.c>90 GROUP BY x",
+        "SELECT x, count(id), sum(id) FROM j LEFT JOIN v"
+        " ON v.d+0=x AND v.c>90 GROUP BY x");
+    CHECK_SQL(db, "SELECT count(*) FROM f WHERE c>100", "0");
+
+    /* Writes through a filtered scan */
+    EXEC_SQL(db, "UPDATE f SET e=-e WHERE c<-50; UPDATE v SET e=-e WHERE c<-50;"
+        "DELETE FROM f WHERE c>=60; DELETE FROM v WHERE c>=60;");
+    CHECK_SAME(db, "SELECT count(*), sum(id), sum(e) FROM f",
+        "SELECT count(*), sum(id), sum(e) FROM v");
+    CHECK_SAME(db, "SELECT count(*), sum(e) FROM f WHERE c<=-50",
+        "SELECT count(*), sum(e) FROM v WHERE c<=-50");
+
+    /* SQLITE_FixedFilter turns the opcode off */
+    sqlite3_test_control(SQLITE_TESTCTRL_OPTIMIZATIONS, db, 0x4000);
+    CHECK_INT(explain_count(db, "SELECT id FROM f WHERE c<0",
+        "FixedFilter", 0), 0);
+    CHECK_SAME(db, "SELECT count(*), sum(e) FROM f WHERE c<=-50",
+        "SELECT count(*), sum(e) FROM v WHERE c<=-50");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+
+/*
+ * Run zSql to completion and return the number of times its filtered
+ * scans moved to another row or page.
+ */
+static int fullscan_steps(sqlite3 *db, const char *zSql)
+{
+    sqlite3_stmt *pStmt = 0;
+    int nStep;
+
+    if (sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0) != SQLITE_OK)
+    {
+        DBG_ERR("cannot prepare %s: %s\n", zSql, sqlite3_errmsg(db));
+        exit(1);
+    }
+    while (sqlite3_step(pStmt) == SQLITE_ROW)
+    {
+    }
+    nStep = sqlite3_stmt_status(pStmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 0);
+    sqlite3_finalize(pStmt);
+    return nStep;
+}
+
+/*
+ * Check, twice, that the rows of z for which zWhere is true are those of
+ * the ordinary table zv.  The first scan may build the page summaries
+ * that the second one uses.
+ */
+static void zone_check(sqlite3 *db, const char *zWhere, int iLine)
+{
+    char *zSql = sqlite3_mprintf("SELECT count(*), sum(id), min(id), max(id)"
+        " FROM z WHERE %s", zWhere);
+    char *zRef = sqlite3_mprintf("SELECT count(*), sum(id), min(id), max(id)"
+        " FROM zv WHERE %s", zWhere);
+
+    check_same(db, zSql, zRef, iLine);
+    check_same(db, zSql, zRef, iLine);
+    sqlite3_free(zSql);
+    sqlite3_free(zRef);
+}
+
+#define ZONE_CHECK(db, where) zone_check(db, where, __LINE__)
+
+/*
+ * Filtered scans of a WITHOUT VARINT table skip leaf pages whose range of
+ * values cannot match, and find the same rows as an ordinary table after
+ * the pages are written, rolled back or changed by another connection.
+ * Column c of z rises with the rowid, so each leaf page holds a narrow
+ * range of its values, and is NULL across several whole pages.
+ */
+static void test_fixed_zone(void)
+{
+    static const char *azWhere[] = {
+        "c=150", "c<3", "c>197", "c<=0", "c>=200", "c>200", "c=80",
+        "c<80", "c>=81", "d=7", "c>90",
+    };
+    sqlite3 *db;
+    sqlite3 *db2;
+    int nFirst, nSecond;
+    int i;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "CREATE TABLE z(id INTEGER PRIMARY KEY, c INT, d SMALLINT)"
+        "  WITHOUT VARINT;"
+        "CREATE TABLE zv(id INTEGER PRIMARY KEY, c, d);"
+        "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<20000)"
+        "INSERT INTO zv SELECT i,"
+        "  CASE WHEN i BETWEEN 8001 AND 9000 THEN NULL ELSE i/100 END, i%50"
+        "  FROM s;"
+        "INSERT INTO z SELECT * FROM zv;");
+
+    /* A repeated scan steps over whole pages instead of over rows */
+    nFirst = fullscan_steps(db, "SELECT count(*) FROM z WHERE c=150");
+    nSecond = fullscan_steps(db, "SELECT count(*) FROM z WHERE c=150");
+    CHECK_INT(nFirst > 19000, 1);
+    CHECK_INT(nSecond * 10 < nFirst, 1);
+    nSecond = fullscan_steps(db,
+        "SELECT id FROM z WHERE c=150 ORDER BY id DESC");
+    CHECK_INT(nSecond * 10 < nFirst, 1);
+    for (i = 0; i < (int)(sizeof(azWhere) / sizeof(azWhere[0])); i++)
+    {
+        ZONE_CHECK(db, azWhere[i]);
+    }
+    CHECK_SAME(db, "SELECT id, c FROM z WHERE c>=195 ORDER BY id DESC LIMIT 3",
+        "SELECT id, c FROM zv WHERE c>=195 ORDER BY id DESC LIMIT 3");
+    CHECK_SAME(db, "SELECT id, c FROM z WHERE c<85 ORDER BY id DESC LIMIT 3",
+        "SELECT id, c FROM zv WHERE c<85 ORDER BY id DESC LIMIT 3");
+
+    /* Pages written after their summaries were built */
+    EXEC_SQL(db, "UPDATE z SET c=1000 WHERE id=5000;"
+        "UPDATE zv SET c=1000 WHERE id=5000;"
+        "UPDATE z SET c=7777 WHERE id=8500;"
+        "UPDATE zv SET c=7777 WHERE id=8500;"
+        "DELETE FROM z WHERE id=15050; DELETE FROM zv WHERE id=15050;"
+        "INSERT INTO z VALUES(20001, -1, 0);"
+        "INSERT INTO zv VALUES(20001, -1, 0);"
+        "DELETE FROM z WHERE id=12345; INSERT INTO z VALUES(12345, -2, 0);"
+        "DELETE FROM zv WHERE id=12345; INSERT INTO zv VALUES(12345, -2, 0);");
+    ZONE_CHECK(db, "c>=1000");
+    ZONE_CHECK(db, "c=7777");
+    ZONE_CHECK(db, "c=150");
+    ZONE_CHECK(db, "c<0");
+
+    /* Summaries built inside a transaction that is rolled back, over
+    ** pages that held only NULLs until the rollback */
+    EXEC_SQL(db, "BEGIN; UPDATE z SET c=NULL WHERE c BETWEEN 110 AND 129;");
+    CHECK_SQL(db, "SELECT count(*) FROM z WHERE c=120", "0");
+    CHECK_SQL(db, "SELECT count(*) FROM z WHERE c=120", "0");
+    EXEC_SQL(db, "ROLLBACK;");
+    ZONE_CHECK(db, "c=120");
+    EXEC_SQL(db, "BEGIN; SAVEPOINT s;"
+        "UPDATE z SET c=NULL WHERE c BETWEEN 130 AND 149;");
+    CHECK_SQL(db, "SELECT count(*) FROM z WHERE c=140", "0");
+    CHECK_SQL(db, "SELECT count(*) FROM z WHERE c=140", "0");
+    EXEC_SQL(db, "ROLLBACK TO s; COMMIT;");
+    ZONE_CHECK(db, "c=140");
+
+    /* Pages changed by another connection */
+    db2 = open_db("regress.db");
+    EXEC_SQL(db2, "UPDATE z SET c=4242 WHERE id=100;"
+        "UPDATE z SET c=4243 WHERE id BETWEEN 8001 AND 8010;");
+    sqlite3_close(db2);
+    EXEC_SQL(db, "UPDATE zv SET c=4242 WHERE id=100;"
+        "UPDATE zv SET c=4243 WHERE id BETWEEN 8001 AND 8010;");
+    ZONE_CHECK(db, "c=4242");
+    ZONE_CHECK(db, "c>4242");
+    CHECK_SQL(db, "PRAGMA integrity_check", "ok");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+
+#ifdef SQLITE_ENABLE_RTREE
+/*
+ * An r-tree built by rtreeload() holds the same entries and answers
+ * queries in the same way as one built by inserting the same rows one at
+ * a time, with fewer nodes.  It may be loaded on top of existing entries,
+ * repacked and then written to as usual, and a load that fails leaves
+ * the table unchanged.
+ */
+static void test_rtree_load(void)
+{
+    static const char *azWindow[] = {
+        "x1>=100 AND x0<=200 AND y1>=100 AND y0<=200",
+        "x0>=500 AND x1<=900",
+        "y1<50",
+        "x1>=0 AND x0<=1000 AND y1>=999.5",
+        "x0=x1",
+    };
+    sqlite3 *db;
+    char *zSql;
+    char *zRef;
+    int i, j;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    EXEC_SQL(db, "CREATE TABLE src(id INTEGER PRIMARY KEY, x0, x1, y0, y1);"
+        "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<3000)"
+        "INSERT INTO src SELECT i, (i*7919)%1000, (i*7919)%1000 + (i%13),"
+        "  (i*104729)%1000 + 0.3, (i*104729)%1000 + 0.3 + (i%7)*1.7 FROM s;"
+        "CREATE VIRTUAL TABLE r1 USING rtree(id, x0, x1, y0, y1);"
+        "CREATE VIRTUAL TABLE r2 USING rtree(id, x0, x1, y0, y1);"
+        "CREATE VIRTUAL TABLE r3 USING rtree(id, x0, x1, y0, y1);"
+        "INSERT INTO r1 SELECT * FROM src;"
+        "INSERT INTO r3 SELECT * FROM src WHERE id%2;");
+    CHECK_SQL(db, "SELECT rtreeload('r2', 'SELECT * FROM src')", "3000");
+    CHECK_SQL(db, "SELECT rtreeload('main', 'r3',"
+        " 'SELECT * FROM src WHERE id%2=0')", "3000");
+    CHECK_SQL(db, "SELECT rtreecheck('r2'), rtreecheck('r3')", "ok|ok");
+    CHECK_SQL(db, "SELECT (SELECT count(*) FROM r2_node)*4"
+        " < (SELECT count(*) FROM r1_node)*3", "1");
+
+    /* The same entries, found by the same queries */
+    for (i = 2; i <= 3; i++)
+    {
+        zSql = sqlite3_mprintf("SELECT count(*), sum(id), total(x0+x1+y0+y1)"
+            " FROM r%d", i);
+        CHECK_SAME(db, zSql, "SELECT count(*), sum(id), total(x0+x1+y0+y1)"
+            " FROM r1");
+        sqlite3_free(zSql);
+        zSql = sqlite3_mprintf("SELECT count(*) FROM r%d a, r1 b"
+            " WHERE a.id=b.id AND (a.x0, a.x1, a.y0, a.y1)"
+            " = (b.x0, b.x1, b.y0, b.y1)", i);
+        CHECK_SQL(db, zSql, "3000");
+        sqlite3_free(zSql);
+        for (j = 0; j < (int)(sizeof(azWindow) / sizeof(azWindow[0])); j++)
+        {
+            zSql = sqlite3_mprintf("SELECT count(*), sum(id) FROM r%d"
+                " WHERE %s", i, azWindow[j]);
+            zRef = sqlite3_mprintf("SELECT count(*), sum(id) FROM r1"
+                " WHERE %s", azWindow[j]);
+            CHECK_SAME(db, zSql, zRef);
+            sqlite3_free(zSql);
+            sqlite3_free(zRef);
+        }
+    }
+
+    /* Failed loads leave the table as it was */
+    CHECK_SQL(db, "SELECT rtreeload('r2', 'SELECT 3000, 1, 2, 3, 4')",
+        "ERR: UNIQUE constraint failed: r2.id");
+    CHECK_SQL(db, "SELECT rtreeload('r2', 'SELECT 4000, 1, 2, 3, 4"
+        " UNION ALL SELECT 4000, 5, 6, 7, 8')",
+        "ERR: UNIQUE constraint failed: r2.id");
+    CHECK_SQL(db, "SELECT rtreeload('r2', 'SELECT 4000, 2, 1, 3, 4')",
+        "ERR: rtree constraint failed: r2.(x0<=x1)");
+    CHECK_SQL(db, "SELECT rtreeload('r2', 'SELECT 4000, 1, 2')",
+        "ERR: rtreeload: query must return 5 columns");
+    CHECK_SQL(db, "SELECT count(*), sum(id), rtreecheck('r2') FROM r2",
+        "3000|4501500|ok");
+
+    /* Rows without an id, a repack and ordinary writes afterwards */
+    CHECK_SQL(db, "SELECT rtreeload('r2', 'SELECT NULL, 1, 2, 3, 4"
+        " UNION ALL SELECT NULL, 5, 6, 7, 8')", "3002");
+    CHECK_SQL(db, "SELECT id FROM r2 WHERE id>3000", "3001 3002");
+    CHECK_SQL(db, "SELECT rtreeload('r1')", "3000");
+    EXEC_SQL(db, "DELETE FROM r2 WHERE id>3000;"
+        "DELETE FROM r1 WHERE id%5=0; DELETE FROM r2 WHERE id%5=0;"
+        "INSERT INTO r1 SELECT id+3000, x0, x1, y0, y1 FROM src WHERE id%3=0;"
+        "INSERT INTO r2 SELECT id+3000, x0, x1, y0, y1 FROM src WHERE id%3=0;");
+    CHECK_SQL(db, "SELECT rtreecheck('r1'), rtreecheck('r2')", "ok|ok");
+    for (j = 0; j < (int)(sizeof(azWindow) / sizeof(azWindow[0])); j++)
+    {
+        zSql = sqlite3_mprintf("SELECT count(*), sum(id) FROM r2 WHERE %s",
+            azWindow[j]);
+        zRef = sqlite3_mprintf("SELECT count(*), sum(id) FROM r1 WHERE %s",
+            azWindow[j]);
+        CHECK_SAME(db, zSql, zRef);
+        sqlite3_free(zSql);
+        sqlite3_free(zRef);
+    }
+
+    /* Integer coordinates, three dimensions and auxiliary columns */
+    EXEC_SQL(db, "CREATE VIRTUAL TABLE i1 USING rtree_i32(id, a0, a1, b0, b1,"
+        "  c0, c1, +tag);"
+        "CREATE VIRTUAL TABLE i2 USING rtree_i32(id, a0, a1, b0, b1,"
+        "  c0, c1, +tag);"
+        "INSERT INTO i1 SELECT id, x0, x1, y0, y1, id%100, id%100+5, 't'||id"
+        "  FROM src;");
+    CHECK_SQL(db, "SELECT rtreeload('i2', 'SELECT id, x0, x1, y0, y1,"
+        " id%100, id%100+5, ''t''||id FROM src')", "3000");
+    CHECK_SQL(db, "SELECT rtreecheck('i2')", "ok");
+    CHECK_SAME(db, "SELECT count(*), sum(id), sum(a0+a1+b0+b1+c0+c1),"
+        " sum(length(tag)) FROM i2",
+        "SELECT count(*), sum(id), sum(a0+a1+b0+b1+c0+c1), sum(length(tag))"
+        " FROM i1");
+    CHECK_SAME(db, "SELECT id, tag FROM i2"
+        " WHERE a0<=100 AND a1>=90 AND c0>=50 AND c1<=60 ORDER BY id",
+        "SELECT id, tag FROM i1"
+        " WHERE a0<=100 AND a1>=90 AND c0>=50 AND c1<=60 ORDER BY id");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+#ifdef SQLITE_ENABLE_RTREE
+/*
+ * Geometry callback for "x MATCH xband(lo, hi)": the box overlaps the
+ * range lo to hi of its first dimension.
+ */
+static int xband_geom(sqlite3_rtree_geometry *p, int nCoord,
+    sqlite3_rtree_dbl *aCoord, int *pRes)
+{
+    if (p->nParam != 2 || nCoord < 2)
+    {
+        return SQLITE_ERROR;
+    }
+    *pRes = aCoord[1] >= p->aParam[0] && aCoord[0] <= p->aParam[1];
+    return SQLITE_OK;
+}
+
+/*
+ * Check that zWhere selects the same rows from r-tree zTab as zRefWhere,
+ * or zWhere if it is NULL, selects from the ordinary table zRefTab.
+ */
+static void rtree_check(sqlite3 *db, const char *zTab, const char *zRefTab,
+    const char *zWhere, const char *zRefWhere, int iLine)
+{
+    char *zSql = sqlite3_mprintf("SELECT count(*), sum(id) FROM %s WHERE %s",
+        zTab, zWhere);
+    char *zRef = sqlite3_mprintf("SELECT count(*), sum(id) FROM %s WHERE %s",
+        zRefTab, zRefWhere ? zRefWhere : zWhere);
+
+    check_same(db, zSql, zRef, iLine);
+    sqlite3_free(zSql);
+    sqlite3_free(zRef);
+}
+
+/*
+ * R-tree scans that test the cells of each node against their simple
+ * constraints in one batch find the same rows as the same constraints
+ * on an ordinary table.  Every operator is used on lower and upper
+ * coordinates, with values that fall exactly on stored coordinates, on
+ * a tree three levels deep, together with a MATCH constraint and with
+ * constraints that change on every pass of a join.  All coordinates are
+ * exact in single precision.
+ */
+static void test_rtree_batch(void)
+{
+    static const char *azCol[] = { "x0", "x1", "y0", "y1" };
+    static const char *azOp[] = { "=", "<", "<=", ">", ">=" };
+    static const char *azVal[] = { "-1", "0", "250.5", "400", "999.5", "2000" };
+    static const char *azMulti[][2] = {
+        { "x0>=100 AND x1<=300 AND y0>50", 0 },
+        { "x1>=400 AND x0<=400 AND y1>=400 AND y0<=400", 0 },
+        { "x0=x1 AND y0<500", 0 },
+        { "x0>1000", 0 },
+        { "x0 MATCH xband(100, 120) AND y1<300",
+          "x1>=100 AND x0<=120 AND y1<300" },
+        { "x0 MATCH xband(100, 120) AND y0>=250.5 AND y0<=600",
+          "x1>=100 AND x0<=120 AND y0>=250.5 AND y0<=600" },
+    };
+    sqlite3 *db;
+    char *zWhere;
+    int i, j, k;
+
+    remove("regress.db");
+    db = open_db("regress.db");
+    CHECK_INT(sqlite3_rtree_geometry_callback(db, "xband", xband_geom, 0),
+        SQLITE_OK);
+    EXEC_SQL(db, "CREATE TABLE src(id INTEGER PRIMARY KEY, x0, x1, y0, y1);"
+        "WITH s(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM s WHERE i<4000)"
+        "INSERT INTO src SELECT i, ((i*7919)%2000)/2.0,"
+        "  ((i*7919)%2000)/2.0 + (i%9)/2.0, ((i*104729)%2000)/2.0,"
+        "  ((i*104729)%2000)/2.0 + (i%5)*10.5 FROM s;"
+        "CREATE VIRTUAL TABLE r USING rtree(id, x0, x1, y0, y1);"
+        "INSERT INTO r SELECT * FROM src;"
+        "CREATE TABLE isrc(id INTEGER PRIMARY KEY, a0, a1);"
+        "INSERT INTO isrc SELECT id, (id*31)%1000, (id*31)%1000 + id%17"
+        "  FROM src;"
+        "CREATE VIRTUAL TABLE ir USING rtree_i32(id, a0, a1);"
+        "INSERT INTO ir SELECT * FROM isrc;"
+        "CREATE TABLE q(v);"
+        "INSERT INTO q VALUES(0), (17.5), (250.5), (400), (999.5), (1200);");
+    CHECK_SQL(db, "SELECT rtreedepth(data) FROM r_node WHERE nodeno=1", "2");
+
+    for (i = 0; i < (int)(sizeof(azCol) / sizeof(azCol[0])); i++)
+    {
+        for (j = 0; j < (int)(sizeof(azOp) / sizeof(azOp[0])); j++)
+        {
+            for (k = 0; k < (int)(sizeof(azVal) / sizeof(azVal[0])); k++)
+            {
+                zWhere = sqlite3_mprintf("%s%s%s", azCol[i], azOp[j], azVal[k]);
+                rtree_check(db, "r", "src", zWhere, 0, __LINE__);
+                sqlite3_free(zWhere);
+            }
+            zWhere = sqlite3_mprintf("a%d%s%d", i % 2, azOp[j], 100 * i + 13);
+            rtree_check(db, "ir", "isrc", zWhere, 0, __LINE__);
+            sqlite3_free(zWhere);
+        }
+    }
+    for (i = 0; i < (int)(sizeof(azMulti) / sizeof(azMulti[0])); i++)
+    {
+        rtree_check(db, "r", "src", azMulti[i][0], azMulti[i][1], __LINE__);
+    }
+
+    /* New constraint values for each row of q */
+    CHECK_SAME(db, "SELECT v, count(*), sum(id) FROM q, r"
+        " WHERE r.x0<=v AND r.x1>=v AND r.y0<v GROUP BY v",
+        "SELECT v, count(*), sum(id) FROM q, src"
+        " WHERE src.x0<=v AND src.x1>=v AND src.y0<v GROUP BY v");
+
+    /* After writes that split and shrink nodes */
+    EXEC_SQL(db, "DELETE FROM r WHERE id%3=0; DELETE FROM src WHERE id%3=0;"
+        "INSERT INTO r SELECT id+4000, y0, y1, x0, x1 FROM src WHERE id%4=0;"
+        "INSERT INTO src SELECT id+4000, y0, y1, x0, x1 FROM src"
+        "  WHERE id%4=0;");
+    for (i = 0; i < (int)(sizeof(azMulti) / sizeof(azMulti[0])); i++)
+    {
+        rtree_check(db, "r", "src", azMulti[i][0], azMulti[i][1], __LINE__);
+    }
+    CHECK_SQL(db, "SELECT rtreecheck('r')", "ok");
+    sqlite3_close(db);
+    remove("regress.db");
+}
+#endif
+
+#ifdef __linux__
+/*
+ * A pwritev() for the unix VFS that counts calls and can be told to write
+ * only the first buffer and half of the second (1) or nothing at all (2).
+ */
+static sqlite3_syscall_ptr pRealPwritev;
+static int eTestPwritev;
+static int nTestPwritev;
+static int mxTestPwritevIov;
+
+static ssize_t test_pwritev(int fd, const struct iovec *aIov, int nIov, off_t iOff)
+{
+    ssize_t (*xReal)(int, const struct iovec *, int, off_t) =
+        (ssize_t (*)(int, const struct iovec *, int, off_t))pRealPwritev;
+    struct iovec aShort[2];
+
+    nTestPwritev++;
+    if (nIov > mxTestPwritevIov)
+    {
+        mxTestPwritevIov = nIov;
+    }
+    if (eTestPwritev == 2)
+    {
+        return 0;
+    }
+    if (eTestPwritev == 1 && nIov > 1)
+    {
+        aShort[0] = aIov[0];
+        aShort[1] = aIov[1];
+        aShort[1].iov_len /= 2;
+        return xReal(fd, aShort, 2, iOff);
+    }
+    return xReal(fd, aIov, nIov, iOff);
+}
+#endif
+
+/*
+ * Write runs of adjacent dirty pages through xWritev, through the xWrite
+ * fallback of a version 4 VFS without one, and through pwritev() calls
+ * that write less than asked.
+ */
+static void test_writev(void)
+{
+    sqlite3 *db;
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    const char *zCheck =
+        "SELECT count(*), sum(substr(x, 1, 1)!='0'), sum(length(x)) FROM t;"
+        "PRAGMA integrity_check;";
+#ifdef __linux__
+    sqlite3_vfs *pUnix = sqlite3_vfs_find("unix");
+#endif
+
+    shim_register();
+    remove("regress.db");
+    remove("regress.db-journal");
+    shim_vfs.eWritev = 1;
+    if (sqlite3_open_v2("regress.db", &db, flags, "shim") != SQLITE_OK)
+    {
+        DBG_ERR("cannot open regress.db: %s\n", sqlite3_errmsg(db));
+        exit(1);
+    }
+
+    /* A bulk load leaves over a thousand adjacent dirty pages, written in
+     * runs of PAGER_WRITEV_MAX pages */
+    shim_vfs.nWrite = shim_vfs.nWritev = 0;
+    shim_vfs.nWritevBuf = shim_vfs.mxWritevBuf = 0;
+    EXEC_SQL(db, "PRAGMA page_size=1024; PRAGMA cache_size=4000;"
+        "CREATE TABLE t(x);"
+        "WITH c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<1200)"
+        "INSERT INTO t SELECT printf('%0800d', i) FROM c;");
+    CHECK_SQL(db, zCheck, "1200|0|960000 ok");
+    CHECK_INT(shim_vfs.mxWritevBuf, 64);
+    CHECK_INT(shim_vfs.nWritevBuf + shim_vfs.nWrite >= 1200, 1);
+    CHECK_INT(shim_vfs.nWritevBuf > 1100, 1);
+    CHECK_INT(shim_vfs.nWritev < shim_vfs.nWritevBuf / 32, 1);
+
+    /* Pages far apart are written one at a time */
+    shim_vfs.nWrite = shim_vfs.nWritev = 0;
+    EXEC_SQL(db, "UPDATE t SET x = 'y' || substr(x, 2)"
+        " WHERE rowid IN (300, 600, 900)");
+    CHECK_INT(shim_vfs.nWritev, 0);
+    CHECK_INT(shim_vfs.nWrite >= 3, 1);
+    CHECK_SQL(db, zCheck, "1200|3|960000 ok");
+    sqlite3_close(db);
+
+    db = open_db("regress.db");
+    CHECK_SQL(db, zCheck, "1200|3|960000 ok");
+    sqlite3_close(db);
+
+    /* A version 4 VFS without xWritev gets one xWrite per page.  Each
+     * update stores new values, as rows set to their old values are not
+     * written */
+    shim_vfs.eWritev = 2;
+    if (sqlite3_open_v2("regress.db", &db, flags, "shim") != SQLITE_OK)
+    {
+        DBG_ERR("cannot open regress.db: %s\n", sqlite3_errmsg(db));
+        exit(1);
+    }
+    shim_vfs.nWrite = shim_vfs.nWritev = 0;
+    EXEC_SQL(db, "PRAGMA cache_size=4000;"
+        "UPDATE t SET x = 'w' || substr(x, 2) WHERE rowid % 2 = 0;");
+    CHECK_INT(shim_vfs.nWritev, 0);
+    CHECK_INT(shim_vfs.nWrite >= 600, 1);
+    CHECK_SQL(db, zCheck, "1200|600|960000 ok");
+    sqlite3_close(db);
+
+    db = open_db("regress.db");
+    CHECK_SQL(db, zCheck, "1200|600|960000 ok");
+    sqlite3_close(db);
+    shim_vfs.eWritev = 0;
+
+#ifdef __linux__
+    pRealPwritev = pUnix->xGetSystemCall(pUnix, "pwritev");
+    if (pRealPwritev)
+    {
+        pUnix->xSetSystemCall(pUnix, "pwritev", (sqlite3_syscall_ptr)test_pwritev);
+
+        /* unixWritev() passes each run to a single pwritev() */
+        db = open_db("regress.db");
+        nTestPwritev = mxTestPwritevIov = 0;
+        EXEC_SQL(db, "PRAGMA cache_size=4000;"
+            "UPDATE t SET x = 'v' || substr(x, 2) WHERE rowid <= 600;");
+        CHECK_INT(nTestPwritev > 0 && nTestPwritev < 100, 1);
+        CHECK_INT(mxTestPwritevIov, 64);
+        CHECK_SQL(db, zCheck, "1200|900|960000 ok");
+
+        /* Short writes are finished by unixWrite() */
+        eTestPwritev = 1;
+        nTestPwritev = 0;
+        EXEC_SQL(db, "UPDATE t SET x = 'u' || substr(x, 2);");
+        CHECK_INT(nTestPwritev > 100, 1);
+        eTestPwritev = 0;
+        CHECK_SQL(db, zCheck, "1200|1200|960000 ok");
+
+        /* A pwritev() that writes nothing reports a full disk and the
+         * transaction is rolled back */
+        eTestPwritev = 2;
+        CHECK_SQL(db, "UPDATE t SET x = 'z' || substr(x, 2);",
+            "ERR: database or disk is full");
+        eTestPwritev = 0;
+        CHECK_SQL(db, "SELECT count(*) FROM t WHERE x LIKE 'z%'", "0");
+        sqlite3_close(db);
+
+        pUnix->xSetSystemCall(pUnix, "pwritev", 0);
+        db = open_db("regress.db");
+        CHECK_SQL(db, zCheck, "1200|1200|960000 ok");
+        sqlite3_close(db);
+    }
+#endif
+    remove("regress.db");
+}
+
+int main(int argc, char **argv)
+{
+    test_cache_policy();
+    test_cache_warmup();
+    test_journal_ioerr();
+    test_hot_journal();
+#ifdef SQLITE_ENABLE_BITMAP
+    test_bitmap();
+#endif
+#ifdef SQLITE_ENABLE_INTERVAL
+    test_interval();
+#endif
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+    test_prefix_compression();
+#endif
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+    test_free_space_map();
+#endif
+#ifdef SQLITE_ENABLE_BLOB_APPEND
+    test_blob_append();
+#endif
+#ifdef SQLITE_ENABLE_RANGE_DELETE
+    test_range_delete();
+#endif
+    test_mmap();
+#if defined(SQLITE_PCACHE_SHARDS) && defined(SQLITE_ENABLE_MEMORY_MANAGEMENT)
+    test_pcache_shards();
+#endif
+#ifdef SQLITE_ENABLE_SUPERINSTRUCTIONS
+    test_superinstructions();
+#endif
+#ifdef SQLITE_ENABLE_COUNTED_BTREE
+    test_counted_btree();
+#endif
+#ifdef SQLITE_ENABLE_FREELIST_INDEX
+    test_freelist_index();
+#endif
+#ifdef SQLITE_ENABLE_OVERFLOW_CACHE
+    test_overflow_cache();
+#endif
+#ifdef SQLITE_ENABLE_BTREE_KEYCACHE
+    test_btree_keycache();
+#endif
+#ifdef SQLITE_ENABLE_HEADER_CACHE
+    test_header_cache();
+#endif
+    test_fixed_record();
+#ifdef SQLITE_ENABLE_PARTITION
+    test_partition();
+#endif
+    test_fixed_filter();
+    test_fixed_zone();
+#ifdef SQLITE_ENABLE_RTREE
+    test_rtree_load();
+    test_rtree_batch();
+#endif
+    test_writev();
+
+    printf("%d checks, %d failures\n", nCheck, nFail);
+    return nFail ? 1 : 0;
+}
@@ -135,6 +135,7 @@ struct fs_file
 static int fsClose(sqlite3_file *);
 static int fsRead(sqlite3_file *, void *, int iAmt, sqlite3_int64 iOfst);
 static int fsWrite(sqlite3_file *, const void *, int iAmt, sqlite3_int64 iOfst);
+static int fsWritev(sqlite3_file *, int nBuf, const void ** apBuf, int iAmt, sqlite3_int64 iOfst);
 static int fsTruncate(sqlite3_file *, sqlite3_int64 size);
 static int fsSync(sqlite3_file *, int flags);
 static int fsFileSize(sqlite3_file *, sqlite3_int64 * pSize);
@@ -144,6 +145,8 @@ static int fsCheckReservedLock(sqlite3_file *, int * pResOut);
 static int fsFileControl(sqlite3_file *, int op, void * pArg);
 static int fsSectorSize(sqlite3_file *);
 static int fsDeviceCharacteristics(sqlite3_file *);
+static int fsFetch(sqlite3_file *, sqlite3_int64 iOfst, int iAmt, void ** pp);
+static int fsUnfetch(sqlite3_file *, sqlite3_int64 iOfst, void * p);
 
 /*
 ** Method declarations for fs_vfs.
@@ -200,7 +203,7 @@ static fs_vfs_t fs_vfs =
 
 static sqlite3_io_methods fs_io_methods =
 {
-    1,                            /* iVersion */
+    4,                            /* iVersion */
     fsClose,                      /* xClose */
     fs_read,                       /* xRead */
     fsWrite,                      /* xWrite */
@@ -216,7 +219,10 @@ static sqlite3_io_methods fs_io_methods =
     0,                            /* xShmMap */
     0,                            /* xShmLock */
     0,                            /* xShmBarrier */
-    0                             /* xShmUnmap */
+    0,                            /* xShmUnmap */
+    fsFetch,                      /* xFetch */
+    fsUnfetch,                    /* xUnfetch */
+    fsWritev                      /* xWritev */
 };
 
 /*
@@ -684,6 +690,49 @@ static int fsWrite(sqlite3_file * pFile, const void * zBuf, int iAmt, sqlite_int
     return rc;
 }
 
+/*
+** Write nBuf buffers of iAmt bytes each to consecutive locations of an
+** fs-file. The database region is stored contiguously in the blob, so a
+** run of database pages is passed to the underlying file as a single
+** multi-sector write. Journal writes are split into blocks by fsWrite().
+*/
+static int fsWritev(sqlite3_file * pFile, int nBuf, const void ** apBuf, int iAmt, sqlite_int64 iOfst)
+{
+    int rc = SQLITE_OK;
+    fs_file * p = (fs_file *)pFile;
+    fs_real_file * pReal = p->pReal;
+    sqlite3_file * pF = pReal->pFile;
+    sqlite_int64 nByte = (sqlite_int64)nBuf * iAmt;
+    int i;
+
+    if (p->eType == DATABASE_FILE
+            && pF->pMethods->iVersion >= 4 && pF->pMethods->xWritev
+       )
+    {
+        if ((nByte + iOfst + BLOCKSIZE) > (pReal->nBlob - pReal->nJournal))
+        {
+            rc = SQLITE_FULL;
+        }
+        else
+        {
+            rc = pF->pMethods->xWritev(pF, nBuf, apBuf, iAmt, iOfst + BLOCKSIZE);
+            if (rc == SQLITE_OK)
+            {
+                pReal->nDatabase = (int)MAX(pReal->nDatabase, nByte + iOfst);
+            }
+        }
+    }
+    else
+    {
+        for (i = 0; rc == SQLITE_OK && i < nBuf; i++)
+        {
+            rc = fsWrite(pFile, apBuf[i], iAmt, iOfst + i * (sqlite_int64)iAmt);
+        }
+    }
+
+    return rc;
+}
+
 /*
 ** Truncate an fs-file.
 */
@@ -796,6 +845,23 @@ static int fsDeviceCharacteristics(sqlite3_file * pFile)
     return 0;
 }
 
+/*
+** Memory mapping is not supported. These methods are only present
+** because xWritev follows them in the version 4 io methods, and the
+** pager calls xFetch whenever iVersion>=3 and mmap_size is set. Returning
+** a NULL pointer makes it read the page with xRead instead.
+*/
+static int fsFetch(sqlite3_file * pFile, sqlite3_int64 iOfst, int iAmt, void ** pp)
+{
+    *pp = 0;
+    return SQLITE_OK;
+}
+
+static int fsUnfetch(sqlite3_file * pFile, sqlite3_int64 iOfst, void * p)
+{
+    return SQLITE_OK;
+}
+
 /*
 ** Delete the file located at zPath. If the dirSync argument is true,
 ** ensure the file-system modifications are synced to disk before
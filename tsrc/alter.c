@@ -756,6 +756,10 @@ void sqlite3AlterBeginAddColumn(Parse *pParse, SrcList *pSrc){
     sqlite3ErrorMsg(pParse, "Cannot add a column to a view");
     goto exit_begin_add_column;
   }
+  if( HasFixedRecord(pTab) ){
+    sqlite3ErrorMsg(pParse, "Cannot add a column to a WITHOUT VARINT table");
+    goto exit_begin_add_column;
+  }
   if( SQLITE_OK!=isSystemTable(pParse, pTab->zName) ){
     goto exit_begin_add_column;
   }
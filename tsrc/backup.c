@@ -402,6 +402,8 @@ int sqlite3_backup_step(sqlite3_backup *p, int nPage){
     ){
       p->bDestLocked = 1;
       sqlite3BtreeGetMeta(p->pDest, BTREE_SCHEMA_VERSION, &p->iDestSchema);
+      sqlite3BtreeClearFreeIndex(p->pDest);
+      sqlite3BtreeClearOverflowCache(p->pDest);
     }
 
     /* Do not allow backup if the destination database is in WAL mode
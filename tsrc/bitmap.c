@@ -0,0 +1,1362 @@
+/*
+** 2026-10-18
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+******************************************************************************
+**
+** This file contains an implementation of the "bitmap" virtual table,
+** a bitmap index on one or more low-cardinality integer columns of an
+** ordinary table.  It is created as follows:
+**
+**    CREATE VIRTUAL TABLE segBitmap USING bitmap(
+**        segTable, channel, devNo, storeType
+**    );
+**
+** For each indexed column and each distinct integer value of that column,
+** the index holds the set of rowids of the rows that have that value.
+** Queries constrain one or more of the indexed columns and receive the
+** matching rowids in the "rid" column:
+**
+**    SELECT * FROM segTable WHERE rowid IN (
+**      SELECT rid FROM segBitmap WHERE channel<16 AND devNo=3
+**    );
+**
+** Range and equality constraints on a single column are answered by
+** OR-ing the bitmaps of the values in the range.  Constraints on several
+** columns are combined by AND-ing the per-column results, so no row of
+** the indexed table is read until the final set of rowids is known.
+**
+** Rowid sets are stored roaring-style.  Rowids are split into chunks of
+** 65536 and each (column, value, chunk) that holds at least one rowid is
+** a row of the shadow table "<name>_data".  A chunk with fewer than 4096
+** rowids is stored as a sorted array of 16-bit big-endian offsets.  A
+** fuller chunk is stored as an 8192 byte bitmap.
+**
+** The index is kept up to date by triggers on the indexed table that are
+** created along with the virtual table.  The triggers write to the hidden
+** column that has the same name as the virtual table:
+**
+**    INSERT INTO segBitmap(segBitmap, rid, channel, devNo, storeType)
+**        VALUES('insert', ...)  or  VALUES('delete', ...);
+**
+** The command 'rebuild' recreates the index from the indexed table.
+** BEFORE triggers also write 'replace' for the rows that REPLACE conflict
+** handling may delete, which does not fire the DELETE trigger.  See
+** bmCreateTriggers() for details.  A UNIQUE index added to the indexed
+** table after the virtual table is created is taken into account by the
+** next 'rebuild'.
+**
+** Only integer values are indexed.  A row whose value in an indexed column
+** is NULL, a real number, text or a blob is never returned by a constraint
+** on that column.  Constraint values are converted using the affinity of
+** the indexed column first, so "channel='5'" finds the rows with 5 in an
+** INTEGER column.
+*/
+
+#include "sqliteInt.h"   /* Requires access to internal data structures */
+#if (defined(SQLITE_ENABLE_BITMAP) || defined(SQLITE_TEST)) \
+    && !defined(SQLITE_OMIT_VIRTUALTABLE)
+
+typedef struct BmTable BmTable;
+typedef struct BmCursor BmCursor;
+typedef struct BmSet BmSet;
+typedef struct BmBuild BmBuild;
+
+/*
+** Chunk geometry.  BM_ARRAY_MAX is the largest number of rowids stored
+** as an array of offsets.  Larger chunks are stored as bitmaps.
+*/
+#define BM_CHUNK_SIZE     65536
+#define BM_CHUNK_BYTES    (BM_CHUNK_SIZE/8)
+#define BM_ARRAY_MAX      4095
+#define BM_CHUNK(R)       (((R) - ((R) & 0xffff)) / BM_CHUNK_SIZE)
+#define BM_OFFSET(R)      ((int)((R) & 0xffff))
+
+struct BmTable {
+  sqlite3_vtab base;              /* Base class.  Must be first */
+  sqlite3 *db;                    /* The database connection */
+  char *zDb;                      /* Schema holding the index */
+  char *zName;                    /* Name of the virtual table */
+  char *zTab;                     /* Name of the indexed table */
+  char **azCol;                   /* Names of the indexed columns */
+  char *aAff;                     /* Affinity of each indexed column */
+  int nCol;                       /* Number of indexed columns */
+  sqlite3_stmt *pRead;            /* Read one chunk */
+  sqlite3_stmt *pWrite;           /* Write one chunk */
+  sqlite3_stmt *pDelete;          /* Delete one chunk */
+  sqlite3_stmt *pLookup;          /* Read indexed columns of a row */
+  sqlite3_stmt *pNextVal;         /* Find the next value of a column */
+  i64 *aiReplace;                 /* Rowids named by 'replace' commands */
+  int nReplace;                   /* Number of entries in aiReplace[] */
+  int nReplaceAlloc;              /* Allocated size of aiReplace[] */
+};
+
+/*
+** A set of rowids as a list of chunk bitmaps in ascending chunk order.
+** The bitmap for aiChunk[i] is BM_CHUNK_BYTES bytes at aBits[i*8192].
+*/
+struct BmSet {
+  int nChunk;                     /* Number of chunks in set */
+  int nAlloc;                     /* Allocated size of aiChunk[] */
+  i64 *aiChunk;                   /* Chunk numbers */
+  u8 *aBits;                      /* Bitmaps for each chunk */
+};
+
+struct BmCursor {
+  sqlite3_vtab_cursor base;       /* Base class.  Must be first */
+  BmSet set;                      /* Rowids matched by the constraints */
+  sqlite3_stmt *pScan;            /* Scan of all rows, if unconstrained */
+  int iChunk;                     /* Current chunk of set */
+  int iBit;                       /* Current bit within chunk */
+  i64 iRowid;                     /* Current rowid */
+  int bEof;                       /* True at EOF */
+};
+
+/*
+** Bitmaps for one indexed column that are being accumulated by a
+** rebuild.  aiVal[] is sorted.
+*/
+struct BmBuild {
+  int nVal;                       /* Number of distinct values seen */
+  int nAlloc;                     /* Allocated size of aiVal[] */
+  i64 *aiVal;                     /* Values */
+  u8 *aBits;                      /* Bitmap for each value */
+};
+
+/*
+** Decode the stored chunk a[] of n bytes into the bitmap aBits[].
+*/
+static int bmDecode(const u8 *a, int n, u8 *aBits){
+  int i;
+  if( n==BM_CHUNK_BYTES ){
+    memcpy(aBits, a, BM_CHUNK_BYTES);
+    return SQLITE_OK;
+  }
+  if( (n&1) || n>BM_ARRAY_MAX*2 ) return SQLITE_CORRUPT_VTAB;
+  memset(aBits, 0, BM_CHUNK_BYTES);
+  for(i=0; i<n; i+=2){
+    int iOff = (a[i]<<8) + a[i+1];
+    aBits[iOff/8] |= (1<<(iOff&7));
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Encode bitmap aBits[] in storage format into aOut[], which must be
+** at least BM_CHUNK_BYTES bytes in size.  Return the number of bytes
+** written, or 0 if the bitmap is empty.
+*/
+static int bmEncode(const u8 *aBits, u8 *aOut){
+  int nSet = 0;
+  int n = 0;
+  int i;
+  for(i=0; i<BM_CHUNK_BYTES; i++){
+    u8 x = aBits[i];
+    while( x ){ nSet++; x &= x-1; }
+  }
+  if( nSet>BM_ARRAY_MAX ){
+    memcpy(aOut, aBits, BM_CHUNK_BYTES);
+    return BM_CHUNK_BYTES;
+  }
+  for(i=0; i<BM_CHUNK_SIZE && n<nSet*2; i++){
+    if( aBits[i/8] & (1<<(i&7)) ){
+      aOut[n++] = (u8)(i>>8);
+      aOut[n++] = (u8)(i&0xff);
+    }
+  }
+  return n;
+}
+
+static void bmSetFree(BmSet *pSet){
+  sqlite3_free(pSet->aiChunk);
+  sqlite3_free(pSet->aBits);
+  memset(pSet, 0, sizeof(BmSet));
+}
+
+/*
+** OR the stored chunk a[] of n bytes into chunk iChunk of pSet.  Chunks
+** must be added in ascending order.
+*/
+static int bmSetAdd(BmSet *pSet, i64 iChunk, const u8 *a, int n){
+  u8 aBits[BM_CHUNK_BYTES];
+  u8 *pDest;
+  int rc;
+  int i;
+  rc = bmDecode(a, n, aBits);
+  if( rc!=SQLITE_OK ) return rc;
+  if( pSet->nChunk==0 || pSet->aiChunk[pSet->nChunk-1]!=iChunk ){
+    assert( pSet->nChunk==0 || pSet->aiChunk[pSet->nChunk-1]<iChunk );
+    if( pSet->nChunk>=pSet->nAlloc ){
+      int nNew = pSet->nAlloc ? pSet->nAlloc*2 : 8;
+      i64 *aiNew;
+      u8 *aNew;
+      aiNew = sqlite3_realloc64(pSet->aiChunk, nNew*sizeof(i64));
+      if( aiNew==0 ) return SQLITE_NOMEM_BKPT;
+      pSet->aiChunk = aiNew;
+      aNew = sqlite3_realloc64(pSet->aBits, (i64)nNew*BM_CHUNK_BYTES);
+      if( aNew==0 ) return SQLITE_NOMEM_BKPT;
+      pSet->aBits = aNew;
+      pSet->nAlloc = nNew;
+    }
+    pSet->aiChunk[pSet->nChunk] = iChunk;
+    memcpy(&pSet->aBits[(i64)pSet->nChunk*BM_CHUNK_BYTES], aBits,
+           BM_CHUNK_BYTES);
+    pSet->nChunk++;
+    return SQLITE_OK;
+  }
+  pDest = &pSet->aBits[(i64)(pSet->nChunk-1)*BM_CHUNK_BYTES];
+  for(i=0; i<BM_CHUNK_BYTES; i++) pDest[i] |= aBits[i];
+  return SQLITE_OK;
+}
+
+/*
+** Replace the contents of pA with the intersection of pA and pB.
+*/
+static void bmSetAnd(BmSet *pA, BmSet *pB){
+  int iA, iB;
+  int nOut = 0;
+  for(iA=iB=0; iA<pA->nChunk && iB<pB->nChunk; ){
+    if( pA->aiChunk[iA]<pB->aiChunk[iB] ){
+      iA++;
+    }else if( pA->aiChunk[iA]>pB->aiChunk[iB] ){
+      iB++;
+    }else{
+      u8 *pOut = &pA->aBits[(i64)nOut*BM_CHUNK_BYTES];
+      const u8 *p1 = &pA->aBits[(i64)iA*BM_CHUNK_BYTES];
+      const u8 *p2 = &pB->aBits[(i64)iB*BM_CHUNK_BYTES];
+      u8 bAny = 0;
+      int i;
+      for(i=0; i<BM_CHUNK_BYTES; i++){
+        pOut[i] = p1[i] & p2[i];
+        bAny |= pOut[i];
+      }
+      if( bAny ) pA->aiChunk[nOut++] = pA->aiChunk[iA];
+      iA++;
+      iB++;
+    }
+  }
+  pA->nChunk = nOut;
+}
+
+/*
+** Run the SQL statement zSql, which is obtained from sqlite3_mprintf(),
+** and free it.
+*/
+static int bmExec(sqlite3 *db, char *zSql){
+  int rc;
+  if( zSql==0 ) return SQLITE_NOMEM_BKPT;
+  rc = sqlite3_exec(db, zSql, 0, 0, 0);
+  sqlite3_free(zSql);
+  return rc;
+}
+
+/*
+** Prepare the SQL statement zSql, which is obtained from sqlite3_mprintf(),
+** into *ppStmt if it is not already prepared, and free zSql.
+*/
+static int bmPrepare(BmTable *pTab, sqlite3_stmt **ppStmt, char *zSql){
+  int rc = SQLITE_OK;
+  if( zSql==0 ) return SQLITE_NOMEM_BKPT;
+  if( *ppStmt==0 ){
+    rc = sqlite3_prepare_v3(pTab->db, zSql, -1, SQLITE_PREPARE_PERSISTENT,
+                            ppStmt, 0);
+  }
+  sqlite3_free(zSql);
+  return rc;
+}
+
+/*
+** Return a comma separated list of the indexed columns, each prefixed
+** by zPrefix.  The list is obtained from sqlite3_malloc().
+*/
+static char *bmColumnList(BmTable *pTab, const char *zPrefix){
+  char *zList = 0;
+  int i;
+  for(i=0; i<pTab->nCol; i++){
+    zList = sqlite3_mprintf("%z%s%s\"%w\"", zList, i ? ", " : "",
+        zPrefix, pTab->azCol[i]
+    );
+    if( zList==0 ) break;
+  }
+  return zList;
+}
+
+/*
+** Finalize all cached statements.
+*/
+static void bmFinalizeAll(BmTable *pTab){
+  sqlite3_finalize(pTab->pRead);
+  sqlite3_finalize(pTab->pWrite);
+  sqlite3_finalize(pTab->pDelete);
+  sqlite3_finalize(pTab->pLookup);
+  sqlite3_finalize(pTab->pNextVal);
+  pTab->pRead = 0;
+  pTab->pWrite = 0;
+  pTab->pDelete = 0;
+  pTab->pLookup = 0;
+  pTab->pNextVal = 0;
+}
+
+static void bmFree(BmTable *pTab){
+  int i;
+  bmFinalizeAll(pTab);
+  for(i=0; i<pTab->nCol; i++) sqlite3_free(pTab->azCol[i]);
+  sqlite3_free(pTab->aiReplace);
+  sqlite3_free(pTab->zTab);
+  sqlite3_free(pTab->zName);
+  sqlite3_free(pTab->zDb);
+  sqlite3_free(pTab);
+}
+
+/*
+** Write chunk iChunk of the bitmap for value iVal of column iCol, or
+** delete it if the bitmap is empty.
+*/
+static int bmWriteChunk(
+  BmTable *pTab,
+  int iCol,
+  i64 iVal,
+  i64 iChunk,
+  const u8 *aBits
+){
+  u8 aOut[BM_CHUNK_BYTES];
+  int n = bmEncode(aBits, aOut);
+  sqlite3_stmt *pStmt;
+  int rc;
+  if( n>0 ){
+    rc = bmPrepare(pTab, &pTab->pWrite, sqlite3_mprintf(
+        "REPLACE INTO \"%w\".\"%w_data\"(col, val, chunk, bits)"
+        " VALUES(?1, ?2, ?3, ?4)", pTab->zDb, pTab->zName
+    ));
+    pStmt = pTab->pWrite;
+    if( rc==SQLITE_OK ) rc = sqlite3_bind_blob(pStmt, 4, aOut, n, SQLITE_STATIC);
+  }else{
+    rc = bmPrepare(pTab, &pTab->pDelete, sqlite3_mprintf(
+        "DELETE FROM \"%w\".\"%w_data\" WHERE col=?1 AND val=?2 AND chunk=?3",
+        pTab->zDb, pTab->zName
+    ));
+    pStmt = pTab->pDelete;
+  }
+  if( rc==SQLITE_OK ){
+    sqlite3_bind_int(pStmt, 1, iCol);
+    sqlite3_bind_int64(pStmt, 2, iVal);
+    sqlite3_bind_int64(pStmt, 3, iChunk);
+    sqlite3_step(pStmt);
+    rc = sqlite3_reset(pStmt);
+  }
+  return rc;
+}
+
+/*
+** Set (if bSet is true) or clear the bit for rowid iRowid in the bitmap
+** for value iVal of column iCol.
+*/
+static int bmUpdateBit(BmTable *pTab, int iCol, i64 iVal, i64 iRowid, int bSet){
+  u8 aBits[BM_CHUNK_BYTES];
+  i64 iChunk = BM_CHUNK(iRowid);
+  int iOff = BM_OFFSET(iRowid);
+  int rc;
+
+  rc = bmPrepare(pTab, &pTab->pRead, sqlite3_mprintf(
+      "SELECT bits FROM \"%w\".\"%w_data\" WHERE col=?1 AND val=?2 AND chunk=?3",
+      pTab->zDb, pTab->zName
+  ));
+  if( rc!=SQLITE_OK ) return rc;
+  sqlite3_bind_int(pTab->pRead, 1, iCol);
+  sqlite3_bind_int64(pTab->pRead, 2, iVal);
+  sqlite3_bind_int64(pTab->pRead, 3, iChunk);
+  if( sqlite3_step(pTab->pRead)==SQLITE_ROW ){
+    rc = bmDecode(sqlite3_column_blob(pTab->pRead, 0),
+                  sqlite3_column_bytes(pTab->pRead, 0), aBits);
+  }else{
+    memset(aBits, 0, BM_CHUNK_BYTES);
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3_reset(pTab->pRead);
+  }else{
+    sqlite3_reset(pTab->pRead);
+  }
+  if( rc!=SQLITE_OK ) return rc;
+  if( bSet ){
+    if( aBits[iOff/8] & (1<<(iOff&7)) ) return SQLITE_OK;
+    aBits[iOff/8] |= (1<<(iOff&7));
+  }else{
+    if( (aBits[iOff/8] & (1<<(iOff&7)))==0 ) return SQLITE_OK;
+    aBits[iOff/8] &= ~(1<<(iOff&7));
+  }
+  return bmWriteChunk(pTab, iCol, iVal, iChunk, aBits);
+}
+
+/*
+** Clear the bit for rowid iRowid in the bitmaps of every value of every
+** indexed column.  This is used when the values the row had are not
+** known.  Each distinct value costs two seeks on the shadow table.
+*/
+static int bmClearRowid(BmTable *pTab, i64 iRowid){
+  int rc;
+  int i;
+  rc = bmPrepare(pTab, &pTab->pNextVal, sqlite3_mprintf(
+      "SELECT val FROM \"%w\".\"%w_data\" WHERE col=?1 AND val>=?2"
+      " ORDER BY val LIMIT 1", pTab->zDb, pTab->zName
+  ));
+  for(i=0; rc==SQLITE_OK && i<pTab->nCol; i++){
+    i64 iVal = SMALLEST_INT64;
+    while( rc==SQLITE_OK ){
+      int bFound;
+      sqlite3_bind_int(pTab->pNextVal, 1, i);
+      sqlite3_bind_int64(pTab->pNextVal, 2, iVal);
+      bFound = sqlite3_step(pTab->pNextVal)==SQLITE_ROW;
+      if( bFound ) iVal = sqlite3_column_int64(pTab->pNextVal, 0);
+      rc = sqlite3_reset(pTab->pNextVal);
+      if( rc!=SQLITE_OK || !bFound ) break;
+      rc = bmUpdateBit(pTab, i, iVal, iRowid, 0);
+      if( iVal==LARGEST_INT64 ) break;
+      iVal++;
+    }
+  }
+  return rc;
+}
+
+/*
+** Prepare pTab->pLookup, which reads the indexed columns of the row of
+** the indexed table with rowid ?1, if it is not already prepared.
+*/
+static int bmPrepareLookup(BmTable *pTab){
+  int rc = SQLITE_OK;
+  if( pTab->pLookup==0 ){
+    char *zCols = bmColumnList(pTab, "");
+    rc = bmPrepare(pTab, &pTab->pLookup, sqlite3_mprintf(
+        "SELECT %s FROM \"%w\".\"%w\" WHERE rowid=?1",
+        zCols, pTab->zDb, pTab->zTab
+    ));
+    sqlite3_free(zCols);
+  }
+  return rc;
+}
+
+/*
+** Called when the row with rowid iRowid has been written.  Clear each
+** rowid named by a 'replace' command since the last 'replace' with a NULL
+** rid that is either iRowid or no longer in the indexed table, and forget
+** them all.  See bmCreateTriggers().
+*/
+static int bmFlushReplace(BmTable *pTab, i64 iRowid){
+  int rc = SQLITE_OK;
+  int i;
+  for(i=0; rc==SQLITE_OK && i<pTab->nReplace; i++){
+    i64 iOld = pTab->aiReplace[i];
+    if( iOld!=iRowid ){
+      int bExists;
+      rc = bmPrepareLookup(pTab);
+      if( rc!=SQLITE_OK ) break;
+      sqlite3_bind_int64(pTab->pLookup, 1, iOld);
+      bExists = sqlite3_step(pTab->pLookup)==SQLITE_ROW;
+      rc = sqlite3_reset(pTab->pLookup);
+      if( rc!=SQLITE_OK || bExists ) continue;
+    }
+    rc = bmClearRowid(pTab, iOld);
+  }
+  pTab->nReplace = 0;
+  return rc;
+}
+
+/*
+** Return a pointer to the bitmap for value iVal in pBuild, adding an
+** empty bitmap if there is none.  Return NULL if out of memory.
+*/
+static u8 *bmBuildFind(BmBuild *pBuild, i64 iVal){
+  int iLo = 0;
+  int iHi = pBuild->nVal;
+  while( iLo<iHi ){
+    int iMid = (iLo+iHi)/2;
+    if( pBuild->aiVal[iMid]==iVal ){
+      return &pBuild->aBits[(i64)iMid*BM_CHUNK_BYTES];
+    }
+    if( pBuild->aiVal[iMid]<iVal ){
+      iLo = iMid+1;
+    }else{
+      iHi = iMid;
+    }
+  }
+  if( pBuild->nVal>=pBuild->nAlloc ){
+    int nNew = pBuild->nAlloc ? pBuild->nAlloc*2 : 16;
+    i64 *aiNew;
+    u8 *aNew;
+    aiNew = sqlite3_realloc64(pBuild->aiVal, nNew*sizeof(i64));
+    if( aiNew==0 ) return 0;
+    pBuild->aiVal = aiNew;
+    aNew = sqlite3_realloc64(pBuild->aBits, (i64)nNew*BM_CHUNK_BYTES);
+    if( aNew==0 ) return 0;
+    pBuild->aBits = aNew;
+    pBuild->nAlloc = nNew;
+  }
+  memmove(&pBuild->aiVal[iLo+1], &pBuild->aiVal[iLo],
+          (pBuild->nVal-iLo)*sizeof(i64));
+  memmove(&pBuild->aBits[(i64)(iLo+1)*BM_CHUNK_BYTES],
+          &pBuild->aBits[(i64)iLo*BM_CHUNK_BYTES],
+          (i64)(pBuild->nVal-iLo)*BM_CHUNK_BYTES);
+  pBuild->aiVal[iLo] = iVal;
+  pBuild->nVal++;
+  memset(&pBuild->aBits[(i64)iLo*BM_CHUNK_BYTES], 0, BM_CHUNK_BYTES);
+  return &pBuild->aBits[(i64)iLo*BM_CHUNK_BYTES];
+}
+
+/*
+** Recreate the contents of the index from the indexed table.  Rowids are
+** visited in order, so the bitmaps for one chunk of each column are
+** accumulated in memory and written out once the scan leaves the chunk.
+*/
+static int bmRebuild(BmTable *pTab){
+  sqlite3_stmt *pStmt = 0;
+  BmBuild *aBuild;
+  char *zCols;
+  i64 iChunk = 0;
+  int bChunk = 0;
+  int rc;
+  int i, j;
+
+  rc = bmExec(pTab->db, sqlite3_mprintf("DELETE FROM \"%w\".\"%w_data\"",
+      pTab->zDb, pTab->zName
+  ));
+  if( rc!=SQLITE_OK ) return rc;
+  aBuild = (BmBuild*)sqlite3_malloc64(pTab->nCol*sizeof(BmBuild));
+  zCols = bmColumnList(pTab, "");
+  if( aBuild==0 || zCols==0 ){
+    sqlite3_free(aBuild);
+    sqlite3_free(zCols);
+    return SQLITE_NOMEM_BKPT;
+  }
+  memset(aBuild, 0, pTab->nCol*sizeof(BmBuild));
+  rc = bmPrepare(pTab, &pStmt, sqlite3_mprintf(
+      "SELECT rowid, %s FROM \"%w\".\"%w\" ORDER BY rowid",
+      zCols, pTab->zDb, pTab->zTab
+  ));
+  sqlite3_free(zCols);
+
+  while( rc==SQLITE_OK ){
+    int bRow = sqlite3_step(pStmt)==SQLITE_ROW;
+    i64 iRowid = bRow ? sqlite3_column_int64(pStmt, 0) : 0;
+
+    /* Flush the bitmaps at the end of each chunk */
+    if( bChunk && (!bRow || BM_CHUNK(iRowid)!=iChunk) ){
+      for(i=0; rc==SQLITE_OK && i<pTab->nCol; i++){
+        BmBuild *p = &aBuild[i];
+        for(j=0; rc==SQLITE_OK && j<p->nVal; j++){
+          u8 *aBits = &p->aBits[(i64)j*BM_CHUNK_BYTES];
+          rc = bmWriteChunk(pTab, i, p->aiVal[j], iChunk, aBits);
+          memset(aBits, 0, BM_CHUNK_BYTES);
+        }
+      }
+    }
+    if( !bRow || rc!=SQLITE_OK ) break;
+
+    iChunk = BM_CHUNK(iRowid);
+    bChunk = 1;
+    for(i=0; i<pTab->nCol; i++){
+      if( sqlite3_column_type(pStmt, i+1)==SQLITE_INTEGER ){
+        u8 *aBits = bmBuildFind(&aBuild[i], sqlite3_column_int64(pStmt, i+1));
+        int iOff = BM_OFFSET(iRowid);
+        if( aBits==0 ){
+          rc = SQLITE_NOMEM_BKPT;
+          break;
+        }
+        aBits[iOff/8] |= (1<<(iOff&7));
+      }
+    }
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3_finalize(pStmt);
+  }else{
+    sqlite3_finalize(pStmt);
+  }
+  for(i=0; i<pTab->nCol; i++){
+    sqlite3_free(aBuild[i].aiVal);
+    sqlite3_free(aBuild[i].aBits);
+  }
+  sqlite3_free(aBuild);
+  return rc;
+}
+
+/*
+** Set *pzWhere to an expression that is true for the existing rows of
+** the indexed table that have the same values as the "new" row in the
+** columns of one of its UNIQUE indexes, and *pzChanged to a list of
+** " OR old.x IS NOT new.x" terms for the columns of those indexes.  Both
+** are obtained from sqlite3_malloc() and are empty strings if there are
+** no UNIQUE indexes.  A UNIQUE index on an expression is an error.
+*/
+static int bmUniqueTerms(
+  BmTable *pTab,
+  char **pzWhere,
+  char **pzChanged,
+  char **pzErr
+){
+  sqlite3_stmt *pStmt = 0;
+  char *zWhere = sqlite3_mprintf("");
+  char *zChanged = sqlite3_mprintf("");
+  char *zIdx = 0;
+  int rc = SQLITE_OK;
+  int rc2;
+
+  if( zWhere==0 || zChanged==0 ) rc = SQLITE_NOMEM_BKPT;
+  if( rc==SQLITE_OK ) rc = bmPrepare(pTab, &pStmt, sqlite3_mprintf(
+      "SELECT il.name, ii.name, ii.coll"
+      "  FROM pragma_index_list(%Q, %Q) AS il,"
+      "       pragma_index_xinfo(il.name, %Q) AS ii"
+      " WHERE il.\"unique\" AND ii.key ORDER BY il.seq, ii.seqno",
+      pTab->zTab, pTab->zDb, pTab->zDb
+  ));
+  while( rc==SQLITE_OK && sqlite3_step(pStmt)==SQLITE_ROW ){
+    const char *zName = (const char*)sqlite3_column_text(pStmt, 0);
+    const char *zCol = (const char*)sqlite3_column_text(pStmt, 1);
+    const char *zColl = (const char*)sqlite3_column_text(pStmt, 2);
+    const char *zSep = " AND ";
+    if( zCol==0 ){
+      *pzErr = sqlite3_mprintf(
+          "bitmap: UNIQUE index %s is on an expression", zName
+      );
+      rc = SQLITE_ERROR;
+      break;
+    }
+    if( zIdx==0 || sqlite3_stricmp(zIdx, zName)!=0 ){
+      zSep = zWhere[0] ? ") OR (" : " OR (";
+      sqlite3_free(zIdx);
+      zIdx = sqlite3_mprintf("%s", zName);
+    }
+    zWhere = sqlite3_mprintf("%z%s\"%w\"=new.\"%w\" COLLATE \"%w\"",
+        zWhere, zSep, zCol, zCol, zColl ? zColl : "BINARY"
+    );
+    zChanged = sqlite3_mprintf("%z OR old.\"%w\" IS NOT new.\"%w\"",
+        zChanged, zCol, zCol
+    );
+    if( zIdx==0 || zWhere==0 || zChanged==0 ) rc = SQLITE_NOMEM_BKPT;
+  }
+  rc2 = sqlite3_finalize(pStmt);
+  if( rc==SQLITE_OK ) rc = rc2;
+  if( rc==SQLITE_OK && zWhere[0] ){
+    zWhere = sqlite3_mprintf("%z)", zWhere);
+    if( zWhere==0 ) rc = SQLITE_NOMEM_BKPT;
+  }
+  sqlite3_free(zIdx);
+  if( rc!=SQLITE_OK ){
+    sqlite3_free(zWhere);
+    sqlite3_free(zChanged);
+    zWhere = zChanged = 0;
+  }
+  *pzWhere = zWhere;
+  *pzChanged = zChanged;
+  return rc;
+}
+
+/*
+** Create the triggers that maintain the index.
+**
+** A row that an INSERT or UPDATE deletes under REPLACE conflict handling
+** does not fire the DELETE trigger unless recursive_triggers is on.  The
+** conflict may be on the rowid or on any UNIQUE index of the indexed
+** table.  So before each row is written, the _bi and _bu triggers send a
+** 'replace' command with a NULL rid, which forgets earlier candidates,
+** and then 'replace' with the rowid of each row that has the same rowid
+** or the same values in the columns of a UNIQUE index as the new row.
+** These are only candidates, as the new row may yet be IGNOREd or a
+** partial index may not hold the new row.  The 'insert' command sent by
+** the AFTER trigger once the row is written removes from the index each
+** candidate that has the new row's rowid or no longer exists.
+**
+** The UNIQUE indexes are read when the triggers are created, which is
+** when the virtual table is created and on each 'rebuild'.
+*/
+static int bmCreateTriggers(BmTable *pTab, char **pzErr){
+  char *zCols = bmColumnList(pTab, "");
+  char *zNew = bmColumnList(pTab, "new.");
+  char *zOld = bmColumnList(pTab, "old.");
+  char *zChanged = 0;
+  char *zUnique = 0;
+  char *zUniqueChanged = 0;
+  int rc;
+  int i;
+
+  rc = bmUniqueTerms(pTab, &zUnique, &zUniqueChanged, pzErr);
+  for(i=0; rc==SQLITE_OK && i<pTab->nCol; i++){
+    zChanged = sqlite3_mprintf("%z OR old.\"%w\" IS NOT new.\"%w\"",
+        zChanged, pTab->azCol[i], pTab->azCol[i]
+    );
+  }
+  if( rc==SQLITE_OK && (zCols==0 || zNew==0 || zOld==0 || zChanged==0) ){
+    rc = SQLITE_NOMEM_BKPT;
+  }
+  if( rc==SQLITE_OK ){
+    rc = bmExec(pTab->db, sqlite3_mprintf(
+        "CREATE TRIGGER \"%w\".\"%w_bi\" BEFORE INSERT ON \"%w\" BEGIN"
+        "  INSERT INTO \"%w\"(\"%w\") VALUES('replace');"
+        "  INSERT INTO \"%w\"(\"%w\", rid)"
+        "    SELECT 'replace', rowid FROM \"%w\" WHERE rowid=new.rowid%s;"
+        "END;"
+        "CREATE TRIGGER \"%w\".\"%w_bu\" BEFORE UPDATE ON \"%w\""
+        "  WHEN old.rowid IS NOT new.rowid%s BEGIN"
+        "  INSERT INTO \"%w\"(\"%w\") VALUES('replace');"
+        "  INSERT INTO \"%w\"(\"%w\", rid)"
+        "    SELECT 'replace', rowid FROM \"%w\""
+        "     WHERE (rowid=new.rowid%s) AND rowid<>old.rowid;"
+        "END;"
+        "CREATE TRIGGER \"%w\".\"%w_ai\" AFTER INSERT ON \"%w\" BEGIN"
+        "  INSERT INTO \"%w\"(\"%w\", rid, %s)"
+        "    VALUES('insert', new.rowid, %s);"
+        "END;"
+        "CREATE TRIGGER \"%w\".\"%w_ad\" AFTER DELETE ON \"%w\" BEGIN"
+        "  INSERT INTO \"%w\"(\"%w\", rid, %s)"
+        "    VALUES('delete', old.rowid, %s);"
+        "END;"
+        "CREATE TRIGGER \"%w\".\"%w_au\" AFTER UPDATE ON \"%w\""
+        "  WHEN old.rowid IS NOT new.rowid%s%s BEGIN"
+        "  INSERT INTO \"%w\"(\"%w\", rid, %s)"
+        "    VALUES('delete', old.rowid, %s);"
+        "  INSERT INTO \"%w\"(\"%w\", rid, %s)"
+        "    VALUES('insert', new.rowid, %s);"
+        "END;",
+        pTab->zDb, pTab->zName, pTab->zTab,
+        pTab->zName, pTab->zName,
+        pTab->zName, pTab->zName, pTab->zTab, zUnique,
+        pTab->zDb, pTab->zName, pTab->zTab, zUniqueChanged,
+        pTab->zName, pTab->zName,
+        pTab->zName, pTab->zName, pTab->zTab, zUnique,
+        pTab->zDb, pTab->zName, pTab->zTab,
+        pTab->zName, pTab->zName, zCols, zNew,
+        pTab->zDb, pTab->zName, pTab->zTab,
+        pTab->zName, pTab->zName, zCols, zOld,
+        pTab->zDb, pTab->zName, pTab->zTab, zChanged, zUniqueChanged,
+        pTab->zName, pTab->zName, zCols, zOld,
+        pTab->zName, pTab->zName, zCols, zNew
+    ));
+  }
+  sqlite3_free(zCols);
+  sqlite3_free(zNew);
+  sqlite3_free(zOld);
+  sqlite3_free(zChanged);
+  sqlite3_free(zUnique);
+  sqlite3_free(zUniqueChanged);
+  return rc;
+}
+
+/*
+** Drop the triggers that maintain the index.
+*/
+static int bmDropTriggers(BmTable *pTab){
+  return bmExec(pTab->db, sqlite3_mprintf(
+      "DROP TRIGGER IF EXISTS \"%w\".\"%w_bi\";"
+      "DROP TRIGGER IF EXISTS \"%w\".\"%w_bu\";"
+      "DROP TRIGGER IF EXISTS \"%w\".\"%w_ai\";"
+      "DROP TRIGGER IF EXISTS \"%w\".\"%w_ad\";"
+      "DROP TRIGGER IF EXISTS \"%w\".\"%w_au\";",
+      pTab->zDb, pTab->zName, pTab->zDb, pTab->zName,
+      pTab->zDb, pTab->zName, pTab->zDb, pTab->zName, pTab->zDb, pTab->zName
+  ));
+}
+
+/*
+** Connect to or create a bitmap virtual table.
+*/
+static int bmInit(
+  sqlite3 *db,
+  int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab,
+  char **pzErr,
+  int isCreate
+){
+  BmTable *pTab;
+  sqlite3_stmt *pStmt = 0;
+  char *zSql;
+  int rc = SQLITE_OK;
+  int i;
+
+  if( argc<5 ){
+    *pzErr = sqlite3_mprintf("bitmap: expected table and column names");
+    return SQLITE_ERROR;
+  }
+  pTab = (BmTable*)sqlite3_malloc64(
+      sizeof(BmTable) + (argc-4)*(sizeof(char*)+1)
+  );
+  if( pTab==0 ) return SQLITE_NOMEM_BKPT;
+  memset(pTab, 0, sizeof(BmTable));
+  pTab->db = db;
+  pTab->azCol = (char**)&pTab[1];
+  pTab->aAff = (char*)&pTab->azCol[argc-4];
+  pTab->zDb = sqlite3_mprintf("%s", argv[1]);
+  pTab->zName = sqlite3_mprintf("%s", argv[2]);
+  pTab->zTab = sqlite3_mprintf("%s", argv[3]);
+  if( pTab->zDb==0 || pTab->zName==0 || pTab->zTab==0 ){
+    rc = SQLITE_NOMEM_BKPT;
+  }else{
+    sqlite3Dequote(pTab->zTab);
+  }
+  for(i=4; rc==SQLITE_OK && i<argc; i++){
+    pTab->azCol[pTab->nCol] = sqlite3_mprintf("%s", argv[i]);
+    if( pTab->azCol[pTab->nCol]==0 ){
+      rc = SQLITE_NOMEM_BKPT;
+    }else{
+      sqlite3Dequote(pTab->azCol[pTab->nCol++]);
+    }
+  }
+
+  /* Check that the indexed table and columns exist and find the
+  ** affinity of each column, which is applied to constraint values */
+  if( rc==SQLITE_OK ){
+    char *zCols = bmColumnList(pTab, "");
+    rc = bmPrepare(pTab, &pStmt, sqlite3_mprintf(
+        "SELECT %s FROM \"%w\".\"%w\"", zCols, pTab->zDb, pTab->zTab
+    ));
+    sqlite3_free(zCols);
+    if( rc==SQLITE_ERROR ){
+      *pzErr = sqlite3_mprintf("bitmap: %s", sqlite3_errmsg(db));
+    }
+    for(i=0; rc==SQLITE_OK && i<pTab->nCol; i++){
+      const char *zType = sqlite3_column_decltype(pStmt, i);
+      pTab->aAff[i] = zType ? sqlite3AffinityType(zType, 0) : SQLITE_AFF_BLOB;
+    }
+    sqlite3_finalize(pStmt);
+  }
+
+  if( rc==SQLITE_OK ){
+    zSql = sqlite3_mprintf("CREATE TABLE x(rid");
+    for(i=0; i<pTab->nCol; i++){
+      zSql = sqlite3_mprintf("%z, \"%w\" HIDDEN", zSql, pTab->azCol[i]);
+    }
+    zSql = sqlite3_mprintf("%z, \"%w\" HIDDEN)", zSql, pTab->zName);
+    if( zSql==0 ){
+      rc = SQLITE_NOMEM_BKPT;
+    }else{
+      rc = sqlite3_declare_vtab(db, zSql);
+      sqlite3_free(zSql);
+    }
+  }
+
+  if( rc==SQLITE_OK && isCreate ){
+    rc = bmExec(db, sqlite3_mprintf(
+        "CREATE TABLE \"%w\".\"%w_data\"("
+        "col INTEGER, val INTEGER, chunk INTEGER, bits BLOB,"
+        "PRIMARY KEY(col, val, chunk)) WITHOUT ROWID",
+        pTab->zDb, pTab->zName
+    ));
+    if( rc==SQLITE_OK ) rc = bmRebuild(pTab);
+    if( rc==SQLITE_OK ) rc = bmCreateTriggers(pTab, pzErr);
+    if( rc!=SQLITE_OK && *pzErr==0 ){
+      *pzErr = sqlite3_mprintf("bitmap: %s", sqlite3_errmsg(db));
+    }
+  }
+
+  if( rc!=SQLITE_OK ){
+    bmFree(pTab);
+    pTab = 0;
+  }
+  *ppVtab = (sqlite3_vtab*)pTab;
+  return rc;
+}
+
+static int bmCreate(
+  sqlite3 *db,
+  void *pAux,
+  int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab,
+  char **pzErr
+){
+  return bmInit(db, argc, argv, ppVtab, pzErr, 1);
+}
+
+static int bmConnect(
+  sqlite3 *db,
+  void *pAux,
+  int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab,
+  char **pzErr
+){
+  return bmInit(db, argc, argv, ppVtab, pzErr, 0);
+}
+
+static int bmDisconnect(sqlite3_vtab *pVtab){
+  bmFree((BmTable*)pVtab);
+  return SQLITE_OK;
+}
+
+static int bmDestroy(sqlite3_vtab *pVtab){
+  BmTable *pTab = (BmTable*)pVtab;
+  int rc;
+  bmFinalizeAll(pTab);
+  rc = bmDropTriggers(pTab);
+  if( rc==SQLITE_OK ){
+    rc = bmExec(pTab->db, sqlite3_mprintf("DROP TABLE \"%w\".\"%w_data\"",
+        pTab->zDb, pTab->zName
+    ));
+  }
+  if( rc==SQLITE_OK ) bmFree(pTab);
+  return rc;
+}
+
+/*
+** Constraint operators used by bmBestIndex() and bmFilter().
+*/
+static const struct {
+  unsigned char eOp;              /* SQLITE_INDEX_CONSTRAINT_* value */
+  char cOp;                       /* Code used in idxStr */
+} aBmOp[] = {
+  { SQLITE_INDEX_CONSTRAINT_EQ, '=' },
+  { SQLITE_INDEX_CONSTRAINT_GT, '>' },
+  { SQLITE_INDEX_CONSTRAINT_LE, 'l' },
+  { SQLITE_INDEX_CONSTRAINT_LT, '<' },
+  { SQLITE_INDEX_CONSTRAINT_GE, 'g' },
+};
+
+/*
+** Every usable comparison against an indexed column is handled by
+** xFilter.  idxStr holds one "<op><column>," entry for each of them.
+** Without any such constraint the plan scans the whole indexed table.
+** Either way rows are returned in rowid order.
+*/
+static int bmBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *pIdxInfo){
+  BmTable *pTab = (BmTable*)pVtab;
+  char *zPlan = 0;
+  double rCost = 1000000.0;
+  int nArg = 0;
+  int i, j;
+
+  for(i=0; i<pIdxInfo->nConstraint; i++){
+    struct sqlite3_index_constraint *p = &pIdxInfo->aConstraint[i];
+    if( p->usable==0 || p->iColumn<1 || p->iColumn>pTab->nCol ) continue;
+    for(j=0; j<ArraySize(aBmOp) && aBmOp[j].eOp!=p->op; j++){}
+    if( j==ArraySize(aBmOp) ) continue;
+    rCost /= (p->op==SQLITE_INDEX_CONSTRAINT_EQ) ? 20.0 : 4.0;
+    zPlan = sqlite3_mprintf("%z%c%d,", zPlan, aBmOp[j].cOp, p->iColumn);
+    if( zPlan==0 ) return SQLITE_NOMEM_BKPT;
+    pIdxInfo->aConstraintUsage[i].argvIndex = ++nArg;
+    pIdxInfo->aConstraintUsage[i].omit = 1;
+  }
+  if( nArg==0 ) rCost = 1e12;
+  pIdxInfo->idxNum = nArg;
+  pIdxInfo->idxStr = zPlan;
+  pIdxInfo->needToFreeIdxStr = 1;
+  pIdxInfo->estimatedCost = rCost;
+  pIdxInfo->estimatedRows = (sqlite3_int64)rCost;
+  if( pIdxInfo->nOrderBy==1
+   && pIdxInfo->aOrderBy[0].iColumn==0
+   && pIdxInfo->aOrderBy[0].desc==0
+  ){
+    pIdxInfo->orderByConsumed = 1;
+  }
+  return SQLITE_OK;
+}
+
+static int bmOpen(sqlite3_vtab *pVTab, sqlite3_vtab_cursor **ppCursor){
+  BmCursor *pCsr;
+  pCsr = (BmCursor*)sqlite3_malloc64(sizeof(BmCursor));
+  if( pCsr==0 ) return SQLITE_NOMEM_BKPT;
+  memset(pCsr, 0, sizeof(BmCursor));
+  pCsr->base.pVtab = pVTab;
+  pCsr->bEof = 1;
+  *ppCursor = (sqlite3_vtab_cursor*)pCsr;
+  return SQLITE_OK;
+}
+
+static void bmResetCursor(BmCursor *pCsr){
+  sqlite3_finalize(pCsr->pScan);
+  pCsr->pScan = 0;
+  bmSetFree(&pCsr->set);
+  pCsr->bEof = 1;
+}
+
+static int bmClose(sqlite3_vtab_cursor *pCursor){
+  BmCursor *pCsr = (BmCursor*)pCursor;
+  bmResetCursor(pCsr);
+  sqlite3_free(pCsr);
+  return SQLITE_OK;
+}
+
+/*
+** Move the cursor to the first rowid in the set at or after bit iBit of
+** chunk iChunk.
+*/
+static void bmSeekSet(BmCursor *pCsr){
+  BmSet *pSet = &pCsr->set;
+  while( pCsr->iChunk<pSet->nChunk ){
+    const u8 *aBits = &pSet->aBits[(i64)pCsr->iChunk*BM_CHUNK_BYTES];
+    while( pCsr->iBit<BM_CHUNK_SIZE ){
+      if( aBits[pCsr->iBit/8]==0 ){
+        pCsr->iBit = (pCsr->iBit|7)+1;
+      }else if( aBits[pCsr->iBit/8] & (1<<(pCsr->iBit&7)) ){
+        pCsr->iRowid = pSet->aiChunk[pCsr->iChunk]*BM_CHUNK_SIZE + pCsr->iBit;
+        return;
+      }else{
+        pCsr->iBit++;
+      }
+    }
+    pCsr->iChunk++;
+    pCsr->iBit = 0;
+  }
+  pCsr->bEof = 1;
+}
+
+/*
+** Narrow the range [*piLo,*piHi] of integer values so that only values
+** that satisfy "x <op> pVal" remain.
+*/
+static void bmNarrow(char cOp, sqlite3_value *pVal, i64 *piLo, i64 *piHi){
+  int eType = sqlite3_value_type(pVal);
+  int bEmpty = 0;
+  i64 iLo = SMALLEST_INT64;
+  i64 iHi = LARGEST_INT64;
+  if( eType==SQLITE_INTEGER ){
+    i64 iVal = sqlite3_value_int64(pVal);
+    switch( cOp ){
+      case '=': iLo = iHi = iVal;                         break;
+      case '>': bEmpty = (iVal==LARGEST_INT64); iLo = iVal+!bEmpty;  break;
+      case 'g': iLo = iVal;                               break;
+      case '<': bEmpty = (iVal==SMALLEST_INT64); iHi = iVal-!bEmpty; break;
+      default:  iHi = iVal;                               break;
+    }
+  }else if( eType==SQLITE_FLOAT ){
+    double r = sqlite3_value_double(pVal);
+    if( r>=9223372036854775808.0 ){
+      /* Every integer is less than r */
+      bEmpty = (cOp=='=' || cOp=='>' || cOp=='g');
+    }else if( r<-9223372036854775808.0 ){
+      /* Every integer is greater than r */
+      bEmpty = (cOp=='=' || cOp=='<' || cOp=='l');
+    }else{
+      i64 iFloor = (i64)r;
+      int bExact;
+      if( r<(double)iFloor ) iFloor--;
+      bExact = (r==(double)iFloor);
+      switch( cOp ){
+        case '=': bEmpty = !bExact; iLo = iHi = iFloor;   break;
+        case '>': iLo = iFloor+1;                         break;
+        case 'g': iLo = iFloor+!bExact;                   break;
+        case '<': bEmpty = (bExact && iFloor==SMALLEST_INT64);
+                  iHi = iFloor-(bExact && !bEmpty);
+                  break;
+        default:  iHi = iFloor;                           break;
+      }
+    }
+  }else{
+    /* A comparison with NULL is never true.  Integers are less than
+    ** any text or blob value. */
+    bEmpty = (eType==SQLITE_NULL || cOp=='=' || cOp=='>' || cOp=='g');
+  }
+  if( bEmpty ){
+    iLo = 1;
+    iHi = 0;
+  }
+  if( iLo>*piLo ) *piLo = iLo;
+  if( iHi<*piHi ) *piHi = iHi;
+}
+
+/*
+** Load into pSet the rowids with values between iLo and iHi in column
+** iCol.
+*/
+static int bmLoadRange(BmTable *pTab, int iCol, i64 iLo, i64 iHi, BmSet *pSet){
+  sqlite3_stmt *pStmt = 0;
+  int rc;
+  rc = bmPrepare(pTab, &pStmt, sqlite3_mprintf(
+      "SELECT chunk, bits FROM \"%w\".\"%w_data\""
+      " WHERE col=?1 AND val BETWEEN ?2 AND ?3 ORDER BY chunk",
+      pTab->zDb, pTab->zName
+  ));
+  if( rc!=SQLITE_OK ) return rc;
+  sqlite3_bind_int(pStmt, 1, iCol);
+  sqlite3_bind_int64(pStmt, 2, iLo);
+  sqlite3_bind_int64(pStmt, 3, iHi);
+  while( rc==SQLITE_OK && sqlite3_step(pStmt)==SQLITE_ROW ){
+    rc = bmSetAdd(pSet, sqlite3_column_int64(pStmt, 0),
+        sqlite3_column_blob(pStmt, 1), sqlite3_column_bytes(pStmt, 1)
+    );
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3_finalize(pStmt);
+  }else{
+    sqlite3_finalize(pStmt);
+  }
+  return rc;
+}
+
+/*
+** Begin a scan.  The rowids for each constrained column are the union
+** of the bitmaps for the values that satisfy its constraints.  The
+** result is the intersection of those sets.
+*/
+static int bmFilter(
+  sqlite3_vtab_cursor *pCursor,
+  int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv
+){
+  BmCursor *pCsr = (BmCursor*)pCursor;
+  BmTable *pTab = (BmTable*)pCursor->pVtab;
+  i64 *aiLo = 0;
+  i64 *aiHi = 0;
+  int bFirst = 1;
+  int rc = SQLITE_OK;
+  int i;
+
+  bmResetCursor(pCsr);
+  pCsr->iChunk = 0;
+  pCsr->iBit = 0;
+  pCsr->bEof = 0;
+
+  if( argc==0 ){
+    rc = bmPrepare(pTab, &pCsr->pScan, sqlite3_mprintf(
+        "SELECT rowid FROM \"%w\".\"%w\" ORDER BY rowid",
+        pTab->zDb, pTab->zTab
+    ));
+    if( rc!=SQLITE_OK ) return rc;
+    if( sqlite3_step(pCsr->pScan)==SQLITE_ROW ){
+      pCsr->iRowid = sqlite3_column_int64(pCsr->pScan, 0);
+      return SQLITE_OK;
+    }
+    pCsr->bEof = 1;
+    return sqlite3_reset(pCsr->pScan);
+  }
+
+  aiLo = (i64*)sqlite3_malloc64(pTab->nCol*sizeof(i64)*2);
+  if( aiLo==0 ) return SQLITE_NOMEM_BKPT;
+  aiHi = &aiLo[pTab->nCol];
+  for(i=0; i<pTab->nCol; i++){
+    aiLo[i] = LARGEST_INT64;
+    aiHi[i] = SMALLEST_INT64;
+  }
+  for(i=0; i<argc; i++){
+    char cOp = *(idxStr++);
+    int iCol = sqlite3Atoi(idxStr)-1;
+    while( *(idxStr++)!=',' ){}
+    assert( iCol>=0 && iCol<pTab->nCol );
+    if( aiLo[iCol]>aiHi[iCol] && aiLo[iCol]==LARGEST_INT64 ){
+      /* First constraint on this column */
+      aiLo[iCol] = SMALLEST_INT64;
+      aiHi[iCol] = LARGEST_INT64;
+    }
+    if( pTab->aAff[iCol]>=SQLITE_AFF_NUMERIC
+     && sqlite3_value_type(argv[i])==SQLITE_TEXT
+    ){
+      sqlite3_value *pVal = sqlite3_value_dup(argv[i]);
+      if( pVal==0 ){
+        sqlite3_free(aiLo);
+        return SQLITE_NOMEM_BKPT;
+      }
+      sqlite3_value_numeric_type(pVal);
+      bmNarrow(cOp, pVal, &aiLo[iCol], &aiHi[iCol]);
+      sqlite3_value_free(pVal);
+    }else{
+      bmNarrow(cOp, argv[i], &aiLo[iCol], &aiHi[iCol]);
+    }
+    if( aiLo[iCol]>aiHi[iCol] ){
+      /* Nothing can match */
+      pCsr->bEof = 1;
+      sqlite3_free(aiLo);
+      return SQLITE_OK;
+    }
+  }
+  assert( idxNum==argc );
+
+  for(i=0; rc==SQLITE_OK && i<pTab->nCol; i++){
+    BmSet set;
+    if( aiLo[i]>aiHi[i] ) continue;     /* Column is not constrained */
+    memset(&set, 0, sizeof(set));
+    rc = bmLoadRange(pTab, i, aiLo[i], aiHi[i], bFirst ? &pCsr->set : &set);
+    if( rc==SQLITE_OK && !bFirst ) bmSetAnd(&pCsr->set, &set);
+    bmSetFree(&set);
+    bFirst = 0;
+    if( pCsr->set.nChunk==0 ) break;
+  }
+  sqlite3_free(aiLo);
+  if( rc!=SQLITE_OK ) return rc;
+  bmSeekSet(pCsr);
+  return SQLITE_OK;
+}
+
+static int bmNext(sqlite3_vtab_cursor *pCursor){
+  BmCursor *pCsr = (BmCursor*)pCursor;
+  if( pCsr->pScan ){
+    if( sqlite3_step(pCsr->pScan)==SQLITE_ROW ){
+      pCsr->iRowid = sqlite3_column_int64(pCsr->pScan, 0);
+      return SQLITE_OK;
+    }
+    pCsr->bEof = 1;
+    return sqlite3_reset(pCsr->pScan);
+  }
+  pCsr->iBit++;
+  bmSeekSet(pCsr);
+  return SQLITE_OK;
+}
+
+static int bmEof(sqlite3_vtab_cursor *pCursor){
+  BmCursor *pCsr = (BmCursor*)pCursor;
+  return pCsr->bEof;
+}
+
+/*
+** The values of indexed columns are read from the indexed table.
+*/
+static int bmColumn(
+  sqlite3_vtab_cursor *pCursor,
+  sqlite3_context *ctx,
+  int i
+){
+  BmCursor *pCsr = (BmCursor*)pCursor;
+  BmTable *pTab = (BmTable*)pCursor->pVtab;
+  int rc = SQLITE_OK;
+  if( i==0 ){
+    sqlite3_result_int64(ctx, pCsr->iRowid);
+  }else if( i<=pTab->nCol ){
+    rc = bmPrepareLookup(pTab);
+    if( rc==SQLITE_OK ){
+      sqlite3_bind_int64(pTab->pLookup, 1, pCsr->iRowid);
+      if( sqlite3_step(pTab->pLookup)==SQLITE_ROW ){
+        sqlite3_result_value(ctx, sqlite3_column_value(pTab->pLookup, i-1));
+      }
+      rc = sqlite3_reset(pTab->pLookup);
+    }
+  }
+  return rc;
+}
+
+static int bmRowid(sqlite3_vtab_cursor *pCursor, sqlite_int64 *pRowid){
+  BmCursor *pCsr = (BmCursor*)pCursor;
+  *pRowid = pCsr->iRowid;
+  return SQLITE_OK;
+}
+
+/*
+** The xUpdate method.  The index may only be modified by writing one of
+** the commands 'insert', 'delete', 'replace' or 'rebuild' to the hidden
+** column that has the same name as the table.
+**
+** 'replace' names a row that REPLACE conflict handling may delete
+** without the DELETE trigger firing, or with a NULL rid forgets all such
+** rows.  The next 'insert' clears the named rows that have been deleted
+** or overwritten from the bitmaps of all values.  'rebuild' also
+** recreates the triggers, so that they see any new UNIQUE indexes.
+*/
+static int bmUpdate(
+  sqlite3_vtab *pVtab,
+  int argc,
+  sqlite3_value **argv,
+  sqlite_int64 *pRowid
+){
+  BmTable *pTab = (BmTable*)pVtab;
+  const char *zCmd = 0;
+  int rc = SQLITE_OK;
+  int i;
+
+  if( argc>1 && sqlite3_value_type(argv[0])==SQLITE_NULL ){
+    zCmd = (const char*)sqlite3_value_text(argv[3+pTab->nCol]);
+  }
+  if( zCmd && sqlite3_stricmp(zCmd, "rebuild")==0 ){
+    rc = bmRebuild(pTab);
+    if( rc==SQLITE_OK ) rc = bmDropTriggers(pTab);
+    if( rc==SQLITE_OK ) rc = bmCreateTriggers(pTab, &pVtab->zErrMsg);
+  }else if( zCmd && sqlite3_stricmp(zCmd, "replace")==0 ){
+    if( sqlite3_value_type(argv[2])==SQLITE_NULL ){
+      pTab->nReplace = 0;
+    }else{
+      if( pTab->nReplace>=pTab->nReplaceAlloc ){
+        int nNew = pTab->nReplaceAlloc ? pTab->nReplaceAlloc*2 : 8;
+        i64 *aNew = (i64*)sqlite3_realloc64(
+            pTab->aiReplace, nNew*sizeof(i64)
+        );
+        if( aNew==0 ) return SQLITE_NOMEM_BKPT;
+        pTab->aiReplace = aNew;
+        pTab->nReplaceAlloc = nNew;
+      }
+      pTab->aiReplace[pTab->nReplace++] = sqlite3_value_int64(argv[2]);
+    }
+  }else if( zCmd && (sqlite3_stricmp(zCmd, "insert")==0
+                  || sqlite3_stricmp(zCmd, "delete")==0)
+  ){
+    int bSet = sqlite3_stricmp(zCmd, "insert")==0;
+    i64 iRowid;
+    if( sqlite3_value_numeric_type(argv[2])!=SQLITE_INTEGER ){
+      pVtab->zErrMsg = sqlite3_mprintf("bitmap: rid must be an integer");
+      return SQLITE_MISMATCH;
+    }
+    iRowid = sqlite3_value_int64(argv[2]);
+    if( bSet && pTab->nReplace>0 ){
+      rc = bmFlushReplace(pTab, iRowid);
+    }
+    for(i=0; rc==SQLITE_OK && i<pTab->nCol; i++){
+      sqlite3_value *pVal = argv[3+i];
+      if( sqlite3_value_type(pVal)==SQLITE_INTEGER ){
+        rc = bmUpdateBit(pTab, i, sqlite3_value_int64(pVal), iRowid, bSet);
+      }
+    }
+  }else{
+    pVtab->zErrMsg = sqlite3_mprintf(
+        "bitmap: %s is maintained by triggers on %s", pTab->zName, pTab->zTab
+    );
+    return SQLITE_ERROR;
+  }
+  if( rc!=SQLITE_OK && pVtab->zErrMsg==0 ){
+    pVtab->zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pTab->db));
+  }
+  return rc;
+}
+
+/*
+** Rename the shadow table and recreate the triggers, which refer to the
+** virtual table by name.
+*/
+static int bmRename(sqlite3_vtab *pVtab, const char *zNew){
+  BmTable *pTab = (BmTable*)pVtab;
+  char *zName;
+  int rc;
+  bmFinalizeAll(pTab);
+  rc = bmDropTriggers(pTab);
+  if( rc==SQLITE_OK ){
+    rc = bmExec(pTab->db, sqlite3_mprintf(
+        "ALTER TABLE \"%w\".\"%w_data\" RENAME TO \"%w_data\"",
+        pTab->zDb, pTab->zName, zNew
+    ));
+  }
+  if( rc!=SQLITE_OK ) return rc;
+  zName = sqlite3_mprintf("%s", zNew);
+  if( zName==0 ) return SQLITE_NOMEM_BKPT;
+  sqlite3_free(pTab->zName);
+  pTab->zName = zName;
+  return bmCreateTriggers(pTab, &pVtab->zErrMsg);
+}
+
+/*
+** Invoke this routine to register the "bitmap" virtual table module
+*/
+int sqlite3BitmapInit(sqlite3 *db){
+  static sqlite3_module bitmap_module = {
+    0,                            /* iVersion */
+    bmCreate,                     /* xCreate */
+    bmConnect,                    /* xConnect */
+    bmBestIndex,                  /* xBestIndex */
+    bmDisconnect,                 /* xDisconnect */
+    bmDestroy,                    /* xDestroy */
+    bmOpen,                       /* xOpen - open a cursor */
+    bmClose,                      /* xClose - close a cursor */
+    bmFilter,                     /* xFilter - configure scan constraints */
+    bmNext,                       /* xNext - advance a cursor */
+    bmEof,                        /* xEof - check for end of scan */
+    bmColumn,                     /* xColumn - read data */
+    bmRowid,                      /* xRowid - read data */
+    bmUpdate,                     /* xUpdate */
+    0,                            /* xBegin */
+    0,                            /* xSync */
+    0,                            /* xCommit */
+    0,                            /* xRollback */
+    0,                            /* xFindMethod */
+    bmRename,                     /* xRename */
+    0,                            /* xSavepoint */
+    0,                            /* xRelease */
+    0,                            /* xRollbackTo */
+  };
+  return sqlite3_create_module(db, "bitmap", &bitmap_module, 0);
+}
+#elif defined(SQLITE_ENABLE_BITMAP)
+int sqlite3BitmapInit(sqlite3 *db){ return SQLITE_OK; }
+#endif /* SQLITE_ENABLE_BITMAP */
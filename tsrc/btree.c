@@ -1057,6 +1057,60 @@ static int ptrmapGet(BtShared *pBt, Pgno key, u8 *pEType, Pgno *pPgno){
   #define ptrmapPutOvflPtr(x, y, rc)
 #endif
 
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+/*
+** Given a page number, return the page number of the free-space map page
+** that holds the bit for that page.  Return 0 for pgno==1, which has no
+** bit.
+*/
+static Pgno freemapPageno(BtShared *pBt, Pgno pgno){
+  u32 nPagesPerMapPage;
+  Pgno iMap, ret;
+  assert( sqlite3_mutex_held(pBt->mutex) );
+  if( pgno<2 ) return 0;
+  nPagesPerMapPage = pBt->usableSize*8 + 1;
+  iMap = (pgno-2)/nPagesPerMapPage;
+  ret = (iMap*nPagesPerMapPage) + 2;
+  if( ret==PENDING_BYTE_PAGE(pBt) ){
+    ret++;
+  }
+  return ret;
+}
+
+/*
+** Mark page iPage as free (if bFree is true) or in use (if bFree is
+** false) in the free-space map.  It is an error if the page is already
+** marked that way.
+*/
+static int freemapSet(BtShared *pBt, Pgno iPage, int bFree){
+  DbPage *pDbPage;   /* The map page */
+  Pgno iMap;         /* Page number of the map page */
+  u8 *aMap;          /* Map page data */
+  u32 iBit;          /* Index of the bit for iPage */
+  int rc;
+
+  assert( sqlite3_mutex_held(pBt->mutex) );
+  assert( pBt->bFreemap );
+  iMap = FREEMAP_PAGENO(pBt, iPage);
+  if( iPage<=iMap || iPage>pBt->nPage ){
+    return SQLITE_CORRUPT_BKPT;
+  }
+  iBit = FREEMAP_BIT(iMap, iPage);
+  assert( iBit<pBt->usableSize*8 );
+  rc = sqlite3PagerGet(pBt->pPager, iMap, &pDbPage, 0);
+  if( rc!=SQLITE_OK ) return rc;
+  aMap = (u8*)sqlite3PagerGetData(pDbPage);
+  if( ((aMap[iBit/8]>>(iBit%8)) & 1)==(bFree ? 1 : 0) ){
+    rc = SQLITE_CORRUPT_PGNO(iMap);
+  }else{
+    rc = sqlite3PagerWrite(pDbPage);
+    if( rc==SQLITE_OK ) aMap[iBit/8] ^= (u8)(1<<(iBit%8));
+  }
+  sqlite3PagerUnref(pDbPage);
+  return rc;
+}
+#endif
+
 /*
 ** Given a btree page and a cell index (0 means the first cell on
 ** the page, 1 means the second cell, and so forth) return a pointer
@@ -1265,6 +1319,7 @@ static void btreeParseCell(
 **
 ** cellSizePtrNoPayload()    =>   table internal nodes
 ** cellSizePtr()             =>   all index nodes & table leaf nodes
+** cellSizePtrPrefix()       =>   PTF_PREFIX index leaf nodes
 */
 static u16 cellSizePtr(MemPage *pPage, u8 *pCell){
   u8 *pIter = pCell + pPage->childPtrSize; /* For looping over bytes of pCell */
@@ -1336,6 +1391,91 @@ static u16 cellSizePtrNoPayload(MemPage *pPage, u8 *pCell){
   return (u16)(pIter - pCell);
 }
 
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+/*
+** Read the payload size varint at the start of cell pCell of a PTF_PREFIX
+** page.  Return the number of bytes in the varint and write the payload
+** size into *pnPayload.  A payload size that cannot belong to a cell of
+** the page (one shorter than the shared prefix or too large to fit on the
+** page) is reported as 0, so that corrupt cells read as empty records.
+*/
+static int btreePrefixCellHdr(MemPage *pPage, u8 *pCell, u32 *pnPayload){
+  u8 *pIter = pCell;
+  u32 nPayload = *pIter;
+  if( nPayload>=0x80 ){
+    u8 *pEnd = &pIter[8];
+    nPayload &= 0x7f;
+    do{
+      nPayload = (nPayload<<7) | (*++pIter & 0x7f);
+    }while( *(pIter)>=0x80 && pIter<pEnd );
+  }
+  pIter++;
+  if( nPayload<pPage->nPrefix || nPayload>pPage->maxLocal ) nPayload = 0;
+  *pnPayload = nPayload;
+  return (int)(pIter - pCell);
+}
+
+/*
+** The xParseCell and xCellSize methods of PTF_PREFIX pages.  The payload
+** reported is always the complete record, all of it local, but pPayload
+** points at the part that follows the shared prefix and nSize is the
+** number of bytes the cell occupies on the page.
+*/
+static void btreeParseCellPtrPrefix(
+  MemPage *pPage,         /* Page containing the cell */
+  u8 *pCell,              /* Pointer to the cell text. */
+  CellInfo *pInfo         /* Fill in this structure */
+){
+  u32 nPayload;
+  int nHdr = btreePrefixCellHdr(pPage, pCell, &nPayload);
+  u32 nSize = nHdr + (nPayload ? nPayload - pPage->nPrefix : 0);
+  assert( sqlite3_mutex_held(pPage->pBt->mutex) );
+  assert( pPage->leaf && pPage->nPrefix>0 );
+  pInfo->nKey = nPayload;
+  pInfo->nPayload = nPayload;
+  pInfo->pPayload = &pCell[nHdr];
+  pInfo->nLocal = (u16)nPayload;
+  pInfo->nSize = (u16)(nSize<4 ? 4 : nSize);
+}
+static u16 cellSizePtrPrefix(MemPage *pPage, u8 *pCell){
+  u32 nPayload;
+  int nHdr = btreePrefixCellHdr(pPage, pCell, &nPayload);
+  u32 nSize = nHdr + (nPayload ? nPayload - pPage->nPrefix : 0);
+  return (u16)(nSize<4 ? 4 : nSize);
+}
+
+/*
+** Copy amt bytes of the record held by cell pInfo of PTF_PREFIX page pPage,
+** starting at byte offset of the record, into pBuf.  Return SQLITE_CORRUPT
+** if the stored part of the record does not lie within the page.
+*/
+static int btreePrefixRead(
+  MemPage *pPage,         /* PTF_PREFIX page holding the cell */
+  CellInfo *pInfo,        /* Parse of the cell */
+  u32 offset,             /* First byte of the record to copy */
+  u32 amt,                /* Number of bytes to copy */
+  u8 *pBuf                /* Write the bytes here */
+){
+  int nPrefix = pPage->nPrefix;
+  u8 *aPrefix = &pPage->aData[pPage->pBt->usableSize - 1 - nPrefix];
+  assert( offset+amt<=pInfo->nPayload );
+  if( pInfo->nPayload
+   && &pInfo->pPayload[pInfo->nPayload-nPrefix]>aPrefix
+  ){
+    return SQLITE_CORRUPT_PAGE(pPage);
+  }
+  if( offset<(u32)nPrefix ){
+    u32 n = MIN(amt, nPrefix-offset);
+    memcpy(pBuf, &aPrefix[offset], n);
+    pBuf += n;
+    offset += n;
+    amt -= n;
+  }
+  if( amt ) memcpy(pBuf, &pInfo->pPayload[offset-nPrefix], amt);
+  return SQLITE_OK;
+}
+#endif /* SQLITE_ENABLE_INDEX_PREFIX */
+
 
 #ifdef SQLITE_DEBUG
 /* This variation on cellSizePtr() is used inside of assert() statements
@@ -1404,6 +1544,9 @@ static int defragmentPage(MemPage *pPage, int nMaxFrag){
   assert( nCell==get2byte(&data[hdr+3]) );
   iCellFirst = cellOffset + 2*nCell;
   usableSize = pPage->pBt->usableSize;
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  if( pPage->nPrefix ) usableSize -= pPage->nPrefix + 1;
+#endif
 
   /* This block handles pages with two or fewer free blocks and nMaxFrag
   ** or fewer fragmented bytes. In this case it is faster to move the
@@ -1779,11 +1922,17 @@ static int decodeFlags(MemPage *pPage, int flagByte){
 
   assert( pPage->hdrOffset==(pPage->pgno==1 ? 100 : 0) );
   assert( sqlite3_mutex_held(pPage->pBt->mutex) );
-  pPage->leaf = (u8)(flagByte>>3);  assert( PTF_LEAF == 1<<3 );
+  pPage->iZoneTag = 0;
+  btreeKeyCacheClear(pPage);
+  btreeCountClear(pPage);
+  pPage->leaf = (u8)((flagByte>>3)&1);  assert( PTF_LEAF == 1<<3 );
   flagByte &= ~PTF_LEAF;
   pPage->childPtrSize = 4-4*pPage->leaf;
   pPage->xCellSize = cellSizePtr;
   pBt = pPage->pBt;
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  pPage->nPrefix = 0;
+#endif
   if( flagByte==(PTF_LEAFDATA | PTF_INTKEY) ){
     /* EVIDENCE-OF: R-07291-35328 A value of 5 (0x05) means the page is an
     ** interior table b-tree page. */
@@ -1814,12 +1963,31 @@ static int decodeFlags(MemPage *pPage, int flagByte){
     pPage->xParseCell = btreeParseCellPtrIndex;
     pPage->maxLocal = pBt->maxLocal;
     pPage->minLocal = pBt->minLocal;
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  }else if( flagByte==(PTF_ZERODATA|PTF_PREFIX) && pPage->leaf ){
+    /* An index leaf page whose cells share a record prefix.  The length
+    ** of the prefix is the last byte of the usable area of the page. */
+    int nPrefix = pPage->aData[pBt->usableSize-1];
+    if( nPrefix==0 || pBt->usableSize-1-nPrefix < pPage->hdrOffset+8 ){
+      return SQLITE_CORRUPT_PAGE(pPage);
+    }
+    pPage->nPrefix = (u8)nPrefix;
+    pPage->intKey = 0;
+    pPage->intKeyLeaf = 0;
+    pPage->xParseCell = btreeParseCellPtrPrefix;
+    pPage->xCellSize = cellSizePtrPrefix;
+    pPage->maxLocal = pBt->maxLocal;
+    pPage->minLocal = pBt->minLocal;
+#endif
   }else{
     /* EVIDENCE-OF: R-47608-56469 Any other value for the b-tree page type is
     ** an error. */
     return SQLITE_CORRUPT_PAGE(pPage);
   }
   pPage->max1bytePayload = pBt->max1bytePayload;
+  /* Interior pages and page 1 are visited by every search. Ask the page
+  ** cache to keep them in memory ahead of leaf and overflow pages. */
+  sqlite3PagerPriority(pPage->pDbPage, pPage->leaf==0 || pPage->pgno==1);
   return SQLITE_OK;
 }
 
@@ -1868,6 +2036,11 @@ static int btreeInitPage(MemPage *pPage){
   pPage->aDataEnd = &data[usableSize];
   pPage->aCellIdx = &data[cellOffset];
   pPage->aDataOfst = &data[pPage->childPtrSize];
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  /* On a PTF_PREFIX page the cell content area ends where the shared
+  ** prefix begins. */
+  if( pPage->nPrefix ) usableSize -= pPage->nPrefix + 1;
+#endif
   /* EVIDENCE-OF: R-58015-48175 The two-byte integer at offset 5 designates
   ** the start of the cell content area. A zero value for this integer is
   ** interpreted as 65536. */
@@ -2228,6 +2401,496 @@ static void pageReinit(DbPage *pData){
   }
 }
 
+#ifdef SQLITE_ENABLE_COUNTED_BTREE
+/*
+** Return the slot of BtShared.aCount[] that holds the subtree entry count
+** of page pPage, or NULL if no count is recorded for the page.
+*/
+static BtCount *btreeCountSlot(MemPage *pPage){
+  BtCount *p;
+  assert( sqlite3_mutex_held(pPage->pBt->mutex) );
+  if( pPage->iCountTag==0 ) return 0;
+  p = &pPage->pBt->aCount[pPage->pgno & (BTREE_COUNTCACHE_SIZE-1)];
+  if( p->pPage!=pPage || p->iTag!=pPage->iCountTag ){
+    /* The slot has since been taken by the count of some other page */
+    btreeCountClear(pPage);
+    return 0;
+  }
+  return p;
+}
+
+/*
+** Return the number of entries in the subtree headed by interior page
+** pPage, or -1 if that number is not known.
+*/
+static i64 btreeCountGet(MemPage *pPage){
+  BtCount *p = btreeCountSlot(pPage);
+  return p ? p->nEntry : -1;
+}
+
+/*
+** Record that the subtree headed by page pPage holds nEntry entries.
+** Nothing is recorded for leaf pages, whose count is their nCell, or if
+** nEntry is negative.
+*/
+static void btreeCountSet(MemPage *pPage, i64 nEntry){
+  BtShared *pBt = pPage->pBt;
+  BtCount *p;
+
+  assert( sqlite3_mutex_held(pBt->mutex) );
+  if( nEntry<0 || pPage->leaf ) return;
+  if( pBt->aCount==0 ){
+    sqlite3BeginBenignMalloc();
+    pBt->aCount = (BtCount*)sqlite3MallocZero(
+        sizeof(BtCount)*BTREE_COUNTCACHE_SIZE
+    );
+    sqlite3EndBenignMalloc();
+    if( pBt->aCount==0 ) return;
+  }
+  p = &pBt->aCount[pPage->pgno & (BTREE_COUNTCACHE_SIZE-1)];
+  if( ++pBt->iCountTag==0 ) pBt->iCountTag = 1;
+  p->pPage = pPage;
+  p->iTag = pPage->iCountTag = pBt->iCountTag;
+  p->nEntry = nEntry;
+}
+
+/*
+** An entry is about to be added to (iDelta==1) or removed from
+** (iDelta==-1) the leaf page that cursor pCur points to.  Adjust the
+** counts of all pages above it.
+*/
+static void btreeCountAdjust(BtCursor *pCur, int iDelta){
+  int i;
+  for(i=0; i<pCur->iPage; i++){
+    BtCount *p = btreeCountSlot(pCur->apPage[i]);
+    if( p ) p->nEntry += iDelta;
+  }
+}
+
+/*
+** Discard all subtree entry counts of BtShared object pBt.
+*/
+static void btreeCountReset(BtShared *pBt){
+  if( pBt->aCount ){
+    memset(pBt->aCount, 0, sizeof(BtCount)*BTREE_COUNTCACHE_SIZE);
+  }
+}
+#else
+# define btreeCountGet(P) (-1)
+# define btreeCountSet(P,N) ((void)(N))
+# define btreeCountAdjust(C,D)
+# define btreeCountReset(B)
+#endif
+
+#ifdef SQLITE_ENABLE_FREELIST_INDEX
+/*
+** Discard the freelist index of BtShared object pBt.
+*/
+static void btreeFreeIndexClear(BtShared *pBt){
+  int i;
+  for(i=0; i<pBt->nFreeTrunk; i++){
+    sqlite3_free(pBt->aFreeTrunk[i].aLeaf);
+  }
+  pBt->nFreeTrunk = 0;
+  pBt->bFreeIndex = 0;
+}
+
+/*
+** Insert an entry for trunk page iTrunk, with no leaves, into the freelist
+** index of pBt at position iIdx.  Return a pointer to the new entry, or
+** NULL if a memory allocation fails.
+*/
+static BtFreeTrunk *btreeFreeIndexInsert(BtShared *pBt, int iIdx, Pgno iTrunk){
+  BtFreeTrunk *p;
+  Pgno *aLeaf;
+
+  assert( iIdx>=0 && iIdx<=pBt->nFreeTrunk );
+  if( pBt->nFreeTrunk>=pBt->nFreeTrunkAlloc ){
+    int nNew = pBt->nFreeTrunkAlloc ? pBt->nFreeTrunkAlloc*2 : 16;
+    BtFreeTrunk *aNew = (BtFreeTrunk*)sqlite3Realloc(
+        pBt->aFreeTrunk, nNew*sizeof(BtFreeTrunk)
+    );
+    if( aNew==0 ) return 0;
+    pBt->aFreeTrunk = aNew;
+    pBt->nFreeTrunkAlloc = nNew;
+  }
+  aLeaf = (Pgno*)sqlite3Malloc((pBt->usableSize/4 - 2)*sizeof(Pgno));
+  if( aLeaf==0 ) return 0;
+  p = &pBt->aFreeTrunk[iIdx];
+  memmove(&p[1], p, (pBt->nFreeTrunk-iIdx)*sizeof(BtFreeTrunk));
+  pBt->nFreeTrunk++;
+  p->iTrunk = iTrunk;
+  p->nLeaf = 0;
+  p->aLeaf = aLeaf;
+  return p;
+}
+
+/*
+** Sort the n page numbers in array a[] in ascending order (heapsort).
+*/
+static void btreeSiftPgno(Pgno *a, u32 i, u32 n){
+  Pgno t = a[i];
+  while( 2*i+1<n ){
+    u32 c = 2*i+1;
+    if( c+1<n && a[c+1]>a[c] ) c++;
+    if( a[c]<=t ) break;
+    a[i] = a[c];
+    i = c;
+  }
+  a[i] = t;
+}
+static void btreeSortPgno(Pgno *a, u32 n){
+  u32 i;
+  for(i=n/2; i>0; i--) btreeSiftPgno(a, i-1, n);
+  for(i=n; i>1; i--){
+    Pgno t = a[0];
+    a[0] = a[i-1];
+    a[i-1] = t;
+    btreeSiftPgno(a, 0, i-1);
+  }
+}
+
+/*
+** Return the index of the first leaf of trunk p that is greater than or
+** equal to iPage, or p->nLeaf if there is no such leaf.
+*/
+static u32 btreeFreeIndexSearch(BtFreeTrunk *p, Pgno iPage){
+  u32 iLo = 0;
+  u32 iHi = p->nLeaf;
+  while( iLo<iHi ){
+    u32 iMid = (iLo+iHi)/2;
+    if( p->aLeaf[iMid]<iPage ){
+      iLo = iMid+1;
+    }else{
+      iHi = iMid;
+    }
+  }
+  return iLo;
+}
+
+/*
+** Build the freelist index of pBt by reading each trunk page of the
+** freelist.  If the freelist has too many trunks, is inconsistent with
+** the count of free pages on page 1 or a memory allocation fails, no
+** index is built.  An SQLite error code is returned only if a trunk page
+** cannot be read.
+*/
+static int btreeFreeIndexBuild(BtShared *pBt){
+  u8 *aData1 = pBt->pPage1->aData;
+  Pgno iTrunk = get4byte(&aData1[32]);
+  u32 nFree = 0;
+  int rc = SQLITE_OK;
+
+  btreeFreeIndexClear(pBt);
+  sqlite3BeginBenignMalloc();
+  while( iTrunk ){
+    MemPage *pTrunk;
+    BtFreeTrunk *p;
+    u32 i;
+    if( pBt->nFreeTrunk>=BTREE_FREEINDEX_MAXTRUNK
+     || iTrunk>btreePagecount(pBt)
+    ){
+      break;
+    }
+    rc = btreeGetPage(pBt, iTrunk, &pTrunk, 0);
+    if( rc ) break;
+    p = btreeFreeIndexInsert(pBt, pBt->nFreeTrunk, iTrunk);
+    if( p==0 || get4byte(&pTrunk->aData[4])>pBt->usableSize/4 - 2 ){
+      releasePage(pTrunk);
+      break;
+    }
+    p->nLeaf = get4byte(&pTrunk->aData[4]);
+    for(i=0; i<p->nLeaf; i++){
+      p->aLeaf[i] = get4byte(&pTrunk->aData[8+i*4]);
+    }
+    btreeSortPgno(p->aLeaf, p->nLeaf);
+    nFree += p->nLeaf + 1;
+    iTrunk = get4byte(&pTrunk->aData[0]);
+    releasePage(pTrunk);
+  }
+  sqlite3EndBenignMalloc();
+  if( iTrunk==0 && nFree==get4byte(&aData1[36]) ){
+    pBt->bFreeIndex = 1;
+    pBt->iFreeVersion = sqlite3PagerDataVersion(pBt->pPager);
+  }else{
+    btreeFreeIndexClear(pBt);
+  }
+  return rc;
+}
+
+/*
+** Leaf iPage has been removed from freelist trunk page iTrunk.  Update
+** the freelist index to match.
+*/
+static void btreeFreeIndexRemove(BtShared *pBt, Pgno iTrunk, Pgno iPage){
+  int i;
+  if( pBt->bFreeIndex==0 ) return;
+  for(i=0; i<pBt->nFreeTrunk; i++){
+    BtFreeTrunk *p = &pBt->aFreeTrunk[i];
+    if( p->iTrunk==iTrunk ){
+      u32 iLeaf = btreeFreeIndexSearch(p, iPage);
+      if( iLeaf<p->nLeaf && p->aLeaf[iLeaf]==iPage ){
+        p->nLeaf--;
+        memmove(&p->aLeaf[iLeaf], &p->aLeaf[iLeaf+1],
+                (p->nLeaf-iLeaf)*sizeof(Pgno));
+        return;
+      }
+      break;
+    }
+  }
+  btreeFreeIndexClear(pBt);
+}
+
+/*
+** Page iPage has been added as a leaf of iTrunk, the first trunk page of
+** the freelist.  Update the freelist index to match.
+*/
+static void btreeFreeIndexAdd(BtShared *pBt, Pgno iTrunk, Pgno iPage){
+  BtFreeTrunk *p;
+  u32 iLeaf;
+  if( pBt->bFreeIndex==0 ) return;
+  p = pBt->aFreeTrunk;
+  if( pBt->nFreeTrunk==0 || p->iTrunk!=iTrunk
+   || p->nLeaf>=pBt->usableSize/4 - 2
+  ){
+    btreeFreeIndexClear(pBt);
+    return;
+  }
+  iLeaf = btreeFreeIndexSearch(p, iPage);
+  memmove(&p->aLeaf[iLeaf+1], &p->aLeaf[iLeaf], (p->nLeaf-iLeaf)*sizeof(Pgno));
+  p->aLeaf[iLeaf] = iPage;
+  p->nLeaf++;
+}
+
+/*
+** Page iPage has become the first trunk page of the freelist.  Update the
+** freelist index to match.
+*/
+static void btreeFreeIndexPush(BtShared *pBt, Pgno iPage){
+  BtFreeTrunk *p;
+  if( pBt->bFreeIndex==0 ) return;
+  if( pBt->nFreeTrunk>=BTREE_FREEINDEX_MAXTRUNK ){
+    btreeFreeIndexClear(pBt);
+    return;
+  }
+  sqlite3BeginBenignMalloc();
+  p = btreeFreeIndexInsert(pBt, 0, iPage);
+  sqlite3EndBenignMalloc();
+  if( p==0 ) btreeFreeIndexClear(pBt);
+}
+
+/*
+** Trunk page iTrunk, which had no leaves, has been removed from the head
+** of the freelist.  Update the freelist index to match.
+*/
+static void btreeFreeIndexPop(BtShared *pBt, Pgno iTrunk){
+  BtFreeTrunk *p = pBt->aFreeTrunk;
+  if( pBt->bFreeIndex==0 ) return;
+  if( pBt->nFreeTrunk==0 || p->iTrunk!=iTrunk || p->nLeaf!=0 ){
+    btreeFreeIndexClear(pBt);
+    return;
+  }
+  sqlite3_free(p->aLeaf);
+  pBt->nFreeTrunk--;
+  memmove(p, &p[1], pBt->nFreeTrunk*sizeof(BtFreeTrunk));
+}
+
+/*
+** Use the freelist index to allocate the free leaf page closest to page
+** nearby, from whichever trunk page it is stored on.  Where two leaves are
+** equally close the one that follows nearby is preferred, so that pages
+** allocated one after another for a growing b-tree run forwards through
+** the file.
+**
+** If the index cannot be used, or the freelist holds no leaves, *ppPage
+** is set to NULL and SQLITE_OK returned.  The caller then allocates from
+** the freelist in the usual way.  Otherwise, this function behaves as
+** allocateBtreePage().
+*/
+static int btreeFreeIndexAllocate(
+  BtShared *pBt,         /* The btree */
+  MemPage **ppPage,      /* Store pointer to the allocated page here */
+  Pgno *pPgno,           /* Store the page number here */
+  Pgno nearby            /* Search for a page near this one */
+){
+  MemPage *pPage1 = pBt->pPage1;
+  MemPage *pTrunk = 0;
+  BtFreeTrunk *pBest = 0;
+  u32 iLeaf = 0;         /* Index of the chosen leaf in pBest->aLeaf[] */
+  u32 dist = 0;          /* Distance between nearby and the chosen leaf */
+  Pgno iPage;            /* The chosen leaf */
+  u32 k;                 /* Number of leaves on the chosen trunk page */
+  u32 iSlot;             /* Index of the chosen leaf on the trunk page */
+  u8 *aData;
+  int noContent;
+  int rc;
+  int i;
+
+  *ppPage = 0;
+  if( pBt->bFreeIndex
+   && pBt->iFreeVersion!=sqlite3PagerDataVersion(pBt->pPager)
+  ){
+    btreeFreeIndexClear(pBt);
+  }
+  if( pBt->bFreeIndex==0 ){
+    rc = btreeFreeIndexBuild(pBt);
+    if( rc || pBt->bFreeIndex==0 ) return rc;
+  }
+
+  for(i=0; i<pBt->nFreeTrunk; i++){
+    BtFreeTrunk *p = &pBt->aFreeTrunk[i];
+    u32 j = btreeFreeIndexSearch(p, nearby);
+    if( j<p->nLeaf && (pBest==0 || p->aLeaf[j]-nearby<=dist) ){
+      pBest = p;
+      iLeaf = j;
+      dist = p->aLeaf[j]-nearby;
+    }
+    if( j>0 && (pBest==0 || nearby-p->aLeaf[j-1]<dist) ){
+      pBest = p;
+      iLeaf = j-1;
+      dist = nearby-p->aLeaf[j-1];
+    }
+  }
+  if( pBest==0 ) return SQLITE_OK;
+  iPage = pBest->aLeaf[iLeaf];
+  if( iPage>btreePagecount(pBt) ){
+    return SQLITE_CORRUPT_PGNO(pBest->iTrunk);
+  }
+
+  /* Check that the trunk page still matches the index, then remove the
+  ** leaf from it in the same way as allocateBtreePage() does. */
+  rc = btreeGetUnusedPage(pBt, pBest->iTrunk, &pTrunk, 0);
+  if( rc ) return rc;
+  aData = pTrunk->aData;
+  k = get4byte(&aData[4]);
+  iSlot = 0;
+  if( k==pBest->nLeaf ){
+    while( iSlot<k && get4byte(&aData[8+iSlot*4])!=iPage ) iSlot++;
+  }
+  if( k!=pBest->nLeaf || iSlot>=k ){
+    releasePage(pTrunk);
+    btreeFreeIndexClear(pBt);
+    return SQLITE_OK;
+  }
+  rc = sqlite3PagerWrite(pPage1->pDbPage);
+  if( rc==SQLITE_OK ) rc = sqlite3PagerWrite(pTrunk->pDbPage);
+  if( rc ){
+    releasePage(pTrunk);
+    btreeFreeIndexClear(pBt);
+    return rc;
+  }
+  put4byte(&pPage1->aData[36], get4byte(&pPage1->aData[36])-1);
+  if( iSlot<k-1 ){
+    memcpy(&aData[8+iSlot*4], &aData[4+k*4], 4);
+  }
+  put4byte(&aData[4], k-1);
+  pBest->nLeaf--;
+  memmove(&pBest->aLeaf[iLeaf], &pBest->aLeaf[iLeaf+1],
+          (pBest->nLeaf-iLeaf)*sizeof(Pgno));
+  TRACE(("ALLOCATE: %d was leaf %d of %d on trunk %d near %d\n",
+         iPage, iSlot+1, k, pTrunk->pgno, nearby));
+  releasePage(pTrunk);
+
+  *pPgno = iPage;
+  noContent = !btreeGetHasContent(pBt, iPage) ? PAGER_GET_NOCONTENT : 0;
+  rc = btreeGetUnusedPage(pBt, iPage, ppPage, noContent);
+  if( rc==SQLITE_OK ){
+    rc = sqlite3PagerWrite((*ppPage)->pDbPage);
+    if( rc!=SQLITE_OK ){
+      releasePage(*ppPage);
+      *ppPage = 0;
+    }
+  }
+  return rc;
+}
+#else
+# define btreeFreeIndexClear(B)
+# define btreeFreeIndexRemove(B,T,P)
+# define btreeFreeIndexAdd(B,T,P)
+# define btreeFreeIndexPush(B,P)
+# define btreeFreeIndexPop(B,T)
+#endif
+
+#ifdef SQLITE_ENABLE_OVERFLOW_CACHE
+/*
+** Discard every overflow chain map held by BtShared pBt.
+*/
+static void btreeOvflMapClear(BtShared *pBt){
+  int i;
+  for(i=0; i<BTREE_OVFLMAP_SIZE; i++){
+    sqlite3_free(pBt->aOvflMap[i].aPgno);
+  }
+  memset(pBt->aOvflMap, 0, sizeof(pBt->aOvflMap));
+}
+
+/*
+** Discard the map of the overflow chain that starts at page iFirst, if
+** there is one.  This is called before the chain is freed.
+*/
+static void btreeOvflMapDrop(BtShared *pBt, Pgno iFirst){
+  int i;
+  for(i=0; i<BTREE_OVFLMAP_SIZE; i++){
+    BtOvflMap *p = &pBt->aOvflMap[i];
+    if( p->iFirst==iFirst ){
+      sqlite3_free(p->aPgno);
+      memset(p, 0, sizeof(*p));
+    }
+  }
+}
+
+/*
+** Return the map of the nOvfl page overflow chain that starts at page
+** iFirst.  If there is no such map and bCreate is true, an empty one is
+** created in the least recently used slot.  NULL is returned if there
+** is no map, if the chain is too short to be worth mapping, or if memory
+** for a new map cannot be allocated.
+*/
+static BtOvflMap *btreeOvflMapFind(
+  BtShared *pBt,           /* The BTree that contains the chain */
+  Pgno iFirst,             /* First page of the chain */
+  u32 nOvfl,               /* Number of pages in the chain */
+  int bCreate              /* Create a map if there is none */
+){
+  BtOvflMap *pLru = 0;
+  u32 iVersion = sqlite3PagerDataVersion(pBt->pPager);
+  int i;
+
+  assert( sqlite3_mutex_held(pBt->mutex) );
+  if( nOvfl<BTREE_OVFLMAP_MINPAGES ) return 0;
+  if( pBt->iOvflVersion!=iVersion ){
+    /* Another connection has written to the database */
+    btreeOvflMapClear(pBt);
+    pBt->iOvflVersion = iVersion;
+  }
+  for(i=0; i<BTREE_OVFLMAP_SIZE; i++){
+    BtOvflMap *p = &pBt->aOvflMap[i];
+    if( p->iFirst==iFirst ){
+      if( p->nOvfl==nOvfl ){
+        p->iLru = ++pBt->iOvflTick;
+        return p;
+      }
+      sqlite3_free(p->aPgno);
+      memset(p, 0, sizeof(*p));
+    }
+    if( pLru==0 || p->iLru<pLru->iLru ) pLru = p;
+  }
+  if( bCreate==0 ) return 0;
+  sqlite3_free(pLru->aPgno);
+  memset(pLru, 0, sizeof(*pLru));
+  sqlite3BeginBenignMalloc();
+  pLru->aPgno = (Pgno*)sqlite3MallocZero(nOvfl*sizeof(Pgno));
+  sqlite3EndBenignMalloc();
+  if( pLru->aPgno==0 ) return 0;
+  pLru->iFirst = iFirst;
+  pLru->nOvfl = nOvfl;
+  pLru->iLru = ++pBt->iOvflTick;
+  return pLru;
+}
+#else
+# define btreeOvflMapClear(B)
+# define btreeOvflMapDrop(B,P)
+#endif
+
 /*
 ** Invoke the busy handler for a btree.
 */
@@ -2424,6 +3087,9 @@ int sqlite3BtreeOpen(
     pBt->btsFlags |= BTS_SECURE_DELETE;
 #elif defined(SQLITE_FAST_SECURE_DELETE)
     pBt->btsFlags |= BTS_OVERWRITE;
+#endif
+#if defined(SQLITE_ENABLE_INDEX_PREFIX) && SQLITE_DEFAULT_PREFIX_COMPRESSION
+    pBt->btsFlags |= BTS_PREFIX;
 #endif
     /* EVIDENCE-OF: R-51873-39618 The page size for a database file is
     ** determined by the 2-byte integer located at an offset of 16 bytes from
@@ -2674,6 +3340,17 @@ int sqlite3BtreeClose(Btree *p){
     }
     sqlite3DbFree(0, pBt->pSchema);
     freeTempSpace(pBt);
+#ifdef SQLITE_ENABLE_BTREE_KEYCACHE
+    sqlite3_free(pBt->aKeyCache);
+#endif
+#ifdef SQLITE_ENABLE_COUNTED_BTREE
+    sqlite3_free(pBt->aCount);
+#endif
+#ifdef SQLITE_ENABLE_FREELIST_INDEX
+    btreeFreeIndexClear(pBt);
+    sqlite3_free(pBt->aFreeTrunk);
+#endif
+    btreeOvflMapClear(pBt);
     sqlite3_free(pBt);
   }
 
@@ -2903,10 +3580,31 @@ int sqlite3BtreeSecureDelete(Btree *p, int newFlag){
   return b;
 }
 
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
 /*
-** Change the 'auto-vacuum' property of the database. If the 'autoVacuum'
-** parameter is non-zero, then auto-vacuum mode is enabled. If zero, it
-** is disabled. The default value for the auto-vacuum property is 
+** Set the BTS_PREFIX flag if newFlag is 1, or clear it if newFlag is 0.
+** While the flag is set, index leaf pages written by balance_nonroot() are
+** stored as PTF_PREFIX pages when their records share a prefix.  Return
+** the current value of the flag.  Pass a negative newFlag to query it.
+*/
+int sqlite3BtreePrefixCompression(Btree *p, int newFlag){
+  int b;
+  if( p==0 ) return 0;
+  sqlite3BtreeEnter(p);
+  if( newFlag>=0 ){
+    p->pBt->btsFlags &= ~BTS_PREFIX;
+    if( newFlag ) p->pBt->btsFlags |= BTS_PREFIX;
+  }
+  b = (p->pBt->btsFlags & BTS_PREFIX)!=0;
+  sqlite3BtreeLeave(p);
+  return b;
+}
+#endif
+
+/*
+** Change the 'auto-vacuum' property of the database. If the 'autoVacuum'
+** parameter is non-zero, then auto-vacuum mode is enabled. If zero, it
+** is disabled. The default value for the auto-vacuum property is 
 ** determined by the SQLITE_DEFAULT_AUTOVACUUM macro.
 */
 int sqlite3BtreeSetAutoVacuum(Btree *p, int autoVacuum){
@@ -2949,6 +3647,40 @@ int sqlite3BtreeGetAutoVacuum(Btree *p){
 #endif
 }
 
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+/*
+** Change the 'free-space map' property of the database.  Like the
+** 'auto-vacuum' property, this can only be changed before the database
+** is created.  A database with auto-vacuum enabled never has a free-space
+** map.
+*/
+int sqlite3BtreeSetFreemap(Btree *p, int bFreemap){
+  BtShared *pBt = p->pBt;
+  int rc = SQLITE_OK;
+  u8 b = bFreemap ? 1 : 0;
+
+  sqlite3BtreeEnter(p);
+  if( (pBt->btsFlags & BTS_PAGESIZE_FIXED)!=0 && b!=pBt->bFreemap ){
+    rc = SQLITE_READONLY;
+  }else{
+    pBt->bFreemap = b;
+  }
+  sqlite3BtreeLeave(p);
+  return rc;
+}
+
+/*
+** Return the value of the 'free-space map' property.
+*/
+int sqlite3BtreeGetFreemap(Btree *p){
+  int rc;
+  sqlite3BtreeEnter(p);
+  rc = p->pBt->bFreemap;
+  sqlite3BtreeLeave(p);
+  return rc;
+}
+#endif
+
 /*
 ** If the user has not set the safety-level for this database connection
 ** using "PRAGMA synchronous", and if the safety-level is not already
@@ -3018,6 +3750,8 @@ static int lockBtree(BtShared *pBt){
     u32 pageSize;
     u32 usableSize;
     u8 *page1 = pPage1->aData;
+    u8 iWrite = page1[18];  /* Write version, less any free-space map flag */
+    u8 iRead = page1[19];   /* Read version, less any PTF_PREFIX offset */
     rc = SQLITE_NOTADB;
     /* EVIDENCE-OF: R-43737-39999 Every valid SQLite database file begins
     ** with the following 16 bytes (in hex): 53 51 4c 69 74 65 20 66 6f 72 6d
@@ -3026,18 +3760,25 @@ static int lockBtree(BtShared *pBt){
       goto page1_init_failed;
     }
 
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+    if( iRead>2 ) iRead -= BTREE_PREFIX_VERSION_OFFSET;
+#endif
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+    pBt->bFreemap = (page1[18]==BTREE_FREEMAP_WRITEVERSION);
+    if( pBt->bFreemap ) iWrite = iRead;
+#endif
 #ifdef SQLITE_OMIT_WAL
-    if( page1[18]>1 ){
+    if( iWrite>1 ){
       pBt->btsFlags |= BTS_READ_ONLY;
     }
-    if( page1[19]>1 ){
+    if( iRead>1 ){
       goto page1_init_failed;
     }
 #else
-    if( page1[18]>2 ){
+    if( iWrite>2 ){
       pBt->btsFlags |= BTS_READ_ONLY;
     }
-    if( page1[19]>2 ){
+    if( iRead>2 ){
       goto page1_init_failed;
     }
 
@@ -3049,7 +3790,7 @@ static int lockBtree(BtShared *pBt){
     ** may not be the latest version - there may be a newer one in the log
     ** file.
     */
-    if( page1[19]==2 && (pBt->btsFlags & BTS_NO_WAL)==0 ){
+    if( iRead==2 && (pBt->btsFlags & BTS_NO_WAL)==0 ){
       int isOpen = 0;
       rc = sqlite3PagerOpenWal(pBt->pPager, &isOpen);
       if( rc!=SQLITE_OK ){
@@ -3127,6 +3868,11 @@ static int lockBtree(BtShared *pBt){
 #ifndef SQLITE_OMIT_AUTOVACUUM
     pBt->autoVacuum = (get4byte(&page1[36 + 4*4])?1:0);
     pBt->incrVacuum = (get4byte(&page1[36 + 7*4])?1:0);
+#endif
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+    if( pBt->bFreemap && IfNotOmitAV(pBt->autoVacuum) ){
+      goto page1_init_failed;
+    }
 #endif
   }
 
@@ -3245,6 +3991,10 @@ static int newDatabase(BtShared *pBt){
   assert( pBt->incrVacuum==1 || pBt->incrVacuum==0 );
   put4byte(&data[36 + 4*4], pBt->autoVacuum);
   put4byte(&data[36 + 7*4], pBt->incrVacuum);
+#endif
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+  if( IfNotOmitAV(pBt->autoVacuum) ) pBt->bFreemap = 0;
+  if( pBt->bFreemap ) data[18] = BTREE_FREEMAP_WRITEVERSION;
 #endif
   pBt->nPage = 1;
   data[31] = 1;
@@ -3596,6 +4346,7 @@ static int relocatePage(
     }
   }else{
     Pgno nextOvfl = get4byte(pDbPage->aData);
+    btreeOvflMapClear(pBt);
     if( nextOvfl!=0 ){
       ptrmapPut(pBt, nextOvfl, PTRMAP_OVERFLOW2, iFreePage, &rc);
       if( rc!=SQLITE_OK ){
@@ -3847,6 +4598,7 @@ static int autoVacuumCommit(BtShared *pBt){
       rc = sqlite3PagerWrite(pBt->pPage1->pDbPage);
       put4byte(&pBt->pPage1->aData[32], 0);
       put4byte(&pBt->pPage1->aData[36], 0);
+      btreeFreeIndexClear(pBt);
       put4byte(&pBt->pPage1->aData[28], nFin);
       pBt->bDoTruncate = 1;
       pBt->nPage = nFin;
@@ -3991,6 +4743,10 @@ int sqlite3BtreeCommitPhaseTwo(Btree *p, int bCleanup){
   if( p->inTrans==TRANS_WRITE ){
     int rc;
     BtShared *pBt = p->pBt;
+#if defined(SQLITE_ENABLE_FREELIST_INDEX) \
+ || defined(SQLITE_ENABLE_OVERFLOW_CACHE)
+    u32 iVersion = sqlite3PagerDataVersion(pBt->pPager);
+#endif
     assert( pBt->inTransaction==TRANS_WRITE );
     assert( pBt->nTransaction>0 );
     rc = sqlite3PagerCommitPhaseTwo(pBt->pPager);
@@ -3999,6 +4755,24 @@ int sqlite3BtreeCommitPhaseTwo(Btree *p, int bCleanup){
       return rc;
     }
     p->iDataVersion--;  /* Compensate for pPager->iDataVersion++; */
+#ifdef SQLITE_ENABLE_FREELIST_INDEX
+    /* The freelist index remains valid only if it was valid when the
+    ** transaction began, and so has been kept in step with all changes
+    ** to the freelist made by the transaction. */
+    if( rc==SQLITE_OK && pBt->iFreeVersion==iVersion ){
+      pBt->iFreeVersion = sqlite3PagerDataVersion(pBt->pPager);
+    }else{
+      btreeFreeIndexClear(pBt);
+    }
+#endif
+#ifdef SQLITE_ENABLE_OVERFLOW_CACHE
+    /* Likewise the overflow chain maps */
+    if( rc==SQLITE_OK && pBt->iOvflVersion==iVersion ){
+      pBt->iOvflVersion = sqlite3PagerDataVersion(pBt->pPager);
+    }else{
+      btreeOvflMapClear(pBt);
+    }
+#endif
     pBt->inTransaction = TRANS_READ;
     btreeClearHasContent(pBt);
   }
@@ -4116,6 +4890,9 @@ int sqlite3BtreeRollback(Btree *p, int tripCode, int writeOnly){
     if( rc2!=SQLITE_OK ){
       rc = rc2;
     }
+    btreeCountReset(pBt);
+    btreeFreeIndexClear(pBt);
+    btreeOvflMapClear(pBt);
 
     /* The rollback may have destroyed the pPage1->aData value.  So
     ** call btreeGetPage() on page 1 again to make
@@ -4200,6 +4977,11 @@ int sqlite3BtreeSavepoint(Btree *p, int op, int iSavepoint){
     if( rc==SQLITE_OK ){
       rc = sqlite3PagerSavepoint(pBt->pPager, op, iSavepoint);
     }
+    if( op==SAVEPOINT_ROLLBACK ){
+      btreeCountReset(pBt);
+      btreeFreeIndexClear(pBt);
+      btreeOvflMapClear(pBt);
+    }
     if( rc==SQLITE_OK ){
       if( iSavepoint<0 && (pBt->btsFlags & BTS_INITIALLY_EMPTY)!=0 ){
         pBt->nPage = 0;
@@ -4387,6 +5169,9 @@ int sqlite3BtreeCloseCursor(BtCursor *pCur){
     unlockBtreeIfUnused(pBt);
     sqlite3_free(pCur->aOverflow);
     sqlite3_free(pCur->pKey);
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+    sqlite3_free(pCur->aRecord);
+#endif
     sqlite3BtreeLeave(pBtree);
   }
   return SQLITE_OK;
@@ -4644,10 +5429,17 @@ static int accessPayload(
   assert( pCur->eState==CURSOR_VALID );
   assert( pCur->ix<pPage->nCell );
   assert( cursorHoldsMutex(pCur) );
+  if( eOp ) pPage->iZoneTag = 0;
 
   getCellInfo(pCur);
   aPayload = pCur->info.pPayload;
   assert( offset+amt <= pCur->info.nPayload );
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  if( pPage->nPrefix ){
+    assert( eOp==0 );
+    return btreePrefixRead(pPage, &pCur->info, offset, amt, pBuf);
+  }
+#endif
 
   assert( aPayload > pPage->aData );
   if( (uptr)(aPayload - pPage->aData) > (pBt->usableSize - pCur->info.nLocal) ){
@@ -4676,7 +5468,11 @@ static int accessPayload(
 
   if( rc==SQLITE_OK && amt>0 ){
     const u32 ovflSize = pBt->usableSize - 4;  /* Bytes content per ovfl page */
+    const int nOvfl = (pCur->info.nPayload-pCur->info.nLocal+ovflSize-1)/ovflSize;
     Pgno nextPage;
+#ifdef SQLITE_ENABLE_OVERFLOW_CACHE
+    BtOvflMap *pMap;                           /* Shared map of the chain */
+#endif
 
     nextPage = get4byte(&aPayload[pCur->info.nLocal]);
 
@@ -4688,7 +5484,6 @@ static int accessPayload(
     ** means "not yet known" (the cache is lazily populated).
     */
     if( (pCur->curFlags & BTCF_ValidOvfl)==0 ){
-      int nOvfl = (pCur->info.nPayload-pCur->info.nLocal+ovflSize-1)/ovflSize;
       if( pCur->aOverflow==0
        || nOvfl*(int)sizeof(Pgno) > sqlite3MallocSize(pCur->aOverflow)
       ){
@@ -4702,7 +5497,28 @@ static int accessPayload(
         }
       }
       memset(pCur->aOverflow, 0, nOvfl*sizeof(Pgno));
+#ifdef SQLITE_ENABLE_OVERFLOW_CACHE
+      /* Start from whatever is already known about the chain */
+      pMap = btreeOvflMapFind(pBt, nextPage, nOvfl, 1);
+      if( pMap ) memcpy(pCur->aOverflow, pMap->aPgno, nOvfl*sizeof(Pgno));
+#endif
       pCur->curFlags |= BTCF_ValidOvfl;
+#ifdef SQLITE_ENABLE_OVERFLOW_CACHE
+    }else{
+      pMap = btreeOvflMapFind(pBt, nextPage, nOvfl, 0);
+    }
+    {
+      /* The known entries of aOverflow[] are always a prefix of the
+      ** chain.  Skip to the last known page at or before the one that
+      ** holds offset, so that only the pages after it are walked. */
+      iIdx = offset/ovflSize;
+      while( iIdx>0 && pCur->aOverflow[iIdx]==0 ) iIdx--;
+      if( iIdx>0 ){
+        nextPage = pCur->aOverflow[iIdx];
+        offset -= iIdx*ovflSize;
+      }
+    }
+#else
     }else{
       /* If the overflow page-list cache has been allocated and the
       ** entry for the first required overflow page is valid, skip
@@ -4714,6 +5530,7 @@ static int accessPayload(
         offset = (offset%ovflSize);
       }
     }
+#endif
 
     assert( rc==SQLITE_OK && amt>0 );
     while( nextPage ){
@@ -4722,6 +5539,9 @@ static int accessPayload(
               || pCur->aOverflow[iIdx]==nextPage
               || CORRUPT_DB );
       pCur->aOverflow[iIdx] = nextPage;
+#ifdef SQLITE_ENABLE_OVERFLOW_CACHE
+      if( pMap ) pMap->aPgno[iIdx] = nextPage;
+#endif
 
       if( offset>=ovflSize ){
         /* The only reason to read this page is to obtain the page
@@ -4865,6 +5685,52 @@ int sqlite3BtreePayloadChecked(BtCursor *pCur, u32 offset, u32 amt, void *pBuf){
 }
 #endif /* SQLITE_OMIT_INCRBLOB */
 
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+/*
+** Copy the complete record held by cell pInfo of PTF_PREFIX page pPage
+** into the BtCursor.aRecord buffer of pCur, allocating the buffer if
+** required.  The buffer is one page in size, which leaves room after the
+** largest record that fits on a page for the over-read permitted to
+** xRecordCompare on corrupt records.
+*/
+static int btreePrefixExpand(BtCursor *pCur, MemPage *pPage, CellInfo *pInfo){
+  if( pCur->aRecord==0 ){
+    pCur->aRecord = (u8*)sqlite3Malloc(pCur->pBt->pageSize);
+    if( pCur->aRecord==0 ) return SQLITE_NOMEM_BKPT;
+  }
+  return btreePrefixRead(pPage, pInfo, 0, pInfo->nPayload, pCur->aRecord);
+}
+
+/*
+** Rebuild cell pCell of PTF_PREFIX page pPage as a standard format cell
+** of an interior page, with 4 bytes reserved for the child page number,
+** in the BtCursor.aRecord buffer of pCur.  Write the size of the interior
+** cell into *pnCell.
+*/
+static int btreePrefixInteriorCell(
+  BtCursor *pCur,
+  MemPage *pPage,
+  u8 *pCell,
+  int *pnCell
+){
+  CellInfo info;
+  int nHdr;
+  int rc;
+  btreeParseCellPtrPrefix(pPage, pCell, &info);
+  if( info.nPayload==0 ) return SQLITE_CORRUPT_PAGE(pPage);
+  nHdr = (int)(info.pPayload - pCell);
+  rc = btreePrefixExpand(pCur, pPage, &info);
+  if( rc==SQLITE_OK ){
+    u8 *aRecord = pCur->aRecord;
+    memmove(&aRecord[4+nHdr], aRecord, info.nPayload);
+    memcpy(&aRecord[4], pCell, nHdr);
+    if( nHdr+info.nPayload<4 ) memset(&aRecord[4+nHdr+info.nPayload], 0, 4);
+    *pnCell = 4 + MAX(4, nHdr+(int)info.nPayload);
+  }
+  return rc;
+}
+#endif
+
 /*
 ** Return a pointer to payload information from the entry that the 
 ** pCur cursor is pointing to.  The pointer is to the beginning of
@@ -4897,6 +5763,19 @@ static const void *fetchPayload(
   assert( pCur->info.nSize>0 );
   assert( pCur->info.pPayload>pCur->pPage->aData || CORRUPT_DB );
   assert( pCur->info.pPayload<pCur->pPage->aDataEnd ||CORRUPT_DB);
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  if( pCur->pPage->nPrefix ){
+    /* Return the record reassembled from the page prefix and the cell.  If
+    ** that fails, report no bytes available so that the caller falls back
+    ** to accessPayload(), which reports the error. */
+    if( btreePrefixExpand(pCur, pCur->pPage, &pCur->info) ){
+      *pAmt = 0;
+      return (void*)pCur->info.pPayload;
+    }
+    *pAmt = pCur->info.nPayload;
+    return (void*)pCur->aRecord;
+  }
+#endif
   amt = pCur->info.nLocal;
   if( amt>(int)(pCur->pPage->aDataEnd - pCur->info.pPayload) ){
     /* There is too little space on the page for the expected amount
@@ -5223,6 +6102,158 @@ int sqlite3BtreeLast(BtCursor *pCur, int *pRes){
   return rc;
 }
 
+#ifdef SQLITE_ENABLE_BTREE_KEYCACHE
+/*
+** Read the integer key of cell iCell of page pPage into *piKey.  For an
+** intkey page this is the rowid.  For an index page it is the first
+** field of the record, which must be an integer stored entirely on the
+** page.  Return non-zero if successful, or zero if the cell has no such
+** key.
+*/
+static int btreeKeyCacheCell(MemPage *pPage, int iCell, i64 *piKey){
+  static const u8 aSize[] = { 0, 1, 2, 3, 4, 6, 8 };
+  u8 *pCell = findCellPastPtr(pPage, iCell);
+  u8 *pEnd = pPage->aDataEnd;
+  u32 nPayload;                   /* Size of the index record */
+  u32 nHdr;                       /* Size of the record header */
+  u32 t;                          /* Serial type of the first field */
+  u8 *pRec;                       /* First byte of the record */
+  u8 *pBody;                      /* First byte of the first field */
+  u64 x;
+  int i;
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  u8 aRec[32];                    /* Leading bytes of a compressed record */
+#endif
+
+  if( pPage->intKey ){
+    if( pPage->intKeyLeaf ){
+      while( 0x80 <= *(pCell++) ){
+        if( pCell>=pEnd ) return 0;
+      }
+    }
+    getVarint(pCell, (u64*)piKey);
+    return 1;
+  }
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  if( pPage->nPrefix ){
+    /* Reassemble the start of the record.  Records whose first field
+    ** ends beyond sizeof(aRec) bytes are not cached. */
+    CellInfo info;
+    btreeParseCellPtrPrefix(pPage, pCell, &info);
+    nPayload = MIN(info.nPayload, sizeof(aRec));
+    if( btreePrefixRead(pPage, &info, 0, nPayload, aRec) ) return 0;
+    pRec = aRec;
+  }else
+#endif
+  {
+    pRec = pCell + getVarint32(pCell, nPayload);
+    if( nPayload>pPage->maxLocal || &pRec[nPayload]>pEnd ) return 0;
+  }
+  i = getVarint32(pRec, nHdr);
+  if( nHdr<=(u32)i || nHdr>nPayload ) return 0;
+  getVarint32(&pRec[i], t);
+  if( t==8 || t==9 ){
+    *piKey = t-8;
+    return 1;
+  }
+  if( t<1 || t>6 || nHdr+aSize[t]>nPayload ) return 0;
+  pBody = &pRec[nHdr];
+  x = (pBody[0] & 0x80) ? ~(u64)0 : 0;
+  for(i=0; i<aSize[t]; i++){
+    x = (x<<8) | pBody[i];
+  }
+  *piKey = (i64)x;
+  return 1;
+}
+
+/*
+** Return the key cache of page pPage, building it if the page has been
+** searched once before without one.  Return NULL if the page has no key
+** cache, either because it is too small or its keys are not integers, or
+** because it has not yet been searched often enough.
+*/
+static BtKeyCache *btreeKeyCacheGet(MemPage *pPage){
+  BtShared *pBt = pPage->pBt;
+  BtKeyCache *p;
+  int nCell = pPage->nCell;
+  int i;
+
+  assert( sqlite3_mutex_held(pBt->mutex) );
+  assert( pPage->nOverflow==0 );
+  if( pPage->iKeyTag ){
+    p = &pBt->aKeyCache[pPage->pgno & (BTREE_KEYCACHE_SIZE-1)];
+    if( p->pPage==pPage && p->iTag==pPage->iKeyTag ) return p;
+    /* The slot has since been taken by the cache of some other page */
+    btreeKeyCacheClear(pPage);
+  }
+  if( nCell<BTREE_KEYCACHE_N*2 || pPage->nKeySearch==KEYCACHE_UNUSABLE ){
+    return 0;
+  }
+  if( pPage->nKeySearch==0 ){
+    pPage->nKeySearch = 1;
+    return 0;
+  }
+  if( pBt->aKeyCache==0 ){
+    sqlite3BeginBenignMalloc();
+    pBt->aKeyCache = (BtKeyCache*)sqlite3MallocZero(
+        sizeof(BtKeyCache)*BTREE_KEYCACHE_SIZE
+    );
+    sqlite3EndBenignMalloc();
+    if( pBt->aKeyCache==0 ) return 0;
+  }
+  p = &pBt->aKeyCache[pPage->pgno & (BTREE_KEYCACHE_SIZE-1)];
+  p->pPage = 0;
+  for(i=0; i<BTREE_KEYCACHE_N; i++){
+    int iCell = ((i+1)*nCell)/(BTREE_KEYCACHE_N+1);
+    p->aKeyCell[i] = (u16)iCell;
+    if( btreeKeyCacheCell(pPage, iCell, &p->aKey[i])==0 ){
+      pPage->nKeySearch = KEYCACHE_UNUSABLE;
+      return 0;
+    }
+  }
+  if( ++pBt->iKeyTag==0 ) pBt->iKeyTag = 1;
+  p->pPage = pPage;
+  p->iTag = pPage->iKeyTag = pBt->iKeyTag;
+  return p;
+}
+
+/*
+** Narrow the range of cells [*pLwr, *pUpr] that a binary search of page
+** pPage for integer key iKey must examine, using the key cache of the
+** page if it has one.  The search key is compared against every sample.
+** The loop has no branches that depend on the data, so that the compiler
+** is free to turn it into vector compares.
+**
+** On intkey pages a sample equal to iKey identifies the cell sought, and
+** the range is reduced to that single cell.  On index pages only the
+** first field is known, so equal samples do not narrow the range.
+*/
+static void btreeKeyCacheBound(MemPage *pPage, i64 iKey, int *pLwr, int *pUpr){
+  BtKeyCache *p = btreeKeyCacheGet(pPage);
+  const i64 *aKey;
+  int nLt = 0;                    /* Number of samples less than iKey */
+  int nLe = 0;                    /* Number of samples less than or equal */
+  int lwr, upr;
+  int i;
+
+  if( p==0 ) return;
+  aKey = p->aKey;
+  for(i=0; i<BTREE_KEYCACHE_N; i++){
+    nLt += (aKey[i]<iKey);
+    nLe += (aKey[i]<=iKey);
+  }
+  if( nLe>nLt && pPage->intKey ){
+    *pLwr = *pUpr = p->aKeyCell[nLt];
+    return;
+  }
+  lwr = nLt>0 ? p->aKeyCell[nLt-1]+1 : 0;
+  upr = nLe<BTREE_KEYCACHE_N ? p->aKeyCell[nLe]-1 : pPage->nCell-1;
+  if( lwr>upr ) lwr = upr;
+  *pLwr = lwr;
+  *pUpr = upr;
+}
+#endif /* SQLITE_ENABLE_BTREE_KEYCACHE */
+
 /* Move the cursor so that it points to an entry near the key 
 ** specified by pIdxKey or intKey.   Return a success code.
 **
@@ -5262,6 +6293,10 @@ int sqlite3BtreeMovetoUnpacked(
 ){
   int rc;
   RecordCompare xRecordCompare;
+#ifdef SQLITE_ENABLE_BTREE_KEYCACHE
+  int bKeyCache;           /* True if the page key caches may be used */
+  i64 iKeyCache = intKey;  /* Integer key to look up in the key caches */
+#endif
 
   assert( cursorOwnsBtShared(pCur) );
   assert( sqlite3_mutex_held(pCur->pBtree->db->mutex) );
@@ -5314,6 +6349,9 @@ int sqlite3BtreeMovetoUnpacked(
   }else{
     xRecordCompare = 0; /* All keys are integers */
   }
+#ifdef SQLITE_ENABLE_BTREE_KEYCACHE
+  bKeyCache = pIdxKey==0 || sqlite3VdbeRecordIntKey(pIdxKey, &iKeyCache);
+#endif
 
   rc = moveToRoot(pCur);
   if( rc ){
@@ -5346,8 +6384,11 @@ int sqlite3BtreeMovetoUnpacked(
     assert( pPage->intKey==(pIdxKey==0) );
     lwr = 0;
     upr = pPage->nCell-1;
+#ifdef SQLITE_ENABLE_BTREE_KEYCACHE
+    if( bKeyCache ) btreeKeyCacheBound(pPage, iKeyCache, &lwr, &upr);
+#endif
     assert( biasRight==0 || biasRight==1 );
-    idx = upr>>(1-biasRight); /* idx = biasRight ? upr : (lwr+upr)/2; */
+    idx = biasRight ? upr : (lwr+upr)>>1;
     pCur->ix = (u16)idx;
     if( xRecordCompare==0 ){
       for(;;){
@@ -5398,6 +6439,21 @@ int sqlite3BtreeMovetoUnpacked(
         ** 2 bytes of the cell.
         */
         nCell = pCell[0];
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+        if( pPage->nPrefix ){
+          /* The cell holds only the part of the record that follows the
+          ** prefix of the page.  Compare against the complete record. */
+          CellInfo info;
+          btreeParseCellPtrPrefix(pPage, pCell, &info);
+          if( info.nPayload<2 ){
+            rc = SQLITE_CORRUPT_PAGE(pPage);
+            goto moveto_finish;
+          }
+          rc = btreePrefixExpand(pCur, pPage, &info);
+          if( rc ) goto moveto_finish;
+          c = xRecordCompare(info.nPayload, pCur->aRecord, pIdxKey);
+        }else
+#endif
         if( nCell<=pPage->max1bytePayload ){
           /* This branch runs if the record-size field of the cell is a
           ** single byte varint and the record fits entirely on the main
@@ -5732,6 +6788,197 @@ int sqlite3BtreePrevious(BtCursor *pCur, int flags){
   return SQLITE_OK;
 }
 
+/*
+** Add value iVal, or a NULL if isNull is true, for the entry that cursor
+** pCur points to to the zone summary of the current leaf page.  iTag
+** identifies the value being summarized and must be positive.
+**
+** The summary is restarted when the cursor is on the first cell of the
+** page.  Values must then be added for every cell, in order, for the
+** summary to become complete.  A complete summary remains available to
+** sqlite3BtreeZoneGet() until the content of the page changes or a
+** summary with a different tag is started.
+*/
+void sqlite3BtreeZoneAdd(BtCursor *pCur, int iTag, i64 iVal, int isNull){
+  MemPage *pPage = pCur->pPage;
+  assert( cursorOwnsBtShared(pCur) );
+  assert( pCur->eState==CURSOR_VALID );
+  assert( iTag>0 );
+  if( !pPage->leaf || pPage->nOverflow ) return;
+  if( pPage->iZoneTag==iTag && pPage->nZoneCell==pPage->nCell ) return;
+  if( pCur->ix==0 ){
+    pPage->iZoneTag = iTag;
+    pPage->nZoneCell = 0;
+    pPage->iZoneMin = LARGEST_INT64;
+    pPage->iZoneMax = SMALLEST_INT64;
+  }else if( pPage->iZoneTag!=iTag || pPage->nZoneCell!=pCur->ix ){
+    return;
+  }
+  pPage->nZoneCell++;
+  if( !isNull ){
+    if( iVal<pPage->iZoneMin ) pPage->iZoneMin = iVal;
+    if( iVal>pPage->iZoneMax ) pPage->iZoneMax = iVal;
+  }
+}
+
+/*
+** If cursor pCur is on the first cell of a leaf page (or on the last
+** cell if bRev is true) and that page has a complete zone summary for
+** iTag, write the smallest and largest non-NULL values of the page into
+** *piMin and *piMax and return non-zero.  *piMin is greater than *piMax
+** if every value is NULL.  Otherwise return zero.
+*/
+int sqlite3BtreeZoneGet(
+  BtCursor *pCur,
+  int iTag,
+  int bRev,
+  i64 *piMin,
+  i64 *piMax
+){
+  MemPage *pPage = pCur->pPage;
+  assert( cursorOwnsBtShared(pCur) );
+  if( pCur->eState!=CURSOR_VALID || !pPage->leaf ) return 0;
+  if( pCur->ix!=(bRev ? pPage->nCell-1 : 0) ) return 0;
+  if( pPage->iZoneTag!=iTag || pPage->nZoneCell!=pPage->nCell ) return 0;
+  *piMin = pPage->iZoneMin;
+  *piMax = pPage->iZoneMax;
+  return 1;
+}
+
+/*
+** Move cursor pCur, which points into a leaf page, past the remaining
+** cells of that page.  The cursor is left on the first cell of the next
+** leaf page, or on the last cell of the previous leaf page if bRev is
+** true.  Return values are as for sqlite3BtreeNext().
+*/
+int sqlite3BtreeSkipLeaf(BtCursor *pCur, int bRev){
+  assert( cursorOwnsBtShared(pCur) );
+  assert( pCur->eState==CURSOR_VALID );
+  assert( pCur->pPage->leaf );
+  if( bRev ){
+    pCur->ix = 0;
+    return sqlite3BtreePrevious(pCur, 0);
+  }
+  pCur->ix = pCur->pPage->nCell-1;
+  return sqlite3BtreeNext(pCur, 0);
+}
+
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+/*
+** Return the index of the first bit in the range iFrom..iTo-1 that is set
+** in bitmap aMap[], or -1 if there is no such bit.
+*/
+static int freemapFindNext(const u8 *aMap, int iFrom, int iTo){
+  int i = iFrom;
+  while( i<iTo ){
+    if( (i&7)==0 && aMap[i/8]==0 ){
+      i += 8;
+    }else if( aMap[i/8] & (1<<(i&7)) ){
+      return i;
+    }else{
+      i++;
+    }
+  }
+  return -1;
+}
+
+/*
+** Return the index of the last bit in the range iFrom..iTo-1 that is set
+** in bitmap aMap[], or -1 if there is no such bit.
+*/
+static int freemapFindPrev(const u8 *aMap, int iFrom, int iTo){
+  int i = iTo-1;
+  while( i>=iFrom ){
+    if( (i&7)==7 && aMap[i/8]==0 ){
+      i -= 8;
+    }else if( aMap[i/8] & (1<<(i&7)) ){
+      return i;
+    }else{
+      i--;
+    }
+  }
+  return -1;
+}
+
+/*
+** Allocate a page from the free-space map of a database that has one.
+**
+** The first free page that follows page nearby is preferred, then the
+** last free page before it that is covered by the same map page, then
+** the first free page covered by each of the following map pages in
+** turn, wrapping around to the start of the file.  Pages allocated one
+** after another for a growing b-tree therefore run forwards through a
+** range of free pages.  Otherwise, this function behaves as
+** allocateBtreePage().
+*/
+static int freemapAllocate(
+  BtShared *pBt,         /* The btree */
+  MemPage **ppPage,      /* Store pointer to the allocated page here */
+  Pgno *pPgno,           /* Store the page number here */
+  Pgno nearby            /* Search for a page near this one */
+){
+  MemPage *pPage1 = pBt->pPage1;
+  Pgno mxPage = btreePagecount(pBt);
+  u32 nPagesPerMapPage = pBt->usableSize*8 + 1;
+  u32 nMap;              /* Number of map pages in the file */
+  u32 iFirst;            /* Index of the map page covering nearby */
+  u32 i;
+  Pgno iMap = 0;         /* Map page being searched */
+  int iBit = -1;         /* Bit of the free page found on iMap */
+  int noContent;
+  int rc;
+
+  *ppPage = 0;
+  assert( pBt->bFreemap );
+  assert( mxPage>=2 );
+  if( nearby<2 || nearby>mxPage ) nearby = 2;
+  nMap = (mxPage-2)/nPagesPerMapPage + 1;
+  iFirst = (nearby-2)/nPagesPerMapPage;
+  for(i=0; i<nMap && iBit<0; i++){
+    DbPage *pDbPage;
+    const u8 *aMap;
+    int nBit;
+    iMap = FREEMAP_PAGENO(pBt, ((iFirst+i)%nMap)*nPagesPerMapPage + 2);
+    if( iMap>=mxPage ) continue;
+    nBit = (int)MIN(pBt->usableSize*8, mxPage-iMap);
+    rc = sqlite3PagerGet(pBt->pPager, iMap, &pDbPage, 0);
+    if( rc!=SQLITE_OK ) return rc;
+    aMap = (const u8*)sqlite3PagerGetData(pDbPage);
+    if( i==0 && nearby>iMap ){
+      int iNear = (int)FREEMAP_BIT(iMap, nearby);
+      iBit = freemapFindNext(aMap, iNear, nBit);
+      if( iBit<0 ) iBit = freemapFindPrev(aMap, 0, iNear);
+    }else{
+      iBit = freemapFindNext(aMap, 0, nBit);
+    }
+    sqlite3PagerUnref(pDbPage);
+  }
+  if( iBit<0 ){
+    /* The header says there are free pages, but none are marked free */
+    return SQLITE_CORRUPT_BKPT;
+  }
+
+  *pPgno = iMap + 1 + iBit;
+  rc = sqlite3PagerWrite(pPage1->pDbPage);
+  if( rc==SQLITE_OK ) rc = freemapSet(pBt, *pPgno, 0);
+  if( rc!=SQLITE_OK ) return rc;
+  put4byte(&pPage1->aData[36], get4byte(&pPage1->aData[36])-1);
+  TRACE(("ALLOCATE: %d from free-space map page %d near %d\n",
+         *pPgno, iMap, nearby));
+
+  noContent = !btreeGetHasContent(pBt, *pPgno) ? PAGER_GET_NOCONTENT : 0;
+  rc = btreeGetUnusedPage(pBt, *pPgno, ppPage, noContent);
+  if( rc==SQLITE_OK ){
+    rc = sqlite3PagerWrite((*ppPage)->pDbPage);
+    if( rc!=SQLITE_OK ){
+      releasePage(*ppPage);
+      *ppPage = 0;
+    }
+  }
+  return rc;
+}
+#endif
+
 /*
 ** Allocate a new page from the database file.
 **
@@ -5753,6 +7000,11 @@ int sqlite3BtreePrevious(BtCursor *pCur, int flags){
 ** eMode is BTALLOC_LT then the page returned will be less than or equal
 ** to nearby if any such page exists.  If eMode is BTALLOC_ANY then there
 ** are no restrictions on which page is returned.
+**
+** When built with SQLITE_ENABLE_FREELIST_INDEX, a BTALLOC_ANY request with
+** a nearby page is satisfied from anywhere on the freelist, not just the
+** first trunk page, using the freelist index.  A database that has a
+** free-space map allocates from that instead of the freelist.
 */
 static int allocateBtreePage(
   BtShared *pBt,         /* The btree */
@@ -5780,6 +7032,14 @@ static int allocateBtreePage(
   if( n>=mxPage ){
     return SQLITE_CORRUPT_BKPT;
   }
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+  if( n>0 && pBt->bFreemap ){
+    /* There are pages in the free-space map.  Reuse one of those pages. */
+    assert( eMode==BTALLOC_ANY );
+    rc = freemapAllocate(pBt, ppPage, pPgno, nearby);
+    if( rc ) return rc;
+  }else
+#endif
   if( n>0 ){
     /* There are pages on the freelist.  Reuse one of those pages. */
     Pgno iTrunk;
@@ -5805,6 +7065,14 @@ static int allocateBtreePage(
     }else if( eMode==BTALLOC_LE ){
       searchList = 1;
     }
+    if( searchList ) btreeFreeIndexClear(pBt);
+#endif
+
+#ifdef SQLITE_ENABLE_FREELIST_INDEX
+    if( eMode==BTALLOC_ANY && nearby>0 ){
+      rc = btreeFreeIndexAllocate(pBt, ppPage, pPgno, nearby);
+      if( rc!=SQLITE_OK || *ppPage ) goto end_allocate_page;
+    }
 #endif
 
     /* Decrement the free-list count by 1. Set iTrunk to the index of the
@@ -5858,6 +7126,7 @@ static int allocateBtreePage(
         }
         *pPgno = iTrunk;
         memcpy(&pPage1->aData[32], &pTrunk->aData[0], 4);
+        btreeFreeIndexPop(pBt, iTrunk);
         *ppPage = pTrunk;
         pTrunk = 0;
         TRACE(("ALLOCATE: %d trunk - %d free pages left\n", *pPgno, n-1));
@@ -5980,6 +7249,7 @@ static int allocateBtreePage(
             memcpy(&aData[8+closest*4], &aData[4+k*4], 4);
           }
           put4byte(&aData[4], k-1);
+          btreeFreeIndexRemove(pBt, iTrunk, iPage);
           noContent = !btreeGetHasContent(pBt, *pPgno)? PAGER_GET_NOCONTENT : 0;
           rc = btreeGetUnusedPage(pBt, *pPgno, ppPage, noContent);
           if( rc==SQLITE_OK ){
@@ -6039,6 +7309,26 @@ static int allocateBtreePage(
       pBt->nPage++;
       if( pBt->nPage==PENDING_BYTE_PAGE(pBt) ){ pBt->nPage++; }
     }
+#endif
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+    if( pBt->bFreemap && FREEMAP_ISPAGE(pBt, pBt->nPage) ){
+      /* Likewise, if *pPgno refers to a free-space map page, allocate an
+      ** empty map page followed by the page used by the caller.
+      */
+      MemPage *pPg = 0;
+      TRACE(("ALLOCATE: %d from end of file (free-space map page)\n",
+             pBt->nPage));
+      assert( pBt->nPage!=PENDING_BYTE_PAGE(pBt) );
+      rc = btreeGetUnusedPage(pBt, pBt->nPage, &pPg, bNoContent);
+      if( rc==SQLITE_OK ){
+        rc = sqlite3PagerWrite(pPg->pDbPage);
+        if( rc==SQLITE_OK ) memset(pPg->aData, 0, pBt->pageSize);
+        releasePage(pPg);
+      }
+      if( rc ) return rc;
+      pBt->nPage++;
+      if( pBt->nPage==PENDING_BYTE_PAGE(pBt) ){ pBt->nPage++; }
+    }
 #endif
     put4byte(28 + (u8*)pBt->pPage1->aData, pBt->nPage);
     *pPgno = pBt->nPage;
@@ -6122,6 +7412,23 @@ static int freePage2(BtShared *pBt, MemPage *pMemPage, Pgno iPage){
     if( rc ) goto freepage_out;
   }
 
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+  /* If the database has a free-space map, set the bit for the page.  As
+  ** for a new freelist leaf, the content of the page need not be written.
+  */
+  if( pBt->bFreemap ){
+    rc = freemapSet(pBt, iPage, 1);
+    if( rc==SQLITE_OK ){
+      if( pPage && (pBt->btsFlags & BTS_SECURE_DELETE)==0 ){
+        sqlite3PagerDontWrite(pPage->pDbPage);
+      }
+      rc = btreeSetHasContent(pBt, iPage);
+    }
+    TRACE(("FREE-PAGE: %d in free-space map\n", iPage));
+    goto freepage_out;
+  }
+#endif
+
   /* Now manipulate the actual database free-list structure. There are two
   ** possibilities. If the free-list is currently empty, or if the first
   ** trunk page in the free-list is full, then this page will become a
@@ -6168,6 +7475,7 @@ static int freePage2(BtShared *pBt, MemPage *pMemPage, Pgno iPage){
       if( rc==SQLITE_OK ){
         put4byte(&pTrunk->aData[4], nLeaf+1);
         put4byte(&pTrunk->aData[8+nLeaf*4], iPage);
+        btreeFreeIndexAdd(pBt, iTrunk, iPage);
         if( pPage && (pBt->btsFlags & BTS_SECURE_DELETE)==0 ){
           sqlite3PagerDontWrite(pPage->pDbPage);
         }
@@ -6194,6 +7502,7 @@ static int freePage2(BtShared *pBt, MemPage *pMemPage, Pgno iPage){
   put4byte(pPage->aData, iTrunk);
   put4byte(&pPage->aData[4], 0);
   put4byte(&pPage1->aData[32], iPage);
+  btreeFreeIndexPush(pBt, iPage);
   TRACE(("FREE-PAGE: %d new trunk page replacing %d\n", pPage->pgno, iTrunk));
 
 freepage_out:
@@ -6238,6 +7547,7 @@ static int clearCell(
   }
   ovflPgno = get4byte(pCell + pInfo->nSize - 4);
   pBt = pPage->pBt;
+  btreeOvflMapDrop(pBt, ovflPgno);
   assert( pBt->usableSize > 4 );
   ovflPageSize = pBt->usableSize - 4;
   nOvfl = (pInfo->nPayload - pInfo->nLocal + ovflPageSize - 1)/ovflPageSize;
@@ -6382,7 +7692,7 @@ static int fillInCell(
   ** were computed correctly.
   */
 #ifdef SQLITE_DEBUG
-  {
+  if( btreePagePrefix(pPage)==0 ){
     CellInfo info;
     pPage->xParseCell(pPage, pCell, &info);
     assert( nHeader==(int)(info.pPayload - pCell) );
@@ -6479,6 +7789,96 @@ static int fillInCell(
   return SQLITE_OK;
 }
 
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+/*
+** Switch index leaf page pPage between the standard cell format
+** (nPrefix==0) and the PTF_PREFIX format with an nPrefix byte prefix.
+** Only the flag byte and the length byte of the prefix are written.  The
+** caller supplies the prefix itself and makes sure that the cells on the
+** page are in the right format.
+*/
+static void btreePrefixSetFormat(MemPage *pPage, int nPrefix){
+  u8 *data = pPage->aData;
+  int hdr = pPage->hdrOffset;
+  assert( pPage->leaf && pPage->intKey==0 );
+  assert( nPrefix>=0 && nPrefix<=255 );
+  assert( sqlite3PagerIswriteable(pPage->pDbPage) );
+  pPage->nPrefix = (u8)nPrefix;
+  if( nPrefix ){
+    data[hdr] = PTF_ZERODATA|PTF_LEAF|PTF_PREFIX;
+    data[pPage->pBt->usableSize-1] = (u8)nPrefix;
+    pPage->xParseCell = btreeParseCellPtrPrefix;
+    pPage->xCellSize = cellSizePtrPrefix;
+  }else{
+    data[hdr] = PTF_ZERODATA|PTF_LEAF;
+    pPage->xParseCell = btreeParseCellPtrIndex;
+    pPage->xCellSize = cellSizePtr;
+  }
+}
+
+/*
+** Raise the read version of the database to show that it holds PTF_PREFIX
+** pages, if this has not been done already.  This is called before the
+** first such page is written.
+*/
+static int btreeMarkPrefixPages(BtShared *pBt){
+  u8 *aData = pBt->pPage1->aData;
+  int rc = SQLITE_OK;
+  if( aData[19]<=2 ){
+    rc = sqlite3PagerWrite(pBt->pPage1->pDbPage);
+    if( rc==SQLITE_OK ) aData[19] += BTREE_PREFIX_VERSION_OFFSET;
+  }
+  return rc;
+}
+
+/*
+** Try to store the standard format index cell pCell as the i-th cell of
+** PTF_PREFIX page pPage.  This is possible if the record fits on the page
+** without overflow, begins with the prefix of the page and the page has
+** room for the compressed cell.  Return 1 if the cell was stored or an
+** error was written to *pRC, or 0 if the cell cannot be stored.
+*/
+static int insertPrefixCell(MemPage *pPage, int i, u8 *pCell, int *pRC){
+  int nPrefix = pPage->nPrefix;
+  u8 *aPrefix = &pPage->aData[pPage->pBt->usableSize - 1 - nPrefix];
+  u32 nPayload;
+  int nHdr;
+  int sz;
+  int idx = 0;
+  int rc;
+  u8 *data;
+  u8 *pIns;
+
+  nHdr = getVarint32(pCell, nPayload);
+  if( nPayload<(u32)nPrefix || nPayload>pPage->maxLocal
+   || memcmp(&pCell[nHdr], aPrefix, nPrefix)!=0
+  ){
+    return 0;
+  }
+  sz = nHdr + nPayload - nPrefix;
+  if( sz<4 ) sz = 4;
+  if( sz+2>pPage->nFree ) return 0;
+  rc = sqlite3PagerWrite(pPage->pDbPage);
+  if( rc==SQLITE_OK ) rc = allocateSpace(pPage, sz, &idx);
+  if( rc ){
+    *pRC = rc;
+    return 1;
+  }
+  assert( idx+sz <= (int)pPage->pBt->usableSize-1-nPrefix || CORRUPT_DB );
+  data = pPage->aData;
+  pPage->nFree -= (u16)(2 + sz);
+  memset(&data[idx], 0, sz);
+  memcpy(&data[idx], pCell, nHdr);
+  memcpy(&data[idx+nHdr], &pCell[nHdr+nPrefix], nPayload-nPrefix);
+  pIns = pPage->aCellIdx + i*2;
+  memmove(pIns+2, pIns, 2*(pPage->nCell - i));
+  put2byte(pIns, idx);
+  pPage->nCell++;
+  put2byte(&data[pPage->hdrOffset+3], pPage->nCell);
+  return 1;
+}
+#endif /* SQLITE_ENABLE_INDEX_PREFIX */
+
 /*
 ** Remove the i-th cell from pPage.  This routine effects pPage only.
 ** The cell content is not freed or deallocated.  It is assumed that
@@ -6498,6 +7898,9 @@ static void dropCell(MemPage *pPage, int idx, int sz, int *pRC){
   assert( idx>=0 && idx<pPage->nCell );
   assert( CORRUPT_DB || sz==cellSize(pPage, idx) );
   assert( sqlite3PagerIswriteable(pPage->pDbPage) );
+  pPage->iZoneTag = 0;
+  btreeKeyCacheClear(pPage);
+  btreeCountClear(pPage);
   assert( sqlite3_mutex_held(pPage->pBt->mutex) );
   data = pPage->aData;
   ptr = &pPage->aCellIdx[2*idx];
@@ -6521,6 +7924,11 @@ static void dropCell(MemPage *pPage, int idx, int sz, int *pRC){
     put2byte(&data[hdr+5], pPage->pBt->usableSize);
     pPage->nFree = pPage->pBt->usableSize - pPage->hdrOffset
                        - pPage->childPtrSize - 8;
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+    /* An empty page has no shared prefix.  Return it to the standard
+    ** format. */
+    if( pPage->nPrefix ) btreePrefixSetFormat(pPage, 0);
+#endif
   }else{
     memmove(ptr, ptr+2, 2*(pPage->nCell - idx));
     put2byte(&data[hdr+3], pPage->nCell);
@@ -6563,13 +7971,27 @@ static void insertCell(
   assert( pPage->nOverflow<=ArraySize(pPage->apOvfl) );
   assert( ArraySize(pPage->apOvfl)==ArraySize(pPage->aiOvfl) );
   assert( sqlite3_mutex_held(pPage->pBt->mutex) );
+  pPage->iZoneTag = 0;
+  btreeKeyCacheClear(pPage);
+  btreeCountClear(pPage);
   /* The cell should normally be sized correctly.  However, when moving a
   ** malformed cell from a leaf page to an interior page, if the cell size
   ** wanted to be less than 4 but got rounded up to 4 on the leaf, then size
   ** might be less than 8 (leaf-size + pointer) on the interior node.  Hence
   ** the term after the || in the following assert(). */
-  assert( sz==pPage->xCellSize(pPage, pCell) || (sz==8 && iChild>0) );
-  if( pPage->nOverflow || sz+2>pPage->nFree ){
+  assert( btreePagePrefix(pPage)
+       || sz==pPage->xCellSize(pPage, pCell) || (sz==8 && iChild>0) );
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  /* pCell is in the standard format.  A PTF_PREFIX page stores it in
+  ** compressed form if it can, and otherwise treats it as an overflow
+  ** cell so that the caller rebalances the page. */
+  if( pPage->nPrefix && pPage->nOverflow==0
+   && insertPrefixCell(pPage, i, pCell, pRC)
+  ){
+    return;
+  }
+#endif
+  if( pPage->nOverflow || sz+2>pPage->nFree || btreePagePrefix(pPage) ){
     if( pTemp ){
       memcpy(pTemp, pCell, sz);
       pCell = pTemp;
@@ -6705,6 +8127,9 @@ static int rebuildPage(
   u8 *pTmp = sqlite3PagerTempSpace(pPg->pBt->pPager);
   u8 *pData;
 
+  pPg->iZoneTag = 0;
+  btreeKeyCacheClear(pPg);
+  btreeCountClear(pPg);
   i = get2byte(&aData[hdr+5]);
   memcpy(&pTmp[i], &aData[i], usableSize - i);
 
@@ -6884,6 +8309,10 @@ static int editPage(
   memcpy(pTmp, aData, pPg->pBt->usableSize);
 #endif
 
+  pPg->iZoneTag = 0;
+  btreeKeyCacheClear(pPg);
+  btreeCountClear(pPg);
+
   /* Remove cells from the start and end of the page */
   if( iOld<iNew ){
     int nShift = pageFreeArray(pPg, iOld, iNew-iOld, pCArray);
@@ -6956,6 +8385,261 @@ static int editPage(
   return rebuildPage(pPg, nNew, &pCArray->apCell[iNew], &pCArray->szCell[iNew]);
 }
 
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+/*
+** This routine is used by balance_nonroot() when balancing index leaf
+** pages while prefix compression is enabled or while any of the pages
+** being balanced is a PTF_PREFIX page.
+**
+** Copy every cell in pCArray into a single allocation, reassembling the
+** records of cells that are stored on PTF_PREFIX pages among apOld[], so
+** that all cells are in the standard format and none of them points into
+** a page that is about to be rewritten.  Four bytes are reserved in front
+** of each copy so that it can be inserted into the parent page as a
+** divider cell.  The allocation is written to *paSpace and must be freed
+** by the caller.  pCArray->szCell[] is set to the standard cell sizes.
+*/
+static int balancePrefixCells(
+  CellArray *pCArray,             /* Cells being balanced */
+  MemPage **apOld,                /* Pages being balanced */
+  int nOld,                       /* Number of entries in apOld[] */
+  u8 **paSpace                    /* OUT: Copies of the cells */
+){
+  MemPage *pRef = pCArray->pRef;
+  i64 nByte = 0;
+  u8 *aSpace;
+  u8 *pOut;
+  int i, j;
+
+  /* Compute the size of each cell in the standard format */
+  for(i=0; i<pCArray->nCell; i++){
+    u8 *pCell = pCArray->apCell[i];
+    CellInfo info;
+    for(j=0; j<nOld; j++){
+      MemPage *pOld = apOld[j];
+      if( pOld->nPrefix && SQLITE_WITHIN(pCell, pOld->aData, pOld->aDataEnd) ){
+        btreeParseCellPtrPrefix(pOld, pCell, &info);
+        if( info.nPayload==0 ) return SQLITE_CORRUPT_PAGE(pOld);
+        info.nSize = (u16)(info.pPayload - pCell) + info.nPayload;
+        if( info.nSize<4 ) info.nSize = 4;
+        break;
+      }
+    }
+    if( j==nOld ){
+      btreeParseCellPtrIndex(pRef, pCell, &info);
+      if( info.nSize<pCArray->szCell[i] ) info.nSize = pCArray->szCell[i];
+    }
+    pCArray->szCell[i] = info.nSize;
+    nByte += 4 + info.nSize;
+  }
+
+  aSpace = pOut = (u8*)sqlite3Malloc(nByte);
+  if( aSpace==0 ) return SQLITE_NOMEM_BKPT;
+
+  /* Copy the cells */
+  for(i=0; i<pCArray->nCell; i++){
+    u8 *pCell = pCArray->apCell[i];
+    pOut += 4;
+    for(j=0; j<nOld; j++){
+      MemPage *pOld = apOld[j];
+      if( pOld->nPrefix && SQLITE_WITHIN(pCell, pOld->aData, pOld->aDataEnd) ){
+        CellInfo info;
+        int nHdr;
+        int rc;
+        btreeParseCellPtrPrefix(pOld, pCell, &info);
+        nHdr = (int)(info.pPayload - pCell);
+        memset(pOut, 0, pCArray->szCell[i]);
+        memcpy(pOut, pCell, nHdr);
+        rc = btreePrefixRead(pOld, &info, 0, info.nPayload, &pOut[nHdr]);
+        if( rc ){
+          sqlite3_free(aSpace);
+          return rc;
+        }
+        break;
+      }
+    }
+    if( j==nOld ) memcpy(pOut, pCell, pCArray->szCell[i]);
+    pCArray->apCell[i] = pOut;
+    pOut += pCArray->szCell[i];
+  }
+  *paSpace = aSpace;
+  return SQLITE_OK;
+}
+
+/*
+** This routine is used by balance_nonroot() in place of its usual packing
+** of cells onto the new sibling pages when the cells are index leaf cells
+** prepared by balancePrefixCells().
+**
+** Fill the new pages from the left, each with as many cells as it will
+** hold, the cell that follows each page but the last becoming a divider
+** cell in the parent.  If bCompress is true, each page is written as a
+** PTF_PREFIX page using the longest prefix its records share, if any.
+** Since any run of cells from one of the old pages shares at least the
+** prefix of that page, this never needs more pages than the old pages and
+** their overflow cells would.  A single prefix for all of the new pages
+** would not do: cells from a page with a long prefix might then need far
+** more space than the balance can provide.
+**
+** Return the number of new pages, or zero if more than nMax would be
+** needed.  For each new page i, cntNew[i], szNew[i] and aPrefix[i] are set
+** to the index in pCArray of the cell that follows it, the space its cells
+** use, including the prefix, and the length of its prefix.  The sizes in
+** pCArray->szCell[] are set to the sizes of the cells on their pages.
+*/
+static int balancePrefixPack(
+  CellArray *pCArray,             /* Cells prepared by balancePrefixCells() */
+  int usableSpace,                /* Bytes available for cells on a page */
+  int bCompress,                  /* True to write PTF_PREFIX pages */
+  int nMax,                       /* Maximum number of new pages */
+  int *cntNew,                    /* OUT: Index of cell after each page */
+  int *szNew,                     /* OUT: Space used on each page */
+  u8 *aPrefix                     /* OUT: Prefix length of each page */
+){
+  int nCell = pCArray->nCell;
+  int iFirst = 0;                 /* First cell of the current page */
+  int k = 0;                      /* Number of pages so far */
+  int i;
+
+  if( nCell==0 ){
+    cntNew[0] = szNew[0] = aPrefix[0] = 0;
+    return 1;
+  }
+  while( iFirst<nCell ){
+    u8 *aRec0 = 0;                /* Record of cell iFirst */
+    int nRun = bCompress ? 255 : 0; /* Prefix shared by iFirst..i */
+    int nPrefix = 0;              /* Prefix used for cells iFirst..i-1 */
+    int sz = 0;                   /* Standard size of cells iFirst..i-1 */
+    if( k>=nMax ) return 0;
+
+    /* Find the first cell that does not fit on the page.  The prefix is
+    ** the longest one (at most 255 bytes) shared by the records that
+    ** leaves each compressed cell at least 4 bytes in size.  Records that
+    ** spill onto overflow pages cannot be compressed.  */
+    for(i=iFirst; i<nCell; i++){
+      u8 *pCell = pCArray->apCell[i];
+      int nNew;
+      int szPg;
+      u32 nPayload;
+      int nHdr = getVarint32(pCell, nPayload);
+      if( nPayload>pCArray->pRef->maxLocal ){
+        nRun = 0;
+      }else if( nRun>nHdr+(int)nPayload-4 ){
+        nRun = nHdr+(int)nPayload-4;
+      }
+      if( aRec0==0 ){
+        aRec0 = &pCell[nHdr];
+      }else{
+        int j;
+        for(j=0; j<nRun && pCell[nHdr+j]==aRec0[j]; j++);
+        nRun = j;
+      }
+      /* A prefix of less than two bytes does not pay for its length byte */
+      nNew = nRun<2 ? 0 : nRun;
+      szPg = sz + 2 + pCArray->szCell[i];
+      if( nNew ) szPg += nNew + 1 - (i-iFirst+1)*nNew;
+      if( szPg>usableSpace ) break;
+      sz += 2 + pCArray->szCell[i];
+      nPrefix = nNew;
+    }
+
+    /* If the cell that follows the page would be the last cell, it must
+    ** go on the next page instead of becoming the divider.  The records
+    ** that remain on the page still share nPrefix bytes.  */
+    if( i==nCell-1 ){
+      i--;
+      sz -= 2 + pCArray->szCell[i];
+    }
+    if( i<=iFirst ) return 0;
+
+    cntNew[k] = i;
+    aPrefix[k] = (u8)nPrefix;
+    szNew[k] = sz;
+    if( nPrefix ){
+      int j;
+      szNew[k] = nPrefix + 1;
+      for(j=iFirst; j<i; j++){
+        u32 nPayload;
+        int nHdr = getVarint32(pCArray->apCell[j], nPayload);
+        pCArray->szCell[j] = (u16)(nHdr + nPayload - nPrefix);
+        szNew[k] += 2 + pCArray->szCell[j];
+      }
+    }
+    k++;
+    iFirst = i+1;
+  }
+  return k;
+}
+
+/*
+** Rebuild index leaf page pPg so that it holds the nCell cells of pCArray
+** starting at iFirst.  The cells must have been prepared by
+** balancePrefixCells() and balancePrefixPack().  If nPrefix is not zero,
+** the page is written as a PTF_PREFIX page with an nPrefix byte prefix and
+** pCArray->szCell[] holds the compressed cell sizes.  Otherwise it is
+** written in the standard format.  As for rebuildPage(), the caller must
+** fix pPg->nFree.
+*/
+static int rebuildPrefixPage(
+  MemPage *pPg,                   /* Page to rebuild */
+  int iFirst,                     /* First cell of pCArray to store */
+  int nCell,                      /* Number of cells to store */
+  CellArray *pCArray,             /* Cells in the standard format */
+  int nPrefix                     /* Prefix shared by the records */
+){
+  const int hdr = pPg->hdrOffset;
+  u8 * const aData = pPg->aData;
+  u8 *pEnd = &aData[pPg->pBt->usableSize];
+  u8 *pCellptr = pPg->aCellIdx;
+  u8 *pData;
+  int i;
+
+  assert( pPg->leaf && pPg->intKey==0 );
+  pPg->iZoneTag = 0;
+  btreeKeyCacheClear(pPg);
+  if( nCell==0 ) nPrefix = 0;
+  btreePrefixSetFormat(pPg, nPrefix);
+  if( nPrefix ){
+    u8 *pCell = pCArray->apCell[iFirst];
+    u32 nPayload;
+    int nHdr = getVarint32(pCell, nPayload);
+    pEnd -= nPrefix + 1;
+    memcpy(pEnd, &pCell[nHdr], nPrefix);
+  }
+
+  pData = pEnd;
+  for(i=iFirst; i<iFirst+nCell; i++){
+    u8 *pCell = pCArray->apCell[i];
+    int sz = pCArray->szCell[i];
+    pData -= sz;
+    put2byte(pCellptr, (pData - aData));
+    pCellptr += 2;
+    if( pData < pCellptr ) return SQLITE_CORRUPT_BKPT;
+    if( nPrefix ){
+      u32 nPayload;
+      int nHdr = getVarint32(pCell, nPayload);
+      int n = nHdr + nPayload - nPrefix;
+      memcpy(pData, pCell, nHdr);
+      memcpy(&pData[nHdr], &pCell[nHdr+nPrefix], nPayload - nPrefix);
+      if( n<sz ) memset(&pData[n], 0, sz-n);
+    }else{
+      memcpy(pData, pCell, sz);
+    }
+    assert( sz==pPg->xCellSize(pPg, pData) || CORRUPT_DB );
+  }
+
+  /* The pPg->nFree field is now set incorrectly. The caller will fix it. */
+  pPg->nCell = nCell;
+  pPg->nOverflow = 0;
+
+  put2byte(&aData[hdr+1], 0);
+  put2byte(&aData[hdr+3], pPg->nCell);
+  put2byte(&aData[hdr+5], pData - aData);
+  aData[hdr+7] = 0x00;
+  return SQLITE_OK;
+}
+#endif /* SQLITE_ENABLE_INDEX_PREFIX */
+
 /*
 ** The following parameters determine how many adjacent pages get involved
 ** in a balancing operation.  NN is the number of neighbors on either side
@@ -7013,7 +8697,11 @@ static int balance_quick(MemPage *pParent, MemPage *pPage, u8 *pSpace){
   ** pPage. Make the parent page writable, so that the new divider cell
   ** may be inserted. If both these operations are successful, proceed.
   */
+#if defined(SQLITE_ENABLE_FREELIST_INDEX) || defined(SQLITE_ENABLE_FREE_SPACE_MAP)
+  rc = allocateBtreePage(pBt, &pNew, &pgnoNew, pPage->pgno, 0);
+#else
   rc = allocateBtreePage(pBt, &pNew, &pgnoNew, 0, 0);
+#endif
 
   if( rc==SQLITE_OK ){
 
@@ -7256,6 +8944,11 @@ static int balance_nonroot(
   Pgno aPgOrder[NB+2];         /* Copy of aPgno[] used for sorting pages */
   u16 aPgFlags[NB+2];          /* flags field of new pages before shuffling */
   CellArray b;                  /* Parsed information on cells being balanced */
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  int bPrefix = 0;             /* True if balancing with balancePrefixCells() */
+  u8 aPrefix[NB+2];            /* Record prefix shared by the i-th new page */
+  u8 *aPrefixSpace = 0;        /* Cell copies made by balancePrefixCells() */
+#endif
 
   memset(abDone, 0, sizeof(abDone));
   b.nCell = 0;
@@ -7412,7 +9105,7 @@ static int balance_nonroot(
     /* Verify that all sibling pages are of the same "type" (table-leaf,
     ** table-interior, index-leaf, or index-interior).
     */
-    if( pOld->aData[0]!=apOld[0]->aData[0] ){
+    if( (pOld->aData[0] ^ apOld[0]->aData[0]) & ~PTF_PREFIX ){
       rc = SQLITE_CORRUPT_BKPT;
       goto balance_cleanup;
     }
@@ -7516,89 +9209,127 @@ static int balance_nonroot(
     }
     cntNew[i] = cntOld[i];
   }
-  k = nOld;
-  for(i=0; i<k; i++){
-    int sz;
-    while( szNew[i]>usableSpace ){
-      if( i+1>=k ){
-        k = i+2;
-        if( k>NB+2 ){ rc = SQLITE_CORRUPT_BKPT; goto balance_cleanup; }
-        szNew[k-1] = 0;
-        cntNew[k-1] = b.nCell;
-      }
-      sz = 2 + cachedCellSize(&b, cntNew[i]-1);
-      szNew[i] -= sz;
-      if( !leafData ){
-        if( cntNew[i]<b.nCell ){
-          sz = 2 + cachedCellSize(&b, cntNew[i]);
-        }else{
-          sz = 0;
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  /* When balancing index leaves, either compress the new pages or, if any
+  ** of the old pages were compressed, store the cells in the standard
+  ** format where they fit.  balancePrefixPack() packs the cells in place
+  ** of the two loops below.  */
+  if( leafCorrection && !b.pRef->intKey ){
+    bPrefix = (pBt->btsFlags & BTS_PREFIX)!=0;
+    for(i=0; i<nOld; i++){
+      if( apOld[i]->nPrefix ) bPrefix = 1;
+    }
+  }
+  if( bPrefix ){
+    int bCompress = (pBt->btsFlags & BTS_PREFIX)!=0;
+    rc = balancePrefixCells(&b, apOld, nOld, &aPrefixSpace);
+    if( rc ) goto balance_cleanup;
+    k = balancePrefixPack(&b, usableSpace, bCompress, NB+2,
+                          cntNew, szNew, aPrefix);
+    if( k==0 && !bCompress ){
+      /* The cells of the compressed old pages do not fit on NB+2 standard
+      ** format pages, so compress the new pages after all */
+      bCompress = 1;
+      k = balancePrefixPack(&b, usableSpace, bCompress, NB+2,
+                            cntNew, szNew, aPrefix);
+    }
+    if( k==0 ){
+      rc = SQLITE_CORRUPT_BKPT;
+      goto balance_cleanup;
+    }
+    for(i=0; i<k && aPrefix[i]==0; i++);
+    if( i<k ){
+      rc = btreeMarkPrefixPages(pBt);
+      if( rc ) goto balance_cleanup;
+    }
+  }else
+#endif
+  {
+    k = nOld;
+    for(i=0; i<k; i++){
+      int sz;
+      while( szNew[i]>usableSpace ){
+        if( i+1>=k ){
+          k = i+2;
+          if( k>NB+2 ){ rc = SQLITE_CORRUPT_BKPT; goto balance_cleanup; }
+          szNew[k-1] = 0;
+          cntNew[k-1] = b.nCell;
         }
+        sz = 2 + cachedCellSize(&b, cntNew[i]-1);
+        szNew[i] -= sz;
+        if( !leafData ){
+          if( cntNew[i]<b.nCell ){
+            sz = 2 + cachedCellSize(&b, cntNew[i]);
+          }else{
+            sz = 0;
+          }
+        }
+        szNew[i+1] += sz;
+        cntNew[i]--;
       }
-      szNew[i+1] += sz;
-      cntNew[i]--;
-    }
-    while( cntNew[i]<b.nCell ){
-      sz = 2 + cachedCellSize(&b, cntNew[i]);
-      if( szNew[i]+sz>usableSpace ) break;
-      szNew[i] += sz;
-      cntNew[i]++;
-      if( !leafData ){
-        if( cntNew[i]<b.nCell ){
-          sz = 2 + cachedCellSize(&b, cntNew[i]);
-        }else{
-          sz = 0;
+      while( cntNew[i]<b.nCell ){
+        sz = 2 + cachedCellSize(&b, cntNew[i]);
+        if( szNew[i]+sz>usableSpace ) break;
+        szNew[i] += sz;
+        cntNew[i]++;
+        if( !leafData ){
+          if( cntNew[i]<b.nCell ){
+            sz = 2 + cachedCellSize(&b, cntNew[i]);
+          }else{
+            sz = 0;
+          }
         }
+        szNew[i+1] -= sz;
+      }
+      if( cntNew[i]>=b.nCell ){
+        k = i+1;
+      }else if( cntNew[i] <= (i>0 ? cntNew[i-1] : 0) ){
+        rc = SQLITE_CORRUPT_BKPT;
+        goto balance_cleanup;
       }
-      szNew[i+1] -= sz;
-    }
-    if( cntNew[i]>=b.nCell ){
-      k = i+1;
-    }else if( cntNew[i] <= (i>0 ? cntNew[i-1] : 0) ){
-      rc = SQLITE_CORRUPT_BKPT;
-      goto balance_cleanup;
     }
-  }
 
-  /*
-  ** The packing computed by the previous block is biased toward the siblings
-  ** on the left side (siblings with smaller keys). The left siblings are
-  ** always nearly full, while the right-most sibling might be nearly empty.
-  ** The next block of code attempts to adjust the packing of siblings to
-  ** get a better balance.
-  **
-  ** This adjustment is more than an optimization.  The packing above might
-  ** be so out of balance as to be illegal.  For example, the right-most
-  ** sibling might be completely empty.  This adjustment is not optional.
-  */
-  for(i=k-1; i>0; i--){
-    int szRight = szNew[i];  /* Size of sibling on the right */
-    int szLeft = szNew[i-1]; /* Size of sibling on the left */
-    int r;              /* Index of right-most cell in left sibling */
-    int d;              /* Index of first cell to the left of right sibling */
-
-    r = cntNew[i-1] - 1;
-    d = r + 1 - leafData;
-    (void)cachedCellSize(&b, d);
-    do{
-      assert( d<nMaxCells );
-      assert( r<nMaxCells );
-      (void)cachedCellSize(&b, r);
-      if( szRight!=0
-       && (bBulk || szRight+b.szCell[d]+2 > szLeft-(b.szCell[r]+(i==k-1?0:2)))){
-        break;
+    /*
+    ** The packing computed by the previous block is biased toward the siblings
+    ** on the left side (siblings with smaller keys). The left siblings are
+    ** always nearly full, while the right-most sibling might be nearly empty.
+    ** The next block of code attempts to adjust the packing of siblings to
+    ** get a better balance.
+    **
+    ** This adjustment is more than an optimization.  The packing above might
+    ** be so out of balance as to be illegal.  For example, the right-most
+    ** sibling might be completely empty.  This adjustment is not optional.
+    */
+    for(i=k-1; i>0; i--){
+      int szRight = szNew[i];  /* Size of sibling on the right */
+      int szLeft = szNew[i-1]; /* Size of sibling on the left */
+      int r;              /* Index of right-most cell in left sibling */
+      int d;              /* Index of first cell to the left of right sibling */
+
+      r = cntNew[i-1] - 1;
+      d = r + 1 - leafData;
+      (void)cachedCellSize(&b, d);
+      do{
+        assert( d<nMaxCells );
+        assert( r<nMaxCells );
+        (void)cachedCellSize(&b, r);
+        if( szRight!=0
+         && (bBulk
+          || szRight+b.szCell[d]+2 > szLeft-(b.szCell[r]+(i==k-1?0:2)))){
+          break;
+        }
+        szRight += b.szCell[d] + 2;
+        szLeft -= b.szCell[r] + 2;
+        cntNew[i-1] = r;
+        r--;
+        d--;
+      }while( r>=0 );
+      szNew[i] = szRight;
+      szNew[i-1] = szLeft;
+      if( cntNew[i-1] <= (i>1 ? cntNew[i-2] : 0) ){
+        rc = SQLITE_CORRUPT_BKPT;
+        goto balance_cleanup;
       }
-      szRight += b.szCell[d] + 2;
-      szLeft -= b.szCell[r] + 2;
-      cntNew[i-1] = r;
-      r--;
-      d--;
-    }while( r>=0 );
-    szNew[i] = szRight;
-    szNew[i-1] = szLeft;
-    if( cntNew[i-1] <= (i>1 ? cntNew[i-2] : 0) ){
-      rc = SQLITE_CORRUPT_BKPT;
-      goto balance_cleanup;
     }
   }
 
@@ -7619,7 +9350,7 @@ static int balance_nonroot(
   /*
   ** Allocate k new pages.  Reuse old pages where possible.
   */
-  pageFlags = apOld[0]->aData[0];
+  pageFlags = apOld[0]->aData[0] & ~PTF_PREFIX;
   for(i=0; i<k; i++){
     MemPage *pNew;
     if( i<nOld ){
@@ -7628,6 +9359,11 @@ static int balance_nonroot(
       rc = sqlite3PagerWrite(pNew->pDbPage);
       nNew++;
       if( rc ) goto balance_cleanup;
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+      /* The cells have all been copied out by balancePrefixCells(), so the
+      ** page can be treated as a standard format page until it is rebuilt */
+      if( pNew->nPrefix ) btreePrefixSetFormat(pNew, 0);
+#endif
     }else{
       assert( i>0 );
       rc = allocateBtreePage(pBt, &pNew, &pgno, (bBulk ? 1 : pgno), 0);
@@ -7817,6 +9553,12 @@ static int balance_nonroot(
         assert(leafCorrection==4);
         sz = pParent->xCellSize(pParent, pCell);
       }
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+      else if( bPrefix ){
+        /* b.szCell[] holds the compressed size of the cell */
+        sz = pParent->xCellSize(pParent, pCell);
+      }
+#endif
     }
     iOvflSpace += sz;
     assert( sz<=pBt->maxLocal+23 );
@@ -7876,6 +9618,11 @@ static int balance_nonroot(
         nNewCell = cntNew[iPg] - iNew;
       }
 
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+      if( bPrefix ){
+        rc = rebuildPrefixPage(apNew[iPg], iNew, nNewCell, &b, aPrefix[iPg]);
+      }else
+#endif
       rc = editPage(apNew[iPg], iOld, iNew, nNewCell, &b);
       if( rc ) goto balance_cleanup;
       abDone[iPg]++;
@@ -7952,6 +9699,9 @@ static int balance_nonroot(
   */
 balance_cleanup:
   sqlite3StackFree(0, b.apCell);
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  sqlite3_free(aPrefixSpace);
+#endif
   for(i=0; i<nOld; i++){
     releasePage(apOld[i]);
   }
@@ -8022,7 +9772,7 @@ static int balance_deeper(MemPage *pRoot, MemPage **ppChild){
   pChild->nOverflow = pRoot->nOverflow;
 
   /* Zero the contents of pRoot. Then install pChild as the right-child. */
-  zeroPage(pRoot, pChild->aData[0] & ~PTF_LEAF);
+  zeroPage(pRoot, pChild->aData[0] & ~(PTF_LEAF|PTF_PREFIX));
   put4byte(&pRoot->aData[pRoot->hdrOffset+8], pgnoChild);
 
   *ppChild = pChild;
@@ -8059,10 +9809,12 @@ static int balance(BtCursor *pCur){
         ** and copy the current contents of the root-page to it. The
         ** next iteration of the do-loop will balance the child page.
         */ 
+        i64 nEntry = btreeCountGet(pPage);
         assert( balance_deeper_called==0 );
         VVA_ONLY( balance_deeper_called++ );
         rc = balance_deeper(pPage, &pCur->apPage[1]);
         if( rc==SQLITE_OK ){
+          btreeCountSet(pPage, nEntry);
           pCur->iPage = 1;
           pCur->ix = 0;
           pCur->aiIdx[0] = 0;
@@ -8079,6 +9831,10 @@ static int balance(BtCursor *pCur){
       MemPage * const pParent = pCur->apPage[iPage-1];
       int const iIdx = pCur->aiIdx[iPage-1];
 
+      /* Rebalancing moves entries between the children of pParent but
+      ** does not change the number of entries below pParent.  */
+      i64 const nEntry = btreeCountGet(pParent);
+
       rc = sqlite3PagerWrite(pParent->pDbPage);
       if( rc==SQLITE_OK ){
 #ifndef SQLITE_OMIT_QUICKBALANCE
@@ -8140,6 +9896,7 @@ static int balance(BtCursor *pCur){
           ** comes first. */
           pFree = pSpace;
         }
+        if( rc==SQLITE_OK ) btreeCountSet(pParent, nEntry);
       }
 
       pPage->nOverflow = 0;
@@ -8212,6 +9969,7 @@ static int btreeOverwriteCell(BtCursor *pCur, const BtreePayload *pX){
   if( pCur->info.pPayload + pCur->info.nLocal > pPage->aDataEnd ){
     return SQLITE_CORRUPT_BKPT;
   }
+  pPage->iZoneTag = 0;
   /* Overwrite the local portion first */
   rc = btreeOverwriteContent(pPage, pCur->info.pPayload, pX,
                              0, pCur->info.nLocal);
@@ -8431,7 +10189,7 @@ int sqlite3BtreeInsert(
   assert( newCell!=0 );
   rc = fillInCell(pPage, newCell, pX, &szNew);
   if( rc ) goto end_insert;
-  assert( szNew==pPage->xCellSize(pPage, newCell) );
+  assert( btreePagePrefix(pPage) || szNew==pPage->xCellSize(pPage, newCell) );
   assert( szNew <= MX_CELL_SIZE(pBt) );
   idx = pCur->ix;
   if( loc==0 ){
@@ -8448,6 +10206,7 @@ int sqlite3BtreeInsert(
     rc = clearCell(pPage, oldCell, &info);
     if( info.nSize==szNew && info.nLocal==info.nPayload 
      && (!ISAUTOVACUUM || szNew<pPage->minLocal)
+     && btreePagePrefix(pPage)==0
     ){
       /* Overwrite the old cell with the new if they are the same size.
       ** We could also try to do this if the old cell is smaller, then add
@@ -8473,6 +10232,7 @@ int sqlite3BtreeInsert(
     assert( pPage->leaf );
   }
   insertCell(pPage, idx, newCell, szNew, 0, 0, &rc);
+  if( loc && rc==SQLITE_OK ) btreeCountAdjust(pCur, 1);
   assert( pPage->nOverflow==0 || rc==SQLITE_OK );
   assert( rc!=SQLITE_OK || pPage->nCell>0 || pPage->nOverflow>0 );
 
@@ -8557,6 +10317,7 @@ int sqlite3BtreeDelete(BtCursor *pCur, u8 flags){
   CellInfo info;                       /* Size of the cell being deleted */
   int bSkipnext = 0;                   /* Leaf cursor in SKIPNEXT state */
   u8 bPreserve = flags & BTREE_SAVEPOSITION;  /* Keep cursor valid */
+  i64 nEntry;                          /* Entries below pPage, or -1 */
 
   assert( cursorOwnsBtShared(pCur) );
   assert( pBt->inTransaction==TRANS_WRITE );
@@ -8621,6 +10382,8 @@ int sqlite3BtreeDelete(BtCursor *pCur, u8 flags){
     invalidateIncrblobCursors(p, pCur->pgnoRoot, pCur->info.nKey, 0);
   }
 
+  nEntry = btreeCountGet(pPage);
+
   /* Make the page containing the entry to be deleted writable. Then free any
   ** overflow pages associated with the entry and finally remove the cell
   ** itself from within the page.  */
@@ -8640,6 +10403,8 @@ int sqlite3BtreeDelete(BtCursor *pCur, u8 flags){
     int nCell;
     Pgno n;
     unsigned char *pTmp;
+    u8 *pIns;
+    int nIns;
 
     if( iCellDepth<pCur->iPage-1 ){
       n = pCur->apPage[iCellDepth+1]->pgno;
@@ -8652,14 +10417,29 @@ int sqlite3BtreeDelete(BtCursor *pCur, u8 flags){
     assert( MX_CELL_SIZE(pBt) >= nCell );
     pTmp = pBt->pTmpSpace;
     assert( pTmp!=0 );
+    pIns = pCell-4;
+    nIns = nCell+4;
     rc = sqlite3PagerWrite(pLeaf->pDbPage);
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+    if( rc==SQLITE_OK && pLeaf->nPrefix ){
+      /* Interior pages hold standard format cells */
+      rc = btreePrefixInteriorCell(pCur, pLeaf, pCell, &nIns);
+      pIns = pCur->aRecord;
+    }
+#endif
     if( rc==SQLITE_OK ){
-      insertCell(pPage, iCellIdx, pCell-4, nCell+4, pTmp, n, &rc);
+      insertCell(pPage, iCellIdx, pIns, nIns, pTmp, n, &rc);
     }
     dropCell(pLeaf, pLeaf->nCell-1, nCell, &rc);
     if( rc ) return rc;
   }
 
+  /* Every page between the root and the leaf the cursor points to has
+  ** lost one entry, whether the entry deleted was on that leaf or the
+  ** last cell of the leaf replaced a deleted interior cell.  */
+  btreeCountAdjust(pCur, -1);
+  btreeCountSet(pPage, nEntry-1);
+
   /* Balance the tree. If the entry deleted was located on a leaf page,
   ** then the cursor still points to that page. In this case the first
   ** call to balance() repairs the tree, and the if(...) condition is
@@ -8921,7 +10701,7 @@ static int clearDatabasePage(
   if( freePageFlag ){
     freePage(pPage, &rc);
   }else if( (rc = sqlite3PagerWrite(pPage->pDbPage))==0 ){
-    zeroPage(pPage, pPage->aData[hdr] | PTF_LEAF);
+    zeroPage(pPage, (pPage->aData[hdr] | PTF_LEAF) & ~PTF_PREFIX);
   }
 
 cleardatabasepage_out:
@@ -8971,6 +10751,300 @@ int sqlite3BtreeClearTableOfCursor(BtCursor *pCur){
   return sqlite3BtreeClearTable(pCur->pBtree, pCur->pgnoRoot, 0);
 }
 
+#ifdef SQLITE_ENABLE_RANGE_DELETE
+/*
+** Remove from the intkey subtree rooted at page pgno every entry whose
+** key lies between iLo and iHi inclusive.  All keys in the subtree are
+** known to lie between iMin and iMax inclusive.
+**
+** A child subtree whose key range falls entirely within iLo..iHi is
+** freed in one step by clearDatabasePage(), without being edited first.
+** Only the children that straddle iLo or iHi are descended into, so at
+** most two pages on each level of the tree are modified.  Cells are
+** dropped from the boundary pages but no balancing is done here.
+**
+** If the page is left with no entries and no children, it is freed and
+** *pbGone is set, in which case the caller must remove its pointer to
+** the page.  A root page is never freed: if it becomes empty it is
+** turned into an empty leaf instead.  If a root page is left with no
+** cells and a single child, the child is copied into it as the
+** balance-shallower step of balance_nonroot() would do.
+*/
+static int btreeDeleteRangePage(
+  BtShared *pBt,           /* The BTree that contains the table */
+  Pgno pgno,               /* Page number of the subtree root */
+  int isRoot,              /* True if pgno is the root of the table */
+  i64 iMin, i64 iMax,      /* All keys in the subtree lie in this range */
+  i64 iLo, i64 iHi,        /* Delete entries with keys in this range */
+  int *pnChange,           /* Add number of entries deleted to this counter */
+  int *pbGone              /* OUT: Set if page pgno was freed */
+){
+  MemPage *pPage;
+  int rc;
+  int hdr;
+  int i;
+  CellInfo info;
+
+  assert( sqlite3_mutex_held(pBt->mutex) );
+  *pbGone = 0;
+  if( pgno>btreePagecount(pBt) ){
+    return SQLITE_CORRUPT_BKPT;
+  }
+  rc = getAndInitPage(pBt, pgno, &pPage, 0, 0);
+  if( rc ) return rc;
+  if( pPage->bBusy || !pPage->intKey ){
+    rc = SQLITE_CORRUPT_BKPT;
+    goto deleterange_out;
+  }
+  pPage->bBusy = 1;
+  rc = sqlite3PagerWrite(pPage->pDbPage);
+  if( rc ) goto deleterange_page_out;
+  hdr = pPage->hdrOffset;
+
+  /* The number of entries below this page is about to change */
+  btreeCountClear(pPage);
+
+  if( pPage->leaf ){
+    for(i=pPage->nCell-1; i>=0 && rc==SQLITE_OK; i--){
+      u8 *pCell = findCell(pPage, i);
+      pPage->xParseCell(pPage, pCell, &info);
+      if( info.nKey>iHi ) continue;
+      if( info.nKey<iLo ) break;
+      rc = clearCell(pPage, pCell, &info);
+      dropCell(pPage, i, info.nSize, &rc);
+      if( pnChange ) (*pnChange)++;
+    }
+  }else{
+    int nCell = pPage->nCell;
+    int iFirst = -1;       /* First child removed from this page */
+    int iLast = -1;        /* Last child removed from this page */
+
+    /* Child i holds the keys greater than the key of cell i-1 and no
+    ** greater than the key of cell i.  Visit the children that overlap
+    ** iLo..iHi.  Those strictly between the first and last such child
+    ** are always covered in full, so the removed children form a single
+    ** run iFirst..iLast.  */
+    for(i=0; i<=nCell && rc==SQLITE_OK; i++){
+      Pgno iChild;
+      i64 iChildMax;
+      int bGone = 0;
+      if( i<nCell ){
+        u8 *pCell = findCell(pPage, i);
+        u64 iKey;
+        iChild = get4byte(pCell);
+        getVarint(&pCell[4], &iKey);
+        iChildMax = (i64)iKey<iMax ? (i64)iKey : iMax;
+      }else{
+        iChild = get4byte(&pPage->aData[hdr+8]);
+        iChildMax = iMax;
+      }
+      if( iChildMax>=iLo ){
+        if( iMin>=iLo && iChildMax<=iHi ){
+          rc = clearDatabasePage(pBt, iChild, 1, pnChange);
+          bGone = 1;
+        }else{
+          rc = btreeDeleteRangePage(pBt, iChild, 0, iMin, iChildMax,
+                                    iLo, iHi, pnChange, &bGone);
+        }
+        if( bGone ){
+          if( iFirst<0 ) iFirst = i;
+          iLast = i;
+        }
+      }
+      if( iChildMax>=iHi ) break;
+      iMin = iChildMax+1;
+    }
+
+    if( rc==SQLITE_OK && iFirst>=0 ){
+      if( iLast<nCell ){
+        /* Drop the cells that point to the removed children.  The child
+        ** that follows them inherits their key range. */
+        for(i=iLast; i>=iFirst; i--){
+          dropCell(pPage, i, pPage->xCellSize(pPage, findCell(pPage, i)), &rc);
+        }
+      }else if( iFirst>0 ){
+        /* The right-child was removed.  The child of the last remaining
+        ** cell becomes the new right-child. */
+        Pgno iRight = get4byte(findCell(pPage, iFirst-1));
+        for(i=nCell-1; i>=iFirst-1; i--){
+          dropCell(pPage, i, pPage->xCellSize(pPage, findCell(pPage, i)), &rc);
+        }
+        if( rc==SQLITE_OK ){
+          put4byte(&pPage->aData[hdr+8], iRight);
+        }
+      }else{
+        /* Every child was removed */
+        assert( iFirst==0 && iLast==nCell );
+        if( isRoot ){
+          zeroPage(pPage, (pPage->aData[hdr] | PTF_LEAF) & ~PTF_PREFIX);
+        }else{
+          *pbGone = 1;
+        }
+      }
+    }
+
+    /* Balance-shallower: while the root page has no cells and a single
+    ** child, copy the child into the root.  */
+    while( rc==SQLITE_OK && isRoot && pPage->nCell==0 && !pPage->leaf ){
+      MemPage *pChild;
+      int bFits = 0;
+      rc = getAndInitPage(pBt, get4byte(&pPage->aData[hdr+8]), &pChild, 0, 0);
+      if( rc ) break;
+      if( (rc = sqlite3PagerWrite(pChild->pDbPage))==SQLITE_OK
+       && (rc = defragmentPage(pChild, -1))==SQLITE_OK
+      ){
+        /* Page 1 may have too little room for the content of its child */
+        bFits = pPage->hdrOffset<=pChild->nFree;
+        if( bFits ){
+          copyNodeContent(pChild, pPage, &rc);
+          freePage(pChild, &rc);
+        }
+      }
+      releasePage(pChild);
+      if( !bFits ) break;
+    }
+  }
+
+  if( rc==SQLITE_OK && pPage->nCell==0 && !isRoot && pPage->leaf ){
+    *pbGone = 1;
+  }
+  if( *pbGone ){
+    freePage(pPage, &rc);
+  }
+
+deleterange_page_out:
+  pPage->bBusy = 0;
+deleterange_out:
+  releasePage(pPage);
+  return rc;
+}
+
+/*
+** Move pCur down the path that a seek for key iKey follows, stopping at
+** the leaf.  btreeDeleteRangePage() may leave interior pages with no
+** cells and only a right-child, which moveToChild() and
+** sqlite3BtreeMovetoUnpacked() treat as corrupt, so this routine loads
+** the pages itself.  On return pCur is valid unless the table is empty.
+*/
+static int btreeDeleteRangeSeek(BtCursor *pCur, i64 iKey){
+  int rc = moveToRoot(pCur);
+  if( rc==SQLITE_EMPTY ) return SQLITE_OK;
+  while( rc==SQLITE_OK && !pCur->pPage->leaf ){
+    MemPage *pPage = pCur->pPage;
+    Pgno iChild;
+    int idx;
+    for(idx=0; idx<pPage->nCell; idx++){
+      u64 iCellKey;
+      getVarint(findCell(pPage, idx)+4, &iCellKey);
+      if( (i64)iCellKey>=iKey ) break;
+    }
+    if( idx<pPage->nCell ){
+      iChild = get4byte(findCell(pPage, idx));
+    }else{
+      iChild = get4byte(&pPage->aData[pPage->hdrOffset+8]);
+    }
+    if( pCur->iPage>=(BTCURSOR_MAX_DEPTH-1) ) return SQLITE_CORRUPT_BKPT;
+    pCur->aiIdx[pCur->iPage] = (u16)idx;
+    pCur->apPage[pCur->iPage] = pPage;
+    pCur->ix = 0;
+    pCur->iPage++;
+    rc = getAndInitPage(pCur->pBt, iChild, &pCur->pPage, 0,
+                        pCur->curPagerFlags);
+    if( rc ){
+      pCur->iPage--;
+      pCur->pPage = pPage;
+    }else if( pCur->pPage->intKey!=pCur->curIntKey
+           || (pCur->pPage->leaf && pCur->pPage->nCell==0)
+    ){
+      rc = SQLITE_CORRUPT_PGNO(iChild);
+    }
+  }
+  return rc;
+}
+
+/*
+** Restore the balance of the b-tree after a range delete along the path
+** that a seek for key iKey follows.  The deepest page on the path that
+** has no cells or is less than one third full is balanced, and the seek
+** is repeated, until no such page remains or the pass limit is reached.
+** Underfull pages are legal, so giving up after the limit is harmless.
+** Interior pages left with no cells are not, so the shallowest of those
+** is balanced first.  Its parent has cells, so it has a sibling to merge
+** with.
+*/
+static int btreeDeleteRangeBalance(BtCursor *pCur, i64 iKey){
+  const int nMin = pCur->pBt->usableSize * 2 / 3;
+  int rc = SQLITE_OK;
+  int nPass;
+
+  for(nPass=0; nPass<BTCURSOR_MAX_DEPTH*2; nPass++){
+    int iBad = 0;
+    int i;
+    rc = btreeDeleteRangeSeek(pCur, iKey);
+    if( rc || pCur->eState!=CURSOR_VALID ) break;
+    for(i=1; i<pCur->iPage && iBad==0; i++){
+      if( pCur->apPage[i]->nCell==0 ) iBad = i;
+    }
+    for(i=pCur->iPage; i>0 && iBad==0; i--){
+      MemPage *p = i==pCur->iPage ? pCur->pPage : pCur->apPage[i];
+      if( p->nCell==0 || p->nFree>nMin ) iBad = i;
+    }
+    if( iBad==0 ) break;
+    while( pCur->iPage>iBad ) moveToParent(pCur);
+    rc = balance(pCur);
+    btreeReleaseAllCursorPages(pCur);
+    pCur->eState = CURSOR_INVALID;
+    pCur->curFlags &= ~(BTCF_ValidNKey|BTCF_ValidOvfl|BTCF_AtLast);
+    if( rc ) break;
+  }
+  return rc;
+}
+
+/*
+** Delete every entry with a key between iLo and iHi inclusive from the
+** intkey table that write-cursor pCur is open on.  Subtrees that lie
+** wholly inside the range are freed without visiting their cells one by
+** one, only the pages on the two edges of the range are edited, and the
+** tree is rebalanced once along each edge afterwards.
+**
+** If pnChange is not NULL, it is incremented by the number of entries
+** deleted.  Other cursors open on the table are saved first.  On return
+** pCur is left invalid.
+*/
+int sqlite3BtreeDeleteRange(BtCursor *pCur, i64 iLo, i64 iHi, int *pnChange){
+  Btree *p = pCur->pBtree;
+  BtShared *pBt = p->pBt;
+  int rc;
+  int bGone = 0;
+
+  assert( cursorOwnsBtShared(pCur) );
+  assert( pBt->inTransaction==TRANS_WRITE );
+  assert( (pBt->btsFlags & BTS_READ_ONLY)==0 );
+  assert( pCur->curFlags & BTCF_WriteFlag );
+  assert( pCur->curIntKey );
+  assert( hasSharedCacheTableLock(p, pCur->pgnoRoot, 0, 2) );
+  assert( !hasReadConflicts(p, pCur->pgnoRoot) );
+
+  rc = saveAllCursors(pBt, pCur->pgnoRoot, pCur);
+  if( rc ) return rc;
+  invalidateIncrblobCursors(p, pCur->pgnoRoot, 0, 1);
+  sqlite3BtreeClearCursor(pCur);
+  btreeReleaseAllCursorPages(pCur);
+  pCur->curFlags &= ~(BTCF_ValidNKey|BTCF_ValidOvfl|BTCF_AtLast);
+  if( iLo>iHi ) return SQLITE_OK;
+
+  rc = btreeDeleteRangePage(pBt, pCur->pgnoRoot, 1, SMALLEST_INT64,
+                            LARGEST_INT64, iLo, iHi, pnChange, &bGone);
+  assert( bGone==0 );
+  if( rc==SQLITE_OK ) rc = btreeDeleteRangeBalance(pCur, iLo);
+  if( rc==SQLITE_OK ) rc = btreeDeleteRangeBalance(pCur, iHi);
+  btreeReleaseAllCursorPages(pCur);
+  pCur->eState = CURSOR_INVALID;
+  pCur->curFlags &= ~(BTCF_ValidNKey|BTCF_ValidOvfl|BTCF_AtLast);
+  return rc;
+}
+#endif /* SQLITE_ENABLE_RANGE_DELETE */
+
 /*
 ** Erase all information in a table and add the root of the table to
 ** the freelist.  Except, the root of the principle table (the one on
@@ -9158,77 +11232,176 @@ int sqlite3BtreeUpdateMeta(Btree *p, int idx, u32 iMeta){
 
 #ifndef SQLITE_OMIT_BTREECOUNT
 /*
-** The first argument, pCur, is a cursor opened on some b-tree. Count the
-** number of entries in the b-tree and write the result to *pnEntry.
+** Count the number of entries in the subtree headed by the page that
+** cursor pCur points to and write the result to *pnEntry.  The cursor
+** is left pointing at the same page, although not necessarily at the
+** same cell of it.
 **
-** SQLITE_OK is returned if the operation is successfully executed. 
-** Otherwise, if an error is encountered (i.e. an IO error or database
-** corruption) an SQLite error code is returned.
+** Subtrees whose entry count is already known are not descended into.
+** The count of every interior page visited is recorded on the way back
+** up, so that the next count need not descend into it either.
 */
-int sqlite3BtreeCount(BtCursor *pCur, i64 *pnEntry){
-  i64 nEntry = 0;                      /* Value to return in *pnEntry */
-  int rc;                              /* Return code */
-
-  rc = moveToRoot(pCur);
-  if( rc==SQLITE_EMPTY ){
-    *pnEntry = 0;
-    return SQLITE_OK;
-  }
+static int btreeSubtreeCount(BtCursor *pCur, i64 *pnEntry){
+  i64 aSum[BTCURSOR_MAX_DEPTH];        /* Entries so far below each page */
+  int iBase = pCur->iPage;             /* Depth of the page to count */
+  int rc = SQLITE_OK;                  /* Return code */
+  i64 nEntry;                          /* Entries in the current subtree */
+  MemPage *pPage;                      /* Current page of the b-tree */
 
   /* Unless an error occurs, the following loop runs one iteration for each
-  ** page in the B-Tree structure (not including overflow pages). 
+  ** page visited (not including overflow pages). 
   */
   while( rc==SQLITE_OK ){
-    int iIdx;                          /* Index of child node in parent */
-    MemPage *pPage;                    /* Current page of the b-tree */
-
-    /* If this is a leaf page or the tree is not an int-key tree, then 
-    ** this page contains countable entries. Increment the entry counter
-    ** accordingly.
-    */
     pPage = pCur->pPage;
-    if( pPage->leaf || !pPage->intKey ){
-      nEntry += pPage->nCell;
-    }
 
-    /* pPage is a leaf node. This loop navigates the cursor so that it 
-    ** points to the first interior cell that it points to the parent of
-    ** the next page in the tree that has not yet been visited. The
-    ** pCur->aiIdx[pCur->iPage] value is set to the index of the parent cell
-    ** of the page, or to the number of cells in the page if the next page
-    ** to visit is the right-child of its parent.
-    **
-    ** If all pages in the tree have been visited, return SQLITE_OK to the
-    ** caller.
+    /* If the number of entries in the subtree headed by this page is not
+    ** known, descend to its first child.  The cells of an interior page
+    ** of an index b-tree are entries as well.
     */
     if( pPage->leaf ){
-      do {
-        if( pCur->iPage==0 ){
-          /* All pages of the b-tree have been visited. Return successfully. */
+      nEntry = pPage->nCell;
+    }else if( (nEntry = btreeCountGet(pPage))<0 ){
+      aSum[pCur->iPage] = pPage->intKey ? 0 : pPage->nCell;
+      pCur->ix = 0;
+    }
+
+    /* The subtree headed by pPage holds nEntry entries.  Add them to the
+    ** parent page and move the cursor to the first cell of the parent
+    ** whose child has not yet been visited, recording the count of each
+    ** interior page that has no such cell.  The pCur->ix value is set to
+    ** the number of cells in the page if the next page to visit is the
+    ** right-child of its parent.
+    **
+    ** If the subtree headed by the starting page has been visited, return
+    ** SQLITE_OK to the caller.
+    */
+    if( nEntry>=0 ){
+      while( 1 ){
+        if( pCur->iPage==iBase ){
           *pnEntry = nEntry;
-          return moveToRoot(pCur);
+          return SQLITE_OK;
         }
         moveToParent(pCur);
-      }while ( pCur->ix>=pCur->pPage->nCell );
-
+        pPage = pCur->pPage;
+        aSum[pCur->iPage] += nEntry;
+        if( pCur->ix<pPage->nCell ) break;
+        nEntry = aSum[pCur->iPage];
+        btreeCountSet(pPage, nEntry);
+      }
       pCur->ix++;
-      pPage = pCur->pPage;
     }
 
     /* Descend to the child node of the cell that the cursor currently 
-    ** points at. This is the right-child if (iIdx==pPage->nCell).
+    ** points at. This is the right-child if (pCur->ix==pPage->nCell).
     */
-    iIdx = pCur->ix;
-    if( iIdx==pPage->nCell ){
+    if( pCur->ix==pPage->nCell ){
       rc = moveToChild(pCur, get4byte(&pPage->aData[pPage->hdrOffset+8]));
     }else{
-      rc = moveToChild(pCur, get4byte(findCell(pPage, iIdx)));
+      rc = moveToChild(pCur, get4byte(findCell(pPage, pCur->ix)));
     }
   }
 
   /* An error has occurred. Return an error code. */
   return rc;
 }
+
+/*
+** The first argument, pCur, is a cursor opened on some b-tree. Count the
+** number of entries in the b-tree and write the result to *pnEntry.
+**
+** SQLITE_OK is returned if the operation is successfully executed. 
+** Otherwise, if an error is encountered (i.e. an IO error or database
+** corruption) an SQLite error code is returned.
+*/
+int sqlite3BtreeCount(BtCursor *pCur, i64 *pnEntry){
+  int rc;                              /* Return code */
+
+  rc = moveToRoot(pCur);
+  if( rc==SQLITE_EMPTY ){
+    *pnEntry = 0;
+    return SQLITE_OK;
+  }
+  if( rc==SQLITE_OK ){
+    rc = btreeSubtreeCount(pCur, pnEntry);
+  }
+  if( rc==SQLITE_OK ){
+    rc = moveToRoot(pCur);
+  }
+  return rc;
+}
+
+#ifdef SQLITE_ENABLE_COUNTED_BTREE
+/*
+** Move cursor pCur to the entry that has iRank entries before it in the
+** b-tree, so that an iRank of 0 is the first entry.  Set *pRes to 0 if
+** successful, or to 1, leaving the cursor pointing at nothing, if the
+** b-tree has no such entry.
+**
+** At each level, the subtrees to the left of the target entry are
+** skipped using their entry counts, which btreeSubtreeCount() records
+** as it goes.  Only the pages on the path to the target entry, and the
+** children of those pages, are loaded.
+*/
+int sqlite3BtreeSeekRank(BtCursor *pCur, i64 iRank, int *pRes){
+  int rc;                              /* Return code */
+  i64 nEntry;                          /* Entries in a child subtree */
+  MemPage *pPage;                      /* Current page of the b-tree */
+
+  assert( cursorOwnsBtShared(pCur) );
+  *pRes = 1;
+  rc = moveToRoot(pCur);
+  if( rc!=SQLITE_OK ){
+    if( rc==SQLITE_EMPTY ) rc = SQLITE_OK;
+    return rc;
+  }
+  while( iRank>=0 ){
+    pPage = pCur->pPage;
+    if( pPage->leaf ){
+      if( iRank<pPage->nCell ){
+        pCur->ix = (u16)iRank;
+        pCur->info.nSize = 0;
+        pCur->curFlags &= ~(BTCF_ValidNKey|BTCF_ValidOvfl|BTCF_AtLast);
+        *pRes = 0;
+        return SQLITE_OK;
+      }
+      break;
+    }
+
+    /* Find the child of pPage whose subtree holds the target entry, or
+    ** the interior cell that is the target entry.  */
+    pCur->ix = 0;
+    while( 1 ){
+      int ix = pCur->ix;
+      if( ix==pPage->nCell ){
+        rc = moveToChild(pCur, get4byte(&pPage->aData[pPage->hdrOffset+8]));
+      }else{
+        rc = moveToChild(pCur, get4byte(findCell(pPage, ix)));
+      }
+      if( rc==SQLITE_OK ) rc = btreeSubtreeCount(pCur, &nEntry);
+      if( rc ) return rc;
+      if( iRank<nEntry ) break;
+      iRank -= nEntry;
+      moveToParent(pCur);
+      if( ix>=pPage->nCell ){
+        iRank = -1;
+        break;
+      }
+      if( !pPage->intKey ){
+        if( iRank==0 ){
+          pCur->info.nSize = 0;
+          pCur->curFlags &= ~(BTCF_ValidNKey|BTCF_ValidOvfl|BTCF_AtLast);
+          *pRes = 0;
+          return SQLITE_OK;
+        }
+        iRank--;
+      }
+      pCur->ix = (u16)(ix+1);
+    }
+  }
+  pCur->eState = CURSOR_INVALID;
+  return SQLITE_OK;
+}
+#endif /* SQLITE_ENABLE_COUNTED_BTREE */
 #endif
 
 /*
@@ -9340,6 +11513,47 @@ static void checkPtrmap(
 }
 #endif
 
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+/*
+** Check the integrity of the free-space map.  Each map page and each page
+** marked free is referenced once.  Verify that N pages are marked free.
+*/
+static void checkFreemap(IntegrityCk *pCheck, int N){
+  BtShared *pBt = pCheck->pBt;
+  u32 nPagesPerMapPage = pBt->usableSize*8 + 1;
+  u32 nBit = pBt->usableSize*8;
+  Pgno iBase;
+  int nFree = 0;
+
+  for(iBase=2; iBase<=pCheck->nPage && pCheck->mxErr; iBase+=nPagesPerMapPage){
+    Pgno iMap = FREEMAP_PAGENO(pBt, iBase);
+    DbPage *pMapPage;
+    const u8 *aMap;
+    u32 i;
+    if( iMap>pCheck->nPage ) break;
+    checkRef(pCheck, iMap);
+    if( sqlite3PagerGet(pCheck->pPager, iMap, &pMapPage, 0) ){
+      checkAppendMsg(pCheck, "failed to get page %d", iMap);
+      break;
+    }
+    aMap = (const u8*)sqlite3PagerGetData(pMapPage);
+    for(i=0; i<nBit && pCheck->mxErr; i++){
+      if( (i&7)==0 && aMap[i/8]==0 ){
+        i += 7;
+      }else if( aMap[i/8] & (1<<(i&7)) ){
+        nFree++;
+        checkRef(pCheck, iMap+1+i);
+      }
+    }
+    sqlite3PagerUnref(pMapPage);
+  }
+  if( nFree!=N ){
+    checkAppendMsg(pCheck, "free-page count in header is %d but should be %d",
+                   N, nFree);
+  }
+}
+#endif
+
 /*
 ** Check the integrity of the freelist or of an overflow page list.
 ** Verify that the number of pages on the list is N.
@@ -9683,6 +11897,14 @@ static int checkTreePage(
       assert( (u32)j<=usableSize-4 );   /* Enforced by btreeInitPage() */
       i = j;
     }
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+    /* The shared record prefix and its length byte at the end of a
+    ** PTF_PREFIX page */
+    if( pPage->nPrefix ){
+      i = usableSize - 1 - pPage->nPrefix;
+      btreeHeapInsert(heap, (((u32)i)<<16)|(usableSize-1));
+    }
+#endif
     /* Analyze the min-heap looking for overlap between cells and/or 
     ** freeblocks, and counting the number of untracked bytes in nFrag.
     ** 
@@ -9796,9 +12018,17 @@ char *sqlite3BtreeIntegrityCheck(
 
   /* Check the integrity of the freelist
   */
-  sCheck.zPfx = "Main freelist: ";
-  checkList(&sCheck, 1, get4byte(&pBt->pPage1->aData[32]),
-            get4byte(&pBt->pPage1->aData[36]));
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+  if( pBt->bFreemap ){
+    sCheck.zPfx = "Main free-space map: ";
+    checkFreemap(&sCheck, get4byte(&pBt->pPage1->aData[36]));
+  }else
+#endif
+  {
+    sCheck.zPfx = "Main freelist: ";
+    checkList(&sCheck, 1, get4byte(&pBt->pPage1->aData[32]),
+              get4byte(&pBt->pPage1->aData[36]));
+  }
   sCheck.zPfx = 0;
 
   /* Check all the tables.
@@ -9930,6 +12160,32 @@ int sqlite3BtreeIsInBackup(Btree *p){
   return p->nBackup!=0;
 }
 
+#ifdef SQLITE_ENABLE_FREELIST_INDEX
+/*
+** Discard the freelist index of the database that Btree p belongs to.
+** This is called by the backup module, which writes the pages of its
+** destination database directly to the pager.
+*/
+void sqlite3BtreeClearFreeIndex(Btree *p){
+  sqlite3BtreeEnter(p);
+  btreeFreeIndexClear(p->pBt);
+  sqlite3BtreeLeave(p);
+}
+#endif
+
+#ifdef SQLITE_ENABLE_OVERFLOW_CACHE
+/*
+** Discard the overflow chain maps of the database that Btree p belongs
+** to.  Like sqlite3BtreeClearFreeIndex(), this is called by the backup
+** module before it overwrites the destination database.
+*/
+void sqlite3BtreeClearOverflowCache(Btree *p){
+  sqlite3BtreeEnter(p);
+  btreeOvflMapClear(p->pBt);
+  sqlite3BtreeLeave(p);
+}
+#endif
+
 /*
 ** This function returns a pointer to a blob of memory associated with
 ** a single shared-btree. The memory is used by client code for its own
@@ -10065,6 +12321,192 @@ void sqlite3BtreeIncrblobCursor(BtCursor *pCur){
   pCur->curFlags |= BTCF_Incrblob;
   pCur->pBtree->hasIncrblobCur = 1;
 }
+
+#ifdef SQLITE_ENABLE_BLOB_APPEND
+/*
+** Argument pCsr must be a cursor opened for writing on an INTKEY table
+** currently pointing at a valid table entry.  Append amt bytes from z to
+** the end of the payload of that entry, in place.
+**
+** The split of a payload between the cell and its overflow chain is a
+** function of the payload size, so an append can only be done in place
+** if the entry already spills onto overflow pages and the number of
+** bytes stored locally is the same for the old and new sizes.  In that
+** case only the payload size field of the cell, the last page of the
+** overflow chain and any newly allocated overflow pages are written.
+** Otherwise nothing is modified and SQLITE_DONE is returned.  The
+** caller should then replace the entry using sqlite3BtreeReplaceData().
+*/
+int sqlite3BtreeAppendData(BtCursor *pCsr, u32 amt, const void *z){
+  const u8 *aSrc = (const u8*)z;
+  BtShared *pBt = pCsr->pBt;
+  MemPage *pPage;
+  MemPage *pLast = 0;
+  u8 *pCell;
+  u32 ovflSize = pBt->usableSize - 4;
+  u32 nOld, nNew, nPayload;
+  u32 nOvfl, nUsed, n;
+  Pgno pgnoLast;
+  u8 aByte[1];
+  int nLocal;
+  int rc;
+
+  assert( cursorOwnsBtShared(pCsr) );
+  assert( sqlite3_mutex_held(pCsr->pBtree->db->mutex) );
+  assert( pCsr->curFlags & BTCF_Incrblob );
+
+  rc = restoreCursorPosition(pCsr);
+  if( rc!=SQLITE_OK ){
+    return rc;
+  }
+  if( pCsr->eState!=CURSOR_VALID ){
+    return SQLITE_ABORT;
+  }
+  VVA_ONLY(rc =) saveAllCursors(pBt, pCsr->pgnoRoot, pCsr);
+  assert( rc==SQLITE_OK );
+  if( (pCsr->curFlags & BTCF_WriteFlag)==0 ){
+    return SQLITE_READONLY;
+  }
+  assert( (pBt->btsFlags & BTS_READ_ONLY)==0
+              && pBt->inTransaction==TRANS_WRITE );
+  assert( hasSharedCacheTableLock(pCsr->pBtree, pCsr->pgnoRoot, 0, 2) );
+  assert( !hasReadConflicts(pCsr->pBtree, pCsr->pgnoRoot) );
+  assert( pCsr->pPage->intKey );
+  if( amt==0 ) return SQLITE_OK;
+
+  /* Check that the cell does not change shape */
+  pPage = pCsr->pPage;
+  getCellInfo(pCsr);
+  nOld = pCsr->info.nPayload;
+  nNew = nOld + amt;
+  if( nOld<=pPage->maxLocal || nNew<nOld || nNew>0x7fffffff ){
+    return SQLITE_DONE;
+  }
+  nLocal = pPage->minLocal + (nNew - pPage->minLocal)%ovflSize;
+  if( nLocal>pPage->maxLocal ) nLocal = pPage->minLocal;
+  pCell = findCell(pPage, pCsr->ix);
+  if( nLocal!=pCsr->info.nLocal
+   || getVarint32(pCell, nPayload)!=sqlite3VarintLen(nNew)
+  ){
+    return SQLITE_DONE;
+  }
+  if( nPayload!=nOld ) return SQLITE_CORRUPT_PAGE(pPage);
+
+  /* Reading the last byte of the payload leaves the page number of the
+  ** last page of the overflow chain in aOverflow[]. */
+  rc = accessPayload(pCsr, nOld-1, 1, aByte, 0);
+  if( rc!=SQLITE_OK ) return rc;
+  nOvfl = (nOld - nLocal + ovflSize - 1)/ovflSize;
+  nUsed = nOld - nLocal - (nOvfl-1)*ovflSize;
+  pgnoLast = pCsr->aOverflow[nOvfl-1];
+  assert( nUsed>0 && nUsed<=ovflSize && pgnoLast>0 );
+
+  rc = sqlite3PagerWrite(pPage->pDbPage);
+  if( rc==SQLITE_OK ){
+    rc = btreeGetPage(pBt, pgnoLast, &pLast, 0);
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3PagerWrite(pLast->pDbPage);
+  }
+
+  /* Fill the tail of the last page, then chain on new pages */
+  n = amt;
+  if( n>ovflSize-nUsed ) n = ovflSize - nUsed;
+  if( rc==SQLITE_OK && n>0 ){
+    memcpy(&pLast->aData[4+nUsed], aSrc, n);
+    aSrc += n;
+    amt -= n;
+  }
+  while( rc==SQLITE_OK && amt>0 ){
+    MemPage *pOvfl = 0;
+    Pgno pgnoOvfl = pgnoLast;
+#ifndef SQLITE_OMIT_AUTOVACUUM
+    if( pBt->autoVacuum ){
+      do{
+        pgnoOvfl++;
+      } while(
+        PTRMAP_ISPAGE(pBt, pgnoOvfl) || pgnoOvfl==PENDING_BYTE_PAGE(pBt)
+      );
+    }
+#endif
+    rc = allocateBtreePage(pBt, &pOvfl, &pgnoOvfl, pgnoOvfl, 0);
+#ifndef SQLITE_OMIT_AUTOVACUUM
+    if( pBt->autoVacuum && rc==SQLITE_OK ){
+      ptrmapPut(pBt, pgnoOvfl, PTRMAP_OVERFLOW2, pgnoLast, &rc);
+      if( rc ) releasePage(pOvfl);
+    }
+#endif
+    if( rc==SQLITE_OK ){
+      put4byte(pLast->aData, pgnoOvfl);
+      releasePage(pLast);
+      pLast = pOvfl;
+      pgnoLast = pgnoOvfl;
+      put4byte(pLast->aData, 0);
+      n = amt<ovflSize ? amt : ovflSize;
+      memcpy(&pLast->aData[4], aSrc, n);
+      aSrc += n;
+      amt -= n;
+    }
+  }
+  releasePage(pLast);
+
+  if( rc==SQLITE_OK ){
+    BtCursor *p;
+    putVarint32(pCell, nNew);
+    pPage->iZoneTag = 0;
+    pCsr->info.nSize = 0;
+    pCsr->curFlags &= ~(BTCF_ValidNKey|BTCF_ValidOvfl);
+
+    /* Other handles open on this row have a stale idea of its layout */
+    for(p=pBt->pCursor; p; p=p->pNext){
+      if( p!=pCsr && (p->curFlags & BTCF_Incrblob)!=0
+       && p->pgnoRoot==pCsr->pgnoRoot && p->info.nKey==pCsr->info.nKey
+      ){
+        p->eState = CURSOR_INVALID;
+      }
+    }
+  }
+  return rc;
+}
+
+/*
+** Argument pCsr must be a cursor opened for writing on an INTKEY table
+** currently pointing at a valid table entry.  Replace the payload of that
+** entry with the nData bytes at pData.  The cursor is left pointing at
+** the new entry, and other incremental blob cursors open on the same row
+** are invalidated.
+*/
+int sqlite3BtreeReplaceData(BtCursor *pCsr, const void *pData, int nData){
+  BtreePayload x;
+  int rc;
+
+  assert( cursorOwnsBtShared(pCsr) );
+  assert( pCsr->curFlags & BTCF_Incrblob );
+  rc = restoreCursorPosition(pCsr);
+  if( rc!=SQLITE_OK ){
+    return rc;
+  }
+  if( pCsr->eState!=CURSOR_VALID ){
+    return SQLITE_ABORT;
+  }
+  if( (pCsr->curFlags & BTCF_WriteFlag)==0 ){
+    return SQLITE_READONLY;
+  }
+  getCellInfo(pCsr);
+  memset(&x, 0, sizeof(x));
+  x.nKey = pCsr->info.nKey;
+  x.pData = pData;
+  x.nData = nData;
+
+  /* Clear BTCF_Incrblob so that the insert does not invalidate pCsr
+  ** along with the other handles open on this row. */
+  pCsr->curFlags &= ~BTCF_Incrblob;
+  rc = sqlite3BtreeInsert(pCsr, &x, BTREE_SAVEPOSITION, 0);
+  invalidateOverflowCache(pCsr);
+  sqlite3BtreeIncrblobCursor(pCsr);
+  return rc;
+}
+#endif /* SQLITE_ENABLE_BLOB_APPEND */
 #endif
 
 /*
@@ -10087,13 +12529,23 @@ int sqlite3BtreeSetVersion(Btree *pBtree, int iVersion){
   rc = sqlite3BtreeBeginTrans(pBtree, 0);
   if( rc==SQLITE_OK ){
     u8 *aData = pBt->pPage1->aData;
-    if( aData[18]!=(u8)iVersion || aData[19]!=(u8)iVersion ){
+    u8 iWrite = (u8)iVersion;
+    u8 iRead = (u8)iVersion;
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+    /* The write version of a database with a free-space map never changes */
+    if( pBt->bFreemap ) iWrite = BTREE_FREEMAP_WRITEVERSION;
+#endif
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+    /* Nor does the mark on the read version of one with PTF_PREFIX pages */
+    if( aData[19]>2 ) iRead += BTREE_PREFIX_VERSION_OFFSET;
+#endif
+    if( aData[18]!=iWrite || aData[19]!=iRead ){
       rc = sqlite3BtreeBeginTrans(pBtree, 2);
       if( rc==SQLITE_OK ){
         rc = sqlite3PagerWrite(pBt->pPage1->pDbPage);
         if( rc==SQLITE_OK ){
-          aData[18] = (u8)iVersion;
-          aData[19] = (u8)iVersion;
+          aData[18] = iWrite;
+          aData[19] = iRead;
         }
       }
     }
@@ -74,10 +74,17 @@ int sqlite3BtreeGetPageSize(Btree*);
 int sqlite3BtreeMaxPageCount(Btree*,int);
 u32 sqlite3BtreeLastPage(Btree*);
 int sqlite3BtreeSecureDelete(Btree*,int);
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+int sqlite3BtreePrefixCompression(Btree*,int);
+#endif
 int sqlite3BtreeGetOptimalReserve(Btree*);
 int sqlite3BtreeGetReserveNoMutex(Btree *p);
 int sqlite3BtreeSetAutoVacuum(Btree *, int);
 int sqlite3BtreeGetAutoVacuum(Btree *);
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+int sqlite3BtreeSetFreemap(Btree *, int);
+int sqlite3BtreeGetFreemap(Btree *);
+#endif
 int sqlite3BtreeBeginTrans(Btree*,int);
 int sqlite3BtreeCommitPhaseOne(Btree*, const char *zMaster);
 int sqlite3BtreeCommitPhaseTwo(Btree*, int);
@@ -88,6 +95,16 @@ int sqlite3BtreeCreateTable(Btree*, int*, int flags);
 int sqlite3BtreeIsInTrans(Btree*);
 int sqlite3BtreeIsInReadTrans(Btree*);
 int sqlite3BtreeIsInBackup(Btree*);
+#ifdef SQLITE_ENABLE_FREELIST_INDEX
+void sqlite3BtreeClearFreeIndex(Btree*);
+#else
+# define sqlite3BtreeClearFreeIndex(X)
+#endif
+#ifdef SQLITE_ENABLE_OVERFLOW_CACHE
+void sqlite3BtreeClearOverflowCache(Btree*);
+#else
+# define sqlite3BtreeClearOverflowCache(X)
+#endif
 void *sqlite3BtreeSchema(Btree *, int, void(*)(void *));
 int sqlite3BtreeSchemaLocked(Btree *pBtree);
 #ifndef SQLITE_OMIT_SHARED_CACHE
@@ -249,6 +266,9 @@ int sqlite3BtreeMovetoUnpacked(
 int sqlite3BtreeCursorHasMoved(BtCursor*);
 int sqlite3BtreeCursorRestore(BtCursor*, int*);
 int sqlite3BtreeDelete(BtCursor*, u8 flags);
+#ifdef SQLITE_ENABLE_RANGE_DELETE
+int sqlite3BtreeDeleteRange(BtCursor*, i64 iLo, i64 iHi, int *pnChange);
+#endif
 
 /* Allowed flags for sqlite3BtreeDelete() and sqlite3BtreeInsert() */
 #define BTREE_SAVEPOSITION 0x02  /* Leave cursor pointing at NEXT or PREV */
@@ -305,6 +325,9 @@ int sqlite3BtreeLast(BtCursor*, int *pRes);
 int sqlite3BtreeNext(BtCursor*, int flags);
 int sqlite3BtreeEof(BtCursor*);
 int sqlite3BtreePrevious(BtCursor*, int flags);
+void sqlite3BtreeZoneAdd(BtCursor*, int iTag, i64 iVal, int isNull);
+int sqlite3BtreeZoneGet(BtCursor*, int iTag, int bRev, i64*, i64*);
+int sqlite3BtreeSkipLeaf(BtCursor*, int bRev);
 i64 sqlite3BtreeIntegerKey(BtCursor*);
 #ifdef SQLITE_ENABLE_OFFSET_SQL_FUNC
 i64 sqlite3BtreeOffset(BtCursor*);
@@ -321,6 +344,10 @@ i64 sqlite3BtreeRowCountEst(BtCursor*);
 int sqlite3BtreePayloadChecked(BtCursor*, u32 offset, u32 amt, void*);
 int sqlite3BtreePutData(BtCursor*, u32 offset, u32 amt, void*);
 void sqlite3BtreeIncrblobCursor(BtCursor *);
+#ifdef SQLITE_ENABLE_BLOB_APPEND
+int sqlite3BtreeAppendData(BtCursor*, u32 amt, const void*);
+int sqlite3BtreeReplaceData(BtCursor*, const void*, int);
+#endif
 #endif
 void sqlite3BtreeClearCursor(BtCursor *);
 int sqlite3BtreeSetVersion(Btree *pBt, int iVersion);
@@ -335,6 +362,9 @@ int sqlite3BtreeCursorIsValidNN(BtCursor*);
 
 #ifndef SQLITE_OMIT_BTREECOUNT
 int sqlite3BtreeCount(BtCursor *, i64 *);
+# ifdef SQLITE_ENABLE_COUNTED_BTREE
+int sqlite3BtreeSeekRank(BtCursor*, i64, int*);
+# endif
 #endif
 
 #ifdef SQLITE_TEST
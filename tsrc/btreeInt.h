@@ -258,6 +258,86 @@ typedef struct CellInfo CellInfo;
 #define PTF_LEAFDATA  0x04
 #define PTF_LEAF      0x08
 
+/*
+** Index leaf pages written by a library built with
+** SQLITE_ENABLE_INDEX_PREFIX may also carry the PTF_PREFIX flag.  On such
+** a page every cell holds a record that begins with the same nPrefix
+** bytes.  Those bytes are stored once, at the very end of the usable
+** area of the page, followed by a single byte holding nPrefix:
+**
+**      ... cell content ... | prefix (nPrefix bytes) | nPrefix (1 byte) |
+**
+** and each cell consists of the usual varint payload size (which counts
+** the full record, prefix included) followed by the record bytes that
+** come after the prefix.  Cells are padded to at least 4 bytes.  All
+** cells of a compressed page fit entirely on the page; cells that would
+** need overflow pages are never stored on one.
+*/
+#define PTF_PREFIX    0x10
+
+/*
+** Before the first PTF_PREFIX page of a database is written, the read
+** version (byte 19 of the header) is raised by BTREE_PREFIX_VERSION_OFFSET,
+** to 3 for a rollback-mode database or 4 in WAL mode.  A library that
+** cannot read these pages then refuses to open the file, rather than
+** reporting it as corrupt or writing to it.
+*/
+#define BTREE_PREFIX_VERSION_OFFSET 2
+
+/*
+** Default value of PRAGMA prefix_compression.
+*/
+#ifndef SQLITE_DEFAULT_PREFIX_COMPRESSION
+# define SQLITE_DEFAULT_PREFIX_COMPRESSION 0
+#endif
+
+/*
+** When the library is built with SQLITE_ENABLE_BTREE_KEYCACHE, each
+** BtShared keeps a direct-mapped table of BTREE_KEYCACHE_SIZE key caches,
+** each holding the integer keys of BTREE_KEYCACHE_N cells of a single
+** page.  Pages with fewer than twice BTREE_KEYCACHE_N cells are searched
+** without a cache.  BTREE_KEYCACHE_SIZE must be a power of two.
+*/
+#ifndef BTREE_KEYCACHE_N
+# define BTREE_KEYCACHE_N 16
+#endif
+#ifndef BTREE_KEYCACHE_SIZE
+# define BTREE_KEYCACHE_SIZE 64
+#endif
+
+/*
+** When the library is built with SQLITE_ENABLE_COUNTED_BTREE, each
+** BtShared keeps a direct-mapped table of BTREE_COUNTCACHE_SIZE subtree
+** entry counts for interior pages.  BTREE_COUNTCACHE_SIZE must be a power
+** of two.
+*/
+#ifndef BTREE_COUNTCACHE_SIZE
+# define BTREE_COUNTCACHE_SIZE 256
+#endif
+
+/*
+** When the library is built with SQLITE_ENABLE_FREELIST_INDEX, each
+** BtShared keeps a sorted in-memory copy of the leaf lists of up to
+** BTREE_FREEINDEX_MAXTRUNK freelist trunk pages.  A freelist with more
+** trunks than that is allocated from without the index.
+*/
+#ifndef BTREE_FREEINDEX_MAXTRUNK
+# define BTREE_FREEINDEX_MAXTRUNK 256
+#endif
+
+/*
+** When the library is built with SQLITE_ENABLE_OVERFLOW_CACHE, each
+** BtShared remembers the page numbers of up to BTREE_OVFLMAP_SIZE overflow
+** chains.  Only chains of at least BTREE_OVFLMAP_MINPAGES pages are
+** remembered.
+*/
+#ifndef BTREE_OVFLMAP_SIZE
+# define BTREE_OVFLMAP_SIZE 32
+#endif
+#ifndef BTREE_OVFLMAP_MINPAGES
+# define BTREE_OVFLMAP_MINPAGES 16
+#endif
+
 /*
 ** An instance of this object stores information about each a single database
 ** page that has been loaded into memory.  The information in this object
@@ -269,6 +349,22 @@ typedef struct CellInfo CellInfo;
 **
 ** Access to all fields of this structure is controlled by the mutex
 ** stored in MemPage.pBt->mutex.
+**
+** The iZoneTag, nZoneCell, iZoneMin and iZoneMax fields hold a min/max
+** summary of one integer value per cell of a leaf page.  The summary is
+** built by sqlite3BtreeZoneAdd() as a scan visits the cells in order,
+** and is complete once nZoneCell==nCell.  It is discarded whenever the
+** content of the page changes.
+**
+** The iKeyTag and nKeySearch fields track the key cache of the page (see
+** BtKeyCache below), which is likewise discarded when the page changes.
+** iCountTag does the same for the subtree entry count of an interior page
+** (see BtCount below).
+**
+** nPrefix is the size of the record prefix shared by all cells of a
+** PTF_PREFIX page.  On such pages xParseCell and xCellSize describe the
+** cell as stored, and CellInfo.pPayload points at the part of the record
+** that follows the prefix.
 */
 struct MemPage {
   u8 isInit;           /* True if previously initialized. MUST BE FIRST! */
@@ -283,6 +379,9 @@ struct MemPage {
   u8 childPtrSize;     /* 0 if leaf==1.  4 if leaf==0 */
   u8 max1bytePayload;  /* min(maxLocal,127) */
   u8 nOverflow;        /* Number of overflow cell bodies in aCell[] */
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  u8 nPrefix;          /* Bytes of shared record prefix.  0 if PTF_PREFIX unset */
+#endif
   u16 maxLocal;        /* Copy of BtShared.maxLocal or BtShared.maxLeaf */
   u16 minLocal;        /* Copy of BtShared.minLocal or BtShared.minLeaf */
   u16 cellOffset;      /* Index in aData of first cell pointer */
@@ -300,8 +399,140 @@ struct MemPage {
   DbPage *pDbPage;     /* Pager page handle */
   u16 (*xCellSize)(MemPage*,u8*);             /* cellSizePtr method */
   void (*xParseCell)(MemPage*,u8*,CellInfo*); /* btreeParseCell method */
+  int iZoneTag;        /* Owner of the zone summary below.  0 if none */
+  u16 nZoneCell;       /* Number of cells included in the zone summary */
+  i64 iZoneMin;        /* Smallest non-NULL value in the summarized cells */
+  i64 iZoneMax;        /* Largest non-NULL value in the summarized cells */
+#ifdef SQLITE_ENABLE_BTREE_KEYCACHE
+  u8 nKeySearch;       /* Searches of this page while it had no key cache */
+  u32 iKeyTag;         /* Tag of the key cache of this page.  0 if none */
+#endif
+#ifdef SQLITE_ENABLE_COUNTED_BTREE
+  u32 iCountTag;       /* Tag of the entry count of this page.  0 if none */
+#endif
+};
+
+#ifdef SQLITE_ENABLE_BTREE_KEYCACHE
+/*
+** A key cache holds the integer keys of BTREE_KEYCACHE_N cells spread
+** evenly across a single b-tree page, and the index of each of those
+** cells.  For intkey pages the key is the rowid.  For index pages it is
+** the first field of the record, and a cache is only built if that field
+** is an integer in every sampled cell.  sqlite3BtreeMovetoUnpacked()
+** compares the search key against all samples at once to narrow the
+** range of cells its binary search has to examine.
+**
+** Key caches live in BtShared.aKeyCache[], indexed by page number.  The
+** cache of page pPage is valid only if its pPage and iTag fields match
+** pPage and pPage->iKeyTag.  Clearing MemPage.iKeyTag, which is done
+** whenever the content of the page changes, discards the cache.  A cache
+** is built the second time a page is searched without one, so that pages
+** that are searched only once are not charged for building it.
+*/
+typedef struct BtKeyCache BtKeyCache;
+struct BtKeyCache {
+  MemPage *pPage;                   /* Page this cache was built for */
+  u32 iTag;                         /* Copy of pPage->iKeyTag when built */
+  u16 aKeyCell[BTREE_KEYCACHE_N];   /* Cells sampled by aKey[] */
+  i64 aKey[BTREE_KEYCACHE_N];       /* Integer key of each sampled cell */
 };
 
+/*
+** Value of MemPage.nKeySearch for pages that cannot have a key cache,
+** and the macro used to discard the key cache of a page.
+*/
+# define KEYCACHE_UNUSABLE 0xff
+# define btreeKeyCacheClear(P) ((P)->iKeyTag = 0, (P)->nKeySearch = 0)
+#else
+# define btreeKeyCacheClear(P)
+#endif
+
+#ifdef SQLITE_ENABLE_COUNTED_BTREE
+/*
+** A BtCount records the number of entries in the subtree headed by an
+** interior page: the cells of every leaf below it, plus the cells of the
+** interior pages themselves for index b-trees.  sqlite3BtreeCount() and
+** sqlite3BtreeSeekRank() use it to step over whole subtrees.
+**
+** Counts live in BtShared.aCount[], indexed by page number, and are valid
+** only if the pPage and iTag fields match pPage and pPage->iCountTag, as
+** for key caches.  The count of a page is discarded when the content of
+** the page changes.  Inserts and deletes adjust the counts of all pages
+** on the path from the root to the modified leaf, and balance() carries
+** the count of a parent page across the rebalancing of its children.
+** All counts are discarded when a transaction or savepoint is rolled
+** back, as the pages whose content is restored need not include the
+** ancestors of the pages that were modified.
+*/
+typedef struct BtCount BtCount;
+struct BtCount {
+  MemPage *pPage;                   /* Page this count was recorded for */
+  u32 iTag;                         /* Copy of pPage->iCountTag when recorded */
+  i64 nEntry;                       /* Entries in the subtree headed by pPage */
+};
+# define btreeCountClear(P) ((P)->iCountTag = 0)
+#else
+# define btreeCountClear(P)
+#endif
+
+#ifdef SQLITE_ENABLE_FREELIST_INDEX
+/*
+** A BtFreeTrunk describes one trunk page of the freelist: its page number
+** and the leaf page numbers stored on it, sorted in ascending order.
+** BtShared.aFreeTrunk[] holds one for each trunk, in freelist order, so
+** that allocateBtreePage() can locate the free page closest to the page
+** a new page will be linked from without walking the trunk pages.
+**
+** The index is built from the trunk pages the first time it is needed
+** and is then kept in step with the freelist by allocateBtreePage() and
+** freePage2().  It survives the commit of a transaction, but is discarded
+** by anything that changes the freelist in some other way: a rollback,
+** auto-vacuum, a backup into the database or a change made by another
+** connection (detected using the pager data version).
+*/
+typedef struct BtFreeTrunk BtFreeTrunk;
+struct BtFreeTrunk {
+  Pgno iTrunk;                      /* Page number of the trunk page */
+  u32 nLeaf;                        /* Number of leaves on the trunk */
+  Pgno *aLeaf;                      /* Leaf page numbers, sorted */
+};
+#endif
+
+#ifdef SQLITE_ENABLE_OVERFLOW_CACHE
+/*
+** A BtOvflMap records the page numbers of the overflow chain that starts
+** at page iFirst.  BtCursor.aOverflow[] serves the same purpose for the
+** entry a cursor points to, but is discarded whenever the cursor moves.
+** The maps in BtShared.aOvflMap[] outlive cursor moves, so that random
+** reads into a large blob that is visited repeatedly, for example through
+** sqlite3_blob_reopen(), find the overflow page they need without walking
+** the chain from its start.
+**
+** Like aOverflow[], a map is filled in lazily: a zero in aPgno[] means
+** "not yet known".  The map of a chain is dropped by clearCell() when the
+** chain is freed, and all maps are discarded by anything that may move or
+** free overflow pages in some other way: a rollback, auto-vacuum, a
+** backup into the database or a change made by another connection.
+*/
+typedef struct BtOvflMap BtOvflMap;
+struct BtOvflMap {
+  Pgno iFirst;                      /* First page of the chain, or 0 */
+  u32 nOvfl;                        /* Number of pages in the chain */
+  u32 iLru;                         /* BtShared.iOvflTick when last used */
+  Pgno *aPgno;                      /* Page numbers of the chain, or 0 */
+};
+#endif
+
+/*
+** Size of the shared record prefix of page P, or 0 for pages that use the
+** standard cell format.
+*/
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+# define btreePagePrefix(P) ((P)->nPrefix)
+#else
+# define btreePagePrefix(P) 0
+#endif
+
 /*
 ** A linked list of the following structures is stored at BtShared.pLock.
 ** Locks are added (or upgraded from READ_LOCK to WRITE_LOCK) when a cursor 
@@ -414,6 +645,9 @@ struct BtShared {
   u8 autoVacuum;        /* True if auto-vacuum is enabled */
   u8 incrVacuum;        /* True if incr-vacuum is enabled */
   u8 bDoTruncate;       /* True to truncate db on commit */
+#endif
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+  u8 bFreemap;          /* True if free pages are tracked in a bitmap */
 #endif
   u8 inTransaction;     /* Transaction state */
   u8 max1bytePayload;   /* Maximum first byte of cell for a 1-byte payload */
@@ -440,6 +674,26 @@ struct BtShared {
   Btree *pWriter;       /* Btree with currently open write transaction */
 #endif
   u8 *pTmpSpace;        /* Temp space sufficient to hold a single cell */
+#ifdef SQLITE_ENABLE_BTREE_KEYCACHE
+  BtKeyCache *aKeyCache;  /* BTREE_KEYCACHE_SIZE page key caches, or NULL */
+  u32 iKeyTag;          /* Tag assigned to the most recently built cache */
+#endif
+#ifdef SQLITE_ENABLE_COUNTED_BTREE
+  BtCount *aCount;      /* BTREE_COUNTCACHE_SIZE subtree counts, or NULL */
+  u32 iCountTag;        /* Tag assigned to the most recently recorded count */
+#endif
+#ifdef SQLITE_ENABLE_FREELIST_INDEX
+  BtFreeTrunk *aFreeTrunk;  /* Index of the freelist trunk pages */
+  int nFreeTrunk;       /* Number of valid entries in aFreeTrunk[] */
+  int nFreeTrunkAlloc;  /* Allocated size of aFreeTrunk[] */
+  u8 bFreeIndex;        /* True if aFreeTrunk[] describes the freelist */
+  u32 iFreeVersion;     /* Pager data version when aFreeTrunk[] was valid */
+#endif
+#ifdef SQLITE_ENABLE_OVERFLOW_CACHE
+  BtOvflMap aOvflMap[BTREE_OVFLMAP_SIZE];  /* Maps of large overflow chains */
+  u32 iOvflTick;        /* Incremented each time a map is used */
+  u32 iOvflVersion;     /* Pager data version when aOvflMap[] was valid */
+#endif
 };
 
 /*
@@ -454,6 +708,7 @@ struct BtShared {
 #define BTS_NO_WAL           0x0020   /* Do not open write-ahead-log files */
 #define BTS_EXCLUSIVE        0x0040   /* pWriter has an exclusive lock */
 #define BTS_PENDING          0x0080   /* Waiting for read-locks to clear */
+#define BTS_PREFIX           0x0100   /* PRAGMA prefix_compression is on */
 
 /*
 ** An instance of the following structure is used to hold information
@@ -508,6 +763,9 @@ struct BtCursor {
   Btree *pBtree;            /* The Btree to which this cursor belongs */
   Pgno *aOverflow;          /* Cache of overflow page locations */
   void *pKey;               /* Saved key that was cursor last known position */
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  u8 *aRecord;              /* Buffer for records read from PTF_PREFIX pages */
+#endif
   /* All fields above are zeroed when the cursor is allocated.  See
   ** sqlite3BtreeCursorZero().  Fields that follow must be manually
   ** initialized. */
@@ -633,6 +891,31 @@ struct BtCursor {
 #define PTRMAP_OVERFLOW2 4
 #define PTRMAP_BTREE 5
 
+/*
+** A database created by a library built with SQLITE_ENABLE_FREE_SPACE_MAP
+** while "PRAGMA free_space_map" is on records its free pages in a bitmap
+** instead of on the freelist.  Its freelist is always empty, but the count
+** of free pages at offset 36 of the header is maintained as usual.  The
+** write version (byte 18 of the header) of such a database is
+** BTREE_FREEMAP_WRITEVERSION, so that other libraries treat it as
+** read-only.  A database cannot have both a free-space map and a pointer
+** map, so the free-space map is not used if auto-vacuum is enabled.
+**
+** The bitmap is stored on free-space map pages, which are placed in the
+** same way as pointer-map pages: page 2 is the first, and each covers the
+** (usableSize*8) pages that follow it.  Bit (i%8) of byte (i/8) of a map
+** page is set if the i-th page after the map page is free.
+**
+** FREEMAP_PAGENO returns the map page that holds the bit for page pgno,
+** or pgno itself if pgno is a map page.  FREEMAP_ISPAGE tests whether pgno
+** is a map page.  FREEMAP_BIT returns the index of the bit for page pgno
+** on map page pgmap.
+*/
+#define BTREE_FREEMAP_WRITEVERSION 3
+#define FREEMAP_PAGENO(pBt, pgno) freemapPageno(pBt, pgno)
+#define FREEMAP_ISPAGE(pBt, pgno) (FREEMAP_PAGENO((pBt),(pgno))==(pgno))
+#define FREEMAP_BIT(pgmap, pgno) ((pgno)-(pgmap)-1)
+
 /* A bunch of assert() statements to check the transaction state variables
 ** of handle p (type Btree*) are internally consistent.
 */
@@ -637,6 +637,7 @@ static void SQLITE_NOINLINE deleteTable(sqlite3 *db, Table *pTable){
   sqlite3DeleteColumnNames(db, pTable);
   sqlite3DbFree(db, pTable->zName);
   sqlite3DbFree(db, pTable->zColAff);
+  sqlite3DbFree(db, pTable->aFixOff);
   sqlite3SelectDelete(db, pTable->pSelect);
   sqlite3ExprListDelete(db, pTable->pCheck);
 #ifndef SQLITE_OMIT_VIRTUALTABLE
@@ -1845,6 +1846,76 @@ static void convertToWithoutRowidTable(Parse *pParse, Table *pTab){
   }
 }
 
+/*
+** Return the number of bytes used to store a column of declared type
+** zType in a WITHOUT VARINT record, or 0 if zType is not one of the
+** fixed-width integer types.  The widths follow the SQL standard, so
+** that INT and INTEGER are 32 bits wide.
+*/
+static int fixedTypeWidth(const char *zType){
+  static const struct {
+    const char *zName;
+    u8 nByte;
+  } aType[] = {
+    { "TINYINT",   1 }, { "INT1",      1 },
+    { "SMALLINT",  2 }, { "INT2",      2 },
+    { "MEDIUMINT", 4 }, { "INT4",      4 },
+    { "INT",       4 }, { "INTEGER",   4 },
+    { "BIGINT",    8 }, { "INT8",      8 },
+  };
+  int i, n;
+  if( zType==0 ) return 0;
+  for(n=0; sqlite3Isalnum(zType[n]); n++){}
+  for(i=0; i<ArraySize(aType); i++){
+    if( sqlite3Strlen30(aType[i].zName)==n
+     && sqlite3StrNICmp(zType, aType[i].zName, n)==0
+    ){
+      return aType[i].nByte;
+    }
+  }
+  return 0;
+}
+
+/*
+** Compute the record layout of a WITHOUT VARINT table.
+**
+** A WITHOUT VARINT record is a single 0x00 byte (a header size that an
+** ordinary record can never have), followed by a bitmap with one bit per
+** column that is set for NULL values, followed by every column stored
+** as a big-endian integer at a fixed offset.  Table.aFixOff[i] is the
+** offset of column i from the end of the bitmap and Table.aFixOff[nCol]
+** is the size of that area.  An INTEGER PRIMARY KEY is an alias for the
+** rowid and takes no space in the record.
+*/
+static void computeFixedLayout(Parse *pParse, Table *pTab){
+  sqlite3 *db = pParse->db;
+  u32 *aOff;
+  int i;
+
+  aOff = (u32*)sqlite3DbMallocRaw(0, (pTab->nCol+1)*sizeof(u32));
+  if( aOff==0 ){
+    sqlite3OomFault(db);
+    return;
+  }
+  aOff[0] = 0;
+  for(i=0; i<pTab->nCol; i++){
+    int nByte = 0;
+    if( i!=pTab->iPKey ){
+      nByte = fixedTypeWidth(sqlite3ColumnType(&pTab->aCol[i], 0));
+      if( nByte==0 ){
+        sqlite3ErrorMsg(pParse,
+            "column %s of WITHOUT VARINT table %s is not a fixed-width integer",
+            pTab->aCol[i].zName, pTab->zName);
+        sqlite3DbFree(db, aOff);
+        return;
+      }
+    }
+    aOff[i+1] = aOff[i] + nByte;
+  }
+  pTab->aFixOff = aOff;
+  pTab->tabFlags |= TF_Fixed;
+}
+
 /*
 ** This routine is called to report the final ")" that terminates
 ** a CREATE TABLE statement.
@@ -1869,7 +1940,7 @@ void sqlite3EndTable(
   Parse *pParse,          /* Parse context */
   Token *pCons,           /* The ',' token after the last column defn. */
   Token *pEnd,            /* The ')' before options in the CREATE TABLE */
-  u8 tabOpts,             /* Extra table options. Usually 0. */
+  u32 tabOpts,            /* Extra table options. Usually 0. */
   Select *pSelect         /* Select from a "CREATE ... AS SELECT" */
 ){
   Table *p;                 /* The new table */
@@ -1917,6 +1988,12 @@ void sqlite3EndTable(
     }
   }
 
+  /* Special processing for WITHOUT VARINT tables */
+  if( tabOpts & TF_Fixed ){
+    computeFixedLayout(pParse, p);
+    if( (p->tabFlags & TF_Fixed)==0 ) return;
+  }
+
   iDb = sqlite3SchemaToIndex(db, p->pSchema);
 
 #ifndef SQLITE_OMIT_CHECK
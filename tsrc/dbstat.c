@@ -328,6 +328,9 @@ static int statDecodePage(Btree *pBt, StatPage *p){
   p->nMxPayload = 0;
 
   isLeaf = (p->flags==0x0A || p->flags==0x0D);
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  if( p->flags==0x1A ) isLeaf = 1;
+#endif
   nHdr = 12 - isLeaf*4 + (p->iPgno==1)*100;
 
   nUnused = get2byte(&aHdr[5]) - nHdr - 2*p->nCell;
@@ -371,6 +374,18 @@ static int statDecodePage(Btree *pBt, StatPage *p){
           iOff += sqlite3GetVarint(&aData[iOff], &dummy);
         }
         if( nPayload>(u32)p->nMxPayload ) p->nMxPayload = nPayload;
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+        if( p->flags==0x1A ){
+          /* An index leaf whose records share a prefix stored once at the
+          ** end of the page.  The cell holds the rest of the record. */
+          u32 nPrefix = aData[nUsable-1];
+          nLocal = 0;
+          if( nPayload>nPrefix && nPayload<=(u32)(nUsable-35) ){
+            nLocal = (int)(nPayload-nPrefix);
+          }
+          nPayload = nLocal;
+        }else
+#endif
         getLocalPayload(nUsable, p->flags, nPayload, &nLocal);
         pCell->nLocal = nLocal;
         assert( nLocal>=0 );
@@ -544,6 +559,9 @@ statNextRestart:
           break;
         case 0x0D:             /* table leaf */
         case 0x0A:             /* index leaf */
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+        case 0x1A:             /* index leaf with a shared record prefix */
+#endif
           pCsr->zPagetype = "leaf";
           break;
         default:
@@ -211,6 +211,88 @@ Expr *sqlite3LimitWhere(
 #endif /* defined(SQLITE_ENABLE_UPDATE_DELETE_LIMIT) */
        /*      && !defined(SQLITE_OMIT_SUBQUERY) */
 
+#ifdef SQLITE_ENABLE_RANGE_DELETE
+/*
+** Return true if pExpr is a reference to the rowid of cursor iCur.
+*/
+static int deleteIsRowid(Expr *pExpr, int iCur){
+  return pExpr->op==TK_COLUMN && pExpr->iTable==iCur && pExpr->iColumn<0;
+}
+
+/*
+** Record in apBound[] and *pFlags the rowid bound imposed by WHERE clause
+** term pTerm, which must be "rowid BETWEEN x AND y" or a comparison of
+** the rowid of cursor iCur against a constant.  apBound[0] is the lower
+** bound and apBound[1] the upper one.  Return 0 if the term has some
+** other form or sets a bound that has already been set.
+*/
+static int deleteRangeTerm(Expr *pTerm, int iCur, Expr **apBound, u16 *pFlags){
+  Expr *pVal;
+  int op = pTerm->op;
+  if( op==TK_BETWEEN ){
+    ExprList *pList = pTerm->x.pList;
+    if( !deleteIsRowid(pTerm->pLeft, iCur)
+     || (*pFlags & (OPFLAG_NOLO|OPFLAG_NOHI))!=(OPFLAG_NOLO|OPFLAG_NOHI)
+     || ExprHasProperty(pTerm, EP_xIsSelect)
+     || pList==0 || pList->nExpr!=2
+     || !sqlite3ExprIsConstant(pList->a[0].pExpr)
+     || !sqlite3ExprIsConstant(pList->a[1].pExpr)
+    ){
+      return 0;
+    }
+    apBound[0] = pList->a[0].pExpr;
+    apBound[1] = pList->a[1].pExpr;
+    *pFlags &= ~(OPFLAG_NOLO|OPFLAG_NOHI);
+    return 1;
+  }
+  if( op<TK_GT || op>TK_GE ) return 0;
+  if( deleteIsRowid(pTerm->pLeft, iCur) ){
+    pVal = pTerm->pRight;
+  }else if( deleteIsRowid(pTerm->pRight, iCur) ){
+    /* Constant on the left.  (x<rowid) is the same as (rowid>x) */
+    pVal = pTerm->pLeft;
+    op = ((op-TK_GT)^2)+TK_GT;
+  }else{
+    return 0;
+  }
+  if( !sqlite3ExprIsConstant(pVal) || sqlite3ExprIsVector(pVal) ) return 0;
+  if( op==TK_GT || op==TK_GE ){
+    if( (*pFlags & OPFLAG_NOLO)==0 ) return 0;
+    apBound[0] = pVal;
+    *pFlags &= ~OPFLAG_NOLO;
+    if( op==TK_GT ) *pFlags |= OPFLAG_LOOPEN;
+  }else{
+    if( (*pFlags & OPFLAG_NOHI)==0 ) return 0;
+    apBound[1] = pVal;
+    *pFlags &= ~OPFLAG_NOHI;
+    if( op==TK_LT ) *pFlags |= OPFLAG_HIOPEN;
+  }
+  return 1;
+}
+
+/*
+** Return true if WHERE clause pWhere of a DELETE does nothing but limit
+** the rowid of cursor iCur to a range, as in "rowid<?" or "rowid>=? AND
+** rowid<?".  If so, the expressions for the bounds are written to
+** apBound[] and the P5 flags for OP_DeleteRange to *pFlags.
+*/
+static int deleteRangeBounds(
+  Expr *pWhere,          /* The WHERE clause of the DELETE */
+  int iCur,              /* Cursor of the table being deleted from */
+  Expr **apBound,        /* OUT: Lower and upper bound expressions */
+  u16 *pFlags            /* OUT: OPFLAG_ flags for OP_DeleteRange */
+){
+  apBound[0] = apBound[1] = 0;
+  *pFlags = OPFLAG_NOLO|OPFLAG_NOHI;
+  if( pWhere==0 ) return 0;
+  if( pWhere->op==TK_AND ){
+    return deleteRangeTerm(pWhere->pLeft, iCur, apBound, pFlags)
+        && deleteRangeTerm(pWhere->pRight, iCur, apBound, pFlags);
+  }
+  return deleteRangeTerm(pWhere, iCur, apBound, pFlags);
+}
+#endif /* SQLITE_ENABLE_RANGE_DELETE */
+
 /*
 ** Generate code for a DELETE FROM statement.
 **
@@ -255,6 +337,11 @@ void sqlite3DeleteFrom(
   int addrEphOpen = 0;   /* Instruction to open the Ephemeral table */
   int bComplex;          /* True if there are triggers or FKs or
                          ** subqueries in the WHERE clause */
+#ifdef SQLITE_ENABLE_RANGE_DELETE
+  Expr *apBound[2];      /* Rowid bounds for OP_DeleteRange */
+  u16 rangeFlags;        /* P5 flags for OP_DeleteRange */
+  int addrRangeDone = 0; /* Jump here after OP_DeleteRange succeeds */
+#endif
  
 #ifndef SQLITE_OMIT_TRIGGER
   int isView;                  /* True if attempting to delete from a view */
@@ -414,6 +501,38 @@ void sqlite3DeleteFrom(
   {
     u16 wcf = WHERE_ONEPASS_DESIRED|WHERE_DUPLICATES_OK|WHERE_SEEK_TABLE;
     if( sNC.ncFlags & NC_VarSelect ) bComplex = 1;
+#ifdef SQLITE_ENABLE_RANGE_DELETE
+    /* Special case: A DELETE that only limits the rowid to a range, from a
+    ** table with no indexes, triggers or foreign keys.  OP_DeleteRange
+    ** frees the b-tree pages that lie wholly inside the range without
+    ** visiting their rows one at a time.  If the bounds turn out not to
+    ** be numbers it falls through to the row-at-a-time loop below.
+    */
+    if( rcauth==SQLITE_OK
+     && !bComplex
+     && HasRowid(pTab)
+     && !IsVirtual(pTab)
+     && pTab->pIndex==0
+     && pOrderBy==0
+     && pLimit==0
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+     && db->xPreUpdateCallback==0
+#endif
+     && deleteRangeBounds(pWhere, iTabCur, apBound, &rangeFlags)
+    ){
+      int regBound = pParse->nMem+1;
+      pParse->nMem += 2;
+      if( apBound[0] ) sqlite3ExprCode(pParse, apBound[0], regBound);
+      if( apBound[1] ) sqlite3ExprCode(pParse, apBound[1], regBound+1);
+      sqlite3OpenTable(pParse, iTabCur, iDb, pTab, OP_OpenWrite);
+      sqlite3MultiWrite(pParse);
+      addrRangeDone = sqlite3VdbeMakeLabel(v);
+      sqlite3VdbeAddOp4Int(v, OP_DeleteRange, iTabCur, addrRangeDone,
+          regBound, pParse->nested ? 0 : (memCnt ? memCnt : -1));
+      sqlite3VdbeChangeP5(v, rangeFlags);
+      VdbeCoverage(v);
+    }
+#endif /* SQLITE_ENABLE_RANGE_DELETE */
     wcf |= (bComplex ? 0 : WHERE_ONEPASS_MULTIROW);
     if( HasRowid(pTab) ){
       /* For a rowid table, initialize the RowSet to an empty set */
@@ -582,6 +701,9 @@ void sqlite3DeleteFrom(
       sqlite3VdbeGoto(v, addrLoop);
       sqlite3VdbeJumpHere(v, addrLoop);
     }     
+#ifdef SQLITE_ENABLE_RANGE_DELETE
+    if( addrRangeDone ) sqlite3VdbeResolveLabel(v, addrRangeDone);
+#endif
   } /* End non-truncate path */
 
   /* Update the sqlite_sequence table by storing the content of the
@@ -241,7 +241,8 @@ SQLITE_WSD struct Sqlite3Config sqlite3Config = {
 #endif
    0,                         /* bLocaltimeFault */
    0x7ffffffe,                /* iOnceResetThreshold */
-   SQLITE_DEFAULT_SORTERREF_SIZE   /* szSorterRef */
+   SQLITE_DEFAULT_SORTERREF_SIZE,  /* szSorterRef */
+   SQLITE_DEFAULT_PCACHE_POLICY    /* ePcachePolicy */
 };
 
 /*
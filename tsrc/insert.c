@@ -36,7 +36,11 @@ void sqlite3OpenTable(
   assert( opcode==OP_OpenWrite || opcode==OP_OpenRead );
   sqlite3TableLock(pParse, iDb, pTab->tnum, 
                    (opcode==OP_OpenWrite)?1:0, pTab->zName);
-  if( HasRowid(pTab) ){
+  if( HasFixedRecord(pTab) ){
+    /* The cursor finds the record layout in the Table passed as P4 */
+    sqlite3VdbeAddOp4(v, opcode, iCur, pTab->tnum, iDb, (char*)pTab, P4_TABLE);
+    VdbeComment((v, "%s", pTab->zName));
+  }else if( HasRowid(pTab) ){
     sqlite3VdbeAddOp4Int(v, opcode, iCur, pTab->tnum, iDb, pTab->nCol);
     VdbeComment((v, "%s", pTab->zName));
   }else{
@@ -1948,11 +1952,20 @@ void sqlite3CompleteInsertion(
   if( !HasRowid(pTab) ) return;
   regData = regNewData + 1;
   regRec = sqlite3GetTempReg(pParse);
-  sqlite3VdbeAddOp3(v, OP_MakeRecord, regData, pTab->nCol, regRec);
-  sqlite3SetMakeRecordP5(v, pTab);
-  if( !bAffinityDone ){
-    sqlite3TableAffinity(v, pTab, 0);
-    sqlite3ExprCacheAffinityChange(pParse, regData, pTab->nCol);
+  if( HasFixedRecord(pTab) ){
+    if( !bAffinityDone ){
+      sqlite3TableAffinity(v, pTab, regData);
+      sqlite3ExprCacheAffinityChange(pParse, regData, pTab->nCol);
+    }
+    sqlite3VdbeAddOp4(v, OP_MakeRecord, regData, pTab->nCol, regRec,
+                      (char*)pTab, P4_TABLE);
+  }else{
+    sqlite3VdbeAddOp3(v, OP_MakeRecord, regData, pTab->nCol, regRec);
+    sqlite3SetMakeRecordP5(v, pTab);
+    if( !bAffinityDone ){
+      sqlite3TableAffinity(v, pTab, 0);
+      sqlite3ExprCacheAffinityChange(pParse, regData, pTab->nCol);
+    }
   }
   if( pParse->nested ){
     pik_flags = 0;
@@ -2243,6 +2256,14 @@ static int xferOptimization(
   if( pDest->iPKey!=pSrc->iPKey ){
     return 0;   /* Both tables must have the same INTEGER PRIMARY KEY */
   }
+  if( HasFixedRecord(pDest)!=HasFixedRecord(pSrc) ){
+    return 0;   /* source and destination must both be WITHOUT VARINT or not */
+  }
+  if( HasFixedRecord(pDest)
+   && memcmp(pDest->aFixOff, pSrc->aFixOff, (pDest->nCol+1)*sizeof(u32))!=0
+  ){
+    return 0;   /* WITHOUT VARINT tables must have the same record layout */
+  }
   for(i=0; i<pDest->nCol; i++){
     Column *pDestCol = &pDest->aCol[i];
     Column *pSrcCol = &pSrc->aCol[i];
@@ -0,0 +1,1152 @@
+/*
+** 2026-10-18
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+******************************************************************************
+**
+** This file contains an implementation of the "interval" virtual table,
+** an index that answers interval overlap queries on an ordinary table.
+** It is created as follows:
+**
+**    CREATE VIRTUAL TABLE segInterval USING interval(
+**        segTable, channel, startTime, stopTime
+**    );
+**
+** The channel column is optional.  If present, intervals are indexed
+** separately for each value of the channel column.  Overlap queries are
+** written the natural way and return the rowids of the indexed table:
+**
+**    SELECT * FROM segTable WHERE rowid IN (
+**      SELECT rid FROM segInterval
+**       WHERE channel=?1 AND lower<=?3 AND upper>=?2
+**    );
+**
+** The columns of the virtual table are "rid", and the hidden columns
+** "channel", "lower" and "upper", which hold the channel, start time and
+** stop time of the indexed row.
+**
+** The index is a Relational Interval Tree.  The integers form the nodes
+** of a virtual binary tree of height 64 whose root is 2^63 (after the
+** sign bit of each value is flipped so that unsigned order matches the
+** signed order).  Each interval [lower,upper] is stored with its fork
+** node, the highest node of the tree that lies within the interval.  A
+** query for [ql,qu] then only has to visit:
+**
+**   *  the ancestors n of ql with n<ql, where intervals with upper>=ql
+**      match,
+**   *  the ancestors n of qu with n>qu, where intervals with lower<=qu
+**      match, and
+**   *  the single range of fork nodes between ql and qu, all of whose
+**      intervals match.
+**
+** Each of these is one index seek, so a query costs at most 129 seeks
+** plus the size of the result.  In addition, a bitmask of the levels of
+** the tree that hold at least one fork node is kept for each channel.
+** Intervals of similar length share a few levels, so in practice only a
+** handful of the ancestors are ever searched.
+**
+** Intervals are stored in the shadow table "<name>_node" and the level
+** masks in "<name>_level".  Inserting an interval costs one insert into
+** each of the two b-trees of the node table.  The index is kept up to
+** date by triggers on the indexed table that write the commands 'insert'
+** and 'delete' to the hidden column that has the same name as the virtual
+** table.  The command 'rebuild' recreates the index and the triggers.
+** BEFORE triggers also write the command 'replace' with the values of
+** each row that REPLACE conflict handling on the rowid or on a UNIQUE
+** index may delete without firing the DELETE trigger.  The next 'insert'
+** removes those that are gone from the index.  This works the same way
+** as in the bitmap virtual table; see bmCreateTriggers() in bitmap.c.
+**
+** Rows for which the start or stop time is not an integer, the start time
+** is greater than the stop time, or the channel is NULL are not indexed.
+*/
+
+#include "sqliteInt.h"   /* Requires access to internal data structures */
+#if (defined(SQLITE_ENABLE_INTERVAL) || defined(SQLITE_TEST)) \
+    && !defined(SQLITE_OMIT_VIRTUALTABLE)
+
+typedef struct IvTable IvTable;
+typedef struct IvCursor IvCursor;
+
+/*
+** The root of the virtual backbone tree, and the conversion between
+** values and nodes of the tree.  Value SMALLEST_INT64 is mapped to node
+** 1, the smallest node, which can only cause false positives that are
+** removed by the exact comparison in ivNext().
+*/
+#define IV_ROOT           (((u64)1)<<63)
+#define IV_NODE(V)        (((u64)(V)^IV_ROOT) ? ((u64)(V)^IV_ROOT) : 1)
+#define IV_STORE(N)       ((i64)((N)^IV_ROOT))
+
+/*
+** Columns of the virtual table
+*/
+#define IV_COL_RID        0
+#define IV_COL_CHANNEL    1
+#define IV_COL_LOWER      2
+#define IV_COL_UPPER      3
+#define IV_COL_COMMAND    4
+
+struct IvTable {
+  sqlite3_vtab base;              /* Base class.  Must be first */
+  sqlite3 *db;                    /* The database connection */
+  char *zDb;                      /* Schema holding the index */
+  char *zName;                    /* Name of the virtual table */
+  char *zTab;                     /* Name of the indexed table */
+  char *zChannel;                 /* Channel column, or NULL */
+  char *zLower;                   /* Start time column */
+  char *zUpper;                   /* Stop time column */
+  sqlite3_stmt *pInsert;          /* Insert into node table */
+  sqlite3_stmt *pDelete;          /* Delete from node table */
+  sqlite3_stmt *pMask;            /* Read level mask of a channel */
+  sqlite3_stmt *pSetMask;         /* Write level mask of a channel */
+  sqlite3_stmt *pExists;          /* Test if a row of zTab exists */
+  sqlite3_value **apReplace;      /* Rows named by 'replace', 4 values each */
+  int nReplace;                   /* Number of rows in apReplace[] */
+  int nReplaceAlloc;              /* Allocated rows in apReplace[] */
+};
+
+/*
+** The searches done for each channel are held in aSearch[].  Each is the
+** node number to search, or zero for the final search of the range of
+** nodes between ql and qu.  Searches for nodes less than ql are in
+** aSearch[0..nLeft-1].
+*/
+struct IvCursor {
+  sqlite3_vtab_cursor base;       /* Base class.  Must be first */
+  sqlite3_stmt *pChannel;         /* Yields channels to search, and masks */
+  sqlite3_stmt *apSearch[3];      /* Searches left, right and between */
+  sqlite3_stmt *pStmt;            /* Current search, or NULL */
+  i64 iLo, iHi;                   /* Bounds on lower */
+  i64 iLoU, iHiU;                 /* Bounds on upper */
+  u64 ql, qu;                     /* Query interval as nodes */
+  u64 aSearch[129];               /* Nodes to search in current channel */
+  int nLeft;                      /* Number of searches left of ql */
+  int nSearch;                    /* Number of entries in aSearch[] */
+  int iSearch;                    /* Next entry of aSearch[] */
+  int bEof;                       /* True at EOF */
+};
+
+/*
+** Return the fork node of the interval [l,u], which must be a
+** non-empty interval of nodes.
+*/
+static u64 ivFork(u64 l, u64 u){
+  u64 n = IV_ROOT;
+  int iLevel = 63;
+  assert( l>0 && l<=u );
+  while( iLevel>0 ){
+    if( u<n ){
+      n -= ((u64)1)<<(iLevel-1);
+    }else if( n<l ){
+      n += ((u64)1)<<(iLevel-1);
+    }else{
+      break;
+    }
+    iLevel--;
+  }
+  return n;
+}
+
+/*
+** Return the level of node n.  Leaves are at level 0 and the root is at
+** level 63.
+*/
+static int ivLevel(u64 n){
+  int iLevel = 0;
+  assert( n>0 );
+  while( (n & 1)==0 ){
+    n = n>>1;
+    iLevel++;
+  }
+  return iLevel;
+}
+
+/*
+** Run the SQL statement zSql, which is obtained from sqlite3_mprintf(),
+** and free it.
+*/
+static int ivExec(sqlite3 *db, char *zSql){
+  int rc;
+  if( zSql==0 ) return SQLITE_NOMEM_BKPT;
+  rc = sqlite3_exec(db, zSql, 0, 0, 0);
+  sqlite3_free(zSql);
+  return rc;
+}
+
+/*
+** Prepare the SQL statement zSql, which is obtained from sqlite3_mprintf(),
+** into *ppStmt if it is not already prepared, and free zSql.
+*/
+static int ivPrepare(sqlite3 *db, sqlite3_stmt **ppStmt, char *zSql){
+  int rc = SQLITE_OK;
+  if( zSql==0 ) return SQLITE_NOMEM_BKPT;
+  if( *ppStmt==0 ){
+    rc = sqlite3_prepare_v3(db, zSql, -1, SQLITE_PREPARE_PERSISTENT, ppStmt, 0);
+  }
+  sqlite3_free(zSql);
+  return rc;
+}
+
+static void ivFinalizeAll(IvTable *pTab){
+  sqlite3_finalize(pTab->pInsert);
+  sqlite3_finalize(pTab->pDelete);
+  sqlite3_finalize(pTab->pMask);
+  sqlite3_finalize(pTab->pSetMask);
+  sqlite3_finalize(pTab->pExists);
+  pTab->pInsert = 0;
+  pTab->pDelete = 0;
+  pTab->pMask = 0;
+  pTab->pSetMask = 0;
+  pTab->pExists = 0;
+}
+
+/*
+** Forget the rows named by 'replace' commands.
+*/
+static void ivClearReplace(IvTable *pTab){
+  int i;
+  for(i=0; i<pTab->nReplace*4; i++){
+    sqlite3_value_free(pTab->apReplace[i]);
+  }
+  pTab->nReplace = 0;
+}
+
+static void ivFree(IvTable *pTab){
+  ivFinalizeAll(pTab);
+  ivClearReplace(pTab);
+  sqlite3_free(pTab->apReplace);
+  sqlite3_free(pTab->zDb);
+  sqlite3_free(pTab->zName);
+  sqlite3_free(pTab->zTab);
+  sqlite3_free(pTab->zChannel);
+  sqlite3_free(pTab->zLower);
+  sqlite3_free(pTab->zUpper);
+  sqlite3_free(pTab);
+}
+
+/*
+** Return the expression used to read the channel of a row of the indexed
+** table, prefixed by zPrefix.  Without a channel column every row is on
+** channel 0.
+*/
+static char *ivChannelExpr(IvTable *pTab, const char *zPrefix){
+  if( pTab->zChannel==0 ) return sqlite3_mprintf("0");
+  return sqlite3_mprintf("%s\"%w\"", zPrefix, pTab->zChannel);
+}
+
+/*
+** Add the interval [iLower,iUpper] of row iRowid on channel pChannel to
+** the index (if bInsert is true) or remove it.  Rows that do not have a
+** valid interval are ignored.
+*/
+static int ivWrite(
+  IvTable *pTab,
+  int bInsert,
+  sqlite3_value *pRowid,
+  sqlite3_value *pChannel,
+  sqlite3_value *pLower,
+  sqlite3_value *pUpper
+){
+  sqlite3_stmt *pStmt;
+  i64 iLower, iUpper;
+  u64 n;
+  int rc;
+
+  if( sqlite3_value_type(pRowid)!=SQLITE_INTEGER
+   || sqlite3_value_type(pChannel)==SQLITE_NULL
+   || sqlite3_value_type(pLower)!=SQLITE_INTEGER
+   || sqlite3_value_type(pUpper)!=SQLITE_INTEGER
+  ){
+    return SQLITE_OK;
+  }
+  iLower = sqlite3_value_int64(pLower);
+  iUpper = sqlite3_value_int64(pUpper);
+  if( iLower>iUpper ) return SQLITE_OK;
+  n = ivFork(IV_NODE(iLower), IV_NODE(iUpper));
+
+  if( bInsert ){
+    rc = ivPrepare(pTab->db, &pTab->pInsert, sqlite3_mprintf(
+        "INSERT OR REPLACE INTO \"%w\".\"%w_node\"(channel, node, lower, id,"
+        " upper) VALUES(?1, ?2, ?3, ?4, ?5)", pTab->zDb, pTab->zName
+    ));
+    pStmt = pTab->pInsert;
+  }else{
+    rc = ivPrepare(pTab->db, &pTab->pDelete, sqlite3_mprintf(
+        "DELETE FROM \"%w\".\"%w_node\""
+        " WHERE channel=?1 AND node=?2 AND lower=?3 AND id=?4",
+        pTab->zDb, pTab->zName
+    ));
+    pStmt = pTab->pDelete;
+  }
+  if( rc!=SQLITE_OK ) return rc;
+  sqlite3_bind_value(pStmt, 1, pChannel);
+  sqlite3_bind_int64(pStmt, 2, IV_STORE(n));
+  sqlite3_bind_int64(pStmt, 3, iLower);
+  sqlite3_bind_value(pStmt, 4, pRowid);
+  if( bInsert ) sqlite3_bind_int64(pStmt, 5, iUpper);
+  sqlite3_step(pStmt);
+  rc = sqlite3_reset(pStmt);
+
+  /* Record the level of the fork node in the channel's level mask.  Bits
+  ** are never cleared by deletes, which only makes searches a little
+  ** slower until the next rebuild. */
+  if( rc==SQLITE_OK && bInsert ){
+    i64 mask = 0;
+    i64 bit = (i64)(((u64)1)<<ivLevel(n));
+    rc = ivPrepare(pTab->db, &pTab->pMask, sqlite3_mprintf(
+        "SELECT mask FROM \"%w\".\"%w_level\" WHERE channel=?1",
+        pTab->zDb, pTab->zName
+    ));
+    if( rc!=SQLITE_OK ) return rc;
+    sqlite3_bind_value(pTab->pMask, 1, pChannel);
+    if( sqlite3_step(pTab->pMask)==SQLITE_ROW ){
+      mask = sqlite3_column_int64(pTab->pMask, 0);
+    }
+    rc = sqlite3_reset(pTab->pMask);
+    if( rc==SQLITE_OK && (mask & bit)==0 ){
+      rc = ivPrepare(pTab->db, &pTab->pSetMask, sqlite3_mprintf(
+          "INSERT OR REPLACE INTO \"%w\".\"%w_level\"(channel, mask)"
+          " VALUES(?1, ?2)", pTab->zDb, pTab->zName
+      ));
+      if( rc!=SQLITE_OK ) return rc;
+      sqlite3_bind_value(pTab->pSetMask, 1, pChannel);
+      sqlite3_bind_int64(pTab->pSetMask, 2, mask | bit);
+      sqlite3_step(pTab->pSetMask);
+      rc = sqlite3_reset(pTab->pSetMask);
+    }
+  }
+  return rc;
+}
+
+/*
+** Called when the row with rowid pRowid has been written.  Remove from
+** the index each row named by a 'replace' command that has the same
+** rowid or no longer exists in the indexed table, and forget them all.
+*/
+static int ivFlushReplace(IvTable *pTab, sqlite3_value *pRowid){
+  int rc = SQLITE_OK;
+  int i;
+  for(i=0; rc==SQLITE_OK && i<pTab->nReplace; i++){
+    sqlite3_value **ap = &pTab->apReplace[i*4];
+    if( sqlite3_value_type(pRowid)!=SQLITE_INTEGER
+     || sqlite3_value_int64(ap[IV_COL_RID])!=sqlite3_value_int64(pRowid)
+    ){
+      int bExists;
+      rc = ivPrepare(pTab->db, &pTab->pExists, sqlite3_mprintf(
+          "SELECT 1 FROM \"%w\".\"%w\" WHERE rowid=?1",
+          pTab->zDb, pTab->zTab
+      ));
+      if( rc!=SQLITE_OK ) break;
+      sqlite3_bind_value(pTab->pExists, 1, ap[IV_COL_RID]);
+      bExists = sqlite3_step(pTab->pExists)==SQLITE_ROW;
+      rc = sqlite3_reset(pTab->pExists);
+      if( rc!=SQLITE_OK || bExists ) continue;
+    }
+    rc = ivWrite(pTab, 0, ap[IV_COL_RID], ap[IV_COL_CHANNEL],
+        ap[IV_COL_LOWER], ap[IV_COL_UPPER]
+    );
+  }
+  ivClearReplace(pTab);
+  return rc;
+}
+
+/*
+** Recreate the contents of the index from the indexed table.
+*/
+static int ivRebuild(IvTable *pTab){
+  sqlite3_stmt *pStmt = 0;
+  char *zChannel;
+  int rc;
+
+  rc = ivExec(pTab->db, sqlite3_mprintf(
+      "DELETE FROM \"%w\".\"%w_node\"; DELETE FROM \"%w\".\"%w_level\";",
+      pTab->zDb, pTab->zName, pTab->zDb, pTab->zName
+  ));
+  if( rc!=SQLITE_OK ) return rc;
+  zChannel = ivChannelExpr(pTab, "");
+  if( zChannel==0 ) return SQLITE_NOMEM_BKPT;
+  rc = ivPrepare(pTab->db, &pStmt, sqlite3_mprintf(
+      "SELECT rowid, %s, \"%w\", \"%w\" FROM \"%w\".\"%w\"",
+      zChannel, pTab->zLower, pTab->zUpper, pTab->zDb, pTab->zTab
+  ));
+  sqlite3_free(zChannel);
+  while( rc==SQLITE_OK && sqlite3_step(pStmt)==SQLITE_ROW ){
+    rc = ivWrite(pTab, 1, sqlite3_column_value(pStmt, 0),
+        sqlite3_column_value(pStmt, 1), sqlite3_column_value(pStmt, 2),
+        sqlite3_column_value(pStmt, 3)
+    );
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3_finalize(pStmt);
+  }else{
+    sqlite3_finalize(pStmt);
+  }
+  return rc;
+}
+
+/*
+** Set *pzWhere to an expression that is true for the existing rows of
+** the indexed table that have the same values as the "new" row in the
+** columns of one of its UNIQUE indexes, and *pzChanged to a list of
+** " OR old.x IS NOT new.x" terms for the columns of those indexes.  Both
+** are obtained from sqlite3_malloc() and are empty strings if there are
+** no UNIQUE indexes.  A UNIQUE index on an expression is an error.
+*/
+static int ivUniqueTerms(
+  IvTable *pTab,
+  char **pzWhere,
+  char **pzChanged,
+  char **pzErr
+){
+  sqlite3_stmt *pStmt = 0;
+  char *zWhere = sqlite3_mprintf("");
+  char *zChanged = sqlite3_mprintf("");
+  char *zIdx = 0;
+  int rc = SQLITE_OK;
+  int rc2;
+
+  if( zWhere==0 || zChanged==0 ) rc = SQLITE_NOMEM_BKPT;
+  if( rc==SQLITE_OK ) rc = ivPrepare(pTab->db, &pStmt, sqlite3_mprintf(
+      "SELECT il.name, ii.name, ii.coll"
+      "  FROM pragma_index_list(%Q, %Q) AS il,"
+      "       pragma_index_xinfo(il.name, %Q) AS ii"
+      " WHERE il.\"unique\" AND ii.key ORDER BY il.seq, ii.seqno",
+      pTab->zTab, pTab->zDb, pTab->zDb
+  ));
+  while( rc==SQLITE_OK && sqlite3_step(pStmt)==SQLITE_ROW ){
+    const char *zName = (const char*)sqlite3_column_text(pStmt, 0);
+    const char *zCol = (const char*)sqlite3_column_text(pStmt, 1);
+    const char *zColl = (const char*)sqlite3_column_text(pStmt, 2);
+    const char *zSep = " AND ";
+    if( zCol==0 ){
+      *pzErr = sqlite3_mprintf(
+          "interval: UNIQUE index %s is on an expression", zName
+      );
+      rc = SQLITE_ERROR;
+      break;
+    }
+    if( zIdx==0 || sqlite3_stricmp(zIdx, zName)!=0 ){
+      zSep = zWhere[0] ? ") OR (" : " OR (";
+      sqlite3_free(zIdx);
+      zIdx = sqlite3_mprintf("%s", zName);
+    }
+    zWhere = sqlite3_mprintf("%z%s\"%w\"=new.\"%w\" COLLATE \"%w\"",
+        zWhere, zSep, zCol, zCol, zColl ? zColl : "BINARY"
+    );
+    zChanged = sqlite3_mprintf("%z OR old.\"%w\" IS NOT new.\"%w\"",
+        zChanged, zCol, zCol
+    );
+    if( zIdx==0 || zWhere==0 || zChanged==0 ) rc = SQLITE_NOMEM_BKPT;
+  }
+  rc2 = sqlite3_finalize(pStmt);
+  if( rc==SQLITE_OK ) rc = rc2;
+  if( rc==SQLITE_OK && zWhere[0] ){
+    zWhere = sqlite3_mprintf("%z)", zWhere);
+    if( zWhere==0 ) rc = SQLITE_NOMEM_BKPT;
+  }
+  sqlite3_free(zIdx);
+  if( rc!=SQLITE_OK ){
+    sqlite3_free(zWhere);
+    sqlite3_free(zChanged);
+    zWhere = zChanged = 0;
+  }
+  *pzWhere = zWhere;
+  *pzChanged = zChanged;
+  return rc;
+}
+
+/*
+** Create the triggers that maintain the index.  The _bi and _bu triggers
+** name the rows that REPLACE conflict handling may delete as described
+** above bmCreateTriggers() in bitmap.c.
+*/
+static int ivCreateTriggers(IvTable *pTab, char **pzErr){
+  char *zNew = ivChannelExpr(pTab, "new.");
+  char *zOld = ivChannelExpr(pTab, "old.");
+  char *zCur = ivChannelExpr(pTab, "");
+  char *zUnique = 0;
+  char *zUniqueChanged = 0;
+  int rc;
+  rc = ivUniqueTerms(pTab, &zUnique, &zUniqueChanged, pzErr);
+  if( rc==SQLITE_OK && (zNew==0 || zOld==0 || zCur==0) ){
+    rc = SQLITE_NOMEM_BKPT;
+  }
+  if( rc==SQLITE_OK ){
+    rc = ivExec(pTab->db, sqlite3_mprintf(
+        "CREATE TRIGGER \"%w\".\"%w_bi\" BEFORE INSERT ON \"%w\" BEGIN"
+        "  INSERT INTO \"%w\"(\"%w\") VALUES('replace');"
+        "  INSERT INTO \"%w\"(\"%w\", rid, channel, lower, upper)"
+        "    SELECT 'replace', rowid, %s, \"%w\", \"%w\" FROM \"%w\""
+        "    WHERE rowid=new.rowid%s;"
+        "END;"
+        "CREATE TRIGGER \"%w\".\"%w_bu\" BEFORE UPDATE ON \"%w\""
+        "  WHEN old.rowid IS NOT new.rowid%s BEGIN"
+        "  INSERT INTO \"%w\"(\"%w\") VALUES('replace');"
+        "  INSERT INTO \"%w\"(\"%w\", rid, channel, lower, upper)"
+        "    SELECT 'replace', rowid, %s, \"%w\", \"%w\" FROM \"%w\""
+        "    WHERE (rowid=new.rowid%s) AND rowid<>old.rowid;"
+        "END;"
+        "CREATE TRIGGER \"%w\".\"%w_ai\" AFTER INSERT ON \"%w\" BEGIN"
+        "  INSERT INTO \"%w\"(\"%w\", rid, channel, lower, upper)"
+        "    VALUES('insert', new.rowid, %s, new.\"%w\", new.\"%w\");"
+        "END;"
+        "CREATE TRIGGER \"%w\".\"%w_ad\" AFTER DELETE ON \"%w\" BEGIN"
+        "  INSERT INTO \"%w\"(\"%w\", rid, channel, lower, upper)"
+        "    VALUES('delete', old.rowid, %s, old.\"%w\", old.\"%w\");"
+        "END;"
+        "CREATE TRIGGER \"%w\".\"%w_au\" AFTER UPDATE ON \"%w\""
+        "  WHEN old.rowid IS NOT new.rowid OR %s IS NOT %s"
+        "    OR old.\"%w\" IS NOT new.\"%w\" OR old.\"%w\" IS NOT new.\"%w\"%s"
+        "  BEGIN"
+        "  INSERT INTO \"%w\"(\"%w\", rid, channel, lower, upper)"
+        "    VALUES('delete', old.rowid, %s, old.\"%w\", old.\"%w\");"
+        "  INSERT INTO \"%w\"(\"%w\", rid, channel, lower, upper)"
+        "    VALUES('insert', new.rowid, %s, new.\"%w\", new.\"%w\");"
+        "END;",
+        pTab->zDb, pTab->zName, pTab->zTab, pTab->zName, pTab->zName,
+        pTab->zName, pTab->zName,
+        zCur, pTab->zLower, pTab->zUpper, pTab->zTab, zUnique,
+        pTab->zDb, pTab->zName, pTab->zTab, zUniqueChanged,
+        pTab->zName, pTab->zName, pTab->zName, pTab->zName,
+        zCur, pTab->zLower, pTab->zUpper, pTab->zTab, zUnique,
+        pTab->zDb, pTab->zName, pTab->zTab,
+        pTab->zName, pTab->zName, zNew, pTab->zLower, pTab->zUpper,
+        pTab->zDb, pTab->zName, pTab->zTab,
+        pTab->zName, pTab->zName, zOld, pTab->zLower, pTab->zUpper,
+        pTab->zDb, pTab->zName, pTab->zTab, zOld, zNew,
+        pTab->zLower, pTab->zLower, pTab->zUpper, pTab->zUpper, zUniqueChanged,
+        pTab->zName, pTab->zName, zOld, pTab->zLower, pTab->zUpper,
+        pTab->zName, pTab->zName, zNew, pTab->zLower, pTab->zUpper
+    ));
+  }
+  sqlite3_free(zNew);
+  sqlite3_free(zOld);
+  sqlite3_free(zCur);
+  sqlite3_free(zUnique);
+  sqlite3_free(zUniqueChanged);
+  return rc;
+}
+
+/*
+** Drop the triggers that maintain the index.
+*/
+static int ivDropTriggers(IvTable *pTab){
+  return ivExec(pTab->db, sqlite3_mprintf(
+      "DROP TRIGGER IF EXISTS \"%w\".\"%w_bi\";"
+      "DROP TRIGGER IF EXISTS \"%w\".\"%w_bu\";"
+      "DROP TRIGGER IF EXISTS \"%w\".\"%w_ai\";"
+      "DROP TRIGGER IF EXISTS \"%w\".\"%w_ad\";"
+      "DROP TRIGGER IF EXISTS \"%w\".\"%w_au\";",
+      pTab->zDb, pTab->zName, pTab->zDb, pTab->zName,
+      pTab->zDb, pTab->zName, pTab->zDb, pTab->zName, pTab->zDb, pTab->zName
+  ));
+}
+
+/*
+** Return a dequoted copy of zIn obtained from sqlite3_malloc(), or NULL
+** if zIn is NULL or out of memory.
+*/
+static char *ivDequoted(const char *zIn){
+  char *zOut = zIn ? sqlite3_mprintf("%s", zIn) : 0;
+  if( zOut ) sqlite3Dequote(zOut);
+  return zOut;
+}
+
+/*
+** Connect to or create an interval virtual table.
+*/
+static int ivInit(
+  sqlite3 *db,
+  int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab,
+  char **pzErr,
+  int isCreate
+){
+  IvTable *pTab;
+  int rc = SQLITE_OK;
+
+  if( argc!=6 && argc!=7 ){
+    *pzErr = sqlite3_mprintf(
+        "interval: expected table, [channel,] start and stop column names"
+    );
+    return SQLITE_ERROR;
+  }
+  pTab = (IvTable*)sqlite3_malloc64(sizeof(IvTable));
+  if( pTab==0 ) return SQLITE_NOMEM_BKPT;
+  memset(pTab, 0, sizeof(IvTable));
+  pTab->db = db;
+  pTab->zDb = ivDequoted(argv[1]);
+  pTab->zName = ivDequoted(argv[2]);
+  pTab->zTab = ivDequoted(argv[3]);
+  pTab->zChannel = ivDequoted(argc==7 ? argv[4] : 0);
+  pTab->zLower = ivDequoted(argv[argc-2]);
+  pTab->zUpper = ivDequoted(argv[argc-1]);
+  if( pTab->zDb==0 || pTab->zName==0 || pTab->zTab==0
+   || (argc==7 && pTab->zChannel==0) || pTab->zLower==0 || pTab->zUpper==0
+  ){
+    rc = SQLITE_NOMEM_BKPT;
+  }
+
+  /* Check that the indexed table and columns exist */
+  if( rc==SQLITE_OK ){
+    sqlite3_stmt *pStmt = 0;
+    char *zChannel = ivChannelExpr(pTab, "");
+    rc = ivPrepare(db, &pStmt, sqlite3_mprintf(
+        "SELECT %s, \"%w\", \"%w\" FROM \"%w\".\"%w\"",
+        zChannel, pTab->zLower, pTab->zUpper, pTab->zDb, pTab->zTab
+    ));
+    sqlite3_free(zChannel);
+    if( rc==SQLITE_ERROR ){
+      *pzErr = sqlite3_mprintf("interval: %s", sqlite3_errmsg(db));
+    }
+    sqlite3_finalize(pStmt);
+  }
+
+  if( rc==SQLITE_OK ){
+    char *zSql = sqlite3_mprintf(
+        "CREATE TABLE x(rid, channel HIDDEN, lower HIDDEN, upper HIDDEN,"
+        " \"%w\" HIDDEN)", pTab->zName
+    );
+    if( zSql==0 ){
+      rc = SQLITE_NOMEM_BKPT;
+    }else{
+      rc = sqlite3_declare_vtab(db, zSql);
+      sqlite3_free(zSql);
+    }
+  }
+
+  if( rc==SQLITE_OK && isCreate ){
+    rc = ivExec(db, sqlite3_mprintf(
+        "CREATE TABLE \"%w\".\"%w_node\"("
+        "channel, node INTEGER, lower INTEGER, id INTEGER, upper INTEGER,"
+        "PRIMARY KEY(channel, node, lower, id)) WITHOUT ROWID;"
+        "CREATE INDEX \"%w\".\"%w_upper\" ON \"%w_node\"(channel, node, upper);"
+        "CREATE TABLE \"%w\".\"%w_level\"(channel PRIMARY KEY, mask INTEGER)"
+        " WITHOUT ROWID;",
+        pTab->zDb, pTab->zName, pTab->zDb, pTab->zName, pTab->zName,
+        pTab->zDb, pTab->zName
+    ));
+    if( rc==SQLITE_OK ) rc = ivRebuild(pTab);
+    if( rc==SQLITE_OK ) rc = ivCreateTriggers(pTab, pzErr);
+    if( rc!=SQLITE_OK && *pzErr==0 ){
+      *pzErr = sqlite3_mprintf("interval: %s", sqlite3_errmsg(db));
+    }
+  }
+
+  if( rc!=SQLITE_OK ){
+    ivFree(pTab);
+    pTab = 0;
+  }
+  *ppVtab = (sqlite3_vtab*)pTab;
+  return rc;
+}
+
+static int ivCreate(
+  sqlite3 *db,
+  void *pAux,
+  int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab,
+  char **pzErr
+){
+  return ivInit(db, argc, argv, ppVtab, pzErr, 1);
+}
+
+static int ivConnect(
+  sqlite3 *db,
+  void *pAux,
+  int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab,
+  char **pzErr
+){
+  return ivInit(db, argc, argv, ppVtab, pzErr, 0);
+}
+
+static int ivDisconnect(sqlite3_vtab *pVtab){
+  ivFree((IvTable*)pVtab);
+  return SQLITE_OK;
+}
+
+static int ivDestroy(sqlite3_vtab *pVtab){
+  IvTable *pTab = (IvTable*)pVtab;
+  int rc;
+  ivFinalizeAll(pTab);
+  rc = ivDropTriggers(pTab);
+  if( rc==SQLITE_OK ){
+    rc = ivExec(pTab->db, sqlite3_mprintf(
+        "DROP TABLE \"%w\".\"%w_node\"; DROP TABLE \"%w\".\"%w_level\";",
+        pTab->zDb, pTab->zName, pTab->zDb, pTab->zName
+    ));
+  }
+  if( rc==SQLITE_OK ) ivFree(pTab);
+  return rc;
+}
+
+/*
+** Equality on the channel and any comparison on the lower or upper
+** column is handled by xFilter.  idxStr holds one "<op><column>," entry
+** for each of them.  The search is cheapest when both the lower and
+** upper ends of the query interval are bounded.
+*/
+static int ivBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *pIdxInfo){
+  char *zPlan = 0;
+  double rCost = 1000000.0;
+  int nArg = 0;
+  int bChannel = 0, bLower = 0, bUpper = 0;
+  int i;
+
+  for(i=0; i<pIdxInfo->nConstraint; i++){
+    struct sqlite3_index_constraint *p = &pIdxInfo->aConstraint[i];
+    char cOp;
+    if( p->usable==0 ) continue;
+    switch( p->op ){
+      case SQLITE_INDEX_CONSTRAINT_EQ: cOp = '=';  break;
+      case SQLITE_INDEX_CONSTRAINT_GT: cOp = '>';  break;
+      case SQLITE_INDEX_CONSTRAINT_LE: cOp = 'l';  break;
+      case SQLITE_INDEX_CONSTRAINT_LT: cOp = '<';  break;
+      case SQLITE_INDEX_CONSTRAINT_GE: cOp = 'g';  break;
+      default:                         continue;
+    }
+    if( p->iColumn==IV_COL_CHANNEL ){
+      if( cOp!='=' || bChannel ) continue;
+      bChannel = 1;
+      rCost /= 10.0;
+    }else if( p->iColumn==IV_COL_LOWER ){
+      if( cOp!='>' && cOp!='g' && !bLower ){ bLower = 1; rCost /= 30.0; }
+    }else if( p->iColumn==IV_COL_UPPER ){
+      if( cOp!='<' && cOp!='l' && !bUpper ){ bUpper = 1; rCost /= 30.0; }
+    }else{
+      continue;
+    }
+    zPlan = sqlite3_mprintf("%z%c%d,", zPlan, cOp, p->iColumn);
+    if( zPlan==0 ) return SQLITE_NOMEM_BKPT;
+    pIdxInfo->aConstraintUsage[i].argvIndex = ++nArg;
+    pIdxInfo->aConstraintUsage[i].omit = 1;
+  }
+  pIdxInfo->idxNum = nArg;
+  pIdxInfo->idxStr = zPlan;
+  pIdxInfo->needToFreeIdxStr = 1;
+  pIdxInfo->estimatedCost = rCost;
+  pIdxInfo->estimatedRows = (sqlite3_int64)(rCost/10.0) + 1;
+  return SQLITE_OK;
+}
+
+static int ivOpen(sqlite3_vtab *pVTab, sqlite3_vtab_cursor **ppCursor){
+  IvCursor *pCsr;
+  pCsr = (IvCursor*)sqlite3_malloc64(sizeof(IvCursor));
+  if( pCsr==0 ) return SQLITE_NOMEM_BKPT;
+  memset(pCsr, 0, sizeof(IvCursor));
+  pCsr->base.pVtab = pVTab;
+  pCsr->bEof = 1;
+  *ppCursor = (sqlite3_vtab_cursor*)pCsr;
+  return SQLITE_OK;
+}
+
+static int ivClose(sqlite3_vtab_cursor *pCursor){
+  IvCursor *pCsr = (IvCursor*)pCursor;
+  int i;
+  sqlite3_finalize(pCsr->pChannel);
+  for(i=0; i<ArraySize(pCsr->apSearch); i++){
+    sqlite3_finalize(pCsr->apSearch[i]);
+  }
+  sqlite3_free(pCsr);
+  return SQLITE_OK;
+}
+
+/*
+** Narrow the range [*piLo,*piHi] of integer values so that only values
+** that satisfy "x <op> pVal" remain.
+*/
+static void ivNarrow(char cOp, sqlite3_value *pVal, i64 *piLo, i64 *piHi){
+  int eType = sqlite3_value_type(pVal);
+  int bEmpty = 0;
+  i64 iLo = SMALLEST_INT64;
+  i64 iHi = LARGEST_INT64;
+  if( eType==SQLITE_INTEGER ){
+    i64 iVal = sqlite3_value_int64(pVal);
+    switch( cOp ){
+      case '=': iLo = iHi = iVal;                         break;
+      case '>': bEmpty = (iVal==LARGEST_INT64); iLo = iVal+!bEmpty;  break;
+      case 'g': iLo = iVal;                               break;
+      case '<': bEmpty = (iVal==SMALLEST_INT64); iHi = iVal-!bEmpty; break;
+      default:  iHi = iVal;                               break;
+    }
+  }else if( eType==SQLITE_FLOAT ){
+    double r = sqlite3_value_double(pVal);
+    if( r>=9223372036854775808.0 ){
+      bEmpty = (cOp=='=' || cOp=='>' || cOp=='g');
+    }else if( r<-9223372036854775808.0 ){
+      bEmpty = (cOp=='=' || cOp=='<' || cOp=='l');
+    }else{
+      i64 iFloor = (i64)r;
+      int bExact;
+      if( r<(double)iFloor ) iFloor--;
+      bExact = (r==(double)iFloor);
+      switch( cOp ){
+        case '=': bEmpty = !bExact; iLo = iHi = iFloor;   break;
+        case '>': iLo = iFloor+1;                         break;
+        case 'g': iLo = iFloor+!bExact;                   break;
+        case '<': bEmpty = (bExact && iFloor==SMALLEST_INT64);
+                  iHi = iFloor-(bExact && !bEmpty);
+                  break;
+        default:  iHi = iFloor;                           break;
+      }
+    }
+  }else{
+    bEmpty = (eType==SQLITE_NULL || cOp=='=' || cOp=='>' || cOp=='g');
+  }
+  if( bEmpty ){
+    iLo = 1;
+    iHi = 0;
+  }
+  if( iLo>*piLo ) *piLo = iLo;
+  if( iHi<*piHi ) *piHi = iHi;
+}
+
+/*
+** Fill aSearch[] with the searches needed for a channel whose level mask
+** is mask.
+*/
+static void ivPlanChannel(IvCursor *pCsr, i64 mask){
+  int bLeft;
+  pCsr->nSearch = 0;
+  for(bLeft=1; bLeft>=0; bLeft--){
+    u64 t = bLeft ? pCsr->ql : pCsr->qu;
+    u64 n = IV_ROOT;
+    int iLevel = 63;
+    while( n!=t ){
+      if( (bLeft ? n<t : n>t) && (mask & (i64)(((u64)1)<<iLevel)) ){
+        pCsr->aSearch[pCsr->nSearch++] = n;
+      }
+      if( iLevel==0 ) break;
+      iLevel--;
+      if( n<t ){
+        n += ((u64)1)<<iLevel;
+      }else{
+        n -= ((u64)1)<<iLevel;
+      }
+    }
+    if( bLeft ) pCsr->nLeft = pCsr->nSearch;
+  }
+  pCsr->aSearch[pCsr->nSearch++] = 0;
+  pCsr->iSearch = 0;
+}
+
+/*
+** Advance the cursor to the next matching interval.
+*/
+static int ivNext(sqlite3_vtab_cursor *pCursor){
+  IvCursor *pCsr = (IvCursor*)pCursor;
+  sqlite3_stmt *pChannel = pCsr->pChannel;
+  int rc = SQLITE_OK;
+
+  while( 1 ){
+    /* Return the next row of the current search that matches */
+    if( pCsr->pStmt ){
+      if( sqlite3_step(pCsr->pStmt)==SQLITE_ROW ){
+        i64 iLower = sqlite3_column_int64(pCsr->pStmt, 2);
+        i64 iUpper = sqlite3_column_int64(pCsr->pStmt, 3);
+        if( iLower>=pCsr->iLo && iLower<=pCsr->iHi
+         && iUpper>=pCsr->iLoU && iUpper<=pCsr->iHiU
+        ){
+          return SQLITE_OK;
+        }
+        continue;
+      }
+      rc = sqlite3_reset(pCsr->pStmt);
+      pCsr->pStmt = 0;
+      if( rc!=SQLITE_OK ) break;
+    }
+
+    /* Start the next search of the current channel */
+    if( pCsr->iSearch<pCsr->nSearch ){
+      int i = pCsr->iSearch++;
+      u64 n = pCsr->aSearch[i];
+      sqlite3_stmt *pStmt;
+      if( n==0 ){
+        pStmt = pCsr->apSearch[2];
+        sqlite3_bind_int64(pStmt, 2, IV_STORE(pCsr->ql));
+        sqlite3_bind_int64(pStmt, 3, IV_STORE(pCsr->qu));
+      }else{
+        pStmt = pCsr->apSearch[i<pCsr->nLeft ? 0 : 1];
+        sqlite3_bind_int64(pStmt, 2, IV_STORE(n));
+        sqlite3_bind_int64(pStmt, 3, i<pCsr->nLeft ? pCsr->iLoU : pCsr->iHi);
+      }
+      sqlite3_bind_value(pStmt, 1, sqlite3_column_value(pChannel, 0));
+      pCsr->pStmt = pStmt;
+      continue;
+    }
+
+    /* Move on to the next channel */
+    if( sqlite3_step(pChannel)!=SQLITE_ROW ){
+      pCsr->bEof = 1;
+      rc = sqlite3_reset(pChannel);
+      break;
+    }
+    ivPlanChannel(pCsr, sqlite3_column_int64(pChannel, 1));
+  }
+  return rc;
+}
+
+/*
+** Begin a search.  The query interval [ql,qu] is taken from the bounds
+** on the lower end of the matching intervals (which must be at most qu)
+** and on the upper end (which must be at least ql).
+*/
+static int ivFilter(
+  sqlite3_vtab_cursor *pCursor,
+  int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv
+){
+  IvCursor *pCsr = (IvCursor*)pCursor;
+  IvTable *pTab = (IvTable*)pCursor->pVtab;
+  sqlite3_value *pChannel = 0;
+  sqlite3 *db = pTab->db;
+  u64 ql, qu;
+  int rc = SQLITE_OK;
+  int i;
+
+  if( pCsr->pStmt ){
+    sqlite3_reset(pCsr->pStmt);
+    pCsr->pStmt = 0;
+  }
+  if( pCsr->pChannel ){
+    sqlite3_finalize(pCsr->pChannel);
+    pCsr->pChannel = 0;
+  }
+  pCsr->iLo = pCsr->iLoU = SMALLEST_INT64;
+  pCsr->iHi = pCsr->iHiU = LARGEST_INT64;
+  pCsr->nSearch = pCsr->iSearch = 0;
+  pCsr->bEof = 1;
+
+  for(i=0; i<argc; i++){
+    char cOp = *(idxStr++);
+    int iCol = sqlite3Atoi(idxStr);
+    while( *(idxStr++)!=',' ){}
+    if( iCol==IV_COL_CHANNEL ){
+      pChannel = argv[i];
+      if( sqlite3_value_type(pChannel)==SQLITE_NULL ) return SQLITE_OK;
+    }else if( iCol==IV_COL_LOWER ){
+      ivNarrow(cOp, argv[i], &pCsr->iLo, &pCsr->iHi);
+    }else{
+      ivNarrow(cOp, argv[i], &pCsr->iLoU, &pCsr->iHiU);
+    }
+  }
+  assert( idxNum==argc );
+  if( pCsr->iLo>pCsr->iHi || pCsr->iLoU>pCsr->iHiU ) return SQLITE_OK;
+
+  /* An interval that ends at or after iLoU and begins at or before iHi
+  ** overlaps [iLoU,iHi].  If iLoU is greater than iHi, it also contains
+  ** [iHi,iLoU], so overlaps that.  */
+  ql = IV_NODE(pCsr->iLoU);
+  qu = IV_NODE(pCsr->iHi);
+  pCsr->ql = ql<qu ? ql : qu;
+  pCsr->qu = ql<qu ? qu : ql;
+
+  rc = ivPrepare(db, &pCsr->apSearch[0], sqlite3_mprintf(
+      "SELECT channel, id, lower, upper FROM \"%w\".\"%w_node\""
+      " WHERE channel=?1 AND node=?2 AND upper>=?3",
+      pTab->zDb, pTab->zName
+  ));
+  if( rc==SQLITE_OK ){
+    rc = ivPrepare(db, &pCsr->apSearch[1], sqlite3_mprintf(
+        "SELECT channel, id, lower, upper FROM \"%w\".\"%w_node\""
+        " WHERE channel=?1 AND node=?2 AND lower<=?3",
+        pTab->zDb, pTab->zName
+    ));
+  }
+  if( rc==SQLITE_OK ){
+    rc = ivPrepare(db, &pCsr->apSearch[2], sqlite3_mprintf(
+        "SELECT channel, id, lower, upper FROM \"%w\".\"%w_node\""
+        " WHERE channel=?1 AND node BETWEEN ?2 AND ?3",
+        pTab->zDb, pTab->zName
+    ));
+  }
+  if( rc==SQLITE_OK ){
+    rc = ivPrepare(db, &pCsr->pChannel, sqlite3_mprintf(
+        "SELECT channel, mask FROM \"%w\".\"%w_level\"%s",
+        pTab->zDb, pTab->zName, pChannel ? " WHERE channel=?1" : ""
+    ));
+  }
+  if( rc!=SQLITE_OK ) return rc;
+  if( pChannel ) sqlite3_bind_value(pCsr->pChannel, 1, pChannel);
+  pCsr->bEof = 0;
+  return ivNext(pCursor);
+}
+
+static int ivEof(sqlite3_vtab_cursor *pCursor){
+  IvCursor *pCsr = (IvCursor*)pCursor;
+  return pCsr->bEof;
+}
+
+static int ivColumn(
+  sqlite3_vtab_cursor *pCursor,
+  sqlite3_context *ctx,
+  int i
+){
+  IvCursor *pCsr = (IvCursor*)pCursor;
+  switch( i ){
+    case IV_COL_RID:
+      sqlite3_result_value(ctx, sqlite3_column_value(pCsr->pStmt, 1));
+      break;
+    case IV_COL_CHANNEL:
+    case IV_COL_LOWER:
+    case IV_COL_UPPER:
+      sqlite3_result_value(ctx, sqlite3_column_value(pCsr->pStmt, i-1));
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int ivRowid(sqlite3_vtab_cursor *pCursor, sqlite_int64 *pRowid){
+  IvCursor *pCsr = (IvCursor*)pCursor;
+  *pRowid = sqlite3_column_int64(pCsr->pStmt, 1);
+  return SQLITE_OK;
+}
+
+/*
+** The xUpdate method.  The index may only be modified by writing one of
+** the commands 'insert', 'delete', 'replace' or 'rebuild' to the hidden
+** column that has the same name as the table.
+**
+** 'replace' names a row that REPLACE conflict handling may delete
+** without the DELETE trigger firing, or with a NULL rid forgets all such
+** rows.  The next 'insert' removes the intervals of the named rows that
+** have been deleted or overwritten.  'rebuild' also recreates the
+** triggers, so that they see any new UNIQUE indexes.
+*/
+static int ivUpdate(
+  sqlite3_vtab *pVtab,
+  int argc,
+  sqlite3_value **argv,
+  sqlite_int64 *pRowid
+){
+  IvTable *pTab = (IvTable*)pVtab;
+  const char *zCmd = 0;
+  int rc;
+
+  if( argc>1 && sqlite3_value_type(argv[0])==SQLITE_NULL ){
+    zCmd = (const char*)sqlite3_value_text(argv[2+IV_COL_COMMAND]);
+  }
+  if( zCmd && sqlite3_stricmp(zCmd, "rebuild")==0 ){
+    rc = ivRebuild(pTab);
+    if( rc==SQLITE_OK ) rc = ivDropTriggers(pTab);
+    if( rc==SQLITE_OK ) rc = ivCreateTriggers(pTab, &pVtab->zErrMsg);
+  }else if( zCmd && sqlite3_stricmp(zCmd, "replace")==0 ){
+    rc = SQLITE_OK;
+    if( sqlite3_value_type(argv[2+IV_COL_RID])==SQLITE_NULL ){
+      ivClearReplace(pTab);
+    }else{
+      sqlite3_value **ap;
+      int i;
+      if( pTab->nReplace>=pTab->nReplaceAlloc ){
+        int nNew = pTab->nReplaceAlloc ? pTab->nReplaceAlloc*2 : 8;
+        sqlite3_value **apNew = (sqlite3_value**)sqlite3_realloc64(
+            pTab->apReplace, nNew*4*sizeof(sqlite3_value*)
+        );
+        if( apNew==0 ) return SQLITE_NOMEM_BKPT;
+        pTab->apReplace = apNew;
+        pTab->nReplaceAlloc = nNew;
+      }
+      ap = &pTab->apReplace[pTab->nReplace*4];
+      for(i=0; i<4; i++){
+        ap[i] = sqlite3_value_dup(argv[2+i]);
+        if( ap[i]==0 ) rc = SQLITE_NOMEM_BKPT;
+      }
+      if( rc==SQLITE_OK ){
+        pTab->nReplace++;
+      }else{
+        for(i=0; i<4; i++) sqlite3_value_free(ap[i]);
+      }
+    }
+  }else if( zCmd && (sqlite3_stricmp(zCmd, "insert")==0
+                  || sqlite3_stricmp(zCmd, "delete")==0)
+  ){
+    int bInsert = sqlite3_stricmp(zCmd, "insert")==0;
+    rc = SQLITE_OK;
+    if( bInsert && pTab->nReplace>0 ){
+      rc = ivFlushReplace(pTab, argv[2+IV_COL_RID]);
+    }
+    if( rc==SQLITE_OK ){
+      rc = ivWrite(pTab, bInsert,
+          argv[2+IV_COL_RID], argv[2+IV_COL_CHANNEL],
+          argv[2+IV_COL_LOWER], argv[2+IV_COL_UPPER]
+      );
+    }
+  }else{
+    pVtab->zErrMsg = sqlite3_mprintf(
+        "interval: %s is maintained by triggers on %s", pTab->zName, pTab->zTab
+    );
+    return SQLITE_ERROR;
+  }
+  if( rc!=SQLITE_OK && pVtab->zErrMsg==0 ){
+    pVtab->zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pTab->db));
+  }
+  return rc;
+}
+
+/*
+** Rename the shadow tables and recreate the triggers, which refer to
+** the virtual table by name.
+*/
+static int ivRename(sqlite3_vtab *pVtab, const char *zNew){
+  IvTable *pTab = (IvTable*)pVtab;
+  char *zName;
+  int rc;
+  ivFinalizeAll(pTab);
+  rc = ivDropTriggers(pTab);
+  if( rc==SQLITE_OK ){
+    rc = ivExec(pTab->db, sqlite3_mprintf(
+        "ALTER TABLE \"%w\".\"%w_node\" RENAME TO \"%w_node\";"
+        "ALTER TABLE \"%w\".\"%w_level\" RENAME TO \"%w_level\";",
+        pTab->zDb, pTab->zName, zNew, pTab->zDb, pTab->zName, zNew
+    ));
+  }
+  if( rc!=SQLITE_OK ) return rc;
+  zName = sqlite3_mprintf("%s", zNew);
+  if( zName==0 ) return SQLITE_NOMEM_BKPT;
+  sqlite3_free(pTab->zName);
+  pTab->zName = zName;
+  return ivCreateTriggers(pTab, &pVtab->zErrMsg);
+}
+
+/*
+** Invoke this routine to register the "interval" virtual table module
+*/
+int sqlite3IntervalInit(sqlite3 *db){
+  static sqlite3_module interval_module = {
+    0,                            /* iVersion */
+    ivCreate,                     /* xCreate */
+    ivConnect,                    /* xConnect */
+    ivBestIndex,                  /* xBestIndex */
+    ivDisconnect,                 /* xDisconnect */
+    ivDestroy,                    /* xDestroy */
+    ivOpen,                       /* xOpen - open a cursor */
+    ivClose,                      /* xClose - close a cursor */
+    ivFilter,                     /* xFilter - configure scan constraints */
+    ivNext,                       /* xNext - advance a cursor */
+    ivEof,                        /* xEof - check for end of scan */
+    ivColumn,                     /* xColumn - read data */
+    ivRowid,                      /* xRowid - read data */
+    ivUpdate,                     /* xUpdate */
+    0,                            /* xBegin */
+    0,                            /* xSync */
+    0,                            /* xCommit */
+    0,                            /* xRollback */
+    0,                            /* xFindMethod */
+    ivRename,                     /* xRename */
+    0,                            /* xSavepoint */
+    0,                            /* xRelease */
+    0,                            /* xRollbackTo */
+  };
+  return sqlite3_create_module(db, "interval", &interval_module, 0);
+}
+#elif defined(SQLITE_ENABLE_INTERVAL)
+int sqlite3IntervalInit(sqlite3 *db){ return SQLITE_OK; }
+#endif /* SQLITE_ENABLE_INTERVAL */
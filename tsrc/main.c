@@ -653,6 +653,18 @@ int sqlite3_config(int op, ...){
     }
 #endif /* SQLITE_ENABLE_SORTER_REFERENCES */
 
+    case SQLITE_CONFIG_PCACHE_POLICY: {
+      int ePolicy = va_arg(ap, int);
+      if( ePolicy==SQLITE_PCACHE_POLICY_LRU
+       || ePolicy==SQLITE_PCACHE_POLICY_2Q
+      ){
+        sqlite3GlobalConfig.ePcachePolicy = ePolicy;
+      }else{
+        rc = SQLITE_ERROR;
+      }
+      break;
+    }
+
     default: {
       rc = SQLITE_ERROR;
       break;
@@ -2971,6 +2983,9 @@ static int openDatabase(
   db->aLimit[SQLITE_LIMIT_WORKER_THREADS] = SQLITE_DEFAULT_WORKER_THREADS;
   db->autoCommit = 1;
   db->nextAutovac = -1;
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+  db->nextFreemap = -1;
+#endif
   db->szMmap = sqlite3GlobalConfig.szMmap;
   db->nextPagesize = 0;
   db->nMaxSorterMmap = 0x7FFFFFFF;
@@ -3152,6 +3167,24 @@ static int openDatabase(
   }
 #endif
 
+#ifdef SQLITE_ENABLE_PARTITION
+  if( !db->mallocFailed && rc==SQLITE_OK){
+    rc = sqlite3PartitionInit(db);
+  }
+#endif
+
+#ifdef SQLITE_ENABLE_BITMAP
+  if( !db->mallocFailed && rc==SQLITE_OK){
+    rc = sqlite3BitmapInit(db);
+  }
+#endif
+
+#ifdef SQLITE_ENABLE_INTERVAL
+  if( !db->mallocFailed && rc==SQLITE_OK){
+    rc = sqlite3IntervalInit(db);
+  }
+#endif
+
 #ifdef SQLITE_ENABLE_DBPAGE_VTAB
   if( !db->mallocFailed && rc==SQLITE_OK){
     rc = sqlite3DbpageRegister(db);
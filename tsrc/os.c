@@ -49,6 +49,7 @@ int sqlite3_open_file_count = 0;
 **
 **     sqlite3OsRead()
 **     sqlite3OsWrite()
+**     sqlite3OsWritev()
 **     sqlite3OsSync()
 **     sqlite3OsFileSize()
 **     sqlite3OsLock()
@@ -97,6 +98,21 @@ int sqlite3OsWrite(sqlite3_file * id, const void * pBuf, int amt, i64 offset)
     DO_OS_MALLOC_TEST(id);
     return id->pMethods->xWrite(id, pBuf, amt, offset);
 }
+int sqlite3OsWritev(sqlite3_file * id, int nBuf, const void ** apBuf, int amt, i64 offset)
+{
+    int rc = SQLITE_OK;
+    int i;
+    DO_OS_MALLOC_TEST(id);
+    if (id->pMethods->iVersion >= 4 && id->pMethods->xWritev)
+    {
+        return id->pMethods->xWritev(id, nBuf, apBuf, amt, offset);
+    }
+    for (i = 0; rc == SQLITE_OK && i < nBuf; i++)
+    {
+        rc = id->pMethods->xWrite(id, apBuf[i], amt, offset + i * (i64)amt);
+    }
+    return rc;
+}
 int sqlite3OsTruncate(sqlite3_file * id, i64 size)
 {
     return id->pMethods->xTruncate(id, size);
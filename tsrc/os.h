@@ -163,6 +163,7 @@ int sqlite3OsInit(void);
 void sqlite3OsClose(sqlite3_file*);
 int sqlite3OsRead(sqlite3_file*, void*, int amt, i64 offset);
 int sqlite3OsWrite(sqlite3_file*, const void*, int amt, i64 offset);
+int sqlite3OsWritev(sqlite3_file*, int nBuf, const void **apBuf, int amt, i64 offset);
 int sqlite3OsTruncate(sqlite3_file*, i64 size);
 int sqlite3OsSync(sqlite3_file*, int);
 int sqlite3OsFileSize(sqlite3_file*, i64 *pSize);
@@ -84,6 +84,11 @@
 # define USE_PREAD 1
 #endif
 
+/* Use pwritev() to write runs of adjacent pages if it is available */
+#if defined(__linux__) && !defined(HAVE_PWRITEV)
+# define HAVE_PWRITEV 1
+#endif
+
 /*
 ** standard include files.
 */
@@ -95,6 +100,9 @@
 #include <time.h>
 #include <sys/time.h>
 #include <errno.h>
+#if defined(HAVE_PWRITEV) && HAVE_PWRITEV
+# include <sys/uio.h>
+#endif
 #if !defined(SQLITE_OMIT_WAL) || SQLITE_MAX_MMAP_SIZE>0
 # include <sys/mman.h>
 #endif
@@ -527,6 +535,14 @@ static struct unix_syscall {
 #endif
 #define osIoctl ((int(*)(int,int,...))aSyscall[28].pCurrent)
 
+#if defined(HAVE_PWRITEV) && HAVE_PWRITEV
+  { "pwritev",      (sqlite3_syscall_ptr)pwritev,        0 },
+#else
+  { "pwritev",      (sqlite3_syscall_ptr)0,              0 },
+#endif
+#define osPwritev ((ssize_t(*)(int,const struct iovec*,int,off_t))\
+                    aSyscall[29].pCurrent)
+
 }; /* End of the overrideable system calls */
 
 
@@ -3433,6 +3449,107 @@ static int unixWrite(
   return SQLITE_OK;
 }
 
+/*
+** Maximum number of buffers passed to a single pwritev() call by
+** unixWritev(). POSIX guarantees that IOV_MAX is at least 16, and it
+** is 1024 on Linux.
+*/
+#ifndef SQLITE_UNIX_WRITEV_MAX
+# define SQLITE_UNIX_WRITEV_MAX 64
+#endif
+
+/*
+** Write nBuf buffers of amt bytes each from apBuf[] to consecutive
+** locations in the file, starting at offset. Return SQLITE_OK on
+** success or some other error code on failure.
+**
+** If pwritev() is available, each group of up to SQLITE_UNIX_WRITEV_MAX
+** buffers is written by a single system call. Otherwise, or if part of
+** the region is memory mapped for writing, this is the same as calling
+** unixWrite() once for each buffer.
+*/
+static int unixWritev(
+  sqlite3_file *id,
+  int nBuf,
+  const void **apBuf,
+  int amt,
+  sqlite3_int64 offset
+){
+  int nSlow = nBuf;               /* Leading buffers written by unixWrite() */
+  int i;
+#if defined(HAVE_PWRITEV) && HAVE_PWRITEV
+  unixFile *pFile = (unixFile*)id;
+#endif
+  assert( id );
+  assert( amt>0 );
+
+#if defined(HAVE_PWRITEV) && HAVE_PWRITEV
+  nSlow = (osPwritev==0 ? nBuf : 0);
+#ifdef SQLITE_DEBUG
+  /* Let unixWrite() check for transaction counter changes if the first
+  ** buffer covers the database header. */
+  if( pFile->inNormalWrite ){
+    pFile->dbUpdate = 1;
+    if( offset<=24 && nSlow==0 ) nSlow = 1;
+  }
+#endif
+#if defined(SQLITE_MMAP_READWRITE) && SQLITE_MAX_MMAP_SIZE>0
+  if( offset<pFile->mmapSize ) nSlow = nBuf;
+#endif
+#endif /* HAVE_PWRITEV */
+
+  for(i=0; i<nSlow; i++){
+    int rc = unixWrite(id, apBuf[i], amt, offset + i*(i64)amt);
+    if( rc!=SQLITE_OK ) return rc;
+  }
+
+#if defined(HAVE_PWRITEV) && HAVE_PWRITEV
+  while( i<nBuf ){
+    struct iovec aIov[SQLITE_UNIX_WRITEV_MAX];
+    i64 iOff = offset + i*(i64)amt;
+    int nIov = MIN(nBuf-i, SQLITE_UNIX_WRITEV_MAX);
+    i64 wrote;
+    int j;
+
+    for(j=0; j<nIov; j++){
+      aIov[j].iov_base = (void*)apBuf[i+j];
+      aIov[j].iov_len = amt;
+    }
+    TIMER_START;
+    do{
+      wrote = osPwritev(pFile->h, aIov, nIov, iOff);
+    }while( wrote<0 && errno==EINTR );
+    TIMER_END;
+    OSTRACE(("WRITEV  %-3d %5d %7lld %llu\n",
+             pFile->h, (int)wrote, iOff, TIMER_ELAPSED));
+    SimulateIOError(( wrote=(-1), errno=EIO ));
+    SimulateDiskfullError(( wrote=0 ));
+
+    if( wrote<0 && errno!=ENOSPC ){
+      storeLastErrno(pFile, errno);
+      return SQLITE_IOERR_WRITE;
+    }
+    if( wrote<=0 ){
+      storeLastErrno(pFile, 0); /* not a system error */
+      return SQLITE_FULL;
+    }
+    if( wrote<nIov*(i64)amt ){
+      /* A short write. Finish the buffer it stopped in using unixWrite()
+      ** and continue with the buffer that follows. */
+      int nDone = (int)(wrote % amt);
+      int rc;
+      nIov = (int)(wrote / amt);
+      rc = unixWrite(id, &((const u8*)apBuf[i+nIov])[nDone], amt-nDone,
+                     iOff + wrote);
+      if( rc!=SQLITE_OK ) return rc;
+      nIov++;
+    }
+    i += nIov;
+  }
+#endif /* HAVE_PWRITEV */
+  return SQLITE_OK;
+}
+
 #ifdef SQLITE_TEST
 /*
 ** Count the number of fullsyncs and normal syncs.  This is used to test
@@ -5153,6 +5270,7 @@ static const sqlite3_io_methods METHOD = {                                   \
    unixShmUnmap,               /* xShmUnmap */                               \
    unixFetch,                  /* xFetch */                                  \
    unixUnfetch,                /* xUnfetch */                                \
+   unixWritev,                 /* xWritev */                                 \
 };                                                                           \
 static const sqlite3_io_methods *FINDER##Impl(const char *z, unixFile *p){   \
   UNUSED_PARAMETER(z); UNUSED_PARAMETER(p);                                  \
@@ -5169,7 +5287,7 @@ static const sqlite3_io_methods *(*const FINDER)(const char*,unixFile *p)    \
 IOMETHODS(
   posixIoFinder,            /* Finder function name */
   posixIoMethods,           /* sqlite3_io_methods object name */
-  3,                        /* shared memory and mmap are enabled */
+  4,                        /* shared memory, mmap and xWritev are enabled */
   unixClose,                /* xClose method */
   unixLock,                 /* xLock method */
   unixUnlock,               /* xUnlock method */
@@ -5179,7 +5297,7 @@ IOMETHODS(
 IOMETHODS(
   nolockIoFinder,           /* Finder function name */
   nolockIoMethods,          /* sqlite3_io_methods object name */
-  3,                        /* shared memory is disabled */
+  4,                        /* shared memory is disabled */
   nolockClose,              /* xClose method */
   nolockLock,               /* xLock method */
   nolockUnlock,             /* xUnlock method */
@@ -7763,7 +7881,7 @@ int sqlite3_os_init(void){
 
   /* Double-check that the aSyscall[] array has been constructed
   ** correctly.  See ticket [bb3a86e890c8e96ab] */
-  assert( ArraySize(aSyscall)==29 );
+  assert( ArraySize(aSyscall)==30 );
 
   /* Register all VFSes defined in the aVfs[] array */
   for(i=0; i<(sizeof(aVfs)/sizeof(sqlite3_vfs)); i++){
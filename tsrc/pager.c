@@ -645,6 +645,7 @@ struct Pager
     u8 noLock;                  /* Do not lock (except in WAL mode) */
     u8 readOnly;                /* True for a read-only database */
     u8 memDb;                   /* True to inhibit all file I/O */
+    u8 bWarm;                   /* True to record and preload hot page set */
 
     /**************************************************************************
     ** The following block contains those class members that change during
@@ -663,6 +664,7 @@ struct Pager
     u8 subjInMemory;            /* True to use in-memory sub-journals */
     u8 bUseFetch;               /* True to use xFetch() */
     u8 hasHeldSharedLock;       /* True if a shared lock has ever been held */
+    u8 bWarmLoaded;             /* True once the hot page set is preloaded */
     Pgno dbSize;                /* Number of pages in the database */
     Pgno dbOrigSize;            /* dbSize before the current transaction */
     Pgno dbFileSize;            /* Number of pages in the database file */
@@ -679,6 +681,10 @@ struct Pager
     i64 journalHdr;             /* Byte offset to previous journal header */
     sqlite3_backup * pBackup;   /* Pointer to list of ongoing backup processes */
     PagerSavepoint * aSavepoint; /* Array of active savepoints */
+    u8 * aJrnlBuf;              /* Main journal content not yet written */
+    int szJrnlBuf;              /* Allocated size of aJrnlBuf[] */
+    int nJrnlBuf;               /* Bytes of valid data in aJrnlBuf[] */
+    i64 iJrnlBufOff;            /* Journal file offset of aJrnlBuf[0] */
     int nSavepoint;             /* Number of elements in aSavepoint[] */
     u32 iDataVersion;           /* Changes whenever database content changes */
     char dbFileVers[16];        /* Changes whenever database file changes */
@@ -715,6 +721,10 @@ struct Pager
 #endif
     char * pTmpSpace;           /* Pager.pageSize bytes of space for tmp use */
     PCache * pPCache;           /* Pointer to page cache object */
+    Pgno * aWarm;               /* Hot page set. See pagerWarmRecord() */
+    int nWarm;                  /* Number of entries in aWarm[] */
+    int nWarmAlloc;             /* Allocated size of aWarm[] */
+    int nWarmNew;               /* Entries added since aWarm[] was last saved */
 #ifndef SQLITE_OMIT_WAL
     Wal * pWal;                 /* Write-ahead log used by "journal_mode=wal" */
     char * zWal;                /* File name for write-ahead log */
@@ -1415,6 +1425,119 @@ static i64 journalHdrOffset(Pager * pPager)
     return offset;
 }
 
+/*
+** Size in bytes of the buffer used to assemble main journal records
+** before they are written to the journal file. Set this to 0 to write
+** each record directly, as three separate xWrite() calls.
+*/
+#ifndef SQLITE_JOURNAL_BUFFER_SIZE
+# define SQLITE_JOURNAL_BUFFER_SIZE 65536
+#endif
+
+static int pager_error(Pager * pPager, int rc);
+
+/*
+** Write the content of the main journal buffer, if any, to the journal
+** file. The buffer is empty when this function returns SQLITE_OK.
+**
+** If the write fails, the data is kept in the buffer and the pager is
+** moved to the ERROR state. The buffer holds records for pages that are
+** already marked as journalled and may already have been modified in
+** the cache, so the cache can no longer be rolled back from the journal
+** file. In the ERROR state it is discarded instead. The database file is
+** not written while the buffer holds data (see pager_write_pagelist()),
+** so the journal file still restores it.
+*/
+static int pagerJournalFlush(Pager * pPager)
+{
+    int rc = SQLITE_OK;
+    if (pPager->nJrnlBuf > 0)
+    {
+        rc = sqlite3OsWrite(pPager->jfd, pPager->aJrnlBuf, pPager->nJrnlBuf,
+                            pPager->iJrnlBufOff);
+        if (rc == SQLITE_OK)
+        {
+            pPager->nJrnlBuf = 0;
+        }
+        else
+        {
+            rc = pager_error(pPager, rc);
+        }
+    }
+    return rc;
+}
+
+/*
+** Append nData bytes from pData to the main journal buffer. The data
+** belongs at offset iOff of the journal file. Return SQLITE_OK if
+** successful, or an error code if a write to the journal file fails.
+**
+** When the buffer fills up, everything up to the last sector boundary
+** is written to the journal file by a single xWrite() call, and the
+** remainder is kept in the buffer. A failed write is handled as by
+** pagerJournalFlush().
+*/
+static int pagerJournalAppend(Pager * pPager, const void * pData, int nData, i64 iOff)
+{
+    int rc = SQLITE_OK;
+    if (pPager->nJrnlBuf > 0 && iOff != pPager->iJrnlBufOff + pPager->nJrnlBuf)
+    {
+        rc = pagerJournalFlush(pPager);
+    }
+    if (pPager->nJrnlBuf == 0) pPager->iJrnlBufOff = iOff;
+    while (rc == SQLITE_OK && nData > 0)
+    {
+        int nCopy = MIN(nData, pPager->szJrnlBuf - pPager->nJrnlBuf);
+        memcpy(&pPager->aJrnlBuf[pPager->nJrnlBuf], pData, nCopy);
+        pPager->nJrnlBuf += nCopy;
+        pData = (const void *)&((const u8 *)pData)[nCopy];
+        nData -= nCopy;
+        if (pPager->nJrnlBuf == pPager->szJrnlBuf)
+        {
+            i64 iEnd = pPager->iJrnlBufOff + pPager->nJrnlBuf;
+            int nWrite = pPager->nJrnlBuf - (int)(iEnd % pPager->sectorSize);
+            rc = sqlite3OsWrite(pPager->jfd, pPager->aJrnlBuf, nWrite,
+                                pPager->iJrnlBufOff);
+            if (rc != SQLITE_OK)
+            {
+                rc = pager_error(pPager, rc);
+                break;
+            }
+            memmove(pPager->aJrnlBuf, &pPager->aJrnlBuf[nWrite],
+                    pPager->nJrnlBuf - nWrite);
+            pPager->nJrnlBuf -= nWrite;
+            pPager->iJrnlBufOff += nWrite;
+        }
+    }
+    return rc;
+}
+
+/*
+** Return true if main journal records should be assembled in the journal
+** buffer, allocating or resizing the buffer if required. The buffer is
+** only used for journal files that are not held in memory, and it always
+** spans at least two sectors.
+*/
+static int pagerUseJournalBuffer(Pager * pPager)
+{
+    int szBuf = MAX(SQLITE_JOURNAL_BUFFER_SIZE, (int)pPager->sectorSize * 2);
+    if (SQLITE_JOURNAL_BUFFER_SIZE <= 0) return 0;
+    if (sqlite3JournalIsInMemory(pPager->jfd)) return 0;
+    if (pPager->szJrnlBuf < szBuf && pPager->nJrnlBuf == 0)
+    {
+        u8 * aNew;
+        sqlite3BeginBenignMalloc();
+        aNew = (u8 *)sqlite3Realloc(pPager->aJrnlBuf, szBuf);
+        sqlite3EndBenignMalloc();
+        if (aNew)
+        {
+            pPager->aJrnlBuf = aNew;
+            pPager->szJrnlBuf = szBuf;
+        }
+    }
+    return pPager->szJrnlBuf >= szBuf;
+}
+
 /*
 ** The journal file must be open when this function is called.
 **
@@ -1504,6 +1627,9 @@ static int writeJournalHdr(Pager * pPager)
 
     assert(isOpen(pPager->jfd));        /* Journal file must be open. */
 
+    rc = pagerJournalFlush(pPager);
+    if (rc != SQLITE_OK) return rc;
+
     if (nHeader > JOURNAL_HDR_SZ(pPager))
     {
         nHeader = JOURNAL_HDR_SZ(pPager);
@@ -1775,6 +1901,8 @@ static int writeMasterJournal(Pager * pPager, const char * zMaster)
     }
     pPager->setMaster = 1;
     assert(pPager->journalHdr <= pPager->journalOff);
+    rc = pagerJournalFlush(pPager);
+    if (rc != SQLITE_OK) return rc;
 
     /* Calculate the length in bytes and the checksum of zMaster */
     for (nMaster = 0; zMaster[nMaster]; nMaster++)
@@ -1890,6 +2018,289 @@ static int addToSavepointBitvecs(Pager * pPager, Pgno pgno)
     return rc;
 }
 
+/*
+** Hot page set ("cache_warmup=1" URI parameter).
+**
+** While a database is in use, the page number of each page given the
+** priority hint (b-tree interior pages, see sqlite3PagerPriority()) is
+** appended to Pager.aWarm[] as it is read from the database file. Every
+** PAGER_WARM_SAVE_STEP new entries, and when the pager is closed, the
+** set is written to a side file named after the database file with
+** "-warm" appended. The next time the database is opened, the pages
+** listed in the side file are read into the page cache when the first
+** read transaction starts, in ascending order using a few large reads
+** in place of one small read per page. Preloaded pages are carried over
+** into the set recorded by the new connection.
+**
+** The side file is a hint only. It is not protected by the database
+** locks and any entry that does not fit the current database is ignored.
+** It consists of an 8 byte header, the 4-byte big-endian values
+** PAGER_WARM_MAGIC and the number of entries, followed by that many
+** 4-byte big-endian page numbers in ascending order.
+*/
+#ifndef SQLITE_DEFAULT_CACHE_WARMUP
+# define SQLITE_DEFAULT_CACHE_WARMUP 0
+#endif
+#define PAGER_WARM_MAGIC     0x5741524d  /* "WARM" */
+#define PAGER_WARM_SAVE_STEP 64          /* Save after this many new entries */
+#define PAGER_WARM_MAX_READ  65536       /* Most bytes read by one xRead() */
+#define PAGER_WARM_MAX_GAP   4           /* Read through gaps this small */
+
+/*
+** Sort the nWarm page numbers in aWarm[] into ascending order and remove
+** duplicates. Return the number of entries that remain.
+*/
+static int pagerWarmSort(Pgno * aWarm, int nWarm)
+{
+    int iGap, i, j, n;
+    for (iGap = nWarm / 2; iGap > 0; iGap = iGap / 2)
+    {
+        for (i = iGap; i < nWarm; i++)
+        {
+            Pgno t = aWarm[i];
+            for (j = i; j >= iGap && aWarm[j - iGap] > t; j -= iGap)
+            {
+                aWarm[j] = aWarm[j - iGap];
+            }
+            aWarm[j] = t;
+        }
+    }
+    for (i = n = 0; i < nWarm; i++)
+    {
+        if (n == 0 || aWarm[n - 1] != aWarm[i]) aWarm[n++] = aWarm[i];
+    }
+    return n;
+}
+
+/*
+** Return a pointer to a buffer containing the name of the hot page set
+** file for pager pPager, or NULL if an OOM occurs. The name is followed
+** by two nul-terminator bytes, as expected by xOpen(). The caller must
+** free the buffer using sqlite3_free().
+*/
+static char * pagerWarmName(Pager * pPager)
+{
+    int nName = sqlite3Strlen30(pPager->zFilename);
+    char * zWarm = (char *)sqlite3MallocZero(nName + 5 + 2);
+    if (zWarm)
+    {
+        memcpy(zWarm, pPager->zFilename, nName);
+        memcpy(&zWarm[nName], "-warm", 5);
+    }
+    return zWarm;
+}
+
+/*
+** Write the hot page set of pager pPager to the side file. Errors are
+** ignored - the only consequence is a colder cache the next time the
+** database is opened.
+**
+** This opens, writes, truncates and closes the side file synchronously,
+** without syncing it. It is called when the pager is closed and from
+** pager_unlock() after the database lock has been released (except in
+** exclusive locking mode), so it does not lengthen the time a lock is
+** held. But the transaction that records the PAGER_WARM_SAVE_STEP'th new
+** page pays for the write before it finishes.
+*/
+static void pagerWarmSave(Pager * pPager)
+{
+    sqlite3_vfs * pVfs = pPager->pVfs;
+    sqlite3_file * pFile;
+    char * zWarm;
+    u8 * aBuf;
+    int nWarm;
+    int i;
+
+    nWarm = pagerWarmSort(pPager->aWarm, pPager->nWarm);
+    pPager->nWarm = nWarm;
+    pPager->nWarmNew = 0;
+
+    sqlite3BeginBenignMalloc();
+    zWarm = pagerWarmName(pPager);
+    pFile = (sqlite3_file *)sqlite3MallocZero(pVfs->szOsFile);
+    aBuf = (u8 *)sqlite3Malloc(8 + 4 * (i64)nWarm);
+    if (zWarm && pFile && aBuf)
+    {
+        int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_MAIN_JOURNAL;
+        if (sqlite3OsOpen(pVfs, zWarm, pFile, flags, 0) == SQLITE_OK)
+        {
+            put32bits(&aBuf[0], PAGER_WARM_MAGIC);
+            put32bits(&aBuf[4], nWarm);
+            for (i = 0; i < nWarm; i++)
+            {
+                put32bits(&aBuf[8 + i * 4], pPager->aWarm[i]);
+            }
+            if (sqlite3OsWrite(pFile, aBuf, 8 + 4 * nWarm, 0) == SQLITE_OK)
+            {
+                sqlite3OsTruncate(pFile, 8 + 4 * nWarm);
+            }
+            sqlite3OsClose(pFile);
+        }
+    }
+    sqlite3_free(aBuf);
+    sqlite3_free(pFile);
+    sqlite3_free(zWarm);
+    sqlite3EndBenignMalloc();
+}
+
+/*
+** Append page number pgno to the hot page set of pager pPager. The set
+** never holds more distinct pages than the configured cache size.
+*/
+static void pagerWarmRecord(Pager * pPager, Pgno pgno)
+{
+    if (pPager->nWarm >= pPager->nWarmAlloc)
+    {
+        int nMax = sqlite3PcacheGetCachesize(pPager->pPCache);
+        pPager->nWarm = pagerWarmSort(pPager->aWarm, pPager->nWarm);
+        if (pPager->nWarm >= nMax) return;
+        if (pPager->nWarm * 2 >= pPager->nWarmAlloc)
+        {
+            int nNew = pPager->nWarmAlloc ? pPager->nWarmAlloc * 2 : 64;
+            Pgno * aNew;
+            sqlite3BeginBenignMalloc();
+            aNew = (Pgno *)sqlite3Realloc(pPager->aWarm, nNew * sizeof(Pgno));
+            sqlite3EndBenignMalloc();
+            if (aNew == 0) return;
+            pPager->aWarm = aNew;
+            pPager->nWarmAlloc = nNew;
+        }
+    }
+    pPager->aWarm[pPager->nWarm++] = pgno;
+    pPager->nWarmNew++;
+}
+
+/*
+** Read the pages listed in the hot page set file of pager pPager into
+** the page cache. This is called once, when the first read transaction
+** is opened on a rollback-mode database with an empty cache. Pages
+** already in the cache are left as they are, and no more pages are
+** loaded than will fit in the cache without evicting anything. Errors
+** are ignored.
+*/
+static void pagerWarmLoad(Pager * pPager)
+{
+    sqlite3_vfs * pVfs = pPager->pVfs;
+    sqlite3_file * pFile = 0;
+    char * zWarm;
+    u8 * aList = 0;
+    u8 * aData = 0;
+    i64 szList = 0;
+    int nList = 0;
+    int nRoom;
+    int mxRun = 0;
+    int bExists = 0;
+    int i, j;
+
+    assert(pPager->eState == PAGER_READER && !pagerUseWal(pPager));
+    pPager->bWarmLoaded = 1;
+    nRoom = sqlite3PcacheGetCachesize(pPager->pPCache) * 9 / 10
+            - sqlite3PcachePagecount(pPager->pPCache);
+    if (nRoom <= 0) return;
+
+    sqlite3BeginBenignMalloc();
+    zWarm = pagerWarmName(pPager);
+    if (zWarm
+            && sqlite3OsAccess(pVfs, zWarm, SQLITE_ACCESS_EXISTS, &bExists) == SQLITE_OK
+            && bExists
+            && (pFile = (sqlite3_file *)sqlite3MallocZero(pVfs->szOsFile)) != 0
+       )
+    {
+        int flags = SQLITE_OPEN_READONLY | SQLITE_OPEN_MAIN_JOURNAL;
+        if (sqlite3OsOpen(pVfs, zWarm, pFile, flags, 0) == SQLITE_OK)
+        {
+            if (sqlite3OsFileSize(pFile, &szList) == SQLITE_OK && szList >= 8)
+            {
+                /* The file is not trusted. Read no more entries than the
+                ** cache can hold, which is all that pagerWarmRecord()
+                ** ever records. */
+                int nCache = sqlite3PcacheGetCachesize(pPager->pPCache);
+                int nRead;
+                if (nCache > (SQLITE_MAX_LENGTH - 8) / 4)
+                {
+                    nCache = (SQLITE_MAX_LENGTH - 8) / 4;
+                }
+                nRead = 8 + 4 * nCache;
+                if (szList < nRead) nRead = szList;
+                aList = (u8 *)sqlite3Malloc(nRead);
+                for (i = 0; aList && i < nRead; i += PAGER_WARM_MAX_READ)
+                {
+                    int n = MIN(nRead - i, PAGER_WARM_MAX_READ);
+                    if (sqlite3OsRead(pFile, &aList[i], n, i) != SQLITE_OK) break;
+                }
+                if (aList && i >= nRead && sqlite3Get4byte(aList) == PAGER_WARM_MAGIC)
+                {
+                    nList = MIN(sqlite3Get4byte(&aList[4]), (u32)(nRead - 8) / 4);
+                }
+            }
+            sqlite3OsClose(pFile);
+        }
+    }
+    if (nList > 0)
+    {
+        mxRun = MAX(1, PAGER_WARM_MAX_READ / pPager->pageSize);
+        aData = (u8 *)sqlite3Malloc(mxRun * (i64)pPager->pageSize);
+    }
+
+    /* Each iteration of the following loop reads the run of pages from
+    ** page aList[i] to page aList[j-1] with a single xRead(), then copies
+    ** those pages that are not yet cached into the page cache.
+    */
+    for (i = 0; aData && i < nList && nRoom > 0; i = j)
+    {
+        Pgno iFirst = sqlite3Get4byte(&aList[8 + i * 4]);
+        Pgno iLast = iFirst;
+        int rc;
+        if (iFirst > pPager->dbSize) break;
+        if (iFirst == 0)
+        {
+            j = i + 1;
+            continue;
+        }
+        for (j = i + 1; j < nList; j++)
+        {
+            Pgno pgno = sqlite3Get4byte(&aList[8 + j * 4]);
+            if (pgno <= iLast) break;
+            if (pgno > pPager->dbSize) break;
+            if (pgno - iFirst >= (Pgno)mxRun) break;
+            if (pgno - iLast > PAGER_WARM_MAX_GAP + 1) break;
+            iLast = pgno;
+        }
+        rc = sqlite3OsRead(pPager->fd, aData, (iLast - iFirst + 1) * pPager->pageSize,
+                           (i64)(iFirst - 1) * pPager->pageSize);
+        if (rc != SQLITE_OK && rc != SQLITE_IOERR_SHORT_READ) break;
+        for (; i < j && nRoom > 0; i++)
+        {
+            Pgno pgno = sqlite3Get4byte(&aList[8 + i * 4]);
+            sqlite3_pcache_page * pBase;
+            PgHdr * pPg;
+            if (pgno == 1 || pgno == PAGER_MJ_PGNO(pPager)) continue;
+            pBase = sqlite3PcacheFetch(pPager->pPCache, pgno, 3);
+            if (pBase == 0) break;
+            pPg = sqlite3PcacheFetchFinish(pPager->pPCache, pgno, pBase);
+            if (pPg->pPager == 0)
+            {
+                pPg->pPager = pPager;
+                memcpy(pPg->pData, &aData[(pgno - iFirst) * pPager->pageSize],
+                       pPager->pageSize);
+                pPg->flags |= PGHDR_PRIORITY;
+                pager_set_pagehash(pPg);
+                pagerWarmRecord(pPager, pgno);
+                nRoom--;
+            }
+            sqlite3PcacheRelease(pPg);
+        }
+        if (i < j) break;
+    }
+    pPager->nWarmNew = 0;
+
+    sqlite3_free(aData);
+    sqlite3_free(aList);
+    sqlite3_free(pFile);
+    sqlite3_free(zWarm);
+    sqlite3EndBenignMalloc();
+}
+
 /*
 ** This function is a no-op if the pager is in exclusive mode and not
 ** in the ERROR state. Otherwise, it switches the pager to PAGER_OPEN
@@ -1917,6 +2328,7 @@ static void pager_unlock(Pager * pPager)
 
     sqlite3BitvecDestroy(pPager->pInJournal);
     pPager->pInJournal = 0;
+    pPager->nJrnlBuf = 0;
     releaseAllSavepoints(pPager);
 
     if (pagerUseWal(pPager))
@@ -1994,6 +2406,13 @@ static void pager_unlock(Pager * pPager)
     pPager->journalOff = 0;
     pPager->journalHdr = 0;
     pPager->setMaster = 0;
+
+    /* Unless in exclusive locking mode, the database lock has been
+    ** released. See pagerWarmSave() for the cost of this. */
+    if (pPager->nWarmNew >= PAGER_WARM_SAVE_STEP)
+    {
+        pagerWarmSave(pPager);
+    }
 }
 
 /*
@@ -2138,6 +2557,7 @@ static int pager_end_transaction(Pager * pPager, int hasMaster, int bCommit)
     }
 
     releaseAllSavepoints(pPager);
+    pPager->nJrnlBuf = 0;
     assert(isOpen(pPager->jfd) || pPager->pInJournal == 0
            || (sqlite3OsDeviceCharacteristics(pPager->fd)&SQLITE_IOCAP_BATCH_ATOMIC)
           );
@@ -2929,6 +3349,285 @@ static void setSectorSize(Pager * pPager)
     }
 }
 
+/*
+** Maximum number of adjacent pages written to the database file by a
+** single call to sqlite3OsWritev() from pager_write_pagelist().
+*/
+#ifndef PAGER_WRITEV_MAX
+# define PAGER_WRITEV_MAX 64
+#endif
+
+/*
+** Write the nRun page images in apRun[] to the database file, the first
+** to page iRun and the rest to the pages that directly follow it.
+*/
+static int pagerWriteRun(Pager * pPager, Pgno iRun, int nRun, const void ** apRun)
+{
+    i64 offset = (iRun - 1) * (i64)pPager->pageSize;
+    if (nRun == 1)
+    {
+        return sqlite3OsWrite(pPager->fd, apRun[0], pPager->pageSize, offset);
+    }
+    return sqlite3OsWritev(pPager->fd, nRun, apRun, pPager->pageSize, offset);
+}
+
+/*
+** Number of journal records read, verified and written back as a unit
+** by the batched hot-journal playback below. Set this to 0 to play back
+** hot journals one record at a time using pager_playback_one_page().
+*/
+#ifndef SQLITE_PLAYBACK_BATCH
+# define SQLITE_PLAYBACK_BATCH 256
+#endif
+
+/*
+** Largest xRead() made by batched playback. VFS implementations need not
+** support arbitrarily large reads; the unix VFS asserts that reads are
+** smaller than 128KiB.
+*/
+#define PAGER_PLAYBACK_READ 65536
+
+/*
+** Batched hot-journal playback.
+**
+** A hot journal is rolled back by pager_playback(). Unless memory is
+** short or a codec is in use, it does not call pager_playback_one_page()
+** once per record. Instead, each segment of the journal is processed in
+** chunks of up to SQLITE_PLAYBACK_BATCH records, as follows:
+**
+**   1. The records in the chunk are read with as few xRead() calls as
+**      possible, each of up to PAGER_PLAYBACK_READ bytes.
+**
+**   2. The chunk is checked in record order, as pager_playback_one_page()
+**      would do. An invalid page number or a bad checksum ends playback
+**      of the journal at that record.
+**
+**   3. The valid records of the chunk are sorted by page number and
+**      written to the database file. Each run of adjacent pages is written
+**      with a single sqlite3OsWritev() call. If a page appears more than
+**      once, only the image from its last record is written, which gives
+**      the same final result as writing the records in order.
+**
+** These steps only reorder writes made before the database file is synced
+** and the journal is deleted. A crash part way through leaves the journal
+** in place, so the crash-safety guarantees are unchanged.
+*/
+typedef struct PagerPlayback PagerPlayback;
+struct PagerPlayback
+{
+    Pager * pPager;             /* Pager being played back */
+    u8 * aBuf;                  /* Journal records read from offset iOff */
+    u64 * aKey;                 /* (pgno<<32)+record index for each page */
+    i64 iOff;                   /* Journal file offset of aBuf[0] */
+    int nRec;                   /* Number of records in aBuf[] */
+    int nDone;                  /* OUT: Records processed */
+    int nPage;                  /* OUT: Entries in aKey[] */
+    int bStop;                  /* OUT: True if the journal ends in aBuf[] */
+};
+
+/*
+** Allocate the buffers used for batched playback of a hot journal by
+** pager pPager. Return NULL if batched playback is not possible, in
+** which case the journal is played back one record at a time.
+*/
+static PagerPlayback * pagerPlaybackAlloc(Pager * pPager)
+{
+    PagerPlayback * p;
+    i64 szBuf = SQLITE_PLAYBACK_BATCH * (i64)JOURNAL_PG_SZ(pPager);
+    i64 szKey = SQLITE_PLAYBACK_BATCH * (i64)sizeof(u64);
+
+    if (SQLITE_PLAYBACK_BATCH <= 0) return 0;
+#ifdef SQLITE_HAS_CODEC
+    if (pPager->xCodec) return 0;
+#endif
+    sqlite3BeginBenignMalloc();
+    p = (PagerPlayback *)sqlite3MallocZero(sizeof(PagerPlayback) + szBuf + szKey);
+    sqlite3EndBenignMalloc();
+    if (p)
+    {
+        p->pPager = pPager;
+        p->aKey = (u64 *)&p[1];
+        p->aBuf = (u8 *)&p->aKey[SQLITE_PLAYBACK_BATCH];
+    }
+    return p;
+}
+
+/*
+** Read up to SQLITE_PLAYBACK_BATCH of the *pnLeft records that remain in
+** the current journal segment into chunk p, starting at Pager.journalOff.
+** Only records that lie entirely within the szJ byte journal file are
+** read. If the segment extends past the end of the file, set *pbShort.
+*/
+static int pagerPlaybackRead(
+    Pager * pPager,               /* Pager being played back */
+    PagerPlayback * p,            /* Buffers to read records into */
+    u32 * pnLeft,                 /* IN/OUT: Records left in the segment */
+    i64 szJ,                      /* Size of the journal file in bytes */
+    int * pbShort                 /* OUT: Set if the journal is truncated */
+)
+{
+    i64 szRec = JOURNAL_PG_SZ(pPager);
+    i64 nAvail = (szJ - pPager->journalOff) / szRec;
+    int nRec = (int)MIN(*pnLeft, SQLITE_PLAYBACK_BATCH);
+    int rc = SQLITE_OK;
+
+    if (nAvail < nRec)
+    {
+        nRec = (int)MAX(nAvail, 0);
+        *pbShort = 1;
+    }
+    p->iOff = pPager->journalOff;
+    p->nRec = nRec;
+    if (nRec > 0)
+    {
+        i64 nByte = nRec * szRec;
+        i64 iDone;
+        for (iDone = 0; rc == SQLITE_OK && iDone < nByte; iDone += PAGER_PLAYBACK_READ)
+        {
+            int nRead = (int)MIN(nByte - iDone, PAGER_PLAYBACK_READ);
+            rc = sqlite3OsRead(pPager->jfd, &p->aBuf[iDone], nRead, p->iOff + iDone);
+        }
+        pPager->journalOff += nByte;
+        *pnLeft -= nRec;
+    }
+    return rc;
+}
+
+/*
+** Check the records in chunk p in order, stopping at the first invalid
+** one, and fill in p->aKey[] with the records to write back, sorted by
+** page number.
+*/
+static void pagerPlaybackVerify(PagerPlayback * p)
+{
+    Pager * pPager = p->pPager;
+    int szRec = JOURNAL_PG_SZ(pPager);
+    int nKey = 0;
+    int iGap, i, j;
+
+    p->bStop = 0;
+    for (i = 0; i < p->nRec; i++)
+    {
+        const u8 * aRec = &p->aBuf[i * szRec];
+        Pgno pgno = sqlite3Get4byte(aRec);
+        i64 iEnd = p->iOff + (i + 1) * (i64)szRec;
+        if (pgno == 0 || pgno == PAGER_MJ_PGNO(pPager)
+                || (pgno <= pPager->dbSize
+                    && pager_cksum(pPager, &aRec[4]) != sqlite3Get4byte(&aRec[szRec - 4]))
+           )
+        {
+            p->bStop = 1;
+            break;
+        }
+        if (pgno <= pPager->dbSize && (pPager->noSync || iEnd <= pPager->journalHdr))
+        {
+            p->aKey[nKey++] = ((u64)pgno << 32) + i;
+        }
+    }
+    p->nDone = i;
+
+    /* Sort the keys. Then, of each group of records for the same page,
+    ** keep only the last.
+    */
+    for (iGap = nKey / 2; iGap > 0; iGap = iGap / 2)
+    {
+        for (i = iGap; i < nKey; i++)
+        {
+            u64 t = p->aKey[i];
+            for (j = i; j >= iGap && p->aKey[j - iGap] > t; j -= iGap)
+            {
+                p->aKey[j] = p->aKey[j - iGap];
+            }
+            p->aKey[j] = t;
+        }
+    }
+    for (i = j = 0; i < nKey; i++)
+    {
+        if (i + 1 < nKey && (p->aKey[i] >> 32) == (p->aKey[i + 1] >> 32)) continue;
+        p->aKey[j++] = p->aKey[i];
+    }
+    p->nPage = j;
+}
+
+/*
+** Write the pages selected by pagerPlaybackVerify() from chunk p to the
+** database file.
+*/
+static int pagerPlaybackWrite(Pager * pPager, PagerPlayback * p)
+{
+    int szRec = JOURNAL_PG_SZ(pPager);
+    const void * apRun[PAGER_WRITEV_MAX];
+    int nRun = 0;
+    Pgno iRun = 0;
+    int rc = SQLITE_OK;
+    int i;
+
+    for (i = 0; rc == SQLITE_OK && i < p->nPage; i++)
+    {
+        Pgno pgno = (Pgno)(p->aKey[i] >> 32);
+        u8 * aData = &p->aBuf[(int)(p->aKey[i] & 0xffffffff) * szRec + 4];
+
+        /* When playing back page 1, restore the nReserve setting */
+        if (pgno == 1 && pPager->nReserve != aData[20])
+        {
+            pPager->nReserve = aData[20];
+            pagerReportSize(pPager);
+        }
+        if (nRun > 0 && (nRun == PAGER_WRITEV_MAX || pgno != iRun + nRun))
+        {
+            rc = pagerWriteRun(pPager, iRun, nRun, apRun);
+            nRun = 0;
+        }
+        if (nRun == 0) iRun = pgno;
+        apRun[nRun++] = aData;
+        if (pgno > pPager->dbFileSize)
+        {
+            pPager->dbFileSize = pgno;
+        }
+        if (pPager->pBackup)
+        {
+            sqlite3BackupUpdate(pPager->pBackup, pgno, aData);
+        }
+    }
+    if (rc == SQLITE_OK && nRun > 0)
+    {
+        rc = pagerWriteRun(pPager, iRun, nRun, apRun);
+    }
+    return rc;
+}
+
+/*
+** Play back the nRec records of the journal segment that starts at
+** Pager.journalOff using the buffers in p. *pnPlayback is incremented
+** by the number of records processed. The return value is interpreted
+** in the same way as that of pager_playback_one_page(), except that
+** SQLITE_OK means the whole segment was played back.
+*/
+static int pagerPlaybackBatch(
+    Pager * pPager,               /* Pager being played back */
+    PagerPlayback * p,            /* Buffers from pagerPlaybackAlloc() */
+    u32 nRec,                     /* Number of records in the segment */
+    i64 szJ,                      /* Size of the journal file in bytes */
+    int * pnPlayback              /* IN/OUT: Count of records processed */
+)
+{
+    int bShort = 0;
+    int rc;
+
+    assert(pPager->eState == PAGER_OPEN && isOpen(pPager->fd));
+    rc = pagerPlaybackRead(pPager, p, &nRec, szJ, &bShort);
+    while (rc == SQLITE_OK && p->nRec > 0)
+    {
+        pagerPlaybackVerify(p);
+        rc = pagerPlaybackWrite(pPager, p);
+        *pnPlayback += p->nDone;
+        if (rc == SQLITE_OK && p->bStop) rc = SQLITE_DONE;
+        if (rc == SQLITE_OK) rc = pagerPlaybackRead(pPager, p, &nRec, szJ, &bShort);
+    }
+    if (rc == SQLITE_OK && bShort) rc = SQLITE_IOERR_SHORT_READ;
+    return rc;
+}
+
 /*
 ** Playback the journal and thus restore the database file to
 ** the state it was in before we started making changes.
@@ -2999,12 +3698,17 @@ static int pager_playback(Pager * pPager, int isHot)
     int needPagerReset;      /* True to reset page prior to first page rollback */
     int nPlayback = 0;       /* Total number of pages restored from journal */
     u32 savedPageSize = pPager->pageSize;
+    PagerPlayback * pBatch = 0; /* Buffers for batched hot-journal playback */
 
     /* Figure out how many records are in the journal.  Abort early if
     ** the journal is empty.
     */
     assert(isOpen(pPager->jfd));
-    rc = sqlite3OsFileSize(pPager->jfd, &szJ);
+    rc = pagerJournalFlush(pPager);
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3OsFileSize(pPager->jfd, &szJ);
+    }
     if (rc != SQLITE_OK)
     {
         goto end_playback;
@@ -3101,8 +3805,34 @@ static int pager_playback(Pager * pPager, int isHot)
         }
 
         /* Copy original pages out of the journal and back into the
-        ** database file and/or page cache.
+        ** database file and/or page cache. Hot journals are played back
+        ** in batches if possible. See pagerPlaybackBatch() for details.
         */
+        if (isHot && pBatch == 0)
+        {
+            pBatch = pagerPlaybackAlloc(pPager);
+        }
+        if (pBatch)
+        {
+            if (needPagerReset)
+            {
+                pager_reset(pPager);
+                needPagerReset = 0;
+            }
+            rc = pagerPlaybackBatch(pPager, pBatch, nRec, szJ, &nPlayback);
+            if (rc == SQLITE_DONE)
+            {
+                pPager->journalOff = szJ;
+                rc = SQLITE_OK;
+            }
+            else if (rc != SQLITE_OK)
+            {
+                /* See the comments on the sequential loop below */
+                if (rc == SQLITE_IOERR_SHORT_READ) rc = SQLITE_OK;
+                goto end_playback;
+            }
+            continue;
+        }
         for (u = 0; u < nRec; u++)
         {
             if (needPagerReset)
@@ -3148,6 +3878,7 @@ static int pager_playback(Pager * pPager, int isHot)
     assert(0);
 
 end_playback:
+    sqlite3_free(pBatch);
     if (rc == SQLITE_OK)
     {
         rc = sqlite3PagerSetPagesize(pPager, &savedPageSize, -1);
@@ -3663,6 +4394,9 @@ static int pagerPlaybackSavepoint(Pager * pPager, PagerSavepoint * pSavepoint)
     assert(pPager->eState != PAGER_ERROR);
     assert(pPager->eState >= PAGER_WRITER_LOCKED);
 
+    rc = pagerJournalFlush(pPager);
+    if (rc != SQLITE_OK) return rc;
+
     /* Allocate a bitvec to use to store the set of pages rolled back */
     if (pSavepoint)
     {
@@ -4331,8 +5065,8 @@ void sqlite3PagerTruncateImage(Pager * pPager, Pgno nPage)
 */
 static int pagerSyncHotJournal(Pager * pPager)
 {
-    int rc = SQLITE_OK;
-    if (!pPager->noSync)
+    int rc = pagerJournalFlush(pPager);
+    if (rc == SQLITE_OK && !pPager->noSync)
     {
         rc = sqlite3OsSync(pPager->jfd, SQLITE_SYNC_NORMAL);
     }
@@ -4368,6 +5102,7 @@ static int pagerAcquireMapPage(
         *ppPage = p = pPager->pMmapFreelist;
         pPager->pMmapFreelist = p->pDirty;
         p->pDirty = 0;
+        p->flags = PGHDR_MMAP;
         assert(pPager->nExtra >= 8);
         memset(p->pExtra, 0, 8);
     }
@@ -4523,6 +5258,12 @@ int sqlite3PagerClose(Pager * pPager, sqlite3 * db)
     enable_simulated_io_errors();
     PAGERTRACE(("CLOSE %d\n", PAGERID(pPager)));
     IOTRACE(("CLOSE %p\n", pPager))
+    if (pPager->nWarmNew > 0)
+    {
+        pagerWarmSave(pPager);
+    }
+    sqlite3_free(pPager->aWarm);
+    sqlite3_free(pPager->aJrnlBuf);
     sqlite3OsClose(pPager->jfd);
     sqlite3OsClose(pPager->fd);
     sqlite3PageFree(pTmp);
@@ -4604,6 +5345,8 @@ static int syncJournal(Pager * pPager, int newHdr)
 
     rc = sqlite3PagerExclusiveLock(pPager);
     if (rc != SQLITE_OK) return rc;
+    rc = pagerJournalFlush(pPager);
+    if (rc != SQLITE_OK) return rc;
 
     if (!pPager->noSync)
     {
@@ -4731,8 +5474,9 @@ static int syncJournal(Pager * pPager, int newHdr)
 ** written out.
 **
 ** Once the lock has been upgraded and, if necessary, the file opened,
-** the pages are written out to the database file in list order. Writing
-** a page is skipped if it meets either of the following criteria:
+** the pages are written out to the database file in list order. Each
+** run of adjacent pages is written using a single sqlite3OsWritev() call.
+** Writing a page is skipped if it meets either of the following criteria:
 **
 **   * The page number is greater than Pager.dbSize, or
 **   * The PGHDR_DONT_WRITE flag is set on the page.
@@ -4749,6 +5493,10 @@ static int syncJournal(Pager * pPager, int newHdr)
 static int pager_write_pagelist(Pager * pPager, PgHdr * pList)
 {
     int rc = SQLITE_OK;                  /* Return code */
+    const void * apRun[PAGER_WRITEV_MAX]; /* Data for a run of adjacent pages */
+    int nRun = 0;                        /* Number of pages in apRun[] */
+    int mxRun = PAGER_WRITEV_MAX;        /* Maximum number of pages per run */
+    Pgno iRun = 0;                       /* Page number of apRun[0] */
 
     /* This function is only called for rollback pagers in WRITER_DBMOD state. */
     assert(!pagerUseWal(pPager));
@@ -4756,6 +5504,12 @@ static int pager_write_pagelist(Pager * pPager, PgHdr * pList)
     assert(pPager->eLock == EXCLUSIVE_LOCK);
     assert(isOpen(pPager->fd) || pList->pDirty == 0);
 
+    /* No database page may be overwritten while the journal record that
+    ** holds its original content is still in the journal buffer.
+    */
+    rc = pagerJournalFlush(pPager);
+    if (rc != SQLITE_OK) return rc;
+
     /* If the file is a temp-file has not yet been opened, open it now. It
     ** is not possible for rc to be other than SQLITE_OK if this branch
     ** is taken, as pager_wait_on_lock() is a no-op for temp-files.
@@ -4780,6 +5534,16 @@ static int pager_write_pagelist(Pager * pPager, PgHdr * pList)
         pPager->dbHintSize = pPager->dbSize;
     }
 
+#ifdef SQLITE_HAS_CODEC
+    /* The codec may return the same buffer for every page it encodes, so
+    ** each page is written before the next one is encoded. */
+    if (pPager->xCodec) mxRun = 1;
+#endif
+
+    /* The list is sorted by page number. Pages are not written as they are
+    ** visited. Instead, each run of adjacent pages is accumulated in apRun[]
+    ** and written by a single call to pagerWriteRun() once the run ends.
+    */
     while (rc == SQLITE_OK && pList)
     {
         Pgno pgno = pList->pgno;
@@ -4794,17 +5558,28 @@ static int pager_write_pagelist(Pager * pPager, PgHdr * pList)
         */
         if (pgno <= pPager->dbSize && 0 == (pList->flags & PGHDR_DONT_WRITE))
         {
-            i64 offset = (pgno - 1) * (i64)pPager->pageSize; /* Offset to write */
             char * pData;                                  /* Data to write */
 
             assert((pList->flags & PGHDR_NEED_SYNC) == 0);
             if (pList->pgno == 1) pager_write_changecounter(pList);
 
+            /* Write out the current run if this page cannot be added to it.
+            ** This must be done before the page is encoded, as the codec may
+            ** reuse the buffer that holds the last page of the run.
+            */
+            if (nRun > 0 && (nRun == mxRun || pgno != iRun + nRun))
+            {
+                rc = pagerWriteRun(pPager, iRun, nRun, apRun);
+                nRun = 0;
+                if (rc != SQLITE_OK) break;
+            }
+
             /* Encode the database */
             CODEC2(pPager, pList->pData, pgno, 6, return SQLITE_NOMEM_BKPT, pData);
 
-            /* Write out the page data. */
-            rc = sqlite3OsWrite(pPager->fd, pData, pPager->pageSize, offset);
+            /* Add the page to the current run */
+            if (nRun == 0) iRun = pgno;
+            apRun[nRun++] = pData;
 
             /* If page 1 was just written, update Pager.dbFileVers to match
             ** the value now stored in the database file. If writing this
@@ -4835,6 +5610,10 @@ static int pager_write_pagelist(Pager * pPager, PgHdr * pList)
         pager_set_pagehash(pList);
         pList = pList->pDirty;
     }
+    if (rc == SQLITE_OK && nRun > 0)
+    {
+        rc = pagerWriteRun(pPager, iRun, nRun, apRun);
+    }
 
     return rc;
 }
@@ -5301,6 +6080,8 @@ int sqlite3PagerOpen(
 #endif
             }
             pPager->noLock = sqlite3_uri_boolean(zFilename, "nolock", 0);
+            pPager->bWarm = (u8)sqlite3_uri_boolean(zFilename, "cache_warmup",
+                                                    SQLITE_DEFAULT_CACHE_WARMUP);
             if ((iDc & SQLITE_IOCAP_IMMUTABLE) != 0
                     || sqlite3_uri_boolean(zFilename, "immutable", 0))
             {
@@ -5323,6 +6104,7 @@ int sqlite3PagerOpen(
         */
 act_like_temp_file:
         tempFile = 1;
+        pPager->bWarm = 0;                 /* No side file for temp files */
         pPager->eState = PAGER_READER;     /* Pretend we already have a lock */
         pPager->eLock = EXCLUSIVE_LOCK;    /* Pretend we are in EXCLUSIVE mode */
         pPager->noLock = 1;                /* Do no locking */
@@ -5410,6 +6192,7 @@ act_like_temp_file:
     {
         pPager->journalMode = PAGER_JOURNALMODE_MEMORY;
     }
+    if (memJM) pPager->bWarm = 0;
     /* pPager->xBusyHandler = 0; */
     /* pPager->pBusyHandlerArg = 0; */
     pPager->xReiniter = xReinit;
@@ -5820,6 +6603,20 @@ failed:
     {
         pPager->eState = PAGER_READER;
         pPager->hasHeldSharedLock = 1;
+
+        /* Preload the hot page set recorded by an earlier connection, if
+        ** any. This is only done for rollback-mode databases read through
+        ** the page cache.
+        */
+        if (pPager->bWarm && !pPager->bWarmLoaded
+                && !pagerUseWal(pPager) && !USEFETCH(pPager)
+#ifdef SQLITE_HAS_CODEC
+                && pPager->xCodec == 0
+#endif
+           )
+        {
+            pagerWarmLoad(pPager);
+        }
     }
     return rc;
 }
@@ -6423,12 +7220,27 @@ static SQLITE_NOINLINE int pagerAddPageToRollbackJournal(PgHdr * pPg)
     */
     pPg->flags |= PGHDR_NEED_SYNC;
 
-    rc = write32bits(pPager->jfd, iOff, pPg->pgno);
-    if (rc != SQLITE_OK) return rc;
-    rc = sqlite3OsWrite(pPager->jfd, pData2, pPager->pageSize, iOff + 4);
-    if (rc != SQLITE_OK) return rc;
-    rc = write32bits(pPager->jfd, iOff + pPager->pageSize + 4, cksum);
-    if (rc != SQLITE_OK) return rc;
+    if (pagerUseJournalBuffer(pPager))
+    {
+        u8 aRec[4];
+        put32bits(aRec, pPg->pgno);
+        rc = pagerJournalAppend(pPager, aRec, 4, iOff);
+        if (rc != SQLITE_OK) return rc;
+        rc = pagerJournalAppend(pPager, pData2, pPager->pageSize, iOff + 4);
+        if (rc != SQLITE_OK) return rc;
+        put32bits(aRec, cksum);
+        rc = pagerJournalAppend(pPager, aRec, 4, iOff + pPager->pageSize + 4);
+        if (rc != SQLITE_OK) return rc;
+    }
+    else
+    {
+        rc = write32bits(pPager->jfd, iOff, pPg->pgno);
+        if (rc != SQLITE_OK) return rc;
+        rc = sqlite3OsWrite(pPager->jfd, pData2, pPager->pageSize, iOff + 4);
+        if (rc != SQLITE_OK) return rc;
+        rc = write32bits(pPager->jfd, iOff + pPager->pageSize + 4, cksum);
+        if (rc != SQLITE_OK) return rc;
+    }
 
     IOTRACE(("JOUT %p %d %lld %d\n", pPager, pPg->pgno,
              pPager->journalOff, pPager->pageSize));
@@ -6740,6 +7552,34 @@ void sqlite3PagerDontWrite(PgHdr * pPg)
     }
 }
 
+/*
+** Set or clear the priority hint on page pPg. Once the page is no longer
+** in use, the page cache keeps pages with the hint set in memory in
+** preference to other pages, within a reserved share of the cache. The
+** hint is cleared automatically when the page cache reuses the buffer
+** for a different page. Memory mapped pages are not held by the page
+** cache, so the hint does not apply to them.
+*/
+void sqlite3PagerPriority(PgHdr * pPg, int bPriority)
+{
+    if (pPg->flags & PGHDR_MMAP)
+    {
+        return;
+    }
+    if (bPriority)
+    {
+        if (pPg->pPager->bWarm && (pPg->flags & PGHDR_PRIORITY) == 0)
+        {
+            pagerWarmRecord(pPg->pPager, pPg->pgno);
+        }
+        pPg->flags |= PGHDR_PRIORITY;
+    }
+    else
+    {
+        pPg->flags &= ~PGHDR_PRIORITY;
+    }
+}
+
 /*
 ** This routine is called to increment the value of the database file
 ** change-counter, stored as a 4-byte big-endian integer starting at
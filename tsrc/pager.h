@@ -156,6 +156,7 @@ void sqlite3PagerUnrefPageOne(DbPage*);
 /* Operations on page references. */
 int sqlite3PagerWrite(DbPage*);
 void sqlite3PagerDontWrite(DbPage*);
+void sqlite3PagerPriority(DbPage*, int);
 int sqlite3PagerMovepage(Pager*,DbPage*,Pgno,int);
 int sqlite3PagerPageRefcount(DbPage*);
 void *sqlite3PagerGetData(DbPage *); 
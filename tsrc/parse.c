@@ -2683,6 +2683,8 @@ static YYACTIONTYPE yy_reduce(
 {
   if( yymsp[0].minor.yy0.n==5 && sqlite3_strnicmp(yymsp[0].minor.yy0.z,"rowid",5)==0 ){
     yymsp[-1].minor.yy502 = TF_WithoutRowid | TF_NoVisibleRowid;
+  }else if( yymsp[0].minor.yy0.n==6 && sqlite3_strnicmp(yymsp[0].minor.yy0.z,"varint",6)==0 ){
+    yymsp[-1].minor.yy502 = TF_Fixed;
   }else{
     yymsp[-1].minor.yy502 = 0;
     sqlite3ErrorMsg(pParse, "unknown table option: %.*s", yymsp[0].minor.yy0.n, yymsp[0].minor.yy0.z);
@@ -0,0 +1,931 @@
+/*
+** 2026-10-18
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+******************************************************************************
+**
+** This file contains an implementation of the "partition" virtual table.
+**
+** A partition table stores its rows in a set of ordinary tables, one for
+** each range of values of an integer partition key.  It is created as
+** follows:
+**
+**    CREATE VIRTUAL TABLE segTable USING partition(
+**        startTime, 86400,
+**        devNo int1, channel int1, startTime int, stopTime int,
+**        INDEX(channel, startTime)
+**    );
+**
+** The first argument names the partition key column and the second is the
+** range of key values that each partition covers.  The remaining arguments
+** are column definitions, or INDEX(...) clauses that describe an index to
+** create on every partition.
+**
+** A row with key K is stored in the table "<name>_p<N>" where N is
+** floor(K/span).  Partition tables are created as rows are inserted into
+** them.  Queries with constraints on the partition key only visit the
+** partitions that can hold matching rows.
+**
+** The rowid of a partition table row is (N<<32)+R, where R is the rowid
+** of the row in its partition table.
+**
+** Old data is removed by dropping whole partitions, which releases all
+** of the pages of the partition and its indexes without visiting any
+** row.  For example:
+**
+**    DROP TABLE "segTable_p19700";
+*/
+
+#include "sqliteInt.h"   /* Requires access to internal data structures */
+#if (defined(SQLITE_ENABLE_PARTITION) || defined(SQLITE_TEST)) \
+    && !defined(SQLITE_OMIT_VIRTUALTABLE)
+
+typedef struct PartTable PartTable;
+typedef struct PartCursor PartCursor;
+
+/*
+** Partition numbers must fit in the upper 32 bits of a rowid, and the
+** rowid of a row within a partition table in the lower 32 bits.
+*/
+#define PART_MIN_PART     (-(((i64)1)<<31))
+#define PART_MAX_PART     ((((i64)1)<<31)-1)
+#define PART_MAX_ROWID    ((((i64)1)<<32)-1)
+#define PART_ROWID(N,R)   ((N)*(((i64)1)<<32) + (R))
+
+struct PartTable {
+  sqlite3_vtab base;              /* Base class.  Must be first */
+  sqlite3 *db;                    /* The database connection */
+  char *zDb;                      /* Schema holding the table */
+  char *zName;                    /* Name of the partition table */
+  char *zCols;                    /* Column definitions */
+  char **azCol;                   /* Dequoted column names */
+  int nCol;                       /* Number of columns */
+  int iKey;                       /* Index of the partition key column */
+  i64 nSpan;                      /* Range of keys in each partition */
+  char **azIdx;                   /* Column lists of per-partition indexes */
+  int nIdx;                       /* Number of entries in azIdx[] */
+  sqlite3_stmt *pInsert;          /* Cached INSERT into partition iInsert */
+  i64 iInsert;                    /* Partition that pInsert writes to */
+};
+
+struct PartCursor {
+  sqlite3_vtab_cursor base;       /* Base class.  Must be first */
+  sqlite3_stmt *pStmt;            /* Scan of the current partition */
+  char *zWhere;                   /* Constraints applied to each partition */
+  sqlite3_value **apArg;          /* Values bound to the constraints */
+  int nArg;                       /* Number of entries in apArg[] */
+  i64 *aPart;                     /* Partitions to visit, in order */
+  int nPart;                      /* Number of entries in aPart[] */
+  int iPart;                      /* Index of the current partition */
+  int bEof;                       /* True at EOF */
+};
+
+/*
+** Return the partition that holds key iKey.
+*/
+static i64 partNumber(PartTable *pTab, i64 iKey){
+  i64 iPart = iKey / pTab->nSpan;
+  if( iKey<0 && iPart*pTab->nSpan!=iKey ) iPart--;
+  return iPart;
+}
+
+/*
+** Split a rowid into its partition number and the rowid of the row
+** within the partition table.
+*/
+static i64 partFromRowid(i64 iRowid, i64 *piRowid){
+  *piRowid = (i64)((u64)iRowid & PART_MAX_ROWID);
+  return (iRowid - *piRowid) / (((i64)1)<<32);
+}
+
+/*
+** Return the length of the column name at the start of column
+** definition z.
+*/
+static int partNameLength(const char *z){
+  int n = 0;
+  char q = z[0];
+  if( q=='[' ) q = ']';
+  if( q=='"' || q=='\'' || q=='`' || q==']' ){
+    for(n=1; z[n]; n++){
+      if( z[n]==q ){
+        if( z[n+1]!=q || q==']' ) return n+1;
+        n++;
+      }
+    }
+    return n;
+  }
+  while( z[n] && !sqlite3Isspace(z[n]) ) n++;
+  return n;
+}
+
+/*
+** If z is an INDEX(...) argument, return a pointer to the first byte
+** following the "(" and set *pn to the length of the column list.
+** Otherwise return NULL.
+*/
+static const char *partIndexArg(const char *z, int *pn){
+  int n;
+  if( sqlite3_strnicmp(z, "index", 5) ) return 0;
+  z += 5;
+  while( sqlite3Isspace(z[0]) ) z++;
+  if( z[0]!='(' ) return 0;
+  z++;
+  n = sqlite3Strlen30(z);
+  while( n>0 && z[n-1]!=')' ) n--;
+  if( n==0 ) return 0;
+  *pn = n-1;
+  return z;
+}
+
+/*
+** Connect to or create a partition virtual table.
+*/
+static int partConnect(
+  sqlite3 *db,
+  void *pAux,
+  int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab,
+  char **pzErr
+){
+  PartTable *pTab = 0;
+  char *zKey = 0;
+  int rc = SQLITE_OK;
+  int i;
+
+  if( argc<6 ){
+    *pzErr = sqlite3_mprintf(
+        "partition: expected key column, span and column definitions"
+    );
+    return SQLITE_ERROR;
+  }
+
+  pTab = (PartTable*)sqlite3_malloc64(sizeof(PartTable)
+      + (argc-5)*sizeof(char*)*2
+  );
+  if( pTab==0 ) return SQLITE_NOMEM_BKPT;
+  memset(pTab, 0, sizeof(PartTable));
+  pTab->db = db;
+  pTab->azCol = (char**)&pTab[1];
+  pTab->azIdx = &pTab->azCol[argc-5];
+  pTab->iKey = -1;
+  pTab->zDb = sqlite3_mprintf("%s", argv[1]);
+  pTab->zName = sqlite3_mprintf("%s", argv[2]);
+  zKey = sqlite3_mprintf("%s", argv[3]);
+  if( pTab->zDb==0 || pTab->zName==0 || zKey==0 ){
+    rc = SQLITE_NOMEM_BKPT;
+    goto connect_out;
+  }
+  sqlite3Dequote(zKey);
+
+  if( sqlite3Atoi64(argv[4], &pTab->nSpan, sqlite3Strlen30(argv[4]),
+                    SQLITE_UTF8)
+   || pTab->nSpan<=0
+  ){
+    *pzErr = sqlite3_mprintf("partition: span must be a positive integer");
+    rc = SQLITE_ERROR;
+    goto connect_out;
+  }
+
+  for(i=5; i<argc && rc==SQLITE_OK; i++){
+    const char *zIdx;
+    int n;
+    if( (zIdx = partIndexArg(argv[i], &n))!=0 ){
+      pTab->azIdx[pTab->nIdx] = sqlite3_mprintf("%.*s", n, zIdx);
+      if( pTab->azIdx[pTab->nIdx++]==0 ) rc = SQLITE_NOMEM_BKPT;
+      continue;
+    }
+    pTab->zCols = sqlite3_mprintf("%z%s%s",
+        pTab->zCols, pTab->zCols ? ", " : "", argv[i]
+    );
+    pTab->azCol[pTab->nCol] = sqlite3_mprintf("%.*s",
+        partNameLength(argv[i]), argv[i]
+    );
+    if( pTab->zCols==0 || pTab->azCol[pTab->nCol]==0 ){
+      rc = SQLITE_NOMEM_BKPT;
+    }else{
+      sqlite3Dequote(pTab->azCol[pTab->nCol]);
+      if( sqlite3StrICmp(pTab->azCol[pTab->nCol], zKey)==0 ){
+        pTab->iKey = pTab->nCol;
+      }
+    }
+    pTab->nCol++;
+  }
+  if( rc==SQLITE_OK && pTab->nCol==0 ){
+    *pzErr = sqlite3_mprintf("partition: no columns");
+    rc = SQLITE_ERROR;
+  }
+  if( rc==SQLITE_OK && pTab->iKey<0 ){
+    *pzErr = sqlite3_mprintf("partition: no such column: %s", zKey);
+    rc = SQLITE_ERROR;
+  }
+  if( rc==SQLITE_OK ){
+    char *zSql = sqlite3_mprintf("CREATE TABLE x(%s)", pTab->zCols);
+    if( zSql==0 ){
+      rc = SQLITE_NOMEM_BKPT;
+    }else{
+      rc = sqlite3_declare_vtab(db, zSql);
+      sqlite3_free(zSql);
+    }
+  }
+
+connect_out:
+  sqlite3_free(zKey);
+  if( rc!=SQLITE_OK ){
+    pTab->base.pModule = 0;
+    for(i=0; i<pTab->nCol; i++) sqlite3_free(pTab->azCol[i]);
+    for(i=0; i<pTab->nIdx; i++) sqlite3_free(pTab->azIdx[i]);
+    sqlite3_free(pTab->zCols);
+    sqlite3_free(pTab->zName);
+    sqlite3_free(pTab->zDb);
+    sqlite3_free(pTab);
+    pTab = 0;
+  }
+  *ppVtab = (sqlite3_vtab*)pTab;
+  return rc;
+}
+
+/*
+** Disconnect from or destroy a partition virtual table.
+*/
+static int partDisconnect(sqlite3_vtab *pVtab){
+  PartTable *pTab = (PartTable*)pVtab;
+  int i;
+  sqlite3_finalize(pTab->pInsert);
+  for(i=0; i<pTab->nCol; i++) sqlite3_free(pTab->azCol[i]);
+  for(i=0; i<pTab->nIdx; i++) sqlite3_free(pTab->azIdx[i]);
+  sqlite3_free(pTab->zCols);
+  sqlite3_free(pTab->zName);
+  sqlite3_free(pTab->zDb);
+  sqlite3_free(pTab);
+  return SQLITE_OK;
+}
+
+/*
+** Run the SQL statement zSql, which is obtained from sqlite3_mprintf(),
+** and free it.
+*/
+static int partExec(PartTable *pTab, char *zSql){
+  int rc;
+  if( zSql==0 ) return SQLITE_NOMEM_BKPT;
+  rc = sqlite3_exec(pTab->db, zSql, 0, 0, 0);
+  sqlite3_free(zSql);
+  return rc;
+}
+
+/*
+** Find the partitions that may contain keys between iLo and iHi,
+** inclusive.  Store them in ascending order in a buffer obtained from
+** sqlite3_malloc64() and return it in *paPart.
+*/
+static int partList(
+  PartTable *pTab,
+  i64 iLo, i64 iHi,
+  i64 **paPart, int *pnPart
+){
+  sqlite3_stmt *pStmt = 0;
+  i64 *aPart = 0;
+  int nPart = 0;
+  int nAlloc = 0;
+  int nPrefix = sqlite3Strlen30(pTab->zName)+2;
+  char *zSql;
+  int rc;
+
+  zSql = sqlite3_mprintf(
+      "SELECT substr(name,%d) FROM \"%w\".sqlite_master"
+      " WHERE type='table' AND substr(name,1,%d)=%Q||'_p'"
+      " ORDER BY CAST(substr(name,%d) AS INTEGER)",
+      nPrefix+1, pTab->zDb, nPrefix, pTab->zName, nPrefix+1
+  );
+  if( zSql==0 ) return SQLITE_NOMEM_BKPT;
+  rc = sqlite3_prepare_v2(pTab->db, zSql, -1, &pStmt, 0);
+  sqlite3_free(zSql);
+  while( rc==SQLITE_OK && sqlite3_step(pStmt)==SQLITE_ROW ){
+    const char *z = (const char*)sqlite3_column_text(pStmt, 0);
+    i64 iPart;
+    if( z==0 || sqlite3Atoi64(z, &iPart, sqlite3Strlen30(z), SQLITE_UTF8) ){
+      continue;   /* Not a partition of this table */
+    }
+    if( iPart<iLo || iPart>iHi ) continue;
+    if( nPart>=nAlloc ){
+      i64 *aNew;
+      nAlloc = nAlloc ? nAlloc*2 : 16;
+      aNew = (i64*)sqlite3_realloc64(aPart, nAlloc*sizeof(i64));
+      if( aNew==0 ){
+        rc = SQLITE_NOMEM_BKPT;
+        break;
+      }
+      aPart = aNew;
+    }
+    aPart[nPart++] = iPart;
+  }
+  if( rc==SQLITE_OK ) rc = sqlite3_finalize(pStmt);
+  else sqlite3_finalize(pStmt);
+  if( rc!=SQLITE_OK ){
+    sqlite3_free(aPart);
+    aPart = 0;
+    nPart = 0;
+  }
+  *paPart = aPart;
+  *pnPart = nPart;
+  return rc;
+}
+
+/*
+** Create the table for partition iPart and its indexes if they do not
+** already exist.
+*/
+static int partCreate(PartTable *pTab, i64 iPart){
+  sqlite3_stmt *pStmt = 0;
+  char *zSql;
+  int bExists = 0;
+  int rc;
+  int i;
+
+  zSql = sqlite3_mprintf(
+      "SELECT 1 FROM \"%w\".sqlite_master"
+      " WHERE type='table' AND name='%q_p%lld'",
+      pTab->zDb, pTab->zName, iPart
+  );
+  if( zSql==0 ) return SQLITE_NOMEM_BKPT;
+  rc = sqlite3_prepare_v2(pTab->db, zSql, -1, &pStmt, 0);
+  sqlite3_free(zSql);
+  if( rc==SQLITE_OK ){
+    bExists = sqlite3_step(pStmt)==SQLITE_ROW;
+    rc = sqlite3_finalize(pStmt);
+  }
+  if( rc!=SQLITE_OK || bExists ) return rc;
+
+  rc = partExec(pTab, sqlite3_mprintf(
+      "CREATE TABLE \"%w\".\"%w_p%lld\"(%s)",
+      pTab->zDb, pTab->zName, iPart, pTab->zCols
+  ));
+  for(i=0; rc==SQLITE_OK && i<pTab->nIdx; i++){
+    rc = partExec(pTab, sqlite3_mprintf(
+        "CREATE INDEX \"%w\".\"%w_p%lld_i%d\" ON \"%w_p%lld\"(%s)",
+        pTab->zDb, pTab->zName, iPart, i, pTab->zName, iPart, pTab->azIdx[i]
+    ));
+  }
+  return rc;
+}
+
+/*
+** Constraint operators understood by partBestIndex() and partFilter().
+*/
+static const struct {
+  unsigned char eOp;              /* SQLITE_INDEX_CONSTRAINT_* value */
+  char cOp;                       /* Code used in idxStr */
+  const char *zOp;                /* SQL operator */
+} aPartOp[] = {
+  { SQLITE_INDEX_CONSTRAINT_EQ, '=', "="  },
+  { SQLITE_INDEX_CONSTRAINT_GT, '>', ">"  },
+  { SQLITE_INDEX_CONSTRAINT_LE, 'l', "<=" },
+  { SQLITE_INDEX_CONSTRAINT_LT, '<', "<"  },
+  { SQLITE_INDEX_CONSTRAINT_GE, 'g', ">=" },
+};
+
+/*
+** Usable constraints are passed to xFilter and applied to the scan of
+** each partition.  idxStr holds one "<op><column>," entry for each of
+** them.  The cost estimate favors plans that constrain the partition key
+** and so visit fewer partitions.
+*/
+static int partBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *pIdxInfo){
+  PartTable *pTab = (PartTable*)pVtab;
+  char *zPlan = 0;
+  double rCost = 1000000.0;
+  int nArg = 0;
+  int i, j;
+
+  for(i=0; i<pIdxInfo->nConstraint; i++){
+    struct sqlite3_index_constraint *p = &pIdxInfo->aConstraint[i];
+    if( p->usable==0 ) continue;
+    for(j=0; j<ArraySize(aPartOp) && aPartOp[j].eOp!=p->op; j++){}
+    if( j==ArraySize(aPartOp) ) continue;
+    if( p->iColumn<0 ){
+      /* Only rowid equality can be mapped onto a partition */
+      if( p->op!=SQLITE_INDEX_CONSTRAINT_EQ ) continue;
+      rCost = 1.0;
+      pIdxInfo->idxFlags |= SQLITE_INDEX_SCAN_UNIQUE;
+    }else if( p->iColumn==pTab->iKey ){
+      rCost /= (p->op==SQLITE_INDEX_CONSTRAINT_EQ) ? 100.0 : 10.0;
+    }else{
+      rCost /= (p->op==SQLITE_INDEX_CONSTRAINT_EQ) ? 10.0 : 3.0;
+    }
+    zPlan = sqlite3_mprintf("%z%c%d,", zPlan, aPartOp[j].cOp, p->iColumn);
+    if( zPlan==0 ) return SQLITE_NOMEM_BKPT;
+    pIdxInfo->aConstraintUsage[i].argvIndex = ++nArg;
+  }
+  if( rCost<1.0 ) rCost = 1.0;
+  pIdxInfo->idxNum = nArg;
+  pIdxInfo->idxStr = zPlan;
+  pIdxInfo->needToFreeIdxStr = 1;
+  pIdxInfo->estimatedCost = rCost;
+  pIdxInfo->estimatedRows = (sqlite3_int64)rCost;
+  return SQLITE_OK;
+}
+
+/*
+** Open a new cursor.
+*/
+static int partOpen(sqlite3_vtab *pVTab, sqlite3_vtab_cursor **ppCursor){
+  PartCursor *pCsr;
+  pCsr = (PartCursor*)sqlite3_malloc64(sizeof(PartCursor));
+  if( pCsr==0 ) return SQLITE_NOMEM_BKPT;
+  memset(pCsr, 0, sizeof(PartCursor));
+  pCsr->base.pVtab = pVTab;
+  pCsr->bEof = 1;
+  *ppCursor = (sqlite3_vtab_cursor*)pCsr;
+  return SQLITE_OK;
+}
+
+/*
+** Release all resources held by a cursor, leaving it at EOF.
+*/
+static void partResetCursor(PartCursor *pCsr){
+  int i;
+  sqlite3_finalize(pCsr->pStmt);
+  for(i=0; i<pCsr->nArg; i++) sqlite3_value_free(pCsr->apArg[i]);
+  sqlite3_free(pCsr->apArg);
+  sqlite3_free(pCsr->aPart);
+  sqlite3_free(pCsr->zWhere);
+  memset(&pCsr->pStmt, 0, sizeof(PartCursor)-offsetof(PartCursor, pStmt));
+  pCsr->bEof = 1;
+}
+
+/*
+** Close a cursor.
+*/
+static int partClose(sqlite3_vtab_cursor *pCursor){
+  PartCursor *pCsr = (PartCursor*)pCursor;
+  partResetCursor(pCsr);
+  sqlite3_free(pCsr);
+  return SQLITE_OK;
+}
+
+/*
+** Move the cursor to the first row of the next partition that has one,
+** or to EOF if there are no more such partitions.
+*/
+static int partNextPartition(PartCursor *pCsr){
+  PartTable *pTab = (PartTable*)pCsr->base.pVtab;
+  int rc = SQLITE_OK;
+  while( pCsr->iPart+1<pCsr->nPart ){
+    i64 iPart = pCsr->aPart[++pCsr->iPart];
+    char *zSql;
+    int i;
+    sqlite3_finalize(pCsr->pStmt);
+    pCsr->pStmt = 0;
+    zSql = sqlite3_mprintf("SELECT rowid, * FROM \"%w\".\"%w_p%lld\"%s",
+        pTab->zDb, pTab->zName, iPart, pCsr->zWhere
+    );
+    if( zSql==0 ) return SQLITE_NOMEM_BKPT;
+    rc = sqlite3_prepare_v2(pTab->db, zSql, -1, &pCsr->pStmt, 0);
+    sqlite3_free(zSql);
+    for(i=0; rc==SQLITE_OK && i<pCsr->nArg; i++){
+      rc = sqlite3_bind_value(pCsr->pStmt, i+1, pCsr->apArg[i]);
+    }
+    if( rc!=SQLITE_OK ) break;
+    rc = sqlite3_step(pCsr->pStmt);
+    if( rc==SQLITE_ROW ) return SQLITE_OK;
+    rc = sqlite3_reset(pCsr->pStmt);
+    if( rc!=SQLITE_OK ) break;
+  }
+  if( rc!=SQLITE_OK ){
+    sqlite3_free(pTab->base.zErrMsg);
+    pTab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pTab->db));
+  }
+  pCsr->bEof = 1;
+  return rc;
+}
+
+/*
+** Begin a scan.  Constraints on the partition key narrow the range of
+** partitions visited.  A rowid equality constraint selects a single row
+** of a single partition.
+*/
+static int partFilter(
+  sqlite3_vtab_cursor *pCursor,
+  int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv
+){
+  PartCursor *pCsr = (PartCursor*)pCursor;
+  PartTable *pTab = (PartTable*)pCursor->pVtab;
+  i64 iLo = SMALLEST_INT64;
+  i64 iHi = LARGEST_INT64;
+  const char *z = idxStr;
+  int rc;
+  int i;
+
+  partResetCursor(pCsr);
+  pCsr->zWhere = sqlite3_mprintf("");
+  if( argc>0 ){
+    pCsr->apArg = (sqlite3_value**)sqlite3_malloc64(argc*sizeof(sqlite3_value*));
+  }
+  if( pCsr->zWhere==0 || (argc>0 && pCsr->apArg==0) ) return SQLITE_NOMEM_BKPT;
+
+  for(i=0; i<argc; i++){
+    char cOp = *(z++);
+    int iCol = sqlite3Atoi(z);
+    int j;
+    while( *(z++)!=',' ){}
+    for(j=0; aPartOp[j].cOp!=cOp; j++){}
+
+    if( iCol<0 ){
+      i64 iRowid;
+      i64 iPart;
+      if( sqlite3_value_numeric_type(argv[i])!=SQLITE_INTEGER ){
+        iLo = 1; iHi = 0;
+        continue;
+      }
+      iPart = partFromRowid(sqlite3_value_int64(argv[i]), &iRowid);
+      if( iPart>iLo ) iLo = iPart;
+      if( iPart<iHi ) iHi = iPart;
+    }else{
+      if( iCol==pTab->iKey ){
+        int eType = sqlite3_value_numeric_type(argv[i]);
+        if( eType==SQLITE_INTEGER || eType==SQLITE_FLOAT ){
+          double r = sqlite3_value_double(argv[i]);
+          i64 iKey;
+          if( r<=(double)SMALLEST_INT64 ){
+            iKey = SMALLEST_INT64;
+          }else if( r>=(double)LARGEST_INT64 ){
+            iKey = LARGEST_INT64;
+          }else if( eType==SQLITE_INTEGER ){
+            iKey = sqlite3_value_int64(argv[i]);
+          }else{
+            iKey = (i64)r;
+            if( r<(double)iKey ) iKey--;
+          }
+          /* Bounds are conservative: rows are filtered again by the scan */
+          if( cOp=='=' || cOp=='>' || cOp=='g' ){
+            i64 iPart = partNumber(pTab, iKey);
+            if( iPart>iLo ) iLo = iPart;
+          }
+          if( cOp=='=' || cOp=='<' || cOp=='l' ){
+            i64 iPart = partNumber(pTab, iKey);
+            if( iPart<iHi ) iHi = iPart;
+          }
+        }
+      }
+    }
+    pCsr->apArg[pCsr->nArg] = sqlite3_value_dup(argv[i]);
+    if( pCsr->apArg[pCsr->nArg]==0 ) return SQLITE_NOMEM_BKPT;
+    pCsr->nArg++;
+    if( iCol<0 ){
+      /* Strip the partition number from the rowid */
+      pCsr->zWhere = sqlite3_mprintf("%z %s rowid=(?&%lld)", pCsr->zWhere,
+          pCsr->nArg==1 ? "WHERE" : "AND", PART_MAX_ROWID
+      );
+    }else{
+      pCsr->zWhere = sqlite3_mprintf("%z %s \"%w\" %s ?", pCsr->zWhere,
+          pCsr->nArg==1 ? "WHERE" : "AND", pTab->azCol[iCol], aPartOp[j].zOp
+      );
+    }
+    if( pCsr->zWhere==0 ) return SQLITE_NOMEM_BKPT;
+  }
+  assert( idxNum==argc );
+
+  pCsr->bEof = 0;
+  pCsr->iPart = -1;
+  if( iLo>iHi ){
+    pCsr->bEof = 1;
+    return SQLITE_OK;
+  }
+  rc = partList(pTab, iLo, iHi, &pCsr->aPart, &pCsr->nPart);
+  if( rc!=SQLITE_OK ) return rc;
+  return partNextPartition(pCsr);
+}
+
+/*
+** Advance a cursor to its next row.
+*/
+static int partNext(sqlite3_vtab_cursor *pCursor){
+  PartCursor *pCsr = (PartCursor*)pCursor;
+  int rc = sqlite3_step(pCsr->pStmt);
+  if( rc==SQLITE_ROW ) return SQLITE_OK;
+  rc = sqlite3_reset(pCsr->pStmt);
+  if( rc!=SQLITE_OK ){
+    pCsr->bEof = 1;
+    return rc;
+  }
+  return partNextPartition(pCsr);
+}
+
+static int partEof(sqlite3_vtab_cursor *pCursor){
+  PartCursor *pCsr = (PartCursor*)pCursor;
+  return pCsr->bEof;
+}
+
+static int partColumn(
+  sqlite3_vtab_cursor *pCursor,
+  sqlite3_context *ctx,
+  int i
+){
+  PartCursor *pCsr = (PartCursor*)pCursor;
+  sqlite3_result_value(ctx, sqlite3_column_value(pCsr->pStmt, i+1));
+  return SQLITE_OK;
+}
+
+static int partRowid(sqlite3_vtab_cursor *pCursor, sqlite_int64 *pRowid){
+  PartCursor *pCsr = (PartCursor*)pCursor;
+  *pRowid = PART_ROWID(pCsr->aPart[pCsr->iPart],
+                       sqlite3_column_int64(pCsr->pStmt, 0));
+  return SQLITE_OK;
+}
+
+/*
+** Delete the row with rowid iRowid.
+*/
+static int partDelete(PartTable *pTab, i64 iRowid){
+  i64 iPart = partFromRowid(iRowid, &iRowid);
+  return partExec(pTab, sqlite3_mprintf(
+      "DELETE FROM \"%w\".\"%w_p%lld\" WHERE rowid=%lld",
+      pTab->zDb, pTab->zName, iPart, iRowid
+  ));
+}
+
+/*
+** Bind the column values in apVal[] to parameters 2 and greater of
+** pStmt and the rowid iRowid, or NULL if iRowid is 0, to parameter 1.
+** Then run the statement.
+*/
+static int partWrite(
+  PartTable *pTab,
+  sqlite3_stmt *pStmt,
+  i64 iRowid,
+  sqlite3_value **apVal
+){
+  int rc;
+  int i;
+  rc = iRowid ? sqlite3_bind_int64(pStmt, 1, iRowid)
+              : sqlite3_bind_null(pStmt, 1);
+  for(i=0; rc==SQLITE_OK && i<pTab->nCol; i++){
+    rc = sqlite3_bind_value(pStmt, i+2, apVal[i]);
+  }
+  if( rc==SQLITE_OK ){
+    sqlite3_step(pStmt);
+    rc = sqlite3_reset(pStmt);
+  }
+  return rc;
+}
+
+/*
+** Insert a row into partition iPart.  If iRowid is not zero it is the
+** rowid to use within the partition table.  Return the rowid of the new
+** row within the partition table in *piRowid.
+*/
+static int partInsert(
+  PartTable *pTab,
+  i64 iPart,
+  i64 iRowid,
+  sqlite3_value **apVal,
+  i64 *piRowid
+){
+  int nRetry = 0;
+  int rc;
+  do{
+    if( pTab->pInsert==0 || pTab->iInsert!=iPart ){
+      char *zSql = 0;
+      int i;
+      sqlite3_finalize(pTab->pInsert);
+      pTab->pInsert = 0;
+      rc = partCreate(pTab, iPart);
+      if( rc!=SQLITE_OK ) return rc;
+      zSql = sqlite3_mprintf("INSERT INTO \"%w\".\"%w_p%lld\"(rowid",
+          pTab->zDb, pTab->zName, iPart
+      );
+      for(i=0; i<pTab->nCol; i++){
+        zSql = sqlite3_mprintf("%z, \"%w\"", zSql, pTab->azCol[i]);
+      }
+      zSql = sqlite3_mprintf("%z) VALUES(?1", zSql);
+      for(i=0; i<pTab->nCol; i++){
+        zSql = sqlite3_mprintf("%z, ?%d", zSql, i+2);
+      }
+      zSql = sqlite3_mprintf("%z)", zSql);
+      if( zSql==0 ) return SQLITE_NOMEM_BKPT;
+      rc = sqlite3_prepare_v3(pTab->db, zSql, -1, SQLITE_PREPARE_PERSISTENT,
+                              &pTab->pInsert, 0);
+      sqlite3_free(zSql);
+      if( rc!=SQLITE_OK ) return rc;
+      pTab->iInsert = iPart;
+    }
+    rc = partWrite(pTab, pTab->pInsert, iRowid, apVal);
+    if( rc==SQLITE_OK ){
+      *piRowid = sqlite3_last_insert_rowid(pTab->db);
+    }else if( (rc&0xff)!=SQLITE_CONSTRAINT ){
+      /* The cached statement may refer to a partition that has since been
+      ** dropped.  Recreate the partition and try once more. */
+      sqlite3_finalize(pTab->pInsert);
+      pTab->pInsert = 0;
+    }
+  }while( rc!=SQLITE_OK && (rc&0xff)!=SQLITE_CONSTRAINT && nRetry++==0 );
+  return rc;
+}
+
+/*
+** Update a row in place within partition iPart.
+*/
+static int partUpdateRow(
+  PartTable *pTab,
+  i64 iPart,
+  i64 iRowid,
+  sqlite3_value **apVal
+){
+  sqlite3_stmt *pStmt = 0;
+  char *zSql;
+  int rc;
+  int i;
+  zSql = sqlite3_mprintf("UPDATE \"%w\".\"%w_p%lld\" SET",
+      pTab->zDb, pTab->zName, iPart
+  );
+  for(i=0; i<pTab->nCol; i++){
+    zSql = sqlite3_mprintf("%z%s \"%w\"=?%d", zSql, i ? "," : "",
+        pTab->azCol[i], i+2
+    );
+  }
+  zSql = sqlite3_mprintf("%z WHERE rowid=?1", zSql);
+  if( zSql==0 ) return SQLITE_NOMEM_BKPT;
+  rc = sqlite3_prepare_v2(pTab->db, zSql, -1, &pStmt, 0);
+  sqlite3_free(zSql);
+  if( rc==SQLITE_OK ){
+    rc = partWrite(pTab, pStmt, iRowid, apVal);
+  }
+  sqlite3_finalize(pStmt);
+  return rc;
+}
+
+/*
+** The xUpdate method.  New rows are routed to the partition selected by
+** their key.  An UPDATE that moves a row to a different partition deletes
+** it and inserts it again, which gives the row a new rowid.
+*/
+static int partUpdate(
+  sqlite3_vtab *pVtab,
+  int argc,
+  sqlite3_value **argv,
+  sqlite_int64 *pRowid
+){
+  PartTable *pTab = (PartTable*)pVtab;
+  sqlite3_value *pKey;
+  i64 iPart;
+  i64 iRowid = 0;
+  i64 iOldPart = 0;
+  i64 iOldRowid = 0;
+  int rc = SQLITE_OK;
+
+  if( argc==1 ){
+    return partDelete(pTab, sqlite3_value_int64(argv[0]));
+  }
+  assert( argc==pTab->nCol+2 );
+
+  pKey = argv[2+pTab->iKey];
+  if( sqlite3_value_numeric_type(pKey)!=SQLITE_INTEGER ){
+    sqlite3_free(pVtab->zErrMsg);
+    pVtab->zErrMsg = sqlite3_mprintf(
+        "partition key %s.%s must be an integer",
+        pTab->zName, pTab->azCol[pTab->iKey]
+    );
+    return SQLITE_CONSTRAINT;
+  }
+  iPart = partNumber(pTab, sqlite3_value_int64(pKey));
+  if( iPart<PART_MIN_PART || iPart>PART_MAX_PART ){
+    sqlite3_free(pVtab->zErrMsg);
+    pVtab->zErrMsg = sqlite3_mprintf(
+        "partition key %s.%s out of range", pTab->zName, pTab->azCol[pTab->iKey]
+    );
+    return SQLITE_CONSTRAINT;
+  }
+
+  /* An UPDATE that does not assign the rowid passes the old rowid in
+  ** argv[1].  The row receives a new rowid if it changes partition. */
+  if( sqlite3_value_type(argv[1])!=SQLITE_NULL
+   && (sqlite3_value_type(argv[0])==SQLITE_NULL
+       || sqlite3_value_int64(argv[0])!=sqlite3_value_int64(argv[1]))
+  ){
+    if( partFromRowid(sqlite3_value_int64(argv[1]), &iRowid)!=iPart
+     || iRowid==0
+    ){
+      sqlite3_free(pVtab->zErrMsg);
+      pVtab->zErrMsg = sqlite3_mprintf(
+          "rowid does not belong to the partition of the row"
+      );
+      return SQLITE_CONSTRAINT;
+    }
+  }
+
+  if( sqlite3_value_type(argv[0])!=SQLITE_NULL ){
+    iOldPart = partFromRowid(sqlite3_value_int64(argv[0]), &iOldRowid);
+    if( iOldPart==iPart && (iRowid==0 || iRowid==iOldRowid) ){
+      return partUpdateRow(pTab, iPart, iOldRowid, &argv[2]);
+    }
+    rc = partDelete(pTab, sqlite3_value_int64(argv[0]));
+  }
+  if( rc==SQLITE_OK ){
+    rc = partInsert(pTab, iPart, iRowid, &argv[2], &iRowid);
+  }
+  if( rc==SQLITE_OK && iRowid>PART_MAX_ROWID ){
+    sqlite3_free(pVtab->zErrMsg);
+    pVtab->zErrMsg = sqlite3_mprintf("partition %lld of %s is full",
+        iPart, pTab->zName
+    );
+    rc = SQLITE_FULL;
+  }
+  if( rc==SQLITE_OK ){
+    *pRowid = PART_ROWID(iPart, iRowid);
+  }else if( pVtab->zErrMsg==0 ){
+    pVtab->zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pTab->db));
+  }
+  return rc;
+}
+
+/*
+** Drop all partitions, then disconnect.
+*/
+static int partDestroy(sqlite3_vtab *pVtab){
+  PartTable *pTab = (PartTable*)pVtab;
+  i64 *aPart = 0;
+  int nPart = 0;
+  int rc;
+  int i;
+  sqlite3_finalize(pTab->pInsert);
+  pTab->pInsert = 0;
+  rc = partList(pTab, SMALLEST_INT64, LARGEST_INT64, &aPart, &nPart);
+  for(i=0; rc==SQLITE_OK && i<nPart; i++){
+    rc = partExec(pTab, sqlite3_mprintf("DROP TABLE \"%w\".\"%w_p%lld\"",
+        pTab->zDb, pTab->zName, aPart[i]
+    ));
+  }
+  sqlite3_free(aPart);
+  if( rc==SQLITE_OK ) partDisconnect(pVtab);
+  return rc;
+}
+
+/*
+** Rename all partitions to match the new name of the table.
+*/
+static int partRename(sqlite3_vtab *pVtab, const char *zNew){
+  PartTable *pTab = (PartTable*)pVtab;
+  i64 *aPart = 0;
+  int nPart = 0;
+  int rc;
+  int i;
+  sqlite3_finalize(pTab->pInsert);
+  pTab->pInsert = 0;
+  rc = partList(pTab, SMALLEST_INT64, LARGEST_INT64, &aPart, &nPart);
+  for(i=0; rc==SQLITE_OK && i<nPart; i++){
+    rc = partExec(pTab, sqlite3_mprintf(
+        "ALTER TABLE \"%w\".\"%w_p%lld\" RENAME TO \"%w_p%lld\"",
+        pTab->zDb, pTab->zName, aPart[i], zNew, aPart[i]
+    ));
+  }
+  sqlite3_free(aPart);
+  if( rc==SQLITE_OK ){
+    char *zName = sqlite3_mprintf("%s", zNew);
+    if( zName==0 ) return SQLITE_NOMEM_BKPT;
+    sqlite3_free(pTab->zName);
+    pTab->zName = zName;
+  }
+  return rc;
+}
+
+/*
+** Invoke this routine to register the "partition" virtual table module
+*/
+int sqlite3PartitionInit(sqlite3 *db){
+  static sqlite3_module partition_module = {
+    0,                            /* iVersion */
+    partConnect,                  /* xCreate */
+    partConnect,                  /* xConnect */
+    partBestIndex,                /* xBestIndex */
+    partDisconnect,               /* xDisconnect */
+    partDestroy,                  /* xDestroy */
+    partOpen,                     /* xOpen - open a cursor */
+    partClose,                    /* xClose - close a cursor */
+    partFilter,                   /* xFilter - configure scan constraints */
+    partNext,                     /* xNext - advance a cursor */
+    partEof,                      /* xEof - check for end of scan */
+    partColumn,                   /* xColumn - read data */
+    partRowid,                    /* xRowid - read data */
+    partUpdate,                   /* xUpdate */
+    0,                            /* xBegin */
+    0,                            /* xSync */
+    0,                            /* xCommit */
+    0,                            /* xRollback */
+    0,                            /* xFindMethod */
+    partRename,                   /* xRename */
+    0,                            /* xSavepoint */
+    0,                            /* xRelease */
+    0,                            /* xRollbackTo */
+  };
+  return sqlite3_create_module(db, "partition", &partition_module, 0);
+}
+#elif defined(SQLITE_ENABLE_PARTITION)
+int sqlite3PartitionInit(sqlite3 *db){ return SQLITE_OK; }
+#endif /* SQLITE_ENABLE_PARTITION */
@@ -792,14 +792,12 @@ int sqlite3PcachePagecount(PCache *pCache){
   return sqlite3GlobalConfig.pcache2.xPagecount(pCache->pCache);
 }
 
-#ifdef SQLITE_TEST
 /*
 ** Get the suggested cache-size value.
 */
 int sqlite3PcacheGetCachesize(PCache *pCache){
   return numberOfCachePages(pCache);
 }
-#endif
 
 /*
 ** Set the suggested cache-size value.
@@ -57,6 +57,7 @@ struct PgHdr {
 #define PGHDR_MMAP            0x020  /* This is an mmap page object */
 
 #define PGHDR_WAL_APPEND      0x040  /* Appended to wal file */
+#define PGHDR_PRIORITY        0x080  /* Keep in cache in preference to others */
 
 /* Initialize and shutdown the page cache subsystem */
 int sqlite3PcacheInitialize(void);
@@ -151,9 +152,7 @@ int sqlite3PcachePageSanity(PgHdr*);
 ** of the suggested cache-sizes.
 */
 void sqlite3PcacheSetCachesize(PCache *, int);
-#ifdef SQLITE_TEST
 int sqlite3PcacheGetCachesize(PCache *);
-#endif
 
 /* Set or get the suggested spill-size for the specified pager-cache.
 **
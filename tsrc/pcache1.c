@@ -98,6 +98,9 @@ struct PgHdr1 {
   unsigned int iKey;             /* Key value (page number) */
   u8 isBulkLocal;                /* This page from bulk local storage */
   u8 isAnchor;                   /* This is the PGroup.lru element */
+  u8 isReused;                   /* Fetched again since it was loaded */
+  u8 isProbation;                /* On the PGroup.lruIn list */
+  u8 isPriority;                 /* On the PGroup.lruHi list */
   PgHdr1 *pNext;                 /* Next in hash table chain */
   PCache1 *pCache;               /* Cache that currently owns this page */
   PgHdr1 *pLruNext;              /* Next in LRU list of unpinned pages */
@@ -131,6 +134,36 @@ struct PgHdr1 {
 ** For mode (1), PGroup.mutex is NULL.  For mode (2) there is only a single
 ** PGroup which is the pcache1.grp global variable and its mutex is
 ** SQLITE_MUTEX_STATIC_LRU.
+**
+** If SQLITE_PCACHE_SHARDS is greater than one, mode (2) instead uses that
+** many PGroups, pcache1.grp followed by the elements of pcache1.aShard[],
+** each with its own mutex, LRU list and purgeable page accounting.  Each
+** PCache is then split into one sub-cache per PGroup, and page number P
+** is always held by sub-cache (P % SQLITE_PCACHE_SHARDS).  Threads using
+** different connections then only contend for the group mutex when they
+** happen to touch pages in the same shard.
+**
+** Mode (1) caches are never sharded.  They have no group mutex, so there
+** is no contention to reduce.  In threadsafe builds, mode (2) is only
+** used with SQLITE_ENABLE_MEMORY_MANAGEMENT, so SQLITE_PCACHE_SHARDS has
+** no effect on other threadsafe builds.
+**
+** Unpinned pages are kept on two lists. With SQLITE_PCACHE_POLICY_LRU,
+** every unpinned page goes on the PGroup.lru list, and pages are recycled
+** from its tail in least-recently-used order. With SQLITE_PCACHE_POLICY_2Q
+** a page that has not been fetched again since it was loaded goes on the
+** probationary PGroup.lruIn list instead. Pages are recycled from the tail
+** of lruIn while it holds more than a quarter of nMaxPage pages, so that 
+** the pages read once by a large scan are discarded before those on the
+** lru list that are in repeated use. The lruIn list is always drained
+** first by the LRU policy, which allows the policy to change at any time.
+**
+** Pages that the pager has marked with PGHDR_PRIORITY (b-tree interior 
+** pages and page 1) are placed on a third list, PGroup.lruHi, when they
+** are unpinned, as long as it holds fewer than SQLITE_PCACHE_PRIORITY_PCT
+** percent of nMaxPage pages. Once it is full, its least recently used 
+** page moves to the head of the lru list to make room. Pages are only 
+** recycled from lruHi when both other lists are empty.
 */
 struct PGroup {
   sqlite3_mutex *mutex;          /* MUTEX_STATIC_LRU or NULL */
@@ -138,7 +171,11 @@ struct PGroup {
   unsigned int nMinPage;         /* Sum of nMin for purgeable caches */
   unsigned int mxPinned;         /* nMaxpage + 10 - nMinPage */
   unsigned int nPurgeable;       /* Number of purgeable pages allocated */
+  unsigned int nLruIn;           /* Number of pages on the lruIn list */
+  unsigned int nLruHi;           /* Number of pages on the lruHi list */
   PgHdr1 lru;                    /* The beginning and end of the LRU list */
+  PgHdr1 lruIn;                  /* The 2Q probationary list */
+  PgHdr1 lruHi;                  /* Reserved list for priority pages */
 };
 
 /* Each page cache is an instance of the following object.  Every
@@ -176,8 +213,29 @@ struct PCache1 {
   PgHdr1 **apHash;                    /* Hash table for fast lookup by key */
   PgHdr1 *pFree;                      /* List of unused pcache-local pages */
   void *pBulk;                        /* Bulk memory used by pcache-local */
+#if SQLITE_PCACHE_SHARDS>1
+  PCache1 *aShard;                    /* Sub-caches, one per PGroup, or NULL */
+#endif
 };
 
+/*
+** Number of PGroups used by mode (2).  See the PGroup comment above.
+*/
+#ifndef SQLITE_PCACHE_SHARDS
+# define SQLITE_PCACHE_SHARDS 1
+#endif
+#if SQLITE_PCACHE_SHARDS<1 || SQLITE_PCACHE_SHARDS>64
+# error "SQLITE_PCACHE_SHARDS must be between 1 and 64"
+#endif
+
+/*
+** Percentage of each PGroup's nMaxPage reserved for unpinned pages marked
+** with PGHDR_PRIORITY.  Zero disables the reserved list.
+*/
+#ifndef SQLITE_PCACHE_PRIORITY_PCT
+# define SQLITE_PCACHE_PRIORITY_PCT 25
+#endif
+
 /*
 ** Free slots in the allocator used to divide up the global page cache
 ** buffer provided using the SQLITE_CONFIG_PAGECACHE mechanism.
@@ -191,6 +249,9 @@ struct PgFreeslot {
 */
 static SQLITE_WSD struct PCacheGlobal {
   PGroup grp;                    /* The global PGroup for mode (2) */
+#if SQLITE_PCACHE_SHARDS>1
+  PGroup aShard[SQLITE_PCACHE_SHARDS-1];  /* Additional mode (2) PGroups */
+#endif
 
   /* Variables related to SQLITE_CONFIG_PAGECACHE settings.  The
   ** szSlot, nSlot, pStart, pEnd, nReserve, and isInit values are all
@@ -235,6 +296,18 @@ static SQLITE_WSD struct PCacheGlobal {
 # define PCACHE1_MIGHT_USE_GROUP_MUTEX 1
 #endif
 
+/*
+** Return the mode (2) PGroup for shard iShard.
+*/
+#if SQLITE_PCACHE_SHARDS>1
+static PGroup *pcache1ShardGroup(int iShard){
+  assert( iShard>=0 && iShard<SQLITE_PCACHE_SHARDS );
+  return iShard==0 ? &pcache1.grp : &pcache1.aShard[iShard-1];
+}
+#else
+# define pcache1ShardGroup(X) (&pcache1.grp)
+#endif
+
 /******************************************************************************/
 /******** Page Allocation/SQLITE_CONFIG_PCACHE Related Functions **************/
 
@@ -419,7 +492,7 @@ static PgHdr1 *pcache1AllocPage(PCache1 *pCache, int benignMalloc){
     ** is because it might call sqlite3_release_memory(), which assumes that 
     ** this mutex is not held. */
     assert( pcache1.separateCache==0 );
-    assert( pCache->pGroup==&pcache1.grp );
+    assert( pCache->pGroup==&pcache1.grp || SQLITE_PCACHE_SHARDS>1 );
     pcache1LeaveMutex(pCache->pGroup);
 #endif
     if( benignMalloc ){ sqlite3BeginBenignMalloc(); }
@@ -572,10 +645,52 @@ static PgHdr1 *pcache1PinPage(PgHdr1 *pPage){
   pPage->pLruPrev = 0;
   assert( pPage->isAnchor==0 );
   assert( pPage->pCache->pGroup->lru.isAnchor==1 );
+  if( pPage->isProbation ){
+    assert( pPage->pCache->pGroup->nLruIn>0 );
+    pPage->pCache->pGroup->nLruIn--;
+    pPage->isProbation = 0;
+  }else if( pPage->isPriority ){
+    assert( pPage->pCache->pGroup->nLruHi>0 );
+    pPage->pCache->pGroup->nLruHi--;
+    pPage->isPriority = 0;
+  }
   pPage->pCache->nRecyclable--;
   return pPage;
 }
 
+/*
+** Return the unpinned page in PGroup pGroup that should be recycled next,
+** according to the current replacement policy, or NULL if there are no
+** unpinned pages. The page is not removed from the LRU list.
+**
+** The PGroup mutex must be held when this function is called.
+*/
+static PgHdr1 *pcache1LruVictim(PGroup *pGroup){
+  PgHdr1 *p = pGroup->lru.pLruPrev;
+  assert( sqlite3_mutex_held(pGroup->mutex) );
+  if( pGroup->nLruIn>0 && (p->isAnchor
+   || sqlite3GlobalConfig.ePcachePolicy!=SQLITE_PCACHE_POLICY_2Q
+   || pGroup->nLruIn>pGroup->nMaxPage/4)
+  ){
+    p = pGroup->lruIn.pLruPrev;
+  }
+  if( p->isAnchor ){
+    p = pGroup->lruHi.pLruPrev;
+  }
+  return p->isAnchor ? 0 : p;
+}
+
+/*
+** Insert unpinned page pPage at the head of the list that begins with
+** anchor pAnchor.
+*/
+static void pcache1LruInsert(PgHdr1 *pAnchor, PgHdr1 *pPage){
+  PgHdr1 **ppFirst = &pAnchor->pLruNext;
+  pPage->pLruPrev = pAnchor;
+  (pPage->pLruNext = *ppFirst)->pLruPrev = pPage;
+  *ppFirst = pPage;
+}
+
 
 /*
 ** Remove the page supplied as an argument from the hash table 
@@ -607,7 +722,7 @@ static void pcache1EnforceMaxPage(PCache1 *pCache){
   PgHdr1 *p;
   assert( sqlite3_mutex_held(pGroup->mutex) );
   while( pGroup->nPurgeable>pGroup->nMaxPage
-      && (p=pGroup->lru.pLruPrev)->isAnchor==0
+      && (p=pcache1LruVictim(pGroup))!=0
   ){
     assert( p->pCache->pGroup==pGroup );
     assert( PAGE_IS_UNPINNED(p) );
@@ -711,6 +826,19 @@ static int pcache1Init(void *NotUsed){
   if( sqlite3GlobalConfig.bCoreMutex ){
     pcache1.grp.mutex = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_LRU);
     pcache1.mutex = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_PMEM);
+#if SQLITE_PCACHE_SHARDS>1
+    if( pcache1.separateCache==0 ){
+      int i;
+      for(i=0; i<SQLITE_PCACHE_SHARDS-1; i++){
+        pcache1.aShard[i].mutex = sqlite3MutexAlloc(SQLITE_MUTEX_FAST);
+        if( pcache1.aShard[i].mutex==0 ){
+          while( i-- ) sqlite3_mutex_free(pcache1.aShard[i].mutex);
+          memset(&pcache1, 0, sizeof(pcache1));
+          return SQLITE_NOMEM_BKPT;
+        }
+      }
+    }
+#endif
   }
 #endif
   if( pcache1.separateCache
@@ -722,6 +850,12 @@ static int pcache1Init(void *NotUsed){
     pcache1.nInitPage = 0;
   }
   pcache1.grp.mxPinned = 10;
+#if SQLITE_PCACHE_SHARDS>1
+  {
+    int i;
+    for(i=0; i<SQLITE_PCACHE_SHARDS-1; i++) pcache1.aShard[i].mxPinned = 10;
+  }
+#endif
   pcache1.isInit = 1;
   return SQLITE_OK;
 }
@@ -734,12 +868,59 @@ static int pcache1Init(void *NotUsed){
 static void pcache1Shutdown(void *NotUsed){
   UNUSED_PARAMETER(NotUsed);
   assert( pcache1.isInit!=0 );
+#if SQLITE_PCACHE_SHARDS>1
+  {
+    int i;
+    for(i=0; i<SQLITE_PCACHE_SHARDS-1; i++){
+      sqlite3_mutex_free(pcache1.aShard[i].mutex);
+    }
+  }
+#endif
   memset(&pcache1, 0, sizeof(pcache1));
 }
 
 /* forward declaration */
 static void pcache1Destroy(sqlite3_pcache *p);
 
+/*
+** Initialize the zeroed cache object pCache as a member of PGroup pGroup.
+** Return false if the initial hash table cannot be allocated.
+*/
+static int pcache1InitCache(
+  PCache1 *pCache,      /* Cache to initialize */
+  PGroup *pGroup,       /* The group the cache belongs to */
+  int szPage,           /* Size of database content section */
+  int szExtra,          /* Extra space for each page */
+  int bPurgeable        /* True if the cache is purgeable */
+){
+  if( pGroup->lru.isAnchor==0 ){
+    pGroup->lru.isAnchor = 1;
+    pGroup->lru.pLruPrev = pGroup->lru.pLruNext = &pGroup->lru;
+    pGroup->lruIn.isAnchor = 1;
+    pGroup->lruIn.pLruPrev = pGroup->lruIn.pLruNext = &pGroup->lruIn;
+    pGroup->lruHi.isAnchor = 1;
+    pGroup->lruHi.pLruPrev = pGroup->lruHi.pLruNext = &pGroup->lruHi;
+  }
+  pCache->pGroup = pGroup;
+  pCache->szPage = szPage;
+  pCache->szExtra = szExtra;
+  pCache->szAlloc = szPage + szExtra + ROUND8(sizeof(PgHdr1));
+  pCache->bPurgeable = (bPurgeable ? 1 : 0);
+  pcache1EnterMutex(pGroup);
+  pcache1ResizeHash(pCache);
+  if( bPurgeable ){
+    pCache->nMin = 10;
+    pGroup->nMinPage += pCache->nMin;
+    pGroup->mxPinned = pGroup->nMaxPage + 10 - pGroup->nMinPage;
+    pCache->pnPurgeable = &pGroup->nPurgeable;
+  }else{
+    static unsigned int dummyCurrentPage;
+    pCache->pnPurgeable = &dummyCurrentPage;
+  }
+  pcache1LeaveMutex(pGroup);
+  return pCache->nHash!=0;
+}
+
 /*
 ** Implementation of the sqlite3_pcache.xCreate method.
 **
@@ -753,6 +934,33 @@ static sqlite3_pcache *pcache1Create(int szPage, int szExtra, int bPurgeable){
   assert( (szPage & (szPage-1))==0 && szPage>=512 && szPage<=65536 );
   assert( szExtra < 300 );
 
+#if SQLITE_PCACHE_SHARDS>1
+  if( pcache1.separateCache==0 ){
+    /* A sharded mode (2) cache. The object returned only dispatches to 
+    ** the sub-caches that follow it in memory. */
+    int i;
+    int bOk = 1;
+    sz = sizeof(PCache1)*(1+SQLITE_PCACHE_SHARDS);
+    pCache = (PCache1 *)sqlite3MallocZero(sz);
+    if( pCache ){
+      pCache->aShard = &pCache[1];
+      pCache->szPage = szPage;
+      pCache->szExtra = szExtra;
+      pCache->szAlloc = szPage + szExtra + ROUND8(sizeof(PgHdr1));
+      pCache->bPurgeable = (bPurgeable ? 1 : 0);
+      for(i=0; i<SQLITE_PCACHE_SHARDS; i++){
+        bOk &= pcache1InitCache(&pCache->aShard[i], pcache1ShardGroup(i),
+                                szPage, szExtra, bPurgeable);
+      }
+      if( !bOk ){
+        pcache1Destroy((sqlite3_pcache*)pCache);
+        pCache = 0;
+      }
+    }
+    return (sqlite3_pcache *)pCache;
+  }
+#endif
+
   sz = sizeof(PCache1) + sizeof(PGroup)*pcache1.separateCache;
   pCache = (PCache1 *)sqlite3MallocZero(sz);
   if( pCache ){
@@ -762,28 +970,7 @@ static sqlite3_pcache *pcache1Create(int szPage, int szExtra, int bPurgeable){
     }else{
       pGroup = &pcache1.grp;
     }
-    if( pGroup->lru.isAnchor==0 ){
-      pGroup->lru.isAnchor = 1;
-      pGroup->lru.pLruPrev = pGroup->lru.pLruNext = &pGroup->lru;
-    }
-    pCache->pGroup = pGroup;
-    pCache->szPage = szPage;
-    pCache->szExtra = szExtra;
-    pCache->szAlloc = szPage + szExtra + ROUND8(sizeof(PgHdr1));
-    pCache->bPurgeable = (bPurgeable ? 1 : 0);
-    pcache1EnterMutex(pGroup);
-    pcache1ResizeHash(pCache);
-    if( bPurgeable ){
-      pCache->nMin = 10;
-      pGroup->nMinPage += pCache->nMin;
-      pGroup->mxPinned = pGroup->nMaxPage + 10 - pGroup->nMinPage;
-      pCache->pnPurgeable = &pGroup->nPurgeable;
-    }else{
-      static unsigned int dummyCurrentPage;
-      pCache->pnPurgeable = &dummyCurrentPage;
-    }
-    pcache1LeaveMutex(pGroup);
-    if( pCache->nHash==0 ){
+    if( !pcache1InitCache(pCache, pGroup, szPage, szExtra, bPurgeable) ){
       pcache1Destroy((sqlite3_pcache*)pCache);
       pCache = 0;
     }
@@ -798,6 +985,18 @@ static sqlite3_pcache *pcache1Create(int szPage, int szExtra, int bPurgeable){
 */
 static void pcache1Cachesize(sqlite3_pcache *p, int nMax){
   PCache1 *pCache = (PCache1 *)p;
+#if SQLITE_PCACHE_SHARDS>1
+  if( pCache->aShard ){
+    /* Each shard receives an equal share of the limit, rounded up */
+    int i;
+    for(i=0; i<SQLITE_PCACHE_SHARDS; i++){
+      pcache1Cachesize((sqlite3_pcache*)&pCache->aShard[i],
+                       (nMax+SQLITE_PCACHE_SHARDS-1)/SQLITE_PCACHE_SHARDS);
+    }
+    pCache->nMax = nMax;
+    return;
+  }
+#endif
   if( pCache->bPurgeable ){
     PGroup *pGroup = pCache->pGroup;
     pcache1EnterMutex(pGroup);
@@ -817,6 +1016,15 @@ static void pcache1Cachesize(sqlite3_pcache *p, int nMax){
 */
 static void pcache1Shrink(sqlite3_pcache *p){
   PCache1 *pCache = (PCache1*)p;
+#if SQLITE_PCACHE_SHARDS>1
+  if( pCache->aShard ){
+    int i;
+    for(i=0; i<SQLITE_PCACHE_SHARDS; i++){
+      pcache1Shrink((sqlite3_pcache*)&pCache->aShard[i]);
+    }
+    return;
+  }
+#endif
   if( pCache->bPurgeable ){
     PGroup *pGroup = pCache->pGroup;
     int savedMaxPage;
@@ -835,6 +1043,15 @@ static void pcache1Shrink(sqlite3_pcache *p){
 static int pcache1Pagecount(sqlite3_pcache *p){
   int n;
   PCache1 *pCache = (PCache1*)p;
+#if SQLITE_PCACHE_SHARDS>1
+  if( pCache->aShard ){
+    int i;
+    for(i=n=0; i<SQLITE_PCACHE_SHARDS; i++){
+      n += pcache1Pagecount((sqlite3_pcache*)&pCache->aShard[i]);
+    }
+    return n;
+  }
+#endif
   pcache1EnterMutex(pCache->pGroup);
   n = pCache->nPage;
   pcache1LeaveMutex(pCache->pGroup);
@@ -877,11 +1094,10 @@ static SQLITE_NOINLINE PgHdr1 *pcache1FetchStage2(
 
   /* Step 4. Try to recycle a page. */
   if( pCache->bPurgeable
-   && !pGroup->lru.pLruPrev->isAnchor
    && ((pCache->nPage+1>=pCache->nMax) || pcache1UnderMemoryPressure(pCache))
+   && (pPage = pcache1LruVictim(pGroup))!=0
   ){
     PCache1 *pOther;
-    pPage = pGroup->lru.pLruPrev;
     assert( PAGE_IS_UNPINNED(pPage) );
     pcache1RemoveFromHash(pPage, 0);
     pcache1PinPage(pPage);
@@ -909,6 +1125,9 @@ static SQLITE_NOINLINE PgHdr1 *pcache1FetchStage2(
     pPage->pCache = pCache;
     pPage->pLruPrev = 0;
     pPage->pLruNext = 0;
+    pPage->isReused = 0;
+    pPage->isProbation = 0;
+    pPage->isPriority = 0;
     *(void **)pPage->page.pExtra = 0;
     pCache->apHash[h] = pPage;
     if( iKey>pCache->iMaxKey ){
@@ -994,6 +1213,7 @@ static PgHdr1 *pcache1FetchNoMutex(
   ** Otherwise (page not in hash and createFlag!=0) continue with
   ** subsequent steps to try to create the page. */
   if( pPage ){
+    pPage->isReused = 1;
     if( PAGE_IS_UNPINNED(pPage) ){
       return pcache1PinPage(pPage);
     }else{
@@ -1031,6 +1251,14 @@ static sqlite3_pcache_page *pcache1Fetch(
   PCache1 *pCache = (PCache1 *)p;
 #endif
 
+#if SQLITE_PCACHE_SHARDS>1
+  if( ((PCache1*)p)->aShard ){
+    p = (sqlite3_pcache*)&((PCache1*)p)->aShard[iKey % SQLITE_PCACHE_SHARDS];
+#if PCACHE1_MIGHT_USE_GROUP_MUTEX || defined(SQLITE_DEBUG)
+    pCache = (PCache1 *)p;
+#endif
+  }
+#endif
   assert( offsetof(PgHdr1,page)==0 );
   assert( pCache->bPurgeable || createFlag!=1 );
   assert( pCache->bPurgeable || pCache->nMin==0 );
@@ -1060,8 +1288,12 @@ static void pcache1Unpin(
 ){
   PCache1 *pCache = (PCache1 *)p;
   PgHdr1 *pPage = (PgHdr1 *)pPg;
-  PGroup *pGroup = pCache->pGroup;
+  PGroup *pGroup;
  
+#if SQLITE_PCACHE_SHARDS>1
+  if( pCache->aShard ) pCache = pPage->pCache;
+#endif
+  pGroup = pCache->pGroup;
   assert( pPage->pCache==pCache );
   pcache1EnterMutex(pGroup);
 
@@ -1074,17 +1306,85 @@ static void pcache1Unpin(
   if( reuseUnlikely || pGroup->nPurgeable>pGroup->nMaxPage ){
     pcache1RemoveFromHash(pPage, 1);
   }else{
-    /* Add the page to the PGroup LRU list. */
-    PgHdr1 **ppFirst = &pGroup->lru.pLruNext;
-    pPage->pLruPrev = &pGroup->lru;
-    (pPage->pLruNext = *ppFirst)->pLruPrev = pPage;
-    *ppFirst = pPage;
+    /* Add the page to the reserved list if the pager marked it as a
+    ** priority page, or to the probationary list if the 2Q policy is in 
+    ** use and it has only been used once. Otherwise add it to the PGroup
+    ** LRU list. The PgHdr that pcache.c keeps in pExtra holds the hint. */
+    unsigned int mxHi = (unsigned int)
+        (((u64)pGroup->nMaxPage * SQLITE_PCACHE_PRIORITY_PCT)/100);
+    if( (((PgHdr*)pPage->page.pExtra)->flags & PGHDR_PRIORITY) && mxHi>0 ){
+      if( pGroup->nLruHi>=mxHi ){
+        PgHdr1 *pOld = pGroup->lruHi.pLruPrev;
+        assert( pOld->isPriority );
+        pOld->pLruPrev->pLruNext = pOld->pLruNext;
+        pOld->pLruNext->pLruPrev = pOld->pLruPrev;
+        pOld->isPriority = 0;
+        pGroup->nLruHi--;
+        pcache1LruInsert(&pGroup->lru, pOld);
+      }
+      pcache1LruInsert(&pGroup->lruHi, pPage);
+      pPage->isPriority = 1;
+      pGroup->nLruHi++;
+    }else if( pPage->isReused==0
+     && sqlite3GlobalConfig.ePcachePolicy==SQLITE_PCACHE_POLICY_2Q
+    ){
+      pcache1LruInsert(&pGroup->lruIn, pPage);
+      pPage->isProbation = 1;
+      pGroup->nLruIn++;
+    }else{
+      pcache1LruInsert(&pGroup->lru, pPage);
+    }
     pCache->nRecyclable++;
   }
 
   pcache1LeaveMutex(pCache->pGroup);
 }
 
+#if SQLITE_PCACHE_SHARDS>1
+/*
+** Move pinned page pPage from the sub-cache that currently holds it to 
+** sub-cache pTo, giving it the new key iNew.  The mutexes of both PGroups
+** are held, and always obtained in the same order, while this happens.
+**
+** The hash table of pTo is never grown here, as that would require its
+** mutex to be released. The next xFetch on pTo takes care of that.
+*/
+static void pcache1MoveShard(PgHdr1 *pPage, PCache1 *pTo, unsigned int iNew){
+  PCache1 *pFrom = pPage->pCache;
+  PGroup *pFirst = pFrom->pGroup;
+  PGroup *pSecond = pTo->pGroup;
+  unsigned int h;
+
+  assert( pFirst!=pSecond );
+  assert( PAGE_IS_PINNED(pPage) );
+  assert( pFrom->szAlloc==pTo->szAlloc );
+  if( pFirst>pSecond ){
+    PGroup *pTmp = pFirst;
+    pFirst = pSecond;
+    pSecond = pTmp;
+  }
+  pcache1EnterMutex(pFirst);
+  pcache1EnterMutex(pSecond);
+
+  pcache1RemoveFromHash(pPage, 0);
+  (*pFrom->pnPurgeable)--;
+
+  h = iNew % pTo->nHash;
+  pPage->iKey = iNew;
+  pPage->pCache = pTo;
+  pPage->pNext = pTo->apHash[h];
+  pTo->apHash[h] = pPage;
+  pTo->nPage++;
+  (*pTo->pnPurgeable)++;
+  if( iNew>pTo->iMaxKey ){
+    pTo->iMaxKey = iNew;
+  }
+
+  pcache1LeaveMutex(pSecond);
+  pcache1LeaveMutex(pFirst);
+}
+#endif
+
 /*
 ** Implementation of the sqlite3_pcache.xRekey method. 
 */
@@ -1099,6 +1399,17 @@ static void pcache1Rekey(
   PgHdr1 **pp;
   unsigned int h; 
   assert( pPage->iKey==iOld );
+
+#if SQLITE_PCACHE_SHARDS>1
+  if( pCache->aShard ){
+    PCache1 *pTo = &pCache->aShard[iNew % SQLITE_PCACHE_SHARDS];
+    pCache = pPage->pCache;
+    if( pTo!=pCache ){
+      pcache1MoveShard(pPage, pTo, iNew);
+      return;
+    }
+  }
+#endif
   assert( pPage->pCache==pCache );
 
   pcache1EnterMutex(pCache->pGroup);
@@ -1130,6 +1441,15 @@ static void pcache1Rekey(
 */
 static void pcache1Truncate(sqlite3_pcache *p, unsigned int iLimit){
   PCache1 *pCache = (PCache1 *)p;
+#if SQLITE_PCACHE_SHARDS>1
+  if( pCache->aShard ){
+    int i;
+    for(i=0; i<SQLITE_PCACHE_SHARDS; i++){
+      pcache1Truncate((sqlite3_pcache*)&pCache->aShard[i], iLimit);
+    }
+    return;
+  }
+#endif
   pcache1EnterMutex(pCache->pGroup);
   if( iLimit<=pCache->iMaxKey ){
     pcache1TruncateUnsafe(pCache, iLimit);
@@ -1139,12 +1459,10 @@ static void pcache1Truncate(sqlite3_pcache *p, unsigned int iLimit){
 }
 
 /*
-** Implementation of the sqlite3_pcache.xDestroy method. 
-**
-** Destroy a cache allocated using pcache1Create().
+** Discard all pages of cache pCache and remove it from its PGroup. The
+** hash table and any bulk allocation are freed but not pCache itself.
 */
-static void pcache1Destroy(sqlite3_pcache *p){
-  PCache1 *pCache = (PCache1 *)p;
+static void pcache1Clear(PCache1 *pCache){
   PGroup *pGroup = pCache->pGroup;
   assert( pCache->bPurgeable || (pCache->nMax==0 && pCache->nMin==0) );
   pcache1EnterMutex(pGroup);
@@ -1158,6 +1476,26 @@ static void pcache1Destroy(sqlite3_pcache *p){
   pcache1LeaveMutex(pGroup);
   sqlite3_free(pCache->pBulk);
   sqlite3_free(pCache->apHash);
+}
+
+/*
+** Implementation of the sqlite3_pcache.xDestroy method. 
+**
+** Destroy a cache allocated using pcache1Create().
+*/
+static void pcache1Destroy(sqlite3_pcache *p){
+  PCache1 *pCache = (PCache1 *)p;
+#if SQLITE_PCACHE_SHARDS>1
+  if( pCache->aShard ){
+    int i;
+    for(i=0; i<SQLITE_PCACHE_SHARDS; i++){
+      if( pCache->aShard[i].pGroup ) pcache1Clear(&pCache->aShard[i]);
+    }
+    sqlite3_free(pCache);
+    return;
+  }
+#endif
+  pcache1Clear(pCache);
   sqlite3_free(pCache);
 }
 
@@ -1213,21 +1551,25 @@ int sqlite3PcacheReleaseMemory(int nReq){
   assert( sqlite3_mutex_notheld(pcache1.grp.mutex) );
   assert( sqlite3_mutex_notheld(pcache1.mutex) );
   if( sqlite3GlobalConfig.pPage==0 ){
-    PgHdr1 *p;
-    pcache1EnterMutex(&pcache1.grp);
-    while( (nReq<0 || nFree<nReq)
-       &&  (p=pcache1.grp.lru.pLruPrev)!=0
-       &&  p->isAnchor==0
-    ){
-      nFree += pcache1MemSize(p->page.pBuf);
+    int i;
+    for(i=0; i<SQLITE_PCACHE_SHARDS && (nReq<0 || nFree<nReq); i++){
+      PGroup *pGroup = pcache1ShardGroup(i);
+      PgHdr1 *p;
+      pcache1EnterMutex(pGroup);
+      while( (nReq<0 || nFree<nReq)
+         &&  pGroup->lru.isAnchor
+         &&  (p=pcache1LruVictim(pGroup))!=0
+      ){
+        nFree += pcache1MemSize(p->page.pBuf);
 #ifdef SQLITE_PCACHE_SEPARATE_HEADER
-      nFree += sqlite3MemSize(p);
+        nFree += sqlite3MemSize(p);
 #endif
-      assert( PAGE_IS_UNPINNED(p) );
-      pcache1PinPage(p);
-      pcache1RemoveFromHash(p, 1);
+        assert( PAGE_IS_UNPINNED(p) );
+        pcache1PinPage(p);
+        pcache1RemoveFromHash(p, 1);
+      }
+      pcache1LeaveMutex(pGroup);
     }
-    pcache1LeaveMutex(&pcache1.grp);
   }
   return nFree;
 }
@@ -1246,13 +1588,26 @@ void sqlite3PcacheStats(
 ){
   PgHdr1 *p;
   int nRecyclable = 0;
-  for(p=pcache1.grp.lru.pLruNext; p && !p->isAnchor; p=p->pLruNext){
-    assert( PAGE_IS_UNPINNED(p) );
-    nRecyclable++;
+  int i;
+  *pnCurrent = *pnMax = *pnMin = 0;
+  for(i=0; i<SQLITE_PCACHE_SHARDS; i++){
+    PGroup *pGroup = pcache1ShardGroup(i);
+    for(p=pGroup->lru.pLruNext; p && !p->isAnchor; p=p->pLruNext){
+      assert( PAGE_IS_UNPINNED(p) );
+      nRecyclable++;
+    }
+    for(p=pGroup->lruIn.pLruNext; p && !p->isAnchor; p=p->pLruNext){
+      assert( PAGE_IS_UNPINNED(p) );
+      nRecyclable++;
+    }
+    for(p=pGroup->lruHi.pLruNext; p && !p->isAnchor; p=p->pLruNext){
+      assert( PAGE_IS_UNPINNED(p) );
+      nRecyclable++;
+    }
+    *pnCurrent += pGroup->nPurgeable;
+    *pnMax += (int)pGroup->nMaxPage;
+    *pnMin += (int)pGroup->nMinPage;
   }
-  *pnCurrent = pcache1.grp.nPurgeable;
-  *pnMax = (int)pcache1.grp.nMaxPage;
-  *pnMin = (int)pcache1.grp.nMinPage;
   *pnRecyclable = nRecyclable;
 }
 #endif
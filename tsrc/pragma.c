@@ -543,6 +543,37 @@ void sqlite3Pragma(
     break;
   }
 
+#ifdef SQLITE_ENABLE_INDEX_PREFIX
+  /*
+  **  PRAGMA [schema.]prefix_compression
+  **  PRAGMA [schema.]prefix_compression=ON/OFF
+  **
+  ** The first form reports whether index leaf pages written by balancing
+  ** are compressed by storing the record prefix shared by their cells
+  ** once per page.  The second form changes the setting and reports the
+  ** new value.  Compressed pages are always readable, whatever the
+  ** setting, and balancing may still compress pages while it is off if
+  ** the cells of compressed pages would not fit otherwise.
+  */
+  case PragTyp_PREFIX_COMPRESSION: {
+    Btree *pBt = pDb->pBt;
+    int b = -1;
+    assert( pBt!=0 );
+    if( zRight ){
+      b = sqlite3GetBoolean(zRight, 0);
+    }
+    if( pId2->n==0 && b>=0 ){
+      int ii;
+      for(ii=0; ii<db->nDb; ii++){
+        sqlite3BtreePrefixCompression(db->aDb[ii].pBt, b);
+      }
+    }
+    b = sqlite3BtreePrefixCompression(pBt, b);
+    returnSingleInt(v, b);
+    break;
+  }
+#endif
+
   /*
   **  PRAGMA [schema.]max_page_count
   **  PRAGMA [schema.]max_page_count=N
@@ -734,6 +765,31 @@ void sqlite3Pragma(
   }
 #endif
 
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+  /*
+  **  PRAGMA [schema.]free_space_map
+  **  PRAGMA [schema.]free_space_map=ON/OFF
+  **
+  ** The first form reports whether the database records its free pages
+  ** in a free-space map rather than on the freelist.  The second form
+  ** determines the format of the database when it is created, or by the
+  ** next VACUUM.  A database with auto-vacuum enabled never has a
+  ** free-space map.
+  */
+  case PragTyp_FREE_SPACE_MAP: {
+    Btree *pBt = pDb->pBt;
+    assert( pBt!=0 );
+    if( !zRight ){
+      returnSingleInt(v, sqlite3BtreeGetFreemap(pBt));
+    }else{
+      int b = sqlite3GetBoolean(zRight, 0);
+      db->nextFreemap = (signed char)b;
+      sqlite3BtreeSetFreemap(pBt, b);
+    }
+    break;
+  }
+#endif
+
   /*
   **  PRAGMA [schema.]incremental_vacuum(N)
   **
@@ -757,6 +813,37 @@ void sqlite3Pragma(
 #endif
 
 #ifndef SQLITE_OMIT_PAGER_PRAGMAS
+  /*
+  **  PRAGMA [schema.]cache_policy
+  **  PRAGMA [schema.]cache_policy = 'lru'|'2q'
+  **
+  ** The second form selects the page replacement policy of the default
+  ** page cache.  Like SQLITE_CONFIG_PCACHE_POLICY, this is a process-wide
+  ** setting.  The page cache reads it without a mutex, so it should be
+  ** set before other threads start using SQLite.  Any other policy name
+  ** is an error.  Both forms return the name of the current policy along
+  ** with the number of page cache hits and misses recorded for the
+  ** schema when the statement runs, so that policies can be compared on
+  ** a workload.
+  */
+  case PragTyp_CACHE_POLICY: {
+    int ePolicy = -1;
+    if( zRight ){
+      if( sqlite3StrICmp(zRight, "lru")==0 ){
+        ePolicy = SQLITE_PCACHE_POLICY_LRU;
+      }else if( sqlite3StrICmp(zRight, "2q")==0 ){
+        ePolicy = SQLITE_PCACHE_POLICY_2Q;
+      }else{
+        sqlite3ErrorMsg(pParse, "unknown cache policy: %s", zRight);
+        break;
+      }
+    }
+    pParse->nMem = 3;
+    sqlite3VdbeAddOp3(v, OP_CachePolicy, iDb, 1, ePolicy);
+    sqlite3VdbeAddOp2(v, OP_ResultRow, 1, 3);
+    break;
+  }
+
   /*
   **  PRAGMA [schema.]cache_size
   **  PRAGMA [schema.]cache_size=N
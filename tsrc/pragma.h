@@ -52,6 +52,9 @@
 #define PragTyp_LOCK_STATUS                   44
 #define PragTyp_PARSER_TRACE                  45
 #define PragTyp_STATS                         46
+#define PragTyp_CACHE_POLICY                  47
+#define PragTyp_PREFIX_COMPRESSION            48
+#define PragTyp_FREE_SPACE_MAP                49
 
 /* Property flags associated with various pragma. */
 #define PragFlg_NeedSchema 0x01 /* Force schema load before running */
@@ -120,6 +123,9 @@ static const char *const pragCName[] = {
   /*  49 */ "timeout",     /* Used by: busy_timeout */
   /*  50 */ "database",    /* Used by: lock_status */
   /*  51 */ "status",     
+  /*  52 */ "policy",      /* Used by: cache_policy */
+  /*  53 */ "hit",        
+  /*  54 */ "miss",       
 };
 
 /* Definitions of all built-in pragmas */
@@ -168,6 +174,11 @@ static const PragmaName aPragmaName[] = {
   /* ColNames:  */ 49, 1,
   /* iArg:      */ 0 },
 #if !defined(SQLITE_OMIT_PAGER_PRAGMAS)
+ {/* zName:     */ "cache_policy",
+  /* ePragTyp:  */ PragTyp_CACHE_POLICY,
+  /* ePragFlg:  */ PragFlg_Result0|PragFlg_SchemaReq,
+  /* ColNames:  */ 52, 3,
+  /* iArg:      */ 0 },
  {/* zName:     */ "cache_size",
   /* ePragTyp:  */ PragTyp_CACHE_SIZE,
   /* ePragFlg:  */ PragFlg_NeedSchema|PragFlg_Result0|PragFlg_SchemaReq|PragFlg_NoColumns1,
@@ -293,6 +304,13 @@ static const PragmaName aPragmaName[] = {
   /* iArg:      */ SQLITE_ForeignKeys },
 #endif
 #endif
+#if defined(SQLITE_ENABLE_FREE_SPACE_MAP)
+ {/* zName:     */ "free_space_map",
+  /* ePragTyp:  */ PragTyp_FREE_SPACE_MAP,
+  /* ePragFlg:  */ PragFlg_NeedSchema|PragFlg_Result0|PragFlg_SchemaReq|PragFlg_NoColumns1,
+  /* ColNames:  */ 0, 0,
+  /* iArg:      */ 0 },
+#endif
 #if !defined(SQLITE_OMIT_SCHEMA_VERSION_PRAGMAS)
  {/* zName:     */ "freelist_count",
   /* ePragTyp:  */ PragTyp_HEADER_VALUE,
@@ -472,6 +490,13 @@ static const PragmaName aPragmaName[] = {
   /* ColNames:  */ 31, 1,
   /* iArg:      */ 0 },
 #endif
+#if defined(SQLITE_ENABLE_INDEX_PREFIX)
+ {/* zName:     */ "prefix_compression",
+  /* ePragTyp:  */ PragTyp_PREFIX_COMPRESSION,
+  /* ePragFlg:  */ PragFlg_Result0,
+  /* ColNames:  */ 0, 0,
+  /* iArg:      */ 0 },
+#endif
 #if !defined(SQLITE_OMIT_FLAG_PRAGMAS)
  {/* zName:     */ "query_only",
   /* ePragTyp:  */ PragTyp_FLAG,
@@ -646,4 +671,4 @@ static const PragmaName aPragmaName[] = {
   /* iArg:      */ SQLITE_WriteSchema },
 #endif
 };
-/* Number of pragmas: 60 on by default, 77 total. */
+/* Number of pragmas: 61 on by default, 80 total. */
@@ -234,6 +234,17 @@ struct RtreeSearchPoint {
 */
 #define RTREE_CACHE_SZ  5
 
+/*
+** Nodes with up to RTREE_MASK_CELLS cells are tested against the simple
+** (non-MATCH) constraints of a query one coordinate column at a time,
+** with the outcome for every cell of the node recorded as one bit in an
+** array of RTREE_MASK_WORDS 64-bit words.  Larger nodes, which only occur
+** in databases created with a node size beyond the default maximum, fall
+** back to testing each cell as it is visited.
+*/
+#define RTREE_MASK_WORDS 4
+#define RTREE_MASK_CELLS (RTREE_MASK_WORDS*64)
+
 /* 
 ** An rtree cursor object.
 */
@@ -253,6 +264,9 @@ struct RtreeCursor {
   RtreeSearchPoint sPoint;          /* Cached next search point */
   RtreeNode *aNode[RTREE_CACHE_SZ]; /* Rtree node cache */
   u32 anQueue[RTREE_MAX_DEPTH+1];   /* Number of queued entries by iLevel */
+  u8 bMask;                         /* True if aMask[] is used by this scan */
+  i64 aMaskNode[RTREE_MAX_DEPTH+2]; /* Node described by aMask[], by iLevel */
+  u64 aMask[RTREE_MAX_DEPTH+2][RTREE_MASK_WORDS];  /* Cells passing tests */
 };
 
 /* Return the Rtree of a RtreeCursor */
@@ -1503,6 +1517,94 @@ static void rtreeSearchPointPop(RtreeCursor *p){
 }
 
 
+/*
+** Decode coordinate iCoord of every cell of node pNode into aOut[].
+*/
+static void rtreeNodeColumn(
+  Rtree *pRtree,             /* The r-tree that pNode belongs to */
+  RtreeNode *pNode,          /* Node to decode */
+  int nCell,                 /* Number of cells in pNode */
+  int iCoord,                /* Coordinate to decode */
+  RtreeDValue *aOut          /* OUT: One value for each cell */
+){
+  int eInt = pRtree->eCoordType==RTREE_COORD_INT32;
+  int nByte = pRtree->nBytesPerCell;
+  u8 *a = pNode->zData + 4 + 8 + 4*iCoord;
+  int i;
+  for(i=0; i<nCell; i++){
+    RTREE_DECODE_COORD(eInt, a, aOut[i]);
+    a += nByte;
+  }
+}
+
+/*
+** Test all cells of node pNode, which is at level iLevel of the tree,
+** against the simple (non-MATCH) constraints of cursor pCur. Bit i of
+** aMask[] is set on return if cell i passes all of those constraints,
+** with the same semantics as rtreeLeafConstraint() for leaf cells and
+** rtreeNonleafConstraint() for interior cells.
+**
+** Each constraint is applied to one decoded column of coordinates at a
+** time. The comparison loops have no branches and no dependencies 
+** between iterations, so that the compiler is free to vectorize them.
+*/
+static void rtreeNodeMask(
+  RtreeCursor *pCur,         /* Cursor holding the constraints */
+  RtreeNode *pNode,          /* Node to test */
+  int iLevel,                /* Level of pNode. 1 for leaves */
+  u64 *aMask                 /* OUT: RTREE_MASK_WORDS words of results */
+){
+  Rtree *pRtree = RTREE_OF_CURSOR(pCur);
+  int nCell = NCELL(pNode);
+  u8 aOk[RTREE_MASK_CELLS];
+  RtreeDValue aVal[RTREE_MASK_CELLS];
+  int ii, i;
+
+  assert( nCell<=RTREE_MASK_CELLS );
+  memset(aOk, 1, nCell);
+  for(ii=0; ii<pCur->nConstraint; ii++){
+    RtreeConstraint *p = &pCur->aConstraint[ii];
+    RtreeDValue r = p->u.rValue;
+    if( p->op>=RTREE_MATCH ) continue;
+    if( iLevel==1 ){
+      rtreeNodeColumn(pRtree, pNode, nCell, p->iCoord, aVal);
+      switch( p->op ){
+        case RTREE_LE:
+          for(i=0; i<nCell; i++) aOk[i] &= (aVal[i]<=r);
+          break;
+        case RTREE_LT:
+          for(i=0; i<nCell; i++) aOk[i] &= (aVal[i]<r);
+          break;
+        case RTREE_GE:
+          for(i=0; i<nCell; i++) aOk[i] &= (aVal[i]>=r);
+          break;
+        case RTREE_GT:
+          for(i=0; i<nCell; i++) aOk[i] &= (aVal[i]>r);
+          break;
+        default:
+          for(i=0; i<nCell; i++) aOk[i] &= (aVal[i]==r);
+          break;
+      }
+    }else{
+      /* An interior cell may contain a match if the lower bound of the
+      ** coordinate pair is no greater than the value (LE, LT and EQ) and
+      ** if the upper bound is no less than it (GE, GT and EQ). */
+      if( p->op!=RTREE_GE && p->op!=RTREE_GT ){
+        rtreeNodeColumn(pRtree, pNode, nCell, p->iCoord&0xfe, aVal);
+        for(i=0; i<nCell; i++) aOk[i] &= (r>=aVal[i]);
+      }
+      if( p->op!=RTREE_LE && p->op!=RTREE_LT ){
+        rtreeNodeColumn(pRtree, pNode, nCell, p->iCoord|0x01, aVal);
+        for(i=0; i<nCell; i++) aOk[i] &= (r<=aVal[i]);
+      }
+    }
+  }
+  memset(aMask, 0, sizeof(u64)*RTREE_MASK_WORDS);
+  for(i=0; i<nCell; i++){
+    aMask[i/64] |= ((u64)aOk[i])<<(i%64);
+  }
+}
+
 /*
 ** Continue the search on cursor pCur until the front of the queue
 ** contains an entry suitable for returning as a result-set row,
@@ -1519,6 +1621,7 @@ static int rtreeStepToLeaf(RtreeCursor *pCur){
   int nConstraint = pCur->nConstraint;
   int ii;
   int eInt;
+  u64 *aMask;
   RtreeSearchPoint x;
 
   eInt = pRtree->eCoordType==RTREE_COORD_INT32;
@@ -1527,9 +1630,24 @@ static int rtreeStepToLeaf(RtreeCursor *pCur){
     if( rc ) return rc;
     nCell = NCELL(pNode);
     assert( nCell<200 );
+    aMask = 0;
+    if( pCur->bMask && nCell<=RTREE_MASK_CELLS ){
+      /* The simple constraints are tested against all cells of the node
+      ** the first time it is seen at this level. Only cells that pass
+      ** are considered by the loop below. */
+      aMask = pCur->aMask[p->iLevel];
+      if( pCur->aMaskNode[p->iLevel]!=p->id ){
+        rtreeNodeMask(pCur, pNode, p->iLevel, aMask);
+        pCur->aMaskNode[p->iLevel] = p->id;
+      }
+    }
     while( p->iCell<nCell ){
       sqlite3_rtree_dbl rScore = (sqlite3_rtree_dbl)-1;
       u8 *pCellData = pNode->zData + (4+pRtree->nBytesPerCell*p->iCell);
+      if( aMask && (aMask[p->iCell/64] & (((u64)1)<<(p->iCell%64)))==0 ){
+        p->iCell++;
+        continue;
+      }
       eWithin = FULLY_WITHIN;
       for(ii=0; ii<nConstraint; ii++){
         RtreeConstraint *pConstraint = pCur->aConstraint + ii;
@@ -1537,6 +1655,8 @@ static int rtreeStepToLeaf(RtreeCursor *pCur){
           rc = rtreeCallbackConstraint(pConstraint, eInt, pCellData, p,
                                        &rScore, &eWithin);
           if( rc ) return rc;
+        }else if( aMask ){
+          /* Already tested by rtreeNodeMask() */
         }else if( p->iLevel==1 ){
           rtreeLeafConstraint(pConstraint, eInt, pCellData, &eWithin);
         }else{
@@ -1801,6 +1921,7 @@ static int rtreeFilter(
 #else
             p->u.rValue = sqlite3_value_double(argv[ii]);
 #endif
+            pCsr->bMask = 1;
           }
         }
       }
@@ -4224,6 +4345,518 @@ static void rtreecheck(
 }
 
 
+/*
+** Sort the nCell cells in aCell[] by the centre of their extent in
+** dimension iDim.  aSpare[] must have space for at least nCell/2 cells.
+*/
+static void rtreeLoadSort(
+  Rtree *pRtree,                  /* The r-tree being loaded */
+  RtreeCell *aCell,               /* Cells to sort */
+  RtreeCell *aSpare,              /* Workspace */
+  int nCell,                      /* Number of cells in aCell[] */
+  int iDim                        /* Dimension to sort on */
+){
+  int nLeft = nCell/2;
+  int iLeft = 0;
+  int iRight = nLeft;
+  int i = 0;
+  if( nCell<2 ) return;
+  rtreeLoadSort(pRtree, aCell, aSpare, nLeft, iDim);
+  rtreeLoadSort(pRtree, &aCell[nLeft], aSpare, nCell-nLeft, iDim);
+  memcpy(aSpare, aCell, nLeft*sizeof(RtreeCell));
+  while( iLeft<nLeft ){
+    RtreeCell *pL = &aSpare[iLeft];
+    RtreeCell *pR = &aCell[iRight];
+    if( iRight<nCell
+     && DCOORD(pR->aCoord[iDim*2])+DCOORD(pR->aCoord[iDim*2+1])
+      < DCOORD(pL->aCoord[iDim*2])+DCOORD(pL->aCoord[iDim*2+1])
+    ){
+      aCell[i++] = aCell[iRight++];
+    }else{
+      aCell[i++] = aSpare[iLeft++];
+    }
+  }
+}
+
+/*
+** Order the nCell cells in aCell[] for Sort-Tile-Recursive packing into
+** nodes of nMax cells each, starting with dimension iDim.  The cells are
+** sorted on dimension iDim and cut into S slabs, where S is the
+** (nDim-iDim)'th root of the number of nodes required.  Each slab is then
+** ordered in the same way on the remaining dimensions.  Afterwards each
+** run of nMax consecutive cells forms a compact node.
+*/
+static void rtreeLoadTile(
+  Rtree *pRtree,                  /* The r-tree being loaded */
+  RtreeCell *aCell,               /* Cells to order */
+  RtreeCell *aSpare,              /* Workspace */
+  int nCell,                      /* Number of cells in aCell[] */
+  int nMax,                       /* Cells per node */
+  int iDim                        /* First dimension to order on */
+){
+  int nNode = (nCell+nMax-1)/nMax;
+  int nSlab = 1;
+  int nPer;
+  int i;
+
+  rtreeLoadSort(pRtree, aCell, aSpare, nCell, iDim);
+  if( iDim+1>=pRtree->nDim ) return;
+  for(;;){
+    i64 nPow = 1;
+    for(i=iDim; i<pRtree->nDim && nPow<nNode; i++) nPow *= nSlab;
+    if( nPow>=nNode ) break;
+    nSlab++;
+  }
+  nPer = ((nNode+nSlab-1)/nSlab)*nMax;
+  for(i=0; i<nCell; i+=nPer){
+    rtreeLoadTile(pRtree, &aCell[i], aSpare, MIN(nPer, nCell-i), nMax, iDim+1);
+  }
+}
+
+/*
+** qsort() comparison function for the (rowid, nodeno) pairs written to
+** the %_rowid table by rtreeLoadBuild().
+*/
+static int rtreeLoadCompare(const void *p1, const void *p2){
+  i64 i1 = ((const i64*)p1)[0];
+  i64 i2 = ((const i64*)p2)[0];
+  return (i1<i2) ? -1 : (i1>i2);
+}
+
+/*
+** Write the nCell cells in aCell[] into the %_node table as a packed tree
+** built bottom up.  Each level is tiled, cut into full nodes and replaced
+** by the bounding boxes of those nodes, until the remaining cells fit in
+** the root node.  The %_node and %_parent tables must be empty.
+**
+** The leaf cells are mapped to their nodes in the %_rowid table in rowid
+** order once the tree is complete, as that is much faster than updating
+** the %_rowid b-tree in the order in which the leaves are written.  A
+** rowid that appears twice in aCell[] is a constraint error.
+*/
+static int rtreeLoadBuild(
+  Rtree *pRtree,                  /* The r-tree being loaded */
+  RtreeCell *aCell,               /* Leaf cells.  Overwritten */
+  RtreeCell *aSpare,              /* Workspace of nCell/2 cells */
+  int nCell                       /* Number of cells in aCell[] */
+){
+  int nMax = (pRtree->iNodeSize-4)/pRtree->nBytesPerCell;
+  int nEntry = nCell;             /* Number of leaf cells */
+  i64 *aMap;                      /* (rowid, nodeno) of each leaf cell */
+  i64 iNext = 2;                  /* Node number for next non-root node */
+  int iHeight = 0;                /* Height of level being written */
+  RtreeNode node;
+  int rc = SQLITE_OK;
+  int i;
+
+  memset(&node, 0, sizeof(node));
+  node.zData = (u8*)sqlite3_malloc(pRtree->iNodeSize);
+  aMap = (i64*)sqlite3_malloc64((nEntry+1)*2*sizeof(i64));
+  if( node.zData==0 || aMap==0 ){
+    sqlite3_free(node.zData);
+    sqlite3_free(aMap);
+    return SQLITE_NOMEM;
+  }
+
+  while( rc==SQLITE_OK ){
+    int bRoot = (nCell<=nMax);
+    int nNode = bRoot ? 1 : (nCell+nMax-1)/nMax;
+    int iNode;
+
+    if( !bRoot ) rtreeLoadTile(pRtree, aCell, aSpare, nCell, nMax, 0);
+    for(iNode=0; rc==SQLITE_OK && iNode<nNode; iNode++){
+      int iFirst = iNode*nMax;
+      int n = MIN(nMax, nCell-iFirst);
+      RtreeCell cell;
+      int ii;
+
+      node.iNode = bRoot ? 1 : iNext++;
+      memset(node.zData, 0, pRtree->iNodeSize);
+      writeInt16(node.zData, bRoot ? iHeight : 0);
+      writeInt16(&node.zData[2], n);
+      for(ii=0; rc==SQLITE_OK && ii<n; ii++){
+        RtreeCell *p = &aCell[iFirst+ii];
+        nodeOverwriteCell(pRtree, &node, p, ii);
+        if( iHeight==0 ){
+          aMap[(iFirst+ii)*2] = p->iRowid;
+          aMap[(iFirst+ii)*2+1] = node.iNode;
+        }else{
+          rc = parentWrite(pRtree, p->iRowid, node.iNode);
+        }
+        if( ii==0 ){
+          cell = *p;
+        }else{
+          cellUnion(pRtree, &cell, p);
+        }
+      }
+      if( rc==SQLITE_OK ){
+        sqlite3_stmt *pWrite = pRtree->pWriteNode;
+        sqlite3_bind_int64(pWrite, 1, node.iNode);
+        sqlite3_bind_blob(pWrite, 2, node.zData, pRtree->iNodeSize,
+                          SQLITE_STATIC);
+        sqlite3_step(pWrite);
+        rc = sqlite3_reset(pWrite);
+        sqlite3_bind_null(pWrite, 2);
+      }
+
+      /* Cells of this level at or after iFirst have been consumed, so the
+      ** bounding box of the node can be stored in slot iNode. */
+      if( !bRoot ){
+        cell.iRowid = node.iNode;
+        aCell[iNode] = cell;
+      }
+    }
+    if( bRoot ) break;
+    nCell = nNode;
+    iHeight++;
+  }
+
+  if( rc==SQLITE_OK ){
+    qsort(aMap, nEntry, 2*sizeof(i64), rtreeLoadCompare);
+  }
+  for(i=0; rc==SQLITE_OK && i<nEntry; i++){
+    if( i>0 && aMap[i*2]==aMap[i*2-2] ){
+      rc = rtreeConstraintError(pRtree, 0);
+    }else{
+      rc = rowidWrite(pRtree, aMap[i*2], aMap[i*2+1]);
+    }
+  }
+
+  sqlite3_free(node.zData);
+  sqlite3_free(aMap);
+  return rc;
+}
+
+/*
+** Append a copy of *pCell to the array *paCell, which currently holds
+** *pnCell cells and has space for *pnAlloc.
+*/
+static int rtreeLoadAppend(
+  RtreeCell **paCell,
+  int *pnCell,
+  int *pnAlloc,
+  RtreeCell *pCell
+){
+  if( *pnCell>=*pnAlloc ){
+    int nNew = *pnAlloc ? *pnAlloc*2 : 256;
+    RtreeCell *aNew;
+    aNew = (RtreeCell*)sqlite3_realloc64(*paCell, nNew*sizeof(RtreeCell));
+    if( aNew==0 ) return SQLITE_NOMEM;
+    *paCell = aNew;
+    *pnAlloc = nNew;
+  }
+  (*paCell)[(*pnCell)++] = *pCell;
+  return SQLITE_OK;
+}
+
+/*
+** This function does the work of the rtreeload() SQL function.  The
+** leaf cells currently in the r-tree and the rows returned by statement
+** zSelect (if it is not NULL) are gathered in memory and the whole tree
+** is rewritten by rtreeLoadBuild().
+*/
+static int rtreeLoadTable(
+  sqlite3 *db,                    /* Database handle */
+  const char *zDb,                /* Name of db ("main", "temp" etc.) */
+  const char *zTab,               /* Name of rtree table to load */
+  const char *zSelect,            /* Query returning new rows, or NULL */
+  i64 *pnRow,                     /* OUT: Number of entries in the r-tree */
+  char **pzErr                    /* OUT: Error message, if any */
+){
+  Rtree *pRtree;
+  sqlite3_stmt *pStmt = 0;
+  RtreeCell *aCell = 0;
+  RtreeCell *aSpare = 0;
+  int nCell = 0;
+  int nAlloc = 0;
+  int nCol = 0;
+  i64 iMax = 0;
+  int nDb = (int)strlen(zDb);
+  int nTab = (int)strlen(zTab);
+  char *zSql;
+  int rc;
+
+  pRtree = (Rtree*)sqlite3_malloc(sizeof(Rtree)+nDb+nTab+2);
+  if( pRtree==0 ) return SQLITE_NOMEM;
+  memset(pRtree, 0, sizeof(Rtree)+nDb+nTab+2);
+  pRtree->nBusy = 1;
+  pRtree->zDb = (char*)&pRtree[1];
+  pRtree->zName = &pRtree->zDb[nDb+1];
+  memcpy(pRtree->zDb, zDb, nDb);
+  memcpy(pRtree->zName, zTab, nTab);
+
+  /* Find the shape of the r-tree: the number of auxiliary columns and
+  ** dimensions, the node size and the type of coordinate. */
+  zSql = sqlite3_mprintf("SELECT * FROM %Q.'%q_rowid'", zDb, zTab);
+  rc = zSql ? sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0) : SQLITE_NOMEM;
+  sqlite3_free(zSql);
+  if( rc==SQLITE_OK ){
+    pRtree->nAux = (u8)(sqlite3_column_count(pStmt) - 2);
+    sqlite3_finalize(pStmt);
+    zSql = sqlite3_mprintf("SELECT * FROM %Q.%Q", zDb, zTab);
+    rc = zSql ? sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0) : SQLITE_NOMEM;
+    sqlite3_free(zSql);
+  }
+  if( rc==SQLITE_OK ){
+    nCol = sqlite3_column_count(pStmt);
+    pRtree->nDim2 = (u8)((nCol - 1 - pRtree->nAux) & ~1);
+    pRtree->nDim = pRtree->nDim2/2;
+    pRtree->nBytesPerCell = 8 + pRtree->nDim2*4;
+    sqlite3_finalize(pStmt);
+    if( pRtree->nDim<1 || pRtree->nDim>RTREE_MAX_DIMENSIONS ){
+      rc = SQLITE_ERROR;
+    }
+  }
+  if( rc==SQLITE_OK ){
+    rc = getNodeSize(db, pRtree, 0, pzErr);
+  }
+  if( rc==SQLITE_OK ){
+#ifndef SQLITE_RTREE_INT_ONLY
+    zSql = sqlite3_mprintf(
+        "SELECT sql FROM %Q.sqlite_master WHERE type='table' AND name=%Q",
+        zDb, zTab
+    );
+    rc = zSql ? sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0) : SQLITE_NOMEM;
+    sqlite3_free(zSql);
+    if( rc==SQLITE_OK ){
+      if( sqlite3_step(pStmt)==SQLITE_ROW ){
+        const char *zCreate = (const char*)sqlite3_column_text(pStmt, 0);
+        if( zCreate && sqlite3_strlike("%using%rtree_i32%", zCreate, 0)==0 ){
+          pRtree->eCoordType = RTREE_COORD_INT32;
+        }
+      }
+      rc = sqlite3_finalize(pStmt);
+    }
+#else
+    pRtree->eCoordType = RTREE_COORD_INT32;
+#endif
+  }
+  if( rc==SQLITE_OK ){
+    rc = rtreeSqlInit(pRtree, db, zDb, zTab, 0);
+  }
+
+  /* Gather the cells on the leaf nodes of the existing tree */
+  if( rc==SQLITE_OK ){
+    zSql = sqlite3_mprintf(
+        "SELECT data FROM %Q.'%q_node' WHERE nodeno IN "
+        "(SELECT nodeno FROM %Q.'%q_rowid')", zDb, zTab, zDb, zTab
+    );
+    rc = zSql ? sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0) : SQLITE_NOMEM;
+    sqlite3_free(zSql);
+  }
+  while( rc==SQLITE_OK && sqlite3_step(pStmt)==SQLITE_ROW ){
+    RtreeNode node;
+    int ii;
+    memset(&node, 0, sizeof(node));
+    node.zData = (u8*)sqlite3_column_blob(pStmt, 0);
+    if( sqlite3_column_bytes(pStmt, 0)!=pRtree->iNodeSize
+     || NCELL(&node)>(pRtree->iNodeSize-4)/pRtree->nBytesPerCell
+    ){
+      rc = SQLITE_CORRUPT_VTAB;
+      break;
+    }
+    for(ii=0; rc==SQLITE_OK && ii<NCELL(&node); ii++){
+      RtreeCell cell;
+      nodeGetCell(pRtree, &node, ii, &cell);
+      rc = rtreeLoadAppend(&aCell, &nCell, &nAlloc, &cell);
+    }
+  }
+  if( pStmt ){
+    int rc2 = sqlite3_finalize(pStmt);
+    if( rc==SQLITE_OK ) rc = rc2;
+    pStmt = 0;
+  }
+
+  /* Add the rows returned by zSelect.  Each is checked in the same way as
+  ** by rtreeUpdate().  Rows without an id are numbered after the largest
+  ** rowid seen so far.  If there are auxiliary columns, each new row is
+  ** added to the %_rowid table at once so that they can be written.
+  ** Otherwise, duplicate ids within zSelect are found by rtreeLoadBuild(). */
+  if( rc==SQLITE_OK ){
+    zSql = sqlite3_mprintf("SELECT max(rowid) FROM %Q.'%q_rowid'", zDb, zTab);
+    rc = zSql ? sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0) : SQLITE_NOMEM;
+    sqlite3_free(zSql);
+    if( rc==SQLITE_OK ){
+      if( sqlite3_step(pStmt)==SQLITE_ROW ){
+        iMax = sqlite3_column_int64(pStmt, 0);
+      }
+      rc = sqlite3_finalize(pStmt);
+    }
+    pStmt = 0;
+  }
+  if( rc==SQLITE_OK && zSelect ){
+    rc = sqlite3_prepare_v2(db, zSelect, -1, &pStmt, 0);
+    if( rc==SQLITE_OK
+     && sqlite3_column_count(pStmt)!=1+pRtree->nDim2
+     && sqlite3_column_count(pStmt)!=nCol
+    ){
+      *pzErr = sqlite3_mprintf("rtreeload: query must return %d columns",
+                               1+pRtree->nDim2);
+      rc = SQLITE_ERROR;
+    }
+  }
+  while( rc==SQLITE_OK && pStmt && sqlite3_step(pStmt)==SQLITE_ROW ){
+    RtreeCell cell;
+    int ii;
+#ifndef SQLITE_RTREE_INT_ONLY
+    if( pRtree->eCoordType==RTREE_COORD_REAL32 ){
+      for(ii=0; rc==SQLITE_OK && ii<pRtree->nDim2; ii+=2){
+        cell.aCoord[ii].f = rtreeValueDown(sqlite3_column_value(pStmt, ii+1));
+        cell.aCoord[ii+1].f = rtreeValueUp(sqlite3_column_value(pStmt, ii+2));
+        if( cell.aCoord[ii].f>cell.aCoord[ii+1].f ){
+          rc = rtreeConstraintError(pRtree, ii+1);
+        }
+      }
+    }else
+#endif
+    {
+      for(ii=0; rc==SQLITE_OK && ii<pRtree->nDim2; ii+=2){
+        cell.aCoord[ii].i = sqlite3_column_int(pStmt, ii+1);
+        cell.aCoord[ii+1].i = sqlite3_column_int(pStmt, ii+2);
+        if( cell.aCoord[ii].i>cell.aCoord[ii+1].i ){
+          rc = rtreeConstraintError(pRtree, ii+1);
+        }
+      }
+    }
+    if( rc==SQLITE_OK ){
+      if( sqlite3_column_type(pStmt, 0)==SQLITE_NULL ){
+        if( iMax==(i64)((((u64)1)<<63)-1) ){
+          rc = SQLITE_FULL;
+        }else{
+          cell.iRowid = ++iMax;
+        }
+      }else{
+        int steprc;
+        cell.iRowid = sqlite3_column_int64(pStmt, 0);
+        sqlite3_bind_int64(pRtree->pReadRowid, 1, cell.iRowid);
+        steprc = sqlite3_step(pRtree->pReadRowid);
+        rc = sqlite3_reset(pRtree->pReadRowid);
+        if( rc==SQLITE_OK && steprc==SQLITE_ROW ){
+          rc = rtreeConstraintError(pRtree, 0);
+        }
+        iMax = MAX(iMax, cell.iRowid);
+      }
+    }
+    if( rc==SQLITE_OK && pRtree->nAux ){
+      rc = rowidWrite(pRtree, cell.iRowid, 0);
+    }
+    if( rc==SQLITE_OK && pRtree->nAux && sqlite3_column_count(pStmt)==nCol ){
+      sqlite3_stmt *pUp = pRtree->pWriteAux;
+      sqlite3_bind_int64(pUp, 1, cell.iRowid);
+      for(ii=0; ii<pRtree->nAux; ii++){
+        sqlite3_bind_value(pUp, ii+2,
+            sqlite3_column_value(pStmt, pRtree->nDim2+1+ii));
+      }
+      sqlite3_step(pUp);
+      rc = sqlite3_reset(pUp);
+    }
+    if( rc==SQLITE_OK ){
+      rc = rtreeLoadAppend(&aCell, &nCell, &nAlloc, &cell);
+    }
+  }
+  if( pStmt ){
+    int rc2 = sqlite3_finalize(pStmt);
+    if( rc==SQLITE_OK ) rc = rc2;
+  }
+
+  /* Discard the old tree and write the new one */
+  if( rc==SQLITE_OK ){
+    zSql = sqlite3_mprintf(
+        "DELETE FROM %Q.'%q_node'; DELETE FROM %Q.'%q_parent';",
+        zDb, zTab, zDb, zTab
+    );
+    rc = zSql ? sqlite3_exec(db, zSql, 0, 0, 0) : SQLITE_NOMEM;
+    sqlite3_free(zSql);
+  }
+  if( rc==SQLITE_OK ){
+    aSpare = (RtreeCell*)sqlite3_malloc64((nCell/2+1)*sizeof(RtreeCell));
+    if( aSpare==0 ) rc = SQLITE_NOMEM;
+  }
+  if( rc==SQLITE_OK ){
+    rc = rtreeLoadBuild(pRtree, aCell, aSpare, nCell);
+  }
+  if( rc==SQLITE_CONSTRAINT && *pzErr==0 ){
+    *pzErr = sqlite3_mprintf("%s", pRtree->base.zErrMsg);
+  }
+  sqlite3_free(pRtree->base.zErrMsg);
+
+  *pnRow = nCell;
+  sqlite3_free(aCell);
+  sqlite3_free(aSpare);
+  rtreeRelease(pRtree);
+  return rc;
+}
+
+/*
+** Usage:
+**
+**   rtreeload(<rtree-table>);
+**   rtreeload(<rtree-table>, <select>);
+**   rtreeload(<database>, <rtree-table>, <select>);
+**
+** Rebuild the named rtree table as a packed tree using Sort-Tile-Recursive
+** bulk loading.  If a SELECT statement is supplied, each row it returns
+** (an id, the coordinates and optionally the auxiliary columns) is added
+** to the table first, exactly as for an INSERT.  For example:
+**
+**   SELECT rtreeload('rt', 'SELECT id, minX, maxX, minY, maxY FROM src');
+**
+** This is much faster than inserting the same rows one at a time, as no
+** node is ever split or reinserted, and as every node except the last
+** one on each level is full the resulting tree is also faster to query.
+** The first insert into a full node splits it as usual.  The return value
+** is the number of entries in the rtree.
+*/
+static void rtreeload(
+  sqlite3_context *ctx, 
+  int nArg, 
+  sqlite3_value **apArg
+){
+  sqlite3 *db = sqlite3_context_db_handle(ctx);
+  const char *zDb = "main";
+  const char *zTab;
+  const char *zSelect = 0;
+  char *zErr = 0;
+  i64 nRow = 0;
+  int rc;
+
+  if( nArg<1 || nArg>3 ){
+    sqlite3_result_error(ctx, 
+        "wrong number of arguments to function rtreeload()", -1
+    );
+    return;
+  }
+  if( nArg==3 ){
+    zDb = (const char*)sqlite3_value_text(apArg[0]);
+    apArg++;
+  }
+  zTab = (const char*)sqlite3_value_text(apArg[0]);
+  if( nArg>1 ) zSelect = (const char*)sqlite3_value_text(apArg[1]);
+  if( zDb==0 || zTab==0 ){
+    sqlite3_result_error_nomem(ctx);
+    return;
+  }
+
+  /* Do the work within a savepoint so that the rtree is left unchanged
+  ** if an error occurs. */
+  rc = sqlite3_exec(db, "SAVEPOINT rtreeload", 0, 0, 0);
+  if( rc==SQLITE_OK ){
+    rc = rtreeLoadTable(db, zDb, zTab, zSelect, &nRow, &zErr);
+    if( rc!=SQLITE_OK ){
+      if( zErr==0 ) zErr = sqlite3_mprintf("%s", sqlite3_errmsg(db));
+      sqlite3_exec(db, "ROLLBACK TO rtreeload", 0, 0, 0);
+    }
+    sqlite3_exec(db, "RELEASE rtreeload", 0, 0, 0);
+  }
+  if( rc==SQLITE_OK ){
+    sqlite3_result_int64(ctx, nRow);
+  }else{
+    sqlite3_result_error(ctx, zErr ? zErr : sqlite3_errstr(rc), -1);
+    sqlite3_result_error_code(ctx, rc);
+  }
+  sqlite3_free(zErr);
+}
+
 /*
 ** Register the r-tree module with database handle db. This creates the
 ** virtual table module "rtree" and the debugging/analysis scalar 
@@ -4240,6 +4873,9 @@ int sqlite3RtreeInit(sqlite3 *db){
   if( rc==SQLITE_OK ){
     rc = sqlite3_create_function(db, "rtreecheck", -1, utf8, 0,rtreecheck, 0,0);
   }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3_create_function(db, "rtreeload", -1, utf8, 0, rtreeload, 0,0);
+  }
   if( rc==SQLITE_OK ){
 #ifdef SQLITE_RTREE_INT_ONLY
     void *c = (void *)RTREE_COORD_INT32;
@@ -5865,6 +5865,26 @@ int sqlite3Select(
       sqlite3VdbeChangeToNoop(v, sSort.addrSortIndex);
     }
 
+#if defined(SQLITE_ENABLE_COUNTED_BTREE) && !defined(SQLITE_OMIT_BTREECOUNT)
+    /* If every entry of a single b-tree becomes an output row, in order,
+    ** move the cursor over the OFFSET rows in one step the first time
+    ** through the loop.  The OFFSET counter of the left-hand side of
+    ** a compound SELECT carries over to the right-hand side, so it must
+    ** be consumed one row at a time.  */
+    if( p->iOffset && pWhere==0 && sSort.pOrderBy==0 && sDistinct.isTnct==0
+     && p->pNext==0
+    ){
+      int bRev = 0;
+      int iCur = sqlite3WhereScanCursor(pWInfo, &bRev);
+      if( iCur>=0 ){
+        sqlite3VdbeAddOp3(v, OP_SeekOffset, iCur,
+                          sqlite3WhereBreakLabel(pWInfo), p->iOffset);
+        VdbeCoverage(v);
+        sqlite3VdbeChangeP5(v, (u8)bRev);
+      }
+    }
+#endif
+
     /* Use the standard inner loop. */
     assert( p->pEList==pEList );
     selectInnerLoop(pParse, p, -1, &sSort, &sDistinct, pDest,
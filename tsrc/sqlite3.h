@@ -768,6 +768,14 @@ struct _sqlite3_file
 ** fails to zero-fill short reads might seem to work.  However,
 ** failure to zero-fill short reads will eventually lead to
 ** database corruption.
+**
+** The xWritev() method, available when iVersion is 4 or greater, writes
+** nBuf buffers of iAmt bytes each to consecutive locations in the file,
+** the first at offset iOfst, the second at iOfst+iAmt and so on.  The
+** result must be the same as that of nBuf calls to xWrite().  SQLite uses
+** it to write runs of adjacent database pages with as few system calls
+** as the VFS can manage.  A VFS that sets iVersion to 4 or greater may
+** set xWritev to NULL, in which case SQLite falls back to xWrite().
 */
 typedef struct sqlite3_io_methods sqlite3_io_methods;
 struct sqlite3_io_methods {
@@ -793,6 +801,9 @@ struct sqlite3_io_methods {
   int (*xFetch)(sqlite3_file*, sqlite3_int64 iOfst, int iAmt, void **pp);
   int (*xUnfetch)(sqlite3_file*, sqlite3_int64 iOfst, void *p);
   /* Methods above are valid for version 3 */
+  int (*xWritev)(sqlite3_file*, int nBuf, const void **apBuf, int iAmt,
+                 sqlite3_int64 iOfst);
+  /* Methods above are valid for version 4 */
   /* Additional methods may be added in future releases */
 };
 
@@ -1953,6 +1964,19 @@ struct sqlite3_mem_methods {
 ** negative value for this option restores the default behaviour.
 ** This option is only available if SQLite is compiled with the
 ** [SQLITE_ENABLE_SORTER_REFERENCES] compile-time option.
+**
+** [[SQLITE_CONFIG_PCACHE_POLICY]]
+** <dt>SQLITE_CONFIG_PCACHE_POLICY
+** <dd>The SQLITE_CONFIG_PCACHE_POLICY option accepts a single parameter
+** of type (int) - the page replacement policy used by the default page 
+** cache implementation. ^With [SQLITE_PCACHE_POLICY_LRU], the default,
+** the least recently used unpinned page is recycled first. ^With
+** [SQLITE_PCACHE_POLICY_2Q], pages that have only been used once since
+** they were loaded are kept on a separate probationary list and are 
+** recycled ahead of pages that have been used more than once, so that a
+** single large scan does not flush the frequently used pages from the 
+** cache. The policy may also be changed at run-time using the
+** [PRAGMA cache_policy] command.
 ** </dl>
 */
 #define SQLITE_CONFIG_SINGLETHREAD  1  /* nil */
@@ -1983,6 +2007,16 @@ struct sqlite3_mem_methods {
 #define SQLITE_CONFIG_STMTJRNL_SPILL      26  /* int nByte */
 #define SQLITE_CONFIG_SMALL_MALLOC        27  /* boolean */
 #define SQLITE_CONFIG_SORTERREF_SIZE      28  /* int nByte */
+#define SQLITE_CONFIG_PCACHE_POLICY       29  /* int ePolicy */
+
+/*
+** CAPI3REF: Page Cache Replacement Policies
+**
+** These constants are the page replacement policies that may be selected
+** using [SQLITE_CONFIG_PCACHE_POLICY].
+*/
+#define SQLITE_PCACHE_POLICY_LRU    0
+#define SQLITE_PCACHE_POLICY_2Q     1
 
 /*
 ** CAPI3REF: Database Connection Configuration Options
@@ -6697,6 +6731,39 @@ SQLITE_API int sqlite3_blob_read(sqlite3_blob *, void *Z, int N, int iOffset);
 */
 SQLITE_API int sqlite3_blob_write(sqlite3_blob *, const void *z, int n, int iOffset);
 
+/*
+** CAPI3REF: Append Data To A BLOB
+** METHOD: sqlite3_blob
+**
+** ^(This function appends N bytes of data from the buffer Z to the end
+** of the value that an open [BLOB handle] refers to.)^  ^On success the
+** size reported by [sqlite3_blob_bytes()] grows by N and the handle
+** remains open on the same row.  This interface is only available if
+** SQLite is compiled with the SQLITE_ENABLE_BLOB_APPEND option.
+**
+** ^When the value is the last column of its row and spills onto overflow
+** pages, the append is usually made in place, writing only the tail of
+** the overflow chain and the size fields of the row.  ^Otherwise the row
+** is rewritten once with the new value, as an UPDATE would.
+** Applications that grow large values a piece at a time should append
+** in multiples of the database page size less four bytes, as appends of
+** that size always leave the amount of the row stored on its b-tree page
+** unchanged and so can always be made in place.
+**
+** ^(If the [BLOB handle] was not opened for writing, [SQLITE_READONLY]
+** is returned.)^  ^If N is less than zero [SQLITE_ERROR] is returned,
+** and if the new size would exceed [SQLITE_LIMIT_LENGTH] then
+** [SQLITE_TOOBIG] is returned.  In both cases no data is written.
+** ^An attempt to append to an expired [BLOB handle] fails with an
+** error code of [SQLITE_ABORT].  ^Other [BLOB handle]s open on the same
+** row are expired by a successful append.
+**
+** See also: [sqlite3_blob_write()].
+*/
+#ifdef SQLITE_ENABLE_BLOB_APPEND
+SQLITE_API int sqlite3_blob_append(sqlite3_blob *, const void *z, int n);
+#endif
+
 /*
 ** CAPI3REF: Virtual File System Objects
 **
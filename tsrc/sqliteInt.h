@@ -637,6 +637,14 @@
 # define SQLITE_DEFAULT_PCACHE_INITSZ 20
 #endif
 
+/*
+** Default page replacement policy for the default page cache. One of
+** the SQLITE_PCACHE_POLICY_* values.
+*/
+#ifndef SQLITE_DEFAULT_PCACHE_POLICY
+# define SQLITE_DEFAULT_PCACHE_POLICY SQLITE_PCACHE_POLICY_LRU
+#endif
+
 /*
 ** Default value for the SQLITE_CONFIG_SORTERREF_SIZE option.
 */
@@ -1358,6 +1366,9 @@ struct sqlite3 {
   u8 bBenignMalloc;             /* Do not require OOMs if true */
   u8 dfltLockMode;              /* Default locking-mode for attached dbs */
   signed char nextAutovac;      /* Autovac setting after VACUUM if >=0 */
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+  signed char nextFreemap;      /* Free-space map setting after VACUUM if >=0 */
+#endif
   u8 suppressErr;               /* Do not issue error messages if true */
   u8 vtabOnConflict;            /* Value to return for s3_vtab_on_conflict() */
   u8 isTransactionSavepoint;    /* True if the outermost savepoint is a TS */
@@ -1545,6 +1556,7 @@ struct sqlite3 {
    /* TH3 expects the Stat34  ^^^^^^ value to be 0x0800.  Don't change it */
 #define SQLITE_PushDown       0x1000   /* The push-down optimization */
 #define SQLITE_SimplifyJoin   0x2000   /* Convert LEFT JOIN to JOIN */
+#define SQLITE_FixedFilter    0x4000   /* OP_FixedFilter on full scans */
 #define SQLITE_AllOpts        0xffff   /* All optimizations */
 
 /*
@@ -1901,6 +1913,7 @@ struct Table {
   Select *pSelect;     /* NULL for tables.  Points to definition if a view. */
   FKey *pFKey;         /* Linked list of all foreign keys in this table */
   char *zColAff;       /* String defining the affinity of each column */
+  u32 *aFixOff;        /* Column offsets for WITHOUT VARINT records, or NULL */
   ExprList *pCheck;    /* All CHECK constraints */
                        /*   ... also used as column name list in a VIEW */
   int tnum;            /* Root BTree page for this table */
@@ -1947,6 +1960,7 @@ struct Table {
 #define TF_StatsUsed       0x0100    /* Query planner decisions affected by
                                      ** Index.aiRowLogEst[] values */
 #define TF_HasNotNull      0x0200    /* Contains NOT NULL constraints */
+#define TF_Fixed           0x0400    /* WITHOUT VARINT.  Fixed-width records */
 
 /*
 ** Test to see whether or not a table is a virtual table.  This is
@@ -1981,6 +1995,9 @@ struct Table {
 #define HasRowid(X)     (((X)->tabFlags & TF_WithoutRowid)==0)
 #define VisibleRowid(X) (((X)->tabFlags & TF_NoVisibleRowid)==0)
 
+/* Are the records of the table stored in the WITHOUT VARINT format */
+#define HasFixedRecord(X) (((X)->tabFlags & TF_Fixed)!=0)
+
 /*
 ** Each foreign key constraint is an instance of the following structure.
 **
@@ -3161,6 +3178,10 @@ struct AuthContext {
 #define OPFLAG_SAVEPOSITION  0x02    /* OP_Delete/Insert: save cursor pos */
 #define OPFLAG_AUXDELETE     0x04    /* OP_Delete: index in a DELETE op */
 #define OPFLAG_NOCHNG_MAGIC  0x6d    /* OP_MakeRecord: serialtype 10 is ok */
+#define OPFLAG_LOOPEN        0x01    /* OP_DeleteRange: lower bound is > */
+#define OPFLAG_HIOPEN        0x02    /* OP_DeleteRange: upper bound is < */
+#define OPFLAG_NOLO          0x04    /* OP_DeleteRange: no lower bound */
+#define OPFLAG_NOHI          0x08    /* OP_DeleteRange: no upper bound */
 
 /*
  * Each trigger present in the database schema is stored as an instance of
@@ -3359,6 +3380,7 @@ struct Sqlite3Config {
   int bLocaltimeFault;              /* True to fail localtime() calls */
   int iOnceResetThreshold;          /* When to reset OP_Once counters */
   u32 szSorterRef;                  /* Min size in bytes to use sorter-refs */
+  int ePcachePolicy;                /* SQLITE_PCACHE_POLICY_* value */
 };
 
 /*
@@ -3728,7 +3750,7 @@ void sqlite3AddPrimaryKey(Parse*, ExprList*, int, int, int);
 void sqlite3AddCheckConstraint(Parse*, Expr*);
 void sqlite3AddDefaultValue(Parse*,Expr*,const char*,const char*);
 void sqlite3AddCollateType(Parse*, Token*);
-void sqlite3EndTable(Parse*,Token*,Token*,u8,Select*);
+void sqlite3EndTable(Parse*,Token*,Token*,u32,Select*);
 int sqlite3ParseUri(const char*,const char*,unsigned int*,
                     sqlite3_vfs**,char**,char **);
 Btree *sqlite3DbNameToBtree(sqlite3*,const char*);
@@ -3819,6 +3841,9 @@ int sqlite3WhereIsSorted(WhereInfo*);
 int sqlite3WhereContinueLabel(WhereInfo*);
 int sqlite3WhereBreakLabel(WhereInfo*);
 int sqlite3WhereOkOnePass(WhereInfo*, int*);
+#ifdef SQLITE_ENABLE_COUNTED_BTREE
+int sqlite3WhereScanCursor(WhereInfo*, int*);
+#endif
 #define ONEPASS_OFF      0        /* Use of ONEPASS not allowed */
 #define ONEPASS_SINGLE   1        /* ONEPASS valid for a single row update */
 #define ONEPASS_MULTI    2        /* ONEPASS is valid for multiple rows */
@@ -4477,6 +4502,15 @@ int sqlite3DbpageRegister(sqlite3*);
 #if defined(SQLITE_ENABLE_DBSTAT_VTAB) || defined(SQLITE_TEST)
 int sqlite3DbstatRegister(sqlite3*);
 #endif
+#if defined(SQLITE_ENABLE_PARTITION) || defined(SQLITE_TEST)
+int sqlite3PartitionInit(sqlite3*);
+#endif
+#if defined(SQLITE_ENABLE_BITMAP) || defined(SQLITE_TEST)
+int sqlite3BitmapInit(sqlite3*);
+#endif
+#if defined(SQLITE_ENABLE_INTERVAL) || defined(SQLITE_TEST)
+int sqlite3IntervalInit(sqlite3*);
+#endif
 
 int sqlite3ExprVectorSize(Expr *pExpr);
 int sqlite3ExprIsVector(Expr *pExpr);
@@ -245,6 +245,10 @@ int sqlite3RunVacuum(char **pzErrMsg, sqlite3 *db, int iDb){
   sqlite3BtreeSetAutoVacuum(pTemp, db->nextAutovac>=0 ? db->nextAutovac :
                                            sqlite3BtreeGetAutoVacuum(pMain));
 #endif
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+  sqlite3BtreeSetFreemap(pTemp, db->nextFreemap>=0 ? db->nextFreemap :
+                                           sqlite3BtreeGetFreemap(pMain));
+#endif
 
   /* Query the schema of the main database. Create a mirror schema
   ** in the temporary database.
@@ -336,6 +340,9 @@ int sqlite3RunVacuum(char **pzErrMsg, sqlite3 *db, int iDb){
     if( rc!=SQLITE_OK ) goto end_of_vacuum;
 #ifndef SQLITE_OMIT_AUTOVACUUM
     sqlite3BtreeSetAutoVacuum(pMain, sqlite3BtreeGetAutoVacuum(pTemp));
+#endif
+#ifdef SQLITE_ENABLE_FREE_SPACE_MAP
+    sqlite3BtreeSetFreemap(pMain, sqlite3BtreeGetFreemap(pTemp));
 #endif
   }
 
@@ -213,6 +213,9 @@ static VdbeCursor *allocateCursor(
   nByte = 
       ROUND8(sizeof(VdbeCursor)) + 2*sizeof(u32)*nField + 
       (eCurType==CURTYPE_BTREE?sqlite3BtreeCursorSize():0);
+#ifdef SQLITE_ENABLE_HEADER_CACHE
+  nByte = ROUND8(nByte) + VDBE_HDRCACHE_SIZE(nField);
+#endif
 
   assert( iCur>=0 && iCur<p->nCursor );
   if( p->apCsr[iCur] ){ /*OPTIMIZATION-IF-FALSE*/
@@ -231,6 +234,12 @@ static VdbeCursor *allocateCursor(
           &pMem->z[ROUND8(sizeof(VdbeCursor))+2*sizeof(u32)*nField];
       sqlite3BtreeCursorZero(pCx->uc.pCursor);
     }
+#ifdef SQLITE_ENABLE_HEADER_CACHE
+    pCx->aHdrCache = (u8*)&pMem->z[nByte - VDBE_HDRCACHE_SIZE(nField)];
+    pCx->nHdrCache = 0;
+    pCx->nHdrSkip = 0;
+    pCx->nHdrBackoff = 0;
+#endif
   }
   return pCx;
 }
@@ -271,6 +280,49 @@ static void applyNumericAffinity(Mem *pRec, int bTryForInt){
   pRec->flags &= ~MEM_Str;
 }
 
+#ifdef SQLITE_ENABLE_RANGE_DELETE
+/*
+** Convert a bound of an OP_DeleteRange, held in register pIn, into an
+** inclusive integer key bound and store it in *piKey.  bUpper is true
+** for the upper bound and bOpen is true if the bound value itself is
+** excluded.
+**
+** Return 0 on success, 1 if no rowid can satisfy the bound, or 2 if the
+** bound is not a number that can be compared exactly with a rowid.
+*/
+static int deleteRangeBound(Mem *pIn, int bUpper, int bOpen, i64 *piKey){
+  i64 iKey;
+  if( pIn->flags & MEM_Null ) return 1;
+  if( (pIn->flags & (MEM_Int|MEM_Real|MEM_Str))==MEM_Str ){
+    applyNumericAffinity(pIn, 0);
+  }
+  if( pIn->flags & MEM_Int ){
+    iKey = pIn->u.i;
+  }else if( pIn->flags & MEM_Real ){
+    double r = pIn->u.r;
+    /* Beyond 2**52 a real bound might not compare exactly with a rowid */
+    if( r<=-4503599627370496.0 || r>=4503599627370496.0 ) return 2;
+    iKey = (i64)r;
+    if( r!=(double)iKey ){
+      /* A fractional bound never equals a rowid.  Round it towards the
+      ** inside of the range.  e.g. (x > 4.9) becomes (x >= 5) */
+      if( bUpper && r<(double)iKey ) iKey--;
+      if( !bUpper && r>(double)iKey ) iKey++;
+      *piKey = iKey;
+      return 0;
+    }
+  }else{
+    return 2;
+  }
+  if( bOpen ){
+    if( iKey==(bUpper ? SMALLEST_INT64 : LARGEST_INT64) ) return 1;
+    iKey += bUpper ? -1 : 1;
+  }
+  *piKey = iKey;
+  return 0;
+}
+#endif /* SQLITE_ENABLE_RANGE_DELETE */
+
 /*
 ** Processing is determine by the affinity parameter:
 **
@@ -532,6 +584,103 @@ static int checkSavepointCount(sqlite3 *db){
 }
 #endif
 
+/*
+** Serial types used to decode and encode the N-byte big-endian integers
+** of a WITHOUT VARINT record.  See computeFixedLayout() in build.c for
+** a description of the record format.
+*/
+static const u8 aFixedSerialType[] = { 0, 1, 2, 0, 4, 0, 0, 0, 6 };
+
+/*
+** Extract column iCol from the WITHOUT VARINT record that cursor pC
+** points to and store it in pDest.  pC->aRow, pC->szRow and
+** pC->payloadSize must already describe the current row.
+*/
+static int vdbeFixedColumn(VdbeCursor *pC, int iCol, Mem *pDest){
+  const u32 *aOff = pC->aFixOff;
+  u32 nMap = ((u32)pC->nField+7)/8;       /* Size of the NULL bitmap */
+  u32 iOff = 1 + nMap + aOff[iCol];       /* Offset of the column value */
+  u32 nByte = aOff[iCol+1] - aOff[iCol];  /* Size of the column value */
+  const u8 *z;
+  u8 aBuf[8];
+  int rc;
+
+  assert( iCol<pC->nField );
+  if( pC->payloadSize!=1+nMap+aOff[pC->nField] || pC->aRow[0]!=0 ){
+    return SQLITE_CORRUPT_BKPT;
+  }
+  if( pC->szRow>=iOff+nByte ){
+    z = pC->aRow;
+    if( nByte==0 || (z[1+iCol/8] & (1<<(iCol&7)))!=0 ){
+      sqlite3VdbeMemSetNull(pDest);
+      return SQLITE_OK;
+    }
+    z += iOff;
+  }else{
+    /* Part of the record is on overflow pages */
+    rc = sqlite3BtreePayload(pC->uc.pCursor, 1+iCol/8, 1, aBuf);
+    if( rc ) return rc;
+    if( nByte==0 || (aBuf[0] & (1<<(iCol&7)))!=0 ){
+      sqlite3VdbeMemSetNull(pDest);
+      return SQLITE_OK;
+    }
+    rc = sqlite3BtreePayload(pC->uc.pCursor, iOff, nByte, aBuf);
+    if( rc ) return rc;
+    z = aBuf;
+  }
+  sqlite3VdbeSerialGet(z, aFixedSerialType[nByte], pDest);
+  return SQLITE_OK;
+}
+
+/*
+** Build a WITHOUT VARINT record for table pTab from the pTab->nCol
+** registers starting at pData0 and store it in pOut.  Column affinities
+** must already have been applied.  Every value must be NULL or an
+** integer that fits in the width of its column.
+*/
+static int vdbeMakeFixedRecord(Vdbe *p, Table *pTab, Mem *pData0, Mem *pOut){
+  static const char *azType[] = { "NULL", "INTEGER", "REAL", "TEXT", "BLOB" };
+  const u32 *aOff = pTab->aFixOff;
+  u32 nMap = ((u32)pTab->nCol+7)/8;
+  u32 nRec = 1 + nMap + aOff[pTab->nCol];
+  u8 *z;
+  int i;
+
+  if( sqlite3VdbeMemClearAndResize(pOut, (int)nRec) ){
+    return SQLITE_NOMEM_BKPT;
+  }
+  z = (u8*)pOut->z;
+  memset(z, 0, nRec);
+  for(i=0; i<pTab->nCol; i++){
+    Mem *pRec = &pData0[i];
+    u32 nByte = aOff[i+1] - aOff[i];
+    assert( memIsValid(pRec) );
+    if( nByte==0 || (pRec->flags & MEM_Null)!=0 ){
+      assert( nByte>0 || (pRec->flags & MEM_Null)!=0 );
+      z[1+i/8] |= 1<<(i&7);
+      continue;
+    }
+    if( (pRec->flags & MEM_Int)==0 ){
+      sqlite3VdbeError(p, "cannot store %s value in %s column %s.%s",
+          azType[sqlite3_value_type(pRec)%ArraySize(azType)],
+          sqlite3ColumnType(&pTab->aCol[i], ""),
+          pTab->zName, pTab->aCol[i].zName);
+      return SQLITE_MISMATCH;
+    }
+    if( nByte<8 && (pRec->u.i < -((i64)1<<(nByte*8-1))
+                 || pRec->u.i >= ((i64)1<<(nByte*8-1))) ){
+      sqlite3VdbeError(p, "integer %lld out of range for %s column %s.%s",
+          pRec->u.i, sqlite3ColumnType(&pTab->aCol[i], ""),
+          pTab->zName, pTab->aCol[i].zName);
+      return SQLITE_MISMATCH;
+    }
+    sqlite3VdbeSerialPut(&z[1+nMap+aOff[i]], pRec, aFixedSerialType[nByte]);
+  }
+  pOut->n = (int)nRec;
+  pOut->flags = MEM_Blob;
+  return SQLITE_OK;
+}
+
 /*
 ** Return the register of pOp->p2 after first preparing it to be
 ** overwritten with an integer value.
@@ -555,6 +704,29 @@ static Mem *out2Prerelease(Vdbe *p, VdbeOp *pOp){
   }
 }
 
+/*
+** Superinstructions.  When SQLITE_ENABLE_SUPERINSTRUCTIONS is defined,
+** resolveP2Values() in vdbeaux.c rewrites the first instruction of some
+** common pairs as a fused opcode (OP_ColumnChain, OP_ColumnReal and
+** OP_CompareJump).  The fused opcode does the work of the first
+** instruction and then goes directly to the code for the second, which
+** is left in place so that jumps to it still work.  VDBE_FUSED_STEP
+** moves to the second instruction, doing the bookkeeping that the top
+** of the loop would otherwise do for it.
+*/
+#ifdef SQLITE_ENABLE_SUPERINSTRUCTIONS
+# if defined(SQLITE_DEBUG)
+#  define VDBE_FUSED_STEP { pOp++; nVmStep++; \
+     if( db->flags & SQLITE_VdbeTrace ){ \
+       sqlite3VdbePrintOp(stdout, (int)(pOp - aOp), pOp); \
+     } }
+# elif defined(SQLITE_ENABLE_STMT_SCANSTATUS)
+#  define VDBE_FUSED_STEP { pOp++; nVmStep++; \
+     if( p->anExec ) p->anExec[(int)(pOp-aOp)]++; }
+# else
+#  define VDBE_FUSED_STEP { pOp++; nVmStep++; }
+# endif
+#endif
 
 /*
 ** Execute as much of a VDBE program as we can.
@@ -1735,6 +1907,9 @@ case OP_MustBeInt: {            /* jump, in1 */
 ** to have only a real value.
 */
 case OP_RealAffinity: {                  /* in1 */
+#ifdef SQLITE_ENABLE_SUPERINSTRUCTIONS
+op_real_affinity:
+#endif
   pIn1 = &aMem[pOp->p1];
   if( pIn1->flags & MEM_Int ){
     sqlite3VdbeMemRealify(pIn1);
@@ -2056,7 +2231,7 @@ case OP_ElseNotEq: {       /* same as TK_ESCAPE, jump */
 case OP_Permutation: {
   assert( pOp->p4type==P4_INTARRAY );
   assert( pOp->p4.ai );
-  assert( pOp[1].opcode==OP_Compare );
+  assert( pOp[1].opcode==OP_Compare || pOp[1].opcode==OP_CompareJump );
   assert( pOp[1].p5 & OPFLAG_PERMUTE );
   break;
 }
@@ -2081,6 +2256,17 @@ case OP_Permutation: {
 ** NULLs are less than numbers, numbers are less than strings,
 ** and strings are less than blobs.
 */
+/* Opcode: CompareJump P1 P2 P3 P4 P5
+** Synopsis: r[P1@P3] <-> r[P2@P3]
+**
+** A superinstruction that does the work of OP_Compare and then of the
+** OP_Jump that immediately follows it.  This opcode is never generated
+** directly.  It is substituted for OP_Compare by resolveP2Values() in
+** builds with SQLITE_ENABLE_SUPERINSTRUCTIONS.
+*/
+#ifdef SQLITE_ENABLE_SUPERINSTRUCTIONS
+case OP_CompareJump:
+#endif
 case OP_Compare: {
   int n;
   int i;
@@ -2133,6 +2319,13 @@ case OP_Compare: {
       break;
     }
   }
+#ifdef SQLITE_ENABLE_SUPERINSTRUCTIONS
+  if( pOp->opcode==OP_CompareJump ){
+    VDBE_FUSED_STEP;
+    assert( pOp->opcode==OP_Jump );
+    goto op_jump;
+  }
+#endif
   break;
 }
 
@@ -2143,6 +2336,9 @@ case OP_Compare: {
 ** equal to, or greater than the P2 vector, respectively.
 */
 case OP_Jump: {             /* jump */
+#ifdef SQLITE_ENABLE_SUPERINSTRUCTIONS
+op_jump:
+#endif
   if( iCompare<0 ){
     VdbeBranchTaken(0,3); pOp = &aOp[pOp->p1 - 1];
   }else if( iCompare==0 ){
@@ -2429,6 +2625,29 @@ case OP_Offset: {          /* out3 */
 ** or typeof() function, respectively.  The loading of large blobs can be
 ** skipped for length() and all content loading can be skipped for typeof().
 */
+/* Opcode: ColumnChain P1 P2 P3 P4 P5
+** Synopsis: r[P3]=PX
+**
+** A superinstruction that does the work of OP_Column and then continues
+** directly with the OP_Column, OP_ColumnChain or OP_ColumnReal that
+** immediately follows it.
+*/
+/* Opcode: ColumnReal P1 P2 P3 P4 P5
+** Synopsis: r[P3]=PX
+**
+** A superinstruction that does the work of OP_Column and then of the
+** OP_RealAffinity that immediately follows it.
+**
+** Neither this opcode nor OP_ColumnChain is generated directly.  They
+** are substituted for OP_Column by resolveP2Values() in builds with
+** SQLITE_ENABLE_SUPERINSTRUCTIONS.
+*/
+#ifdef SQLITE_ENABLE_SUPERINSTRUCTIONS
+case OP_ColumnChain:
+#ifndef SQLITE_OMIT_FLOATING_POINT
+case OP_ColumnReal:
+#endif
+#endif
 case OP_Column: {
   int p2;            /* column number to retrieve */
   VdbeCursor *pC;    /* The VDBE cursor */
@@ -2445,6 +2664,9 @@ case OP_Column: {
   u32 t;             /* A type code from the record header */
   Mem *pReg;         /* PseudoTable input register */
 
+#ifdef SQLITE_ENABLE_SUPERINSTRUCTIONS
+op_column:
+#endif
   pC = p->apCsr[pOp->p1];
   p2 = pOp->p2;
 
@@ -2465,6 +2687,30 @@ case OP_Column: {
   assert( pC->eCurType!=CURTYPE_PSEUDO || pC->nullRow );
   assert( pC->eCurType!=CURTYPE_SORTER );
 
+  if( pC->aFixOff ){
+    /* A WITHOUT VARINT record.  Every column is at a fixed offset so there
+    ** is no header to parse. */
+    assert( pC->eCurType==CURTYPE_BTREE );
+    if( pC->nullRow ){
+      sqlite3VdbeMemSetNull(pDest);
+      goto op_column_out;
+    }
+    if( pC->cacheStatus!=p->cacheCtr ){
+      pCrsr = pC->uc.pCursor;
+      assert( sqlite3BtreeCursorIsValid(pCrsr) );
+      pC->payloadSize = sqlite3BtreePayloadSize(pCrsr);
+      pC->aRow = sqlite3BtreePayloadFetch(pCrsr, &pC->szRow);
+      pC->cacheStatus = p->cacheCtr;
+    }
+    if( VdbeMemDynamic(pDest) ){
+      sqlite3VdbeMemSetNull(pDest);
+    }
+    rc = vdbeFixedColumn(pC, p2, pDest);
+    if( rc==SQLITE_CORRUPT ) goto op_column_corrupt;
+    if( rc ) goto abort_due_to_error;
+    goto op_column_out;
+  }
+
   if( pC->cacheStatus!=p->cacheCtr ){                /*OPTIMIZATION-IF-FALSE*/
     if( pC->nullRow ){
       if( pC->eCurType==CURTYPE_PSEUDO ){
@@ -2494,6 +2740,25 @@ case OP_Column: {
       }
     }
     pC->cacheStatus = p->cacheCtr;
+#ifdef SQLITE_ENABLE_HEADER_CACHE
+    if( pC->nHdrCache>0 ){
+      if( pC->szRow>=pC->nHdrCache
+       && pC->payloadSize==pC->szHdrCacheRow
+       && memcmp(pC->aRow, pC->aHdrCache, pC->nHdrCache)==0
+      ){
+        /* This row has the same header as the row that aType[] and
+        ** aOffset[] were decoded from.  Keep the decode, along with
+        ** nHdrParsed and iHdrOffset, and only parse whatever part of the
+        ** header has not been parsed yet. */
+        pC->nHdrBackoff = 0;
+        goto op_column_header_cached;
+      }
+      pC->nHdrCache = 0;
+      pC->nHdrBackoff = pC->nHdrBackoff ?
+          MIN(pC->nHdrBackoff*2, VDBE_HDRCACHE_BACKOFF) : 1;
+      pC->nHdrSkip = pC->nHdrBackoff;
+    }
+#endif
     pC->iHdrOffset = getVarint32(pC->aRow, aOffset[0]);
     pC->nHdrParsed = 0;
 
@@ -2535,9 +2800,22 @@ case OP_Column: {
       zData = pC->aRow;
       assert( pC->nHdrParsed<=p2 );         /* Conditional skipped */
       testcase( aOffset[0]==0 );
+#ifdef SQLITE_ENABLE_HEADER_CACHE
+      assert( pC->nHdrCache==0 );
+      if( pC->nHdrSkip>0 ){
+        pC->nHdrSkip--;
+      }else if( aOffset[0]<=VDBE_HDRCACHE_SIZE(pC->nField) ){
+        memcpy(pC->aHdrCache, zData, aOffset[0]);
+        pC->nHdrCache = aOffset[0];
+        pC->szHdrCacheRow = pC->payloadSize;
+      }
+#endif
       goto op_column_read_header;
     }
   }
+#ifdef SQLITE_ENABLE_HEADER_CACHE
+op_column_header_cached:
+#endif
 
   /* Make sure at least the first p2+1 entries of the header have been
   ** parsed and valid information is in aOffset[] and pC->aType[].
@@ -2565,6 +2843,26 @@ case OP_Column: {
       zEndHdr = zData + aOffset[0];
       testcase( zHdr>=zEndHdr );
       do{
+#ifdef SQLITE_ENABLE_HEADER_CACHE
+        /* Decode eight serial types at once if the next eight header bytes
+        ** are all single-byte varints.  This parses ahead of p2, so that a
+        ** later row that reuses this decode has more of it available. */
+        if( zHdr+8<=zEndHdr && i+8<=pC->nField ){
+          u64 x;
+          memcpy(&x, zHdr, 8);
+          if( (x & ((((u64)0x80808080)<<32)|0x80808080))==0 ){
+            int j;
+            for(j=0; j<8; j++){
+              t = zHdr[j];
+              offset64 += sqlite3VdbeOneByteSerialTypeLen(t);
+              pC->aType[i++] = t;
+              aOffset[i] = (u32)(offset64 & 0xffffffff);
+            }
+            zHdr += 8;
+            continue;
+          }
+        }
+#endif
         if( (t = zHdr[0])<0x80 ){
           zHdr++;
           offset64 += sqlite3VdbeOneByteSerialTypeLen(t);
@@ -2596,6 +2894,9 @@ case OP_Column: {
       pC->nHdrParsed = i;
       pC->iHdrOffset = (u32)(zHdr - zData);
       if( pC->aRow==0 ) sqlite3VdbeMemRelease(&sMem);
+#ifdef SQLITE_ENABLE_HEADER_CACHE
+      if( i>p2 ) t = pC->aType[p2];
+#endif
     }else{
       t = 0;
     }
@@ -2683,6 +2984,21 @@ case OP_Column: {
 op_column_out:
   UPDATE_MAX_BLOBSIZE(pDest);
   REGISTER_TRACE(pOp->p3, pDest);
+#ifdef SQLITE_ENABLE_SUPERINSTRUCTIONS
+  if( pOp->opcode==OP_ColumnChain ){
+    VDBE_FUSED_STEP;
+    assert( pOp->opcode==OP_Column || pOp->opcode==OP_ColumnChain
+         || pOp->opcode==OP_ColumnReal );
+    goto op_column;
+  }
+#ifndef SQLITE_OMIT_FLOATING_POINT
+  if( pOp->opcode==OP_ColumnReal ){
+    VDBE_FUSED_STEP;
+    assert( pOp->opcode==OP_RealAffinity );
+    goto op_real_affinity;
+  }
+#endif
+#endif
   break;
 
 op_column_corrupt:
@@ -2736,6 +3052,10 @@ case OP_Affinity: {
 ** macros defined in sqliteInt.h.
 **
 ** If P4 is NULL then all index fields have the affinity BLOB.
+**
+** If P4 is a P4_TABLE pointer to a WITHOUT VARINT table, then build a
+** fixed-width record for that table instead.  The affinities must have
+** been applied by a prior OP_Affinity.
 */
 case OP_MakeRecord: {
   u8 *zNewRecord;        /* A buffer to hold the data for the new record */
@@ -2774,7 +3094,7 @@ case OP_MakeRecord: {
   nHdr = 0;          /* Number of bytes of header space */
   nZero = 0;         /* Number of zero bytes at the end of the record */
   nField = pOp->p1;
-  zAffinity = pOp->p4.z;
+  zAffinity = pOp->p4type==P4_TABLE ? 0 : pOp->p4.z;
   assert( nField>0 && pOp->p2>0 && pOp->p2+nField<=(p->nMem+1 - p->nCursor)+1 );
   pData0 = &aMem[nField];
   nField = pOp->p2;
@@ -2786,6 +3106,18 @@ case OP_MakeRecord: {
   pOut = &aMem[pOp->p3];
   memAboutToChange(p, pOut);
 
+  if( pOp->p4type==P4_TABLE ){
+    /* A record for a WITHOUT VARINT table.  The affinities have already
+    ** been applied by an OP_Affinity opcode. */
+    assert( HasFixedRecord(pOp->p4.pTab) && nField==pOp->p4.pTab->nCol );
+    rc = vdbeMakeFixedRecord(p, pOp->p4.pTab, pData0, pOut);
+    if( rc==SQLITE_NOMEM ) goto no_mem;
+    if( rc ) goto abort_due_to_error;
+    REGISTER_TRACE(pOp->p3, pOut);
+    UPDATE_MAX_BLOBSIZE(pOut);
+    break;
+  }
+
   /* Apply the requested affinity to all inputs
   */
   assert( pData0<=pLast );
@@ -3386,7 +3718,9 @@ case OP_SetCookie: {
 ** a KeyInfo structure (P4_KEYINFO). If it is a pointer to a KeyInfo 
 ** structure, then said structure defines the content and collating 
 ** sequence of the index being opened. Otherwise, if P4 is an integer 
-** value, it is set to the number of columns in the table.
+** value, it is set to the number of columns in the table.  P4 may also
+** be a pointer to the Table (P4_TABLE) of a WITHOUT VARINT table, in
+** which case the cursor decodes records using the layout of that table.
 **
 ** See also: OpenWrite, ReopenIdx
 */
@@ -3496,6 +3830,9 @@ case OP_OpenWrite:
     nField = pKeyInfo->nAllField;
   }else if( pOp->p4type==P4_INT32 ){
     nField = pOp->p4.i;
+  }else if( pOp->p4type==P4_TABLE ){
+    assert( HasFixedRecord(pOp->p4.pTab) );
+    nField = pOp->p4.pTab->nCol;
   }
   assert( pOp->p1>=0 );
   assert( nField>=0 );
@@ -3505,6 +3842,7 @@ case OP_OpenWrite:
   pCur->nullRow = 1;
   pCur->isOrdered = 1;
   pCur->pgnoRoot = p2;
+  if( pOp->p4type==P4_TABLE ) pCur->aFixOff = pOp->p4.pTab->aFixOff;
 #ifdef SQLITE_DEBUG
   pCur->wrFlag = wrFlag;
 #endif
@@ -5036,6 +5374,56 @@ case OP_Rewind: {        /* jump */
   break;
 }
 
+#if defined(SQLITE_ENABLE_COUNTED_BTREE) && !defined(SQLITE_OMIT_BTREECOUNT)
+/* Opcode: SeekOffset P1 P2 P3 * P5
+** Synopsis: skip r[P3] entries
+**
+** If register P3 holds a positive integer N, move cursor P1 to the entry
+** that has N entries before it in its table or index, or N entries after
+** it if P5 is non-zero, and set register P3 to zero.  If there is no
+** such entry, jump to P2.  If register P3 is zero or negative, this
+** opcode is a no-op.
+**
+** This opcode is coded at the top of the body of a loop that visits
+** every entry of P1 in order, with P3 the OFFSET counter of the SELECT.
+** The first pass through the loop moves the cursor over the OFFSET
+** rows using the subtree entry counts of the b-tree, instead of stepping
+** through them one at a time.
+*/
+case OP_SeekOffset: {     /* jump, in3 */
+  VdbeCursor *pC;
+  BtCursor *pCrsr;
+  i64 iRank;
+  int res;
+
+  pIn3 = &aMem[pOp->p3];
+  assert( pIn3->flags & MEM_Int );
+  if( pIn3->u.i<=0 ) break;
+  assert( pOp->p1>=0 && pOp->p1<p->nCursor );
+  pC = p->apCsr[pOp->p1];
+  assert( pC!=0 );
+  assert( pC->eCurType==CURTYPE_BTREE );
+  pCrsr = pC->uc.pCursor;
+  assert( pCrsr );
+  iRank = pIn3->u.i;
+  pIn3->u.i = 0;
+  if( pOp->p5 ){
+    i64 nEntry = 0;
+    rc = sqlite3BtreeCount(pCrsr, &nEntry);
+    if( rc ) goto abort_due_to_error;
+    iRank = nEntry - 1 - iRank;
+  }
+  rc = sqlite3BtreeSeekRank(pCrsr, iRank, &res);
+  if( rc ) goto abort_due_to_error;
+  pC->deferredMoveto = 0;
+  pC->cacheStatus = CACHE_STALE;
+  pC->nullRow = (u8)res;
+  VdbeBranchTaken(res!=0,2);
+  if( res ) goto jump_to_p2;
+  break;
+}
+#endif
+
 /* Opcode: Next P1 P2 P3 P4 P5
 **
 ** Advance cursor P1 so that it points to the next key/data pair in its
@@ -5157,6 +5545,94 @@ next_tail:
   goto check_for_interrupt;
 }
 
+/* Opcode: FixedFilter P1 P2 P3 P4 P5
+** Synopsis: skip rows unless P1.column[P3] cmp P4
+**
+** Cursor P1 is a table cursor on a WITHOUT VARINT table that points to
+** a valid row.  Move P1 forward until it points to a row for which the
+** value of column P3 compared against the integer P4 gives a result
+** allowed by P5.  Bit 0x01 of P5 accepts values less than P4, bit 0x02
+** values equal to P4 and bit 0x04 values greater than P4.  A NULL value
+** is never accepted.  If bit 0x08 of P5 is set the cursor moves backward
+** instead.  Jump to P2 if the end of the table is reached first.
+**
+** Rows that fail the comparison are skipped inside this opcode, without
+** being decoded into registers and tested by further opcodes.  This
+** speeds up full table scans that reject most rows.
+**
+** A forward scan also records the minimum and maximum value of column P3
+** for each leaf page it visits in full.  When the cursor later arrives
+** at a leaf page whose range of values cannot satisfy the comparison,
+** the whole page is skipped without looking at its rows.
+*/
+case OP_FixedFilter: {      /* jump */
+  VdbeCursor *pC;
+  BtCursor *pCrsr;
+  i64 iRhs;
+  i64 iMin, iMax;
+  Mem m;
+  int bRev;
+  int res;
+
+  assert( pOp->p1>=0 && pOp->p1<p->nCursor );
+  assert( pOp->p4type==P4_INT64 );
+  pC = p->apCsr[pOp->p1];
+  assert( pC!=0 );
+  assert( pC->eCurType==CURTYPE_BTREE );
+  assert( pC->aFixOff!=0 );
+  assert( pC->deferredMoveto==0 );
+  assert( pOp->p3>=0 && pOp->p3<pC->nField );
+  pCrsr = pC->uc.pCursor;
+  iRhs = *pOp->p4.pI64;
+  bRev = (pOp->p5 & 0x08)!=0;
+  sqlite3VdbeMemInit(&m, db, MEM_Null);
+  while( 1 ){
+    if( sqlite3BtreeZoneGet(pCrsr, pOp->p3+1, bRev, &iMin, &iMax) ){
+      res = (iMin<iRhs ? 0x01 : 0)
+          | (iMin<=iRhs && iRhs<=iMax ? 0x02 : 0)
+          | (iMax>iRhs ? 0x04 : 0);
+      if( iMin>iMax || (res & pOp->p5)==0 ){
+        /* No row on this leaf page can match */
+        rc = sqlite3BtreeSkipLeaf(pCrsr, bRev);
+        goto fixed_filter_step;
+      }
+    }
+    if( pC->cacheStatus!=p->cacheCtr ){
+      assert( sqlite3BtreeCursorIsValid(pCrsr) );
+      pC->payloadSize = sqlite3BtreePayloadSize(pCrsr);
+      pC->aRow = sqlite3BtreePayloadFetch(pCrsr, &pC->szRow);
+      pC->cacheStatus = p->cacheCtr;
+    }
+    rc = vdbeFixedColumn(pC, pOp->p3, &m);
+    if( rc ) goto abort_due_to_error;
+    if( !bRev ){
+      sqlite3BtreeZoneAdd(pCrsr, pOp->p3+1, m.u.i, (m.flags & MEM_Int)==0);
+    }
+    if( m.flags & MEM_Int ){
+      res = m.u.i<iRhs ? 0x01 : (m.u.i==iRhs ? 0x02 : 0x04);
+      if( res & pOp->p5 ) break;
+    }
+    if( db->u1.isInterrupted ) goto abort_due_to_interrupt;
+    if( bRev ){
+      rc = sqlite3BtreePrevious(pCrsr, 0);
+    }else{
+      rc = sqlite3BtreeNext(pCrsr, 0);
+    }
+fixed_filter_step:
+    pC->cacheStatus = CACHE_STALE;
+    if( rc ){
+      VdbeBranchTaken(1, 2);
+      if( rc!=SQLITE_DONE ) goto abort_due_to_error;
+      rc = SQLITE_OK;
+      pC->nullRow = 1;
+      goto jump_to_p2;
+    }
+    p->aCounter[SQLITE_STMTSTATUS_FULLSCAN_STEP]++;
+  }
+  VdbeBranchTaken(0, 2);
+  break;
+}
+
 /* Opcode: IdxInsert P1 P2 P3 P4 P5
 ** Synopsis: key=r[P2]
 **
@@ -5538,6 +6014,71 @@ case OP_Clear: {
   break;
 }
 
+#ifdef SQLITE_ENABLE_RANGE_DELETE
+/* Opcode: DeleteRange P1 P2 P3 P4 P5
+** Synopsis: r[P3]<=rowid<=r[P3+1]
+**
+** Delete every row whose rowid lies between the values in registers P3
+** and P3+1 from the table that write cursor P1 is open on, then jump to
+** P2.  The bound values themselves are excluded if the OPFLAG_LOOPEN or
+** OPFLAG_HIOPEN bits of P5 are set, and a bound is ignored altogether if
+** the OPFLAG_NOLO or OPFLAG_NOHI bit is set.  A NULL bound matches no
+** rows.
+**
+** Subtrees that lie wholly inside the range are freed without visiting
+** each row, so no update hook or pre-update hook is invoked for the
+** deleted rows.
+**
+** If a bound is not a number that compares exactly with an integer rowid,
+** nothing is deleted and control falls through to the next instruction,
+** which is expected to delete the rows one at a time instead.
+**
+** If P4 is non-zero, the row change count is incremented by the number
+** of rows deleted.  If P4 is greater than zero, the value stored in
+** register P4 is also incremented by that number.
+*/
+case OP_DeleteRange: {        /* jump */
+  VdbeCursor *pC;
+  i64 iLo = SMALLEST_INT64;
+  i64 iHi = LARGEST_INT64;
+  int nChange = 0;
+  int e = 0;
+
+  assert( pOp->p1>=0 && pOp->p1<p->nCursor );
+  pC = p->apCsr[pOp->p1];
+  assert( pC!=0 );
+  assert( pC->eCurType==CURTYPE_BTREE );
+  assert( pC->isTable );
+  assert( pC->uc.pCursor!=0 );
+  assert( pOp->p4type==P4_INT32 );
+  if( (pOp->p5 & OPFLAG_NOLO)==0 ){
+    e = deleteRangeBound(&aMem[pOp->p3], 0, pOp->p5 & OPFLAG_LOOPEN, &iLo);
+  }
+  if( e==0 && (pOp->p5 & OPFLAG_NOHI)==0 ){
+    e = deleteRangeBound(&aMem[pOp->p3+1], 1, pOp->p5 & OPFLAG_HIOPEN, &iHi);
+  }
+  VdbeBranchTaken(e!=2, 2);
+  if( e==2 ) break;
+  if( e==0 ){
+    sqlite3VdbeIncrWriteCounter(p, pC);
+    rc = sqlite3BtreeDeleteRange(pC->uc.pCursor, iLo, iHi,
+                                 (pOp->p4.i ? &nChange : 0));
+    pC->cacheStatus = CACHE_STALE;
+    pC->seekResult = 0;
+    if( pOp->p4.i ){
+      p->nChange += nChange;
+      if( pOp->p4.i>0 ){
+        assert( memIsValid(&aMem[pOp->p4.i]) );
+        memAboutToChange(p, &aMem[pOp->p4.i]);
+        aMem[pOp->p4.i].u.i += nChange;
+      }
+    }
+    if( rc ) goto abort_due_to_error;
+  }
+  goto jump_to_p2;
+}
+#endif /* SQLITE_ENABLE_RANGE_DELETE */
+
 /* Opcode: ResetSorter P1 * * * *
 **
 ** Delete all contents from the ephemeral table or sorter
@@ -6485,6 +7026,41 @@ case OP_JournalMode: {    /* out2 */
 };
 #endif /* SQLITE_OMIT_PRAGMA */
 
+#if !defined(SQLITE_OMIT_PRAGMA) && !defined(SQLITE_OMIT_PAGER_PRAGMAS)
+/* Opcode: CachePolicy P1 P2 P3 * *
+**
+** If P3 is not negative, set the replacement policy of the default page
+** cache to P3, which must be one of the SQLITE_PCACHE_POLICY_XXX values.
+** Then write the name of the current policy and the number of page cache
+** hits and misses of database P1 to registers P2, P2+1 and P2+2.
+*/
+case OP_CachePolicy: {
+  static const char *const azPolicy[] = { "lru", "2q" };
+  Btree *pBt;
+  int nHit = 0;
+  int nMiss = 0;
+
+  assert( pOp->p1>=0 && pOp->p1<db->nDb );
+  assert( pOp->p2>0 && pOp->p2+2<=(p->nMem+1 - p->nCursor) );
+  assert( pOp->p3<ArraySize(azPolicy) );
+  assert( SQLITE_PCACHE_POLICY_LRU==0 && SQLITE_PCACHE_POLICY_2Q==1 );
+  if( pOp->p3>=0 ) sqlite3GlobalConfig.ePcachePolicy = pOp->p3;
+  pBt = db->aDb[pOp->p1].pBt;
+  if( pBt ){
+    Pager *pPager = sqlite3BtreePager(pBt);
+    sqlite3PagerCacheStat(pPager, SQLITE_DBSTATUS_CACHE_HIT, 0, &nHit);
+    sqlite3PagerCacheStat(pPager, SQLITE_DBSTATUS_CACHE_MISS, 0, &nMiss);
+  }
+  pOut = &aMem[pOp->p2];
+  memAboutToChange(p, pOut);
+  sqlite3VdbeMemSetStr(pOut, azPolicy[sqlite3GlobalConfig.ePcachePolicy],
+                       -1, SQLITE_UTF8, SQLITE_STATIC);
+  sqlite3VdbeMemSetInt64(&pOut[1], nHit);
+  sqlite3VdbeMemSetInt64(&pOut[2], nMiss);
+  break;
+}
+#endif
+
 #if !defined(SQLITE_OMIT_VACUUM) && !defined(SQLITE_OMIT_ATTACH)
 /* Opcode: Vacuum P1 * * * *
 **
@@ -269,6 +269,9 @@ UnpackedRecord *sqlite3VdbeAllocUnpackedRecord(KeyInfo*);
 
 typedef int (*RecordCompare)(int,const void*,UnpackedRecord*);
 RecordCompare sqlite3VdbeFindCompare(UnpackedRecord*);
+#ifdef SQLITE_ENABLE_BTREE_KEYCACHE
+int sqlite3VdbeRecordIntKey(UnpackedRecord*, i64*);
+#endif
 
 #ifndef SQLITE_OMIT_TRIGGER
 void sqlite3VdbeLinkSubProgram(Vdbe *, SubProgram *);
@@ -88,6 +88,7 @@ struct VdbeCursor {
   Btree *pBtx;            /* Separate file holding temporary table */
   i64 seqCount;           /* Sequence counter */
   int *aAltMap;           /* Mapping from table to index column numbers */
+  const u32 *aFixOff;     /* Column offsets of WITHOUT VARINT records or NULL */
 
   /* Cached OP_Column parse information is only valid if cacheStatus matches
   ** Vdbe.cacheCtr.  Vdbe.cacheCtr will never take on the value of
@@ -119,6 +120,13 @@ struct VdbeCursor {
   const u8 *aRow;         /* Data for the current row, if all on one page */
   u32 payloadSize;        /* Total number of bytes in the record */
   u32 szRow;              /* Byte available in aRow */
+#ifdef SQLITE_ENABLE_HEADER_CACHE
+  u8 *aHdrCache;          /* Copy of the header aType[] was decoded from */
+  u32 nHdrCache;          /* Bytes in aHdrCache[].  0 if nothing cached */
+  u32 szHdrCacheRow;      /* payloadSize of the row aHdrCache[] came from */
+  u16 nHdrSkip;           /* Rows to go before a header is saved again */
+  u16 nHdrBackoff;        /* Value nHdrSkip was last set to */
+#endif
 #ifdef SQLITE_ENABLE_COLUMN_USED_MASK
   u64 maskUsed;           /* Mask of columns used by this cursor */
 #endif
@@ -135,6 +143,27 @@ struct VdbeCursor {
 */
 #define CACHE_STALE 0
 
+/*
+** When the library is built with SQLITE_ENABLE_HEADER_CACHE, each
+** VdbeCursor keeps a copy of the record header that its aType[] and
+** aOffset[] arrays were decoded from.  If the next row the cursor visits
+** has exactly the same header bytes, as is usual for tables of integers
+** and other fixed-size values, OP_Column keeps the earlier decode instead
+** of parsing the header again.  Headers larger than VDBE_HDRCACHE_SIZE()
+** bytes are not cached.
+**
+** Each time the next row turns out to have a different header, no header
+** is saved for the following 1, 2, 4 and so on rows, up to a limit of
+** VDBE_HDRCACHE_BACKOFF rows, so that scans of rows with varying headers
+** do not pay to copy and compare every one of them.
+*/
+#ifdef SQLITE_ENABLE_HEADER_CACHE
+# define VDBE_HDRCACHE_SIZE(nField) ROUND8(2*(nField)+3)
+# ifndef VDBE_HDRCACHE_BACKOFF
+#  define VDBE_HDRCACHE_BACKOFF 64
+# endif
+#endif
+
 /*
 ** When a sub-program is executed (OP_Program), a structure of this type
 ** is allocated to store the current value of the program counter, as
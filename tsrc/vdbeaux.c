@@ -740,6 +740,29 @@ static void resolveP2Values(Vdbe *p, int *pMaxFuncArgs){
       ** have non-negative values for P2. */
       assert( (sqlite3OpcodeProperty[pOp->opcode]&OPFLG_JUMP)==0 || pOp->p2>=0);
     }
+#ifdef SQLITE_ENABLE_SUPERINSTRUCTIONS
+    /* Substitute superinstructions for adjacent pairs of opcodes that
+    ** commonly run back to back.  The second opcode of each pair is left
+    ** unchanged so that it still works as a jump destination.  Because
+    ** this loop runs backwards, pOp[1] has already been through here. */
+    if( pOp<&p->aOp[p->nOp-1] ){
+      u8 opNext = pOp[1].opcode;
+      if( pOp->opcode==OP_Column ){
+        if( opNext==OP_Column || opNext==OP_ColumnChain
+         || opNext==OP_ColumnReal
+        ){
+          pOp->opcode = OP_ColumnChain;
+        }
+#ifndef SQLITE_OMIT_FLOATING_POINT
+        else if( opNext==OP_RealAffinity ){
+          pOp->opcode = OP_ColumnReal;
+        }
+#endif
+      }else if( pOp->opcode==OP_Compare && opNext==OP_Jump ){
+        pOp->opcode = OP_CompareJump;
+      }
+    }
+#endif
     if( pOp==p->aOp ) break;
     pOp--;
   }
@@ -4514,6 +4537,27 @@ RecordCompare sqlite3VdbeFindCompare(UnpackedRecord *p){
   return sqlite3VdbeRecordCompare;
 }
 
+#ifdef SQLITE_ENABLE_BTREE_KEYCACHE
+/*
+** If the first field of unpacked record p is an integer and the first
+** column of the index sorts in ascending order, set *piKey to the value
+** of that field and return non-zero.  Otherwise return zero.
+**
+** The b-tree layer uses this to decide whether or not the integer key
+** cache of an index page can narrow a search for p.
+*/
+int sqlite3VdbeRecordIntKey(UnpackedRecord *p, i64 *piKey){
+  if( p->nField>0
+   && (p->aMem[0].flags & MEM_Int)!=0
+   && p->pKeyInfo->aSortOrder[0]==0
+  ){
+    *piKey = p->aMem[0].u.i;
+    return 1;
+  }
+  return 0;
+}
+#endif /* SQLITE_ENABLE_BTREE_KEYCACHE */
+
 /*
 ** pCur points at an index entry created using the OP_MakeRecord opcode.
 ** Read the rowid (the last field in the record) and store it in *rowid.
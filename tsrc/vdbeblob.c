@@ -166,6 +166,10 @@ int sqlite3_blob_open(
       pTab = 0;
       sqlite3ErrorMsg(&sParse, "cannot open table without rowid: %s", zTable);
     }
+    if( pTab && HasFixedRecord(pTab) ){
+      pTab = 0;
+      sqlite3ErrorMsg(&sParse, "cannot open WITHOUT VARINT table: %s", zTable);
+    }
 #ifndef SQLITE_OMIT_VIEW
     if( pTab && pTab->pSelect ){
       pTab = 0;
@@ -453,11 +457,164 @@ int sqlite3_blob_write(sqlite3_blob *pBlob, const void *z, int n, int iOffset){
   return blobReadWrite(pBlob, (void *)z, n, iOffset, sqlite3BtreePutData);
 }
 
+#ifdef SQLITE_ENABLE_BLOB_APPEND
+/*
+** Append n bytes from z to the blob that handle p is open on.  The
+** b-tree cursor mutex must be held.
+**
+** If the blob is the last value in its record, its serial type does not
+** change size and sqlite3BtreeAppendData() can extend the payload in
+** place, only the serial type in the record header is rewritten.
+** Otherwise a new record is assembled in memory and replaces the row.
+*/
+static int blobAppend(Incrblob *p, const u8 *z, int n){
+  BtCursor *pCsr = p->pCsr;
+  u8 aHdr[9];               /* Buffer for varints read from the header */
+  u8 *aNew;                 /* New record, if the row must be rewritten */
+  u32 nPayload;             /* Size of the existing record */
+  u32 nHdr;                 /* Size of the existing record header */
+  u32 iType;                /* Offset of the serial type of the blob */
+  u32 t = 0;                /* Existing serial type of the blob */
+  u32 tNew;                 /* New serial type */
+  int szType = 0;           /* Size of the existing serial type varint */
+  int szTypeNew;            /* Size of the new serial type varint */
+  u32 nHdrNew;              /* Size of the new record header */
+  u32 nNew;                 /* Size of the new record */
+  u32 iEnd;                 /* Offset of the first byte after the blob */
+  u32 i;
+  int iCol;
+  int rc;
+
+  /* Locate the serial type of column iCol in the record header. The
+  ** first read also restores the cursor position if required. */
+  rc = sqlite3BtreePayloadChecked(pCsr, 0, 1, aHdr);
+  if( rc!=SQLITE_OK ) return rc;
+  nPayload = sqlite3BtreePayloadSize(pCsr);
+  rc = sqlite3BtreePayloadChecked(pCsr, 0, MIN(nPayload, 5), aHdr);
+  if( rc!=SQLITE_OK ) return rc;
+  iType = getVarint32(aHdr, nHdr);
+  if( nHdr>nPayload ) return SQLITE_CORRUPT_BKPT;
+  for(iCol=0; iCol<=p->iCol; iCol++){
+    u32 nRead = MIN(nHdr - iType, 9);
+    if( nRead==0 ) return SQLITE_CORRUPT_BKPT;
+    rc = sqlite3BtreePayloadChecked(pCsr, iType, nRead, aHdr);
+    if( rc!=SQLITE_OK ) return rc;
+    szType = getVarint32(aHdr, t);
+    if( (u32)szType>nRead ) return SQLITE_CORRUPT_BKPT;
+    if( iCol<p->iCol ) iType += szType;
+  }
+  if( t<12 || sqlite3VdbeSerialTypeLen(t)!=(u32)p->nByte ){
+    return SQLITE_CORRUPT_BKPT;
+  }
+  tNew = t + 2*n;
+  szTypeNew = sqlite3VarintLen(tNew);
+  iEnd = p->iOffset + p->nByte;
+
+  if( iEnd==nPayload && szTypeNew==szType ){
+    rc = sqlite3BtreeAppendData(pCsr, n, z);
+    if( rc==SQLITE_OK ){
+      putVarint32(aHdr, tNew);
+      rc = sqlite3BtreePutData(pCsr, iType, szType, aHdr);
+    }
+    if( rc!=SQLITE_DONE ) return rc;
+  }
+
+  /* Assemble the new record: the header with the new serial type, then
+  ** the existing body with the appended bytes following the blob. */
+  nHdrNew = nHdr - sqlite3VarintLen(nHdr) + szTypeNew - szType;
+  for(i=nHdrNew+1; sqlite3VarintLen(i)>(int)(i-nHdrNew); i++);
+  nHdrNew = i;
+  nNew = nHdrNew + (nPayload - nHdr) + n;
+  aNew = (u8*)sqlite3DbMallocRaw(p->db, nNew);
+  if( aNew==0 ) return SQLITE_NOMEM_BKPT;
+  i = putVarint32(aNew, nHdrNew);
+  rc = sqlite3BtreePayloadChecked(pCsr, sqlite3VarintLen(nHdr),
+                                  iType - sqlite3VarintLen(nHdr), &aNew[i]);
+  i += iType - sqlite3VarintLen(nHdr);
+  i += putVarint32(&aNew[i], tNew);
+  if( rc==SQLITE_OK ){
+    rc = sqlite3BtreePayloadChecked(pCsr, iType+szType, iEnd-iType-szType,
+                                    &aNew[i]);
+    i += iEnd - iType - szType;
+  }
+  if( rc==SQLITE_OK ){
+    memcpy(&aNew[i], z, n);
+    i += n;
+    rc = sqlite3BtreePayloadChecked(pCsr, iEnd, nPayload-iEnd, &aNew[i]);
+  }
+  assert( rc!=SQLITE_OK || i+nPayload-iEnd==nNew );
+  if( rc==SQLITE_OK ){
+    rc = sqlite3BtreeReplaceData(pCsr, aNew, nNew);
+  }
+  sqlite3DbFree(p->db, aNew);
+  if( rc==SQLITE_OK ){
+    p->iOffset += nHdrNew - nHdr;
+  }
+  return rc;
+}
+
+/*
+** Append data to the end of a blob.
+*/
+int sqlite3_blob_append(sqlite3_blob *pBlob, const void *z, int n){
+  int rc;
+  Incrblob *p = (Incrblob *)pBlob;
+  Vdbe *v;
+  sqlite3 *db;
+
+  if( p==0 ) return SQLITE_MISUSE_BKPT;
+  db = p->db;
+  sqlite3_mutex_enter(db->mutex);
+  v = (Vdbe*)p->pStmt;
+
+  if( n<0 ){
+    rc = SQLITE_ERROR;
+  }else if( v==0 ){
+    rc = SQLITE_ABORT;
+  }else if( (sqlite3_int64)p->nByte+n > db->aLimit[SQLITE_LIMIT_LENGTH] ){
+    rc = SQLITE_TOOBIG;
+  }else if( n==0 ){
+    rc = SQLITE_OK;
+  }else{
+    assert( db == v->db );
+    sqlite3BtreeEnterCursor(p->pCsr);
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+    if( db->xPreUpdateCallback ){
+      /* As for sqlite3_blob_write(), report the change as an SQLITE_DELETE */
+      sqlite3_int64 iKey;
+      iKey = sqlite3BtreeIntegerKey(p->pCsr);
+      sqlite3VdbePreUpdateHook(
+          v, v->apCsr[0], SQLITE_DELETE, p->zDb, p->pTab, iKey, -1
+      );
+    }
+#endif
+    rc = blobAppend(p, (const u8*)z, n);
+    sqlite3BtreeLeaveCursor(p->pCsr);
+    if( rc==SQLITE_OK ){
+      /* The record cached by the blob cursor is out of date */
+      p->nByte += n;
+      v->apCsr[0]->cacheStatus = CACHE_STALE;
+    }
+    if( rc==SQLITE_ABORT ){
+      sqlite3VdbeFinalize(v);
+      p->pStmt = 0;
+    }else{
+      v->rc = rc;
+    }
+  }
+  sqlite3Error(db, rc);
+  rc = sqlite3ApiExit(db, rc);
+  sqlite3_mutex_leave(db->mutex);
+  return rc;
+}
+#endif /* SQLITE_ENABLE_BLOB_APPEND */
+
 /*
 ** Query a blob handle for the size of the data.
 **
-** The Incrblob.nByte field is fixed for the lifetime of the Incrblob
-** so no mutex is required for access.
+** The Incrblob.nByte field only changes within sqlite3_blob_append(),
+** which the caller may not run concurrently with this on the same
+** handle, so no mutex is required for access.
 */
 int sqlite3_blob_bytes(sqlite3_blob *pBlob){
   Incrblob *p = (Incrblob *)pBlob;
@@ -95,6 +95,29 @@ int sqlite3WhereBreakLabel(WhereInfo *pWInfo){
   return pWInfo->iBreak;
 }
 
+#ifdef SQLITE_ENABLE_COUNTED_BTREE
+/*
+** If the WHERE clause is implemented by a single loop that visits every
+** entry of one b-tree exactly once and uses no other cursor (a full scan
+** of a table, or a full scan of a covering index), return the cursor of
+** that b-tree and set *pbRev to true if the scan runs from the last
+** entry to the first.  Otherwise return -1.
+*/
+int sqlite3WhereScanCursor(WhereInfo *pWInfo, int *pbRev){
+  WhereLevel *pLevel = &pWInfo->a[0];
+  WhereLoop *pLoop = pLevel->pWLoop;
+  if( pWInfo->nLevel!=1 || pLoop->nLTerm>0 ) return -1;
+  if( pLevel->op!=OP_Next && pLevel->op!=OP_Prev ) return -1;
+  if( pLoop->wsFlags & WHERE_INDEXED ){
+    if( (pLoop->wsFlags & WHERE_IDX_ONLY)==0 ) return -1;
+  }else if( pLoop->wsFlags & (WHERE_VIRTUALTABLE|WHERE_MULTI_OR) ){
+    return -1;
+  }
+  *pbRev = pLevel->op==OP_Prev;
+  return pLevel->p1;
+}
+#endif
+
 /*
 ** Return ONEPASS_OFF (0) if an UPDATE or DELETE statement is unable to
 ** operate directly on the rowis returned by a WHERE clause.  Return
@@ -4841,7 +4864,7 @@ WhereInfo *sqlite3WhereBegin(
     int bOnerow = (wsFlags & WHERE_ONEROW)!=0;
     if( bOnerow || (
         0!=(wctrlFlags & WHERE_ONEPASS_MULTIROW)
-     && 0==(wsFlags & WHERE_VIRTUALTABLE)
+     && !IsVirtual(pTabList->a[0].pTab)
      && (0==(wsFlags & WHERE_MULTI_OR) || (wctrlFlags & WHERE_DUPLICATES_OK))
     )){
       pWInfo->eOnePass = bOnerow ? ONEPASS_SINGLE : ONEPASS_MULTI;
@@ -4889,7 +4912,9 @@ WhereInfo *sqlite3WhereBegin(
       assert( pTabItem->iCursor==pLevel->iTabCur );
       testcase( pWInfo->eOnePass==ONEPASS_OFF && pTab->nCol==BMS-1 );
       testcase( pWInfo->eOnePass==ONEPASS_OFF && pTab->nCol==BMS );
-      if( pWInfo->eOnePass==ONEPASS_OFF && pTab->nCol<BMS && HasRowid(pTab) ){
+      if( pWInfo->eOnePass==ONEPASS_OFF && pTab->nCol<BMS && HasRowid(pTab)
+       && !HasFixedRecord(pTab)
+      ){
         Bitmask b = pTabItem->colUsed;
         int n = 0;
         for(; b; b=b>>1, n++){}
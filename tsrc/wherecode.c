@@ -1010,6 +1010,56 @@ static void codeCursorHint(
 # define codeCursorHint(A,B,C,D)  /* No-op */
 #endif /* SQLITE_ENABLE_CURSOR_HINTS */
 
+/*
+** Loop pLevel is a full scan of a WITHOUT VARINT table.  If the WHERE
+** clause contains a comparison between a column of that table and an
+** integer literal, code an OP_FixedFilter at the top of the loop that
+** skips rows that fail the comparison, and mark the term as coded.
+** Only one term is handled this way.
+*/
+static void codeFixedFilter(
+  WhereInfo *pWInfo,    /* The where clause */
+  WhereLevel *pLevel,   /* The full table scan loop */
+  Table *pTab,          /* The table being scanned */
+  int bRev              /* True if the scan runs backwards */
+){
+  /* OP_FixedFilter P5 masks for TK_EQ, TK_GT, TK_LE, TK_LT and TK_GE */
+  static const u8 aMask[] = { 0x02, 0x04, 0x03, 0x01, 0x06 };
+  Parse *pParse = pWInfo->pParse;
+  Vdbe *v = pParse->pVdbe;
+  WhereClause *pWC = &pWInfo->sWC;
+  WhereTerm *pTerm;
+  int i;
+
+  assert( TK_GT==TK_EQ+1 && TK_LE==TK_EQ+2 && TK_LT==TK_EQ+3 );
+  assert( TK_GE==TK_EQ+4 );
+  if( !HasFixedRecord(pTab) || pLevel->iLeftJoin ) return;
+  if( OptimizationDisabled(pParse->db, SQLITE_FixedFilter) ) return;
+  for(i=0, pTerm=pWC->a; i<pWC->nTerm; i++, pTerm++){
+    Expr *pExpr = pTerm->pExpr;
+    Expr *pLeft = pExpr->pLeft;
+    int iVal;
+    i64 iRhs;
+    if( pTerm->wtFlags & (TERM_VIRTUAL|TERM_CODED) ) continue;
+    if( pTerm->leftCursor!=pLevel->iTabCur ) continue;
+    if( (pTerm->eOperator & (WO_EQ|WO_LT|WO_LE|WO_GT|WO_GE))==0 ) continue;
+    if( pTerm->prereqAll & pLevel->notReady ) continue;
+    if( ExprHasProperty(pExpr, EP_FromJoin) ) continue;
+    if( pExpr->op<TK_EQ || pExpr->op>TK_GE ) continue;
+    if( pLeft->op!=TK_COLUMN || pLeft->iTable!=pLevel->iTabCur ) continue;
+    if( pLeft->iColumn<0 || pLeft->iColumn==pTab->iPKey ) continue;
+    if( !sqlite3ExprIsInteger(pExpr->pRight, &iVal) ) continue;
+    iRhs = iVal;
+    sqlite3VdbeAddOp4Dup8(v, OP_FixedFilter, pLevel->iTabCur,
+        pLevel->addrBrk, pLeft->iColumn, (const u8*)&iRhs, P4_INT64);
+    VdbeCoverage(v);
+    sqlite3VdbeChangeP5(v, aMask[pExpr->op-TK_EQ] | (bRev ? 0x08 : 0));
+    VdbeComment((v, "%s", pTab->aCol[pLeft->iColumn].zName));
+    disableTerm(pLevel, pTerm);
+    break;
+  }
+}
+
 /*
 ** Cursor iCur is open on an intkey b-tree (a table). Register iRowid contains
 ** a rowid value just read from cursor iIdxCur, open on index pIdx. This
@@ -2090,6 +2140,7 @@ Bitmask sqlite3WhereCodeOneLoopStart(
       VdbeCoverageIf(v, bRev==0);
       VdbeCoverageIf(v, bRev!=0);
       pLevel->p5 = SQLITE_STMTSTATUS_FULLSCAN_STEP;
+      codeFixedFilter(pWInfo, pLevel, pTabItem->pTab, bRev);
     }
   }
 